@@ -396,6 +396,37 @@ void MoveAlgo::tick(uint64_t dt, MvFlags moveFlg) {
     }
   }
 
+bool MoveAlgo::predictProbe(uint64_t dt, Probe& p) const {
+  // mirrors probe points of tick: tickGravity, tickSlide and plain walk
+  if(npc.interactive()!=nullptr || isClimb() || isJumpup() || isSwim())
+    return false;
+
+  auto  pos           = npc.position();
+  float fallThreshold = stepHeight();
+  float fallY         = fallSpeed.y;
+  Tempest::Vec3 dp    = {};
+
+  if(isInAir() && !npc.isJumpAnim()) {
+    if(0.f<fallCount)
+      fallY/=fallCount;
+    fallY -= gravity*float(dt);
+    }
+  else if(!isSlide()) {
+    dp = skipMove+npcMoveSpeed(dt,NoFlag);
+    }
+
+  p.land  = Tempest::Vec3(pos.x+dp.x, pos.y+dp.y+fallThreshold, pos.z+dp.z);
+  p.water = Tempest::Vec3(pos.x+dp.x, pos.y+dp.y,               pos.z+dp.z);
+  p.dy    = (fallY<0) ? 0 : waterDepthChest()+100;
+  return true;
+  }
+
+void MoveAlgo::setPrefetched(const Probe& p, uint64_t rayEpoch,
+                             const DynamicWorld::RayLandResult& land, const DynamicWorld::RayWaterResult& water) {
+  prefLand .set(RayKey{p.land.x, p.land.y, p.land.z, p.dy},rayEpoch,land);
+  prefWater.set(RayKey{p.water.x,p.water.y,p.water.z,0.f },rayEpoch,water);
+  }
+
 void MoveAlgo::clearSpeed() {
   fallSpeed.x = 0;
   fallSpeed.y = 0;
@@ -439,7 +470,7 @@ Tempest::Vec3 MoveAlgo::animMoveSpeed(uint64_t dt) const {
   return ret;
   }
 
-Tempest::Vec3 MoveAlgo::npcMoveSpeed(uint64_t dt, MvFlags moveFlg) {
+Tempest::Vec3 MoveAlgo::npcMoveSpeed(uint64_t dt, MvFlags moveFlg) const {
   Tempest::Vec3 dp = animMoveSpeed(dt);
   if(!npc.isJumpAnim())
     dp.y = 0.f;
@@ -464,11 +495,11 @@ Tempest::Vec3 MoveAlgo::npcMoveSpeed(uint64_t dt, MvFlags moveFlg) {
   return dp;
   }
 
-Tempest::Vec3 MoveAlgo::go2NpcMoveSpeed(const Tempest::Vec3& dp,const Npc& tg) {
+Tempest::Vec3 MoveAlgo::go2NpcMoveSpeed(const Tempest::Vec3& dp,const Npc& tg) const {
   return go2WpMoveSpeed(dp,tg.position());
   }
 
-Tempest::Vec3 MoveAlgo::go2WpMoveSpeed(Tempest::Vec3 dp, const Tempest::Vec3& to) {
+Tempest::Vec3 MoveAlgo::go2WpMoveSpeed(Tempest::Vec3 dp, const Tempest::Vec3& to) const {
   auto  d    = to-npc.position();
   float qLen = (d.x*d.x+d.z*d.z);
 
@@ -753,7 +784,10 @@ void MoveAlgo::onMoveFailed() {
 
 float MoveAlgo::waterRay(float x, float y, float z, bool* hasCol) const {
   if(std::fabs(cacheW.x-x)>eps || std::fabs(cacheW.y-y)>eps || std::fabs(cacheW.z-z)>eps) {
-    static_cast<DynamicWorld::RayWaterResult&>(cacheW) = npc.world().physic()->waterRay(x,y,z);
+    auto& physic = *npc.world().physic();
+    auto& ret    = static_cast<DynamicWorld::RayWaterResult&>(cacheW);
+    if(!prefWater.take(RayKey{x,y,z,0.f},physic.rayEpoch(),ret))
+      ret = physic.waterRay(x,y,z);
     cacheW.x = x;
     cacheW.y = y;
     cacheW.z = z;
@@ -769,7 +803,10 @@ void MoveAlgo::rayMain(float x, float y, float z) const {
     float dy   = waterDepthChest()+100;  // 1 meter extra offset
     if(fallSpeed.y<0)
       dy = 0; // whole world
-    static_cast<DynamicWorld::RayLandResult&>(cache) = npc.world().physic()->landRay(x,y,z,dy);
+    auto& physic = *npc.world().physic();
+    auto& ret    = static_cast<DynamicWorld::RayLandResult&>(cache);
+    if(!prefLand.take(RayKey{x,y,z,dy},physic.rayEpoch(),ret))
+      ret = physic.landRay(x,y,z,dy);
     cache.x = x;
     cache.y = y;
     cache.z = z;
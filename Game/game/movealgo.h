@@ -9,6 +9,7 @@
 
 #include "physics/dynamicworld.h"
 #include "graphics/mesh/animationsolver.h"
+#include "utils/prefetched.h"
 
 class Npc;
 class World;
@@ -33,6 +34,13 @@ class MoveAlgo final {
       WaitMove = 1<<1,
       };
 
+    // ground and water probe of plain tick(dt)
+    struct Probe {
+      Tempest::Vec3 land  = {};
+      float         dy    = 0;
+      Tempest::Vec3 water = {};
+      };
+
     static bool isClose(const Tempest::Vec3& w, const WayPoint& p);
     static bool isClose(float x,float y,float z,const WayPoint& p);
     static bool isClose(float x,float y,float z,const WayPoint& p,float dist);
@@ -41,6 +49,10 @@ class MoveAlgo final {
     void    save(Serialize& fout) const;
 
     void    tick(uint64_t dt,MvFlags fai=NoFlag);
+    // pure: predicts probes of next tick(dt), while nothing else has moved; used by parallel phase of npc tick
+    bool    predictProbe(uint64_t dt, Probe& p) const;
+    void    setPrefetched(const Probe& p, uint64_t rayEpoch,
+                          const DynamicWorld::RayLandResult& land, const DynamicWorld::RayWaterResult& water);
 
     void    multSpeed(float s){ mulSpeed=s; }
     void    clearSpeed();
@@ -101,9 +113,9 @@ class MoveAlgo final {
     void    onMoveFailed();
     void    applyRotation(Tempest::Vec3& out, const Tempest::Vec3& in) const;
     auto    animMoveSpeed(uint64_t dt) const -> Tempest::Vec3;
-    auto    npcMoveSpeed (uint64_t dt, MvFlags moveFlg) -> Tempest::Vec3;
-    auto    go2NpcMoveSpeed (const Tempest::Vec3& dp, const Npc &tg) -> Tempest::Vec3;
-    auto    go2WpMoveSpeed  (Tempest::Vec3 dp, const Tempest::Vec3& to) -> Tempest::Vec3;
+    auto    npcMoveSpeed (uint64_t dt, MvFlags moveFlg) const -> Tempest::Vec3;
+    auto    go2NpcMoveSpeed (const Tempest::Vec3& dp, const Npc &tg) const -> Tempest::Vec3;
+    auto    go2WpMoveSpeed  (Tempest::Vec3 dp, const Tempest::Vec3& to) const -> Tempest::Vec3;
     bool    testSlide(float x, float y, float z) const;
 
     float   stepHeight()  const;
@@ -125,10 +137,16 @@ class MoveAlgo final {
     struct CacheWater : DynamicWorld::RayWaterResult {
       float x=0, y=0, z=std::numeric_limits<float>::infinity();
       };
+    struct RayKey {
+      float x=0, y=0, z=0, dy=0;
+      bool operator == (const RayKey& r) const { return x==r.x && y==r.y && z==r.z && dy==r.dy; }
+      };
 
     Npc&                npc;
     mutable CacheLand   cache;
     mutable CacheWater  cacheW;
+    mutable Prefetched<RayKey,DynamicWorld::RayLandResult>  prefLand;
+    mutable Prefetched<RayKey,DynamicWorld::RayWaterResult> prefWater;
     Flags               flags=NoFlags;
 
     float               mulSpeed  =1.f;
@@ -18,6 +18,7 @@
 #include "utils/installdetect.h"
 #include "utils/fileutil.h"
 #include "utils/inifile.h"
+#include "resources.h"
 
 using namespace Tempest;
 using namespace FileUtil;
@@ -56,6 +57,12 @@ Gothic::Gothic(const int argc, const char **argv) {
     else if(std::strcmp(argv[i],"-nofrate")==0){
       noFrate=true;
       }
+    else if(std::strcmp(argv[i],"-anicompress")==0){
+      aniCompress=true;
+      }
+    else if(std::strcmp(argv[i],"-bakecache")==0){
+      bakeCache=true;
+      }
     else if(std::strcmp(argv[i],"-rambo")==0){
       isRambo=true;
       }
@@ -318,6 +325,10 @@ bool Gothic::finishLoading() {
     if(pendingGame!=nullptr)
       game = std::move(pendingGame);
     saveTex = Texture2d();
+    // previous world is gone at this point; trim waits for gpu, so it's done here, not on loader thread
+    if(trimPending)
+      Resources::trimResidency();
+    trimPending = false;
     onWorldLoaded();
     return true;
     }
@@ -358,6 +369,11 @@ void Gothic::implStartLoadSave(const char* banner,
       try {
         next        = f(std::move(game));
         pendingGame = std::move(next);
+        if(curState==LoadState::Loading) {
+          if(pendingGame!=nullptr && pendingGame->view()!=nullptr)
+            pendingGame->view()->rebuildStaticTree();
+          trimPending = true;
+          }
         loadingFlag.compare_exchange_strong(curState,LoadState::Finalize);
         }
       catch(std::bad_alloc&){
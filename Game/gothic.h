@@ -49,6 +49,8 @@ class Gothic final {
     bool         isInGame() const;
     bool         doStartMenu() const { return !noMenu; }
     bool         doFrate() const { return !noFrate; }
+    bool         doAniCompression() const { return aniCompress; }
+    bool         doBakeCache() const { return bakeCache; }
 
     void         setGame(std::unique_ptr<GameSession> &&w);
     auto         clearGame() -> std::unique_ptr<GameSession>;
@@ -156,6 +158,8 @@ class Gothic final {
     std::string                             saveDef;
     bool                                    noMenu=false;
     bool                                    noFrate=false;
+    bool                                    aniCompress=false;
+    bool                                    bakeCache=false;
     bool                                    isWindow=false;
     GraphicBackend                          graphics = GraphicBackend::Vulkan;
     uint16_t                                pauseSum=0;
@@ -172,6 +176,7 @@ class Gothic final {
     std::atomic_int                         loadProgress{0};
     std::thread                             loaderTh;
     std::atomic<LoadState>                  loadingFlag{LoadState::Idle};
+    bool                                    trimPending=false;
 
     std::unique_ptr<GameSession>            game, pendingGame;
     std::unique_ptr<FightAi>                fight;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Buckets by hash of their key, used by VisualObjects::getBucket. Buckets of same hash form a chain, scanned
+// newest first: only the newest one is likely to be non-full. Engine independent, to be testable without Device.
+template<class Bucket>
+class BucketChain final {
+  public:
+    // first bucket of chain, accepted by `match`, or nullptr
+    template<class Match>
+    Bucket* find(size_t hash, const Match& match) const {
+      auto c = chain.find(hash);
+      if(c==chain.end())
+        return nullptr;
+      for(auto it=c->second.rbegin(); it!=c->second.rend(); ++it)
+        if(match(**it))
+          return *it;
+      return nullptr;
+      }
+
+    void    push(size_t hash, Bucket* b) { chain[hash].push_back(b); }
+    size_t  size() const                 { return chain.size(); }
+
+    // hash of bucket key, as used by VisualObjects::bucketHash
+    static size_t keyHash(const void* tex, const void* morph, size_t alpha, bool isGhost, size_t bones, size_t type) {
+      size_t h = std::hash<const void*>()(tex);
+      h = h*31 + std::hash<const void*>()(morph);
+      h = h*31 + alpha;
+      h = h*31 + size_t(isGhost);
+      h = h*31 + bones;
+      h = h*31 + type;
+      return h;
+      }
+
+  private:
+    std::unordered_map<size_t,std::vector<Bucket*>> chain;
+  };
@@ -0,0 +1,74 @@
+#include "dirtyranges.h"
+
+#include <algorithm>
+
+void DirtyRanges::resize(size_t sz) {
+  const size_t nwords = (sz+63)/64;
+  if(nwords>words) {
+    for(auto& f:pf) {
+      std::unique_ptr<std::atomic<uint64_t>[]> bits(new std::atomic<uint64_t>[nwords]);
+      for(size_t i=0; i<nwords; ++i)
+        bits[i].store(i<words ? f.bits[i].load() : 0);
+      f.bits = std::move(bits);
+      }
+    words = nwords;
+    }
+
+  const size_t prev = count;
+  count = sz;
+  if(sz>prev)
+    mark(prev,sz);
+  }
+
+void DirtyRanges::mark(size_t begin, size_t end) {
+  if(end>count)
+    end = count;
+  if(begin>=end)
+    return;
+  for(auto& f:pf) {
+    for(size_t i=begin; i<end;) {
+      const size_t   w    = i/64;
+      const size_t   b    = i%64;
+      const size_t   len  = std::min<size_t>(64-b,end-i);
+      const uint64_t mask = (len==64) ? ~uint64_t(0) : (((uint64_t(1)<<len)-1)<<b);
+      f.bits[w].fetch_or(mask);
+      i += len;
+      }
+    f.any.store(true);
+    }
+  }
+
+void DirtyRanges::markAll() {
+  mark(0,count);
+  }
+
+void DirtyRanges::take(uint8_t fId, std::vector<Range>& out, size_t gap, size_t maxRanges) {
+  out.clear();
+  auto& f = pf[fId];
+  if(!f.any.exchange(false))
+    return;
+
+  for(size_t w=0; w<words; ++w) {
+    uint64_t b = f.bits[w].exchange(0);
+    for(size_t bit=0; b!=0; ++bit, b>>=1) {
+      if((b&1)==0)
+        continue;
+      const size_t i = w*64+bit;
+      if(!out.empty() && i<=out.back().end+gap)
+        out.back().end = i+1; else
+        out.push_back({i,i+1});
+      }
+    }
+
+  if(out.size()>maxRanges) {
+    out[0].end = out.back().end;
+    out.resize(1);
+    }
+  }
+
+void DirtyRanges::clear(uint8_t fId) {
+  auto& f = pf[fId];
+  f.any.store(false);
+  for(size_t i=0; i<words; ++i)
+    f.bits[i].store(0);
+  }
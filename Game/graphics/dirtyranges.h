@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "resources.h"
+
+// Per-element dirty flags of uniform storage: one bit per element for each frame in flight.
+// mark is thread-safe; resize and take are not.
+class DirtyRanges final {
+  public:
+    DirtyRanges() = default;
+
+    struct Range {
+      size_t begin = 0;
+      size_t end   = 0;
+      };
+
+    // new elements are dirty in every frame
+    void   resize(size_t sz);
+    size_t size() const { return count; }
+
+    void   mark(size_t begin, size_t end);
+    void   markAll();
+    bool   isDirty(uint8_t fId) const { return pf[fId].any.load(); }
+
+    // collect and clear dirty elements of frame; ranges, closer than 'gap' elements, are coalesced,
+    // more than 'maxRanges' ranges collapse into one
+    void   take(uint8_t fId, std::vector<Range>& out, size_t gap, size_t maxRanges);
+    void   clear(uint8_t fId);
+
+  private:
+    struct PerFrame final {
+      std::unique_ptr<std::atomic<uint64_t>[]> bits;
+      std::atomic_bool                         any{false};
+      };
+
+    PerFrame pf[Resources::MaxFramesInFlight];
+    size_t   count = 0;
+    size_t   words = 0;
+  };
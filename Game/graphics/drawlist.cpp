@@ -0,0 +1,29 @@
+#include "drawlist.h"
+
+#include <cassert>
+
+uint8_t DrawList::slotMask(bool empty, bool alwaysVisible, const bool* visible, size_t cameras) {
+  if(empty)
+    return 0;
+  if(alwaysVisible)
+    return uint8_t((1u<<cameras)-1);
+  uint8_t ret = 0;
+  for(size_t c=0; c<cameras; ++c)
+    if(visible[c])
+      ret = uint8_t(ret | (1u<<c));
+  return ret;
+  }
+
+void DrawList::compact(const uint8_t* mask, size_t count, size_t cameras, uint8_t* ids, size_t stride, size_t* sizes) {
+  assert(count<=stride && count<=256);
+  for(size_t c=0; c<cameras; ++c) {
+    uint8_t* out = ids+c*stride;
+    size_t   sz  = 0;
+    // branchless: slot id is always written, but cursor advances only for drawn slots; sz<=i<stride
+    for(size_t i=0; i<count; ++i) {
+      out[sz] = uint8_t(i);
+      sz += (mask[i]>>c)&1u;
+      }
+    sizes[c] = sz;
+    }
+  }
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Compaction of object slots into per-camera lists of draws, used by ObjectsBucket.
+// Engine independent, to be testable without Device.
+namespace DrawList {
+  // bit c of result is set, if slot is drawn for camera c
+  uint8_t slotMask(bool empty, bool alwaysVisible, const bool* visible, size_t cameras);
+
+  // ids[c*stride...] receive indices of slots, drawn for camera c, in slot order; sizes[c] - their count
+  void    compact(const uint8_t* mask, size_t count, size_t cameras, uint8_t* ids, size_t stride, size_t* sizes);
+  }
@@ -1,5 +1,13 @@
 #include "frustrum.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define FRUSTRUM_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FRUSTRUM_NEON
+#endif
+
 using namespace Tempest;
 
 void Frustrum::make(const Matrix4x4& m) {
@@ -118,3 +126,54 @@ bool Frustrum::testPoint(const Vec3 p, float R) const {
     }
   return true;
   }
+
+Frustrum::Result Frustrum::testSphere(const Vec3 p, float R) const {
+  Result ret = T_In;
+  for(size_t i=0; i<6; i++) {
+    const float d = f[i][0]*p.x+f[i][1]*p.y+f[i][2]*p.z+f[i][3];
+    if(d<=-R)
+      return T_Out;
+    if(d<R)
+      ret = T_Partial;
+    }
+  return ret;
+  }
+
+uint8_t Frustrum::testPoints(const float* x, const float* y, const float* z, const float* R) const {
+#if defined(FRUSTRUM_SSE)
+  const __m128 px  = _mm_loadu_ps(x);
+  const __m128 py  = _mm_loadu_ps(y);
+  const __m128 pz  = _mm_loadu_ps(z);
+  const __m128 nr  = _mm_sub_ps(_mm_setzero_ps(),_mm_loadu_ps(R));
+  __m128       out = _mm_setzero_ps();
+  for(size_t i=0; i<6; i++) {
+    __m128 d = _mm_add_ps(_mm_mul_ps(px,_mm_set1_ps(f[i][0])),_mm_mul_ps(py,_mm_set1_ps(f[i][1])));
+    d   = _mm_add_ps(d,_mm_mul_ps(pz,_mm_set1_ps(f[i][2])));
+    d   = _mm_add_ps(d,_mm_set1_ps(f[i][3]));
+    out = _mm_or_ps(out,_mm_cmple_ps(d,nr));
+    }
+  return uint8_t(~_mm_movemask_ps(out) & 0xF);
+#elif defined(FRUSTRUM_NEON)
+  const float32x4_t px  = vld1q_f32(x);
+  const float32x4_t py  = vld1q_f32(y);
+  const float32x4_t pz  = vld1q_f32(z);
+  const float32x4_t nr  = vnegq_f32(vld1q_f32(R));
+  uint32x4_t        out = vdupq_n_u32(0);
+  for(size_t i=0; i<6; i++) {
+    float32x4_t d = vmulq_n_f32(px,f[i][0]);
+    d   = vmlaq_n_f32(d,py,f[i][1]);
+    d   = vmlaq_n_f32(d,pz,f[i][2]);
+    d   = vaddq_f32(d,vdupq_n_f32(f[i][3]));
+    out = vorrq_u32(out,vcleq_f32(d,nr));
+    }
+  const uint32_t m = (vgetq_lane_u32(out,0)&1u) | (vgetq_lane_u32(out,1)&2u) |
+                     (vgetq_lane_u32(out,2)&4u) | (vgetq_lane_u32(out,3)&8u);
+  return uint8_t(~m & 0xF);
+#else
+  uint8_t ret = 0;
+  for(int i=0; i<4; ++i)
+    if(testPoint(x[i],y[i],z[i],R[i]))
+      ret |= uint8_t(1<<i);
+  return ret;
+#endif
+  }
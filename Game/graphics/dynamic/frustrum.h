@@ -1,15 +1,26 @@
 #pragma once
 
 #include <Tempest/Matrix4x4>
+#include <cstdint>
 
 class Frustrum {
   public:
+    enum Result : uint8_t {
+      T_Out,
+      T_Partial,
+      T_In,
+      };
+
     void make(const Tempest::Matrix4x4& m);
     void clear();
 
     bool testPoint(float x, float y, float z) const;
     bool testPoint(float x, float y, float z, float R) const;
     bool testPoint(const Tempest::Vec3 p, float R) const;
+    // sphere classification, for hierarchical culling
+    Result testSphere(const Tempest::Vec3 p, float R) const;
+    // 4 spheres at once, same as testPoint; returns bit-mask of visible ones
+    uint8_t testPoints(const float* x, const float* y, const float* z, const float* R) const;
 
     float f[6][4] = {};
   };
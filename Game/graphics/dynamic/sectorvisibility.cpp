@@ -0,0 +1,206 @@
+#include "sectorvisibility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "graphics/mesh/submesh/packedmesh.h"
+#include "graphics/bounds.h"
+#include "frustrum.h"
+
+using namespace Tempest;
+
+SectorVisibility::SectorVisibility(const ZenLoad::zCBspTreeData& bsp, const PackedMesh& land)
+  :bsp(bsp) {
+  sectors.resize(bsp.sectors.size()+1);
+  outdoor = uint32_t(bsp.sectors.size());
+
+  // leaf to sector; leaf, shared by few sectors, is ambiguous
+  leafSector.resize(bsp.nodes.size(),S_Outdoor);
+  for(size_t i=0; i<bsp.sectors.size(); ++i) {
+    auto& s     = sectors[i];
+    bool  first = true;
+    for(auto r:bsp.sectors[i].bspNodeIndices) {
+      if(r>=bsp.leafIndices.size())
+        continue;
+      const size_t idx = bsp.leafIndices[r];
+      if(idx>=bsp.nodes.size())
+        continue;
+      leafSector[idx] = (leafSector[idx]==S_Outdoor) ? int32_t(i) : S_Any;
+
+      auto& n = bsp.nodes[idx];
+      if(first) {
+        s.bbox[0] = Vec3(n.bbox3dMin.x,n.bbox3dMin.y,n.bbox3dMin.z);
+        s.bbox[1] = Vec3(n.bbox3dMax.x,n.bbox3dMax.y,n.bbox3dMax.z);
+        first     = false;
+        }
+      s.bbox[0].x = std::min(s.bbox[0].x,n.bbox3dMin.x);
+      s.bbox[0].y = std::min(s.bbox[0].y,n.bbox3dMin.y);
+      s.bbox[0].z = std::min(s.bbox[0].z,n.bbox3dMin.z);
+      s.bbox[1].x = std::max(s.bbox[1].x,n.bbox3dMax.x);
+      s.bbox[1].y = std::max(s.bbox[1].y,n.bbox3dMax.y);
+      s.bbox[1].z = std::max(s.bbox[1].z,n.bbox3dMax.z);
+      }
+    }
+
+  // portal polygons are part of landscape; landscape is split into chunks, so merge them by name
+  std::unordered_map<std::string,size_t> byName;
+  std::vector<std::pair<Vec3,Vec3>>      bbox;
+  for(auto& sm:land.subMeshes) {
+    uint32_t a = 0, b = 0;
+    if(sm.indices.empty() || !parsePortal(sm.material.matName,a,b))
+      continue;
+
+    auto it = byName.find(sm.material.matName);
+    if(it==byName.end()) {
+      auto& v0 = land.vertices[sm.indices[0]].Position;
+      it = byName.emplace(sm.material.matName,portals.size()).first;
+      Portal p;
+      p.a = a;
+      p.b = b;
+      portals.push_back(p);
+      bbox.emplace_back(Vec3(v0.x,v0.y,v0.z),Vec3(v0.x,v0.y,v0.z));
+      }
+
+    auto& bb = bbox[it->second];
+    for(auto i:sm.indices) {
+      auto& v = land.vertices[i].Position;
+      bb.first .x = std::min(bb.first .x,v.x);
+      bb.first .y = std::min(bb.first .y,v.y);
+      bb.first .z = std::min(bb.first .z,v.z);
+      bb.second.x = std::max(bb.second.x,v.x);
+      bb.second.y = std::max(bb.second.y,v.y);
+      bb.second.z = std::max(bb.second.z,v.z);
+      }
+    }
+
+  for(size_t i=0; i<portals.size(); ++i) {
+    auto& p  = portals[i];
+    auto& bb = bbox[i];
+    p.mid = (bb.first+bb.second)/2;
+    p.r   = std::sqrt((bb.second-bb.first).quadLength())/2;
+    sectors[p.a].portals.push_back(uint32_t(i));
+    sectors[p.b].portals.push_back(uint32_t(i));
+    }
+
+  // no portals - nothing to cull
+  visible.resize(sectors.size(),1);
+  }
+
+size_t SectorVisibility::visibleCount() const {
+  return size_t(std::count(visible.begin(),visible.begin()+outdoor,1));
+  }
+
+int32_t SectorVisibility::classify(const Bounds& b) const {
+  if(portals.empty())
+    return S_Outdoor;
+  const int32_t id = sectorAt(b.midTr);
+  if(id<0)
+    return S_Outdoor;
+  // sector without resolved portals is unreachable by walk: treat it as outdoor
+  auto& s = sectors[size_t(id)];
+  if(s.portals.empty())
+    return S_Outdoor;
+  // objects, that cross sector boundary (or stick through portal), stay visible
+  if(s.bbox[0].x<=b.bboxTr[0].x && b.bboxTr[1].x<=s.bbox[1].x &&
+     s.bbox[0].y<=b.bboxTr[0].y && b.bboxTr[1].y<=s.bbox[1].y &&
+     s.bbox[0].z<=b.bboxTr[0].z && b.bboxTr[1].z<=s.bbox[1].z)
+    return id;
+  return S_Outdoor;
+  }
+
+void SectorVisibility::update(const Vec3& camera, const Matrix4x4& viewProj) {
+  if(portals.empty())
+    return;
+
+  const int32_t cam = sectorAt(camera);
+  if(cam==S_Any) {
+    std::fill(visible.begin(),visible.end(),1);
+    return;
+    }
+
+  Frustrum f;
+  f.make(viewProj);
+
+  std::fill(visible.begin(),visible.end(),0);
+  uint32_t start = (cam==S_Outdoor) ? outdoor : uint32_t(cam);
+  if(sectors[start].portals.empty())
+    start = outdoor;
+  visible[start] = 1;
+  stk.clear();
+  stk.push_back(start);
+
+  // no portal clipping: sector is visible, if any chain of portals in frustum leads to it
+  while(!stk.empty()) {
+    const uint32_t s = stk.back();
+    stk.pop_back();
+    for(auto id:sectors[s].portals) {
+      auto&          p     = portals[id];
+      const uint32_t other = (p.a==s) ? p.b : p.a;
+      if(visible[other] || !f.testPoint(p.mid,p.r))
+        continue;
+      visible[other] = 1;
+      stk.push_back(other);
+      }
+    }
+  }
+
+int32_t SectorVisibility::sectorAt(const Vec3& p) const {
+  if(bsp.nodes.empty())
+    return S_Outdoor;
+
+  // same walk as World::roomAt
+  size_t id = 0;
+  while(true) {
+    const float*   v    = bsp.nodes[id].plane.v;
+    const float    sgn  = v[0]*p.x + v[1]*p.y + v[2]*p.z - v[3];
+    const uint32_t next = (sgn>0) ? bsp.nodes[id].front : bsp.nodes[id].back;
+    if(next>=bsp.nodes.size())
+      break;
+    id = next;
+    }
+
+  auto& node = bsp.nodes[id];
+  if(node.bbox3dMin.x <= p.x && p.x <node.bbox3dMax.x &&
+     node.bbox3dMin.y <= p.y && p.y <node.bbox3dMax.y &&
+     node.bbox3dMin.z <= p.z && p.z <node.bbox3dMax.z)
+    return leafSector[id];
+  return S_Outdoor;
+  }
+
+int32_t SectorVisibility::sectorId(const std::string& name) const {
+  for(size_t i=0; i<bsp.sectors.size(); ++i)
+    if(bsp.sectors[i].name==name)
+      return int32_t(i);
+  return S_Outdoor;
+  }
+
+bool SectorVisibility::parsePortal(const std::string& name, uint32_t& a, uint32_t& b) const {
+  // portal material is "P:front_back", where unknown side is outdoor; sector names may have '_' too,
+  // so take the split, that resolves most sectors
+  if(name.size()<3 || name[0]!='P' || name[1]!=':')
+    return false;
+
+  int score = 0;
+  for(size_t i=2; i<name.size(); ++i) {
+    if(name[i]!='_')
+      continue;
+    const int32_t sa = sectorId(name.substr(2,i-2));
+    const int32_t sb = sectorId(name.substr(i+1));
+    const int     sc = (sa>=0 ? 1 : 0) + (sb>=0 ? 1 : 0);
+    if(sc<=score)
+      continue;
+    score = sc;
+    a     = (sa>=0) ? uint32_t(sa) : outdoor;
+    b     = (sb>=0) ? uint32_t(sb) : outdoor;
+    }
+
+  if(score==0) {
+    const int32_t sa = sectorId(name.substr(2));
+    if(sa<0)
+      return false;
+    a = uint32_t(sa);
+    b = outdoor;
+    }
+  return a!=b;
+  }
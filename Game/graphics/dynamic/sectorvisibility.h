@@ -0,0 +1,59 @@
+#pragma once
+
+#include <Tempest/Matrix4x4>
+
+#include <zenload/zTypes.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class Bounds;
+class Frustrum;
+class PackedMesh;
+
+// Portal occlusion for indoor sectors of bsp tree.
+// Each frame sectors are walked from the camera one, through portals, that pass frustum test.
+// Only objects, fully inside of a single sector, are ever culled: outdoor is always considered visible.
+class SectorVisibility final {
+  public:
+    SectorVisibility(const ZenLoad::zCBspTreeData& bsp, const PackedMesh& land);
+
+    enum : int32_t {
+      S_Outdoor = -1,
+      S_Any     = -2,
+      };
+
+    int32_t classify (const Bounds& b) const;
+    void    update   (const Tempest::Vec3& camera, const Tempest::Matrix4x4& viewProj);
+    bool    isVisible(int32_t sector) const { return sector<0 || visible[size_t(sector)]; }
+
+    size_t  sectorsCount()  const { return outdoor; }
+    size_t  visibleCount()  const;
+
+  private:
+    struct Portal {
+      Tempest::Vec3 mid;
+      float         r    = 0;
+      uint32_t      a    = 0;
+      uint32_t      b    = 0;
+      };
+
+    struct Sector {
+      Tempest::Vec3         bbox[2];
+      std::vector<uint32_t> portals;
+      };
+
+    int32_t  sectorAt(const Tempest::Vec3& p) const;
+    int32_t  sectorId(const std::string& name) const;
+    bool     parsePortal(const std::string& name, uint32_t& a, uint32_t& b) const;
+
+    const ZenLoad::zCBspTreeData& bsp;
+    std::vector<int32_t>          leafSector;
+    std::vector<Sector>           sectors;
+    std::vector<Portal>           portals;
+    uint32_t                      outdoor = 0;
+
+    std::vector<uint8_t>          visible;
+    std::vector<uint32_t>         stk;
+  };
@@ -1,8 +1,13 @@
 #include "frustrum.h"
+#include "sectorvisibility.h"
 #include "visibilitygroup.h"
 
 #include "utils/workers.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 using namespace Tempest;
 
 VisibilityGroup::Token::Token(VisibilityGroup& ow, size_t id)
@@ -23,15 +28,18 @@ VisibilityGroup::Token& VisibilityGroup::Token::operator =(VisibilityGroup::Toke
 VisibilityGroup::Token::~Token() {
   if(owner==nullptr)
     return;
-  owner->freeList.push_back(id);
+  owner->free(id);
   }
 
 void VisibilityGroup::Token::setObjMatrix(const Matrix4x4& at) {
   if(owner==nullptr)
     return;
   auto& t = owner->tokens[id];
+  if(t.inTree && std::memcmp(&t.pos,&at,sizeof(at))==0)
+    return;
   t.pos = at;
   t.bbox.setObjMatrix(at);
+  owner->onMove(t);
   }
 
 void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
@@ -40,6 +48,7 @@ void VisibilityGroup::Token::setBounds(const Bounds& bbox) {
   auto& t = owner->tokens[id];
   t.bbox = bbox;
   t.bbox.setObjMatrix(owner->tokens[id].pos);
+  owner->onMove(t);
   }
 
 const Bounds& VisibilityGroup::Token::bounds() const {
@@ -50,7 +59,7 @@ VisibilityGroup::VisibilityGroup() {
   freeList.reserve(4);
   }
 
-VisibilityGroup::Token VisibilityGroup::get() {
+VisibilityGroup::Token VisibilityGroup::get(bool isStatic) {
   size_t id = tokens.size();
   if(freeList.size()>0) {
     id = freeList.back();
@@ -58,23 +67,236 @@ VisibilityGroup::Token VisibilityGroup::get() {
     } else {
     tokens.emplace_back();
     }
-  // auto& t = tokens[id];
-  // t.pos  = at;
-  // t.bbox = bbox;
-  // t.bbox.setObjMatrix(at);
+  auto& t = tokens[id];
+  t.kind   = isStatic ? K_Static : K_Dynamic;
+  t.inTree = false;
+  // runtime created statics (arrows, dropped items) must not trigger full rebuild
+  moversDirty = true;
   return Token(*this,id);
   }
 
+void VisibilityGroup::free(size_t id) {
+  // stale tree entries are skipped by kind; no need to rebuild
+  auto& t = tokens[id];
+  if(!t.inTree)
+    moversDirty = true;
+  t.kind   = K_Free;
+  t.inTree = false;
+  freeList.push_back(id);
+  }
+
+void VisibilityGroup::onMove(Tok& t) {
+  if(t.kind!=K_Static || !t.inTree)
+    return;
+  // object is not so static after all: test it one by one, instead of rebuilding tree on each move
+  t.kind      = K_Dynamic;
+  t.inTree    = false;
+  moversDirty = true;
+  }
+
+void VisibilityGroup::rebuildStaticTree() {
+  treeDirty = true;
+  }
+
+void VisibilityGroup::buildMovers() {
+  moversDirty = false;
+  movers.clear();
+  for(size_t i=0; i<tokens.size(); ++i) {
+    auto& t = tokens[i];
+    if(t.kind==K_Dynamic || (t.kind==K_Static && !t.inTree))
+      movers.push_back(uint32_t(i));
+    }
+  }
+
+void VisibilityGroup::buildTree() {
+  treeDirty   = false;
+  moversDirty = true;
+  nodes.clear();
+  packets.clear();
+  roots.clear();
+
+  std::vector<uint32_t> ids;
+  for(size_t i=0; i<tokens.size(); ++i) {
+    auto& t = tokens[i];
+    t.inTree = (t.kind==K_Static);
+    if(!t.inTree)
+      continue;
+    t.sector = (sectors!=nullptr) ? sectors->classify(t.bbox) : SectorVisibility::S_Outdoor;
+    ids.push_back(uint32_t(i));
+    }
+  if(ids.empty())
+    return;
+
+  nodes.reserve(2*ids.size()/PACKET_SIZE+1);
+  packets.reserve(ids.size()/(PACKET_SIZE/2)+1);
+  nodes.emplace_back();
+  buildNode(0,ids.data(),ids.data()+ids.size());
+
+  // breadth-first cut of tree, to cull subtrees in parallel
+  roots.push_back(0);
+  while(roots.size()<MIN_ROOTS) {
+    std::vector<uint32_t> next;
+    for(auto r:roots) {
+      if(nodes[r].left==0) {
+        next.push_back(r);
+        } else {
+        next.push_back(nodes[r].left);
+        next.push_back(nodes[r].left+1);
+        }
+      }
+    if(next.size()==roots.size())
+      break;
+    roots = std::move(next);
+    }
+  }
+
+void VisibilityGroup::buildNode(uint32_t node, uint32_t* b, uint32_t* e) {
+  // bounds of bounding spheres, so node sphere contains every token sphere
+  Vec3 lo = tokens[*b].bbox.midTr, hi = lo;
+  for(auto i=b; i!=e; ++i) {
+    auto& bb = tokens[*i].bbox;
+    lo.x = std::min(lo.x,bb.midTr.x-bb.r);
+    lo.y = std::min(lo.y,bb.midTr.y-bb.r);
+    lo.z = std::min(lo.z,bb.midTr.z-bb.r);
+    hi.x = std::max(hi.x,bb.midTr.x+bb.r);
+    hi.y = std::max(hi.y,bb.midTr.y+bb.r);
+    hi.z = std::max(hi.z,bb.midTr.z+bb.r);
+    }
+  nodes[node].mid      = (lo+hi)/2;
+  nodes[node].r        = std::sqrt((hi-lo).quadLength())/2;
+  nodes[node].pktBegin = uint32_t(packets.size());
+
+  if(std::distance(b,e)<=PACKET_SIZE) {
+    Packet p;
+    for(auto i=b; i!=e; ++i) {
+      auto& bb = tokens[*i].bbox;
+      p.x [p.size] = bb.midTr.x;
+      p.y [p.size] = bb.midTr.y;
+      p.z [p.size] = bb.midTr.z;
+      p.r [p.size] = bb.r;
+      p.id[p.size] = *i;
+      p.size++;
+      }
+    packets.push_back(p);
+    nodes[node].pktEnd = uint32_t(packets.size());
+    return;
+    }
+
+  // median split along longest axis
+  const Vec3 ext  = hi-lo;
+  const int  axis = (ext.x>=ext.y && ext.x>=ext.z) ? 0 : (ext.y>=ext.z ? 1 : 2);
+  auto key = [this,axis](uint32_t i) {
+    auto& c = tokens[i].bbox.midTr;
+    return axis==0 ? c.x : (axis==1 ? c.y : c.z);
+    };
+  uint32_t* mid = b+std::distance(b,e)/2;
+  std::nth_element(b,mid,e,[&key](uint32_t l, uint32_t r){ return key(l)<key(r); });
+
+  const uint32_t left = uint32_t(nodes.size());
+  nodes.resize(nodes.size()+2);
+  nodes[node].left = left;
+  buildNode(left,  b,mid);
+  buildNode(left+1,mid,e);
+  nodes[node].pktEnd = uint32_t(packets.size());
+  }
+
+void VisibilityGroup::cullNode(const Frustrum* f, uint32_t id, uint8_t partial, uint8_t inside) {
+  auto& n = nodes[id];
+  for(uint8_t c=0; c<SceneGlobals::V_Count; ++c) {
+    const uint8_t bit = uint8_t(1u<<c);
+    if((partial&bit)==0)
+      continue;
+    switch(f[c].testSphere(n.mid,n.r)) {
+      case Frustrum::T_Out:
+        partial &= uint8_t(~bit);
+        break;
+      case Frustrum::T_In:
+        partial &= uint8_t(~bit);
+        inside  |= bit;
+        break;
+      case Frustrum::T_Partial:
+        break;
+      }
+    }
+
+  if(partial==0 || n.left==0) {
+    // whole subtree is resolved: no more tests, except leaf packets
+    for(uint32_t i=n.pktBegin; i<n.pktEnd; ++i)
+      cullPacket(f,packets[i],partial,inside);
+    return;
+    }
+  cullNode(f,n.left,  partial,inside);
+  cullNode(f,n.left+1,partial,inside);
+  }
+
+void VisibilityGroup::cullPacket(const Frustrum* f, const Packet& p, uint8_t partial, uint8_t inside) {
+  uint8_t mask[SceneGlobals::V_Count] = {};
+  for(uint8_t c=0; c<SceneGlobals::V_Count; ++c) {
+    const uint8_t bit = uint8_t(1u<<c);
+    if(partial&bit)
+      mask[c] = f[c].testPoints(p.x,p.y,p.z,p.r);
+    else if(inside&bit)
+      mask[c] = 0xF;
+    }
+
+  uint32_t culled = 0;
+  for(uint8_t i=0; i<p.size; ++i) {
+    auto& t = tokens[p.id[i]];
+    // stale entry: freed token, or slot reused by a static not yet in tree - tested as mover
+    if(t.kind!=K_Static || !t.inTree)
+      continue;
+    for(uint8_t c=0; c<SceneGlobals::V_Count; ++c)
+      t.visible[c] = ((mask[c]>>i)&1)!=0;
+    if(t.visible[SceneGlobals::V_Main] && sectors!=nullptr && !sectors->isVisible(t.sector)) {
+      t.visible[SceneGlobals::V_Main] = false;
+      culled++;
+      }
+    }
+  if(culled>0)
+    sectorCulled.fetch_add(culled,std::memory_order_relaxed);
+  }
+
 void VisibilityGroup::pass(const Tempest::Matrix4x4& main, const Tempest::Matrix4x4* sh, size_t /*shCount*/) {
   Frustrum f[SceneGlobals::V_Count];
   f[SceneGlobals::V_Shadow0].make(sh[0]);
   f[SceneGlobals::V_Shadow1].make(sh[1]);
   f[SceneGlobals::V_Main   ].make(main);
 
-  Workers::parallelFor(tokens,[&f](Tok& t){
+  if(treeDirty.load())
+    buildTree();
+  if(moversDirty.load())
+    buildMovers();
+
+  sectorCulled.store(0,std::memory_order_relaxed);
+  const uint8_t all = uint8_t((1u<<SceneGlobals::V_Count)-1);
+  Workers::parallelFor(roots,[this,&f,all](uint32_t& n){
+    cullNode(f,n,all,0);
+    });
+
+  Workers::parallelFor(movers,[this,&f](uint32_t& id){
+    auto& t = tokens[id];
     auto& b = t.bbox;
     t.visible[SceneGlobals::V_Shadow0] = f[SceneGlobals::V_Shadow0].testPoint(b.midTr, b.r);
     t.visible[SceneGlobals::V_Shadow1] = f[SceneGlobals::V_Shadow1].testPoint(b.midTr, b.r);
     t.visible[SceneGlobals::V_Main]    = f[SceneGlobals::V_Main   ].testPoint(b.midTr, b.r);
+    if(t.visible[SceneGlobals::V_Main] && sectors!=nullptr && !sectors->isVisible(sectors->classify(b))) {
+      t.visible[SceneGlobals::V_Main] = false;
+      sectorCulled.fetch_add(1,std::memory_order_relaxed);
+      }
     });
   }
+
+void VisibilityGroup::setSectors(const SectorVisibility* s) {
+  sectors   = s;
+  treeDirty = true;
+  }
+
+VisibilityGroup::Stats VisibilityGroup::stats() const {
+  Stats st;
+  if(sectors!=nullptr) {
+    st.sectors = uint32_t(sectors->sectorsCount());
+    st.visible = uint32_t(sectors->visibleCount());
+    }
+  st.culled = sectorCulled.load(std::memory_order_relaxed);
+  return st;
+  }
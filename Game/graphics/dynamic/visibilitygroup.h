@@ -1,12 +1,15 @@
 #pragma once
 
 #include <Tempest/Matrix4x4>
+#include <atomic>
 #include <cstdint>
+#include <vector>
 
 #include "graphics/sceneglobals.h"
 #include "graphics/bounds.h"
 
 class Frustrum;
+class SectorVisibility;
 
 class VisibilityGroup {
   public:
@@ -33,18 +36,85 @@ class VisibilityGroup {
       friend class VisibilityGroup;
       };
 
-    Token get();
+    struct Stats {
+      uint32_t sectors = 0;
+      uint32_t visible = 0;
+      uint32_t culled  = 0;
+      };
+
+    // static tokens are culled hierarchically; static token, that moves after tree build, becomes a mover
+    Token get(bool isStatic);
     void  pass(const Tempest::Matrix4x4& main, const Tempest::Matrix4x4* sh, size_t shCount);
+    // fold static tokens, created since last build, into tree on next pass; until then they are culled as movers
+    void  rebuildStaticTree();
+    // portal occlusion for main camera; sectors must be updated before pass
+    void  setSectors(const SectorVisibility* s);
+    Stats stats() const;
 
   private:
+    enum Kind : uint8_t {
+      K_Free,
+      K_Static,
+      K_Dynamic,
+      };
+
+    enum {
+      PACKET_SIZE = 4,
+      // subtrees, culled in parallel
+      MIN_ROOTS   = 64,
+      };
+
     struct Tok {
       Tempest::Matrix4x4 pos;
       Bounds             bbox;
+      Kind               kind   = K_Free;
+      bool               inTree = false;
+      int32_t            sector = -1;
       bool               visible[SceneGlobals::V_Count] = {};
       };
 
-    std::vector<Tok>    tokens;
-    std::vector<size_t> freeList;
+    // leaf of tree: bounding spheres of up to 4 tokens, in SoA layout for Frustrum::testPoints
+    struct Packet {
+      float    x[PACKET_SIZE] = {};
+      float    y[PACKET_SIZE] = {};
+      float    z[PACKET_SIZE] = {};
+      float    r[PACKET_SIZE] = {};
+      uint32_t id[PACKET_SIZE] = {};
+      uint8_t  size = 0;
+      };
+
+    // children are at [left,left+1]; packets of subtree are [pktBegin,pktEnd)
+    struct Node {
+      Tempest::Vec3 mid;
+      float         r        = 0;
+      uint32_t      left     = 0;
+      uint32_t      pktBegin = 0;
+      uint32_t      pktEnd   = 0;
+      };
+
+    void     free(size_t id);
+    void     onMove(Tok& t);
+
+    void     buildTree();
+    void     buildNode(uint32_t node, uint32_t* b, uint32_t* e);
+    void     buildMovers();
+
+    void     cullNode  (const Frustrum* f, uint32_t node, uint8_t partial, uint8_t inside);
+    void     cullPacket(const Frustrum* f, const Packet& p, uint8_t partial, uint8_t inside);
+
+    std::vector<Tok>        tokens;
+    std::vector<size_t>     freeList;
+
+    std::vector<Node>       nodes;
+    std::vector<Packet>     packets;
+    std::vector<uint32_t>   roots;
+    std::vector<uint32_t>   movers;
+    // onMove is called from worker threads (npc attachments)
+    std::atomic<bool>       treeDirty{false};
+    std::atomic<bool>       moversDirty{false};
+
+    const SectorVisibility* sectors = nullptr;
+    std::atomic<uint32_t>   sectorCulled{0};
   };
 
 inline bool VisibilityGroup::Token::isVisible(SceneGlobals::VisCamera c) const {
@@ -113,8 +113,8 @@ void Effect::syncAttachesSingle(const Matrix4x4& inPos) {
 
   pos = inPos;
   auto p = inPos;
-  if(pose!=nullptr && boneId<pose->transform().size())
-    p.mul(pose->transform(boneId));
+  if(pose!=nullptr && boneId<pose->renderTransform().size())
+    p.mul(pose->renderTransform(boneId));
 
   const float emTrjEaseVel = root==nullptr ? 0.f : root->handle().emTrjTargetElev;
   p.set(3,1, p.at(3,1)+emTrjEaseVel);
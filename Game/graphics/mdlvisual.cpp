@@ -436,11 +436,6 @@ bool MdlVisual::updateAnimation(Npc* npc, World& world) {
   uint64_t tickCount = world.tickCount();
   auto     pos3      = Vec3{pos.at(3,0), pos.at(3,1), pos.at(3,2)};
 
-  if(npc!=nullptr && world.isInSfxRange(pos3))
-    pose.processSfx(*npc,tickCount);
-  if(world.isInPfxRange(pos3))
-    pose.processPfx(*this,world,tickCount);
-
   for(size_t i=0;i<effects.size();) {
     if(effects[i].timeUntil<tickCount) {
       effects[i] = std::move(effects.back());
@@ -451,7 +446,48 @@ bool MdlVisual::updateAnimation(Npc* npc, World& world) {
     }
 
   solver.update(tickCount);
-  const bool changed = pose.update(tickCount);
+
+  if(npc!=nullptr) {
+    // world transform is updated every frame anyway, only bone palette is throttled
+    auto&    lod      = world.animLod();
+    float    dist     = (world.cameraPosition()-pos3).quadLength();
+    uint64_t interval = 0;
+
+    aniLod = LodFull;
+    if(dist>lod.lowDist*lod.lowDist) {
+      aniLod   = LodLow;
+      interval = lod.lowInterval;
+      }
+    else if(dist>lod.reducedDist*lod.reducedDist) {
+      aniLod   = LodReduced;
+      interval = lod.reducedInterval;
+      }
+    pose.setDetailBones(aniLod==LodFull);
+    if(tickCount<aniUpdate+interval) {
+      // in between of throttled steps: blend two last palettes
+      if(!pose.blendKeyFrames(tickCount))
+        return false;
+      syncAttaches();
+      view.setPose(pose,pos);
+      return true;
+      }
+    }
+  aniUpdate = tickCount;
+
+  // events window is [lastUpdate,tickCount]: must be processed together with pose.update, once per throttled step
+  if(npc!=nullptr && world.isInSfxRange(pos3))
+    pose.processSfx(*npc,tickCount);
+  if(world.isInPfxRange(pos3))
+    pose.processPfx(*this,world,tickCount);
+
+  bool changed = pose.update(tickCount);
+  if(npc!=nullptr && aniLod!=LodFull) {
+    pose.pushKeyFrame(changed,tickCount);
+    changed = true;
+    }
+  else if(npc!=nullptr) {
+    pose.resetKeyFrames();
+    }
 
   if(changed) {
     syncAttaches();
@@ -793,8 +829,8 @@ void MdlVisual::syncAttaches() {
   if(torch.view!=nullptr) {
     auto& pose = *skInst;
     auto  p    = pos;
-    if(torch.boneId<pose.transform().size())
-      p.mul(pose.transform(torch.boneId));
+    if(torch.boneId<pose.renderTransform().size())
+      p.mul(pose.renderTransform(torch.boneId));
     torch.view->setObjMatrix(p);
     }
   }
@@ -808,9 +844,10 @@ void MdlVisual::syncAttaches(Attach<View>& att) {
   auto& pose = *skInst;
   if(att.view.isEmpty())
     return;
+  // attached meshes follow the body on screen
   auto p = pos;
-  if(att.boneId<pose.transform().size())
-    p.mul(pose.transform(att.boneId));
+  if(att.boneId<pose.renderTransform().size())
+    p.mul(pose.renderTransform(att.boneId));
   att.view.setObjMatrix(p);
   }
 
@@ -22,6 +22,14 @@ class MdlVisual final {
     MdlVisual& operator = (MdlVisual&&) = default;
     ~MdlVisual();
 
+    // skeletal animation level-of-detail, by distance to camera (see WorldObjects::AnimLod);
+    // throttled palettes are blended on frames in between
+    enum AnimLod : uint8_t {
+      LodFull,    // every frame, all bones
+      LodReduced, // ~15 updates per second, no finger/toe bones
+      LodLow,     // ~5 updates per second, no finger/toe bones
+      };
+
     void                           save(Serialize& fout, const Npc& npc) const;
     void                           save(Serialize& fout, const Interactive& mob) const;
     void                           load(Serialize& fin,  Npc& npc);
@@ -70,6 +78,7 @@ class MdlVisual final {
 
     const Pose&                    pose() const { return *skInst; }
     bool                           updateAnimation(Npc* npc, World& world);
+    AnimLod                        animLod() const { return aniLod; }
     void                           processLayers  (World& world);
     auto                           mapBone(const size_t boneId) const -> Tempest::Vec3;
     auto                           mapWeaponBone() const -> Tempest::Vec3;
@@ -161,5 +170,8 @@ class MdlVisual final {
     WeaponState                    fgtMode=WeaponState::NoWeapon;
     AnimationSolver                solver;
     std::unique_ptr<Pose>          skInst;
+
+    AnimLod                        aniLod    = LodFull;
+    uint64_t                       aniUpdate = 0;
   };
 
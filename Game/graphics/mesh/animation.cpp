@@ -2,6 +2,7 @@
 
 #include <Tempest/Log>
 #include <cctype>
+#include <algorithm>
 
 #include <zenload/modelAnimationParser.h>
 #include <zenload/zCModelPrototype.h>
@@ -195,6 +196,28 @@ void Animation::debug() const {
     Log::d(i.name);
   }
 
+size_t Animation::samplesMemory() const {
+  // aliases and combos share data with their source sequence
+  std::vector<const AnimData*> data;
+  for(auto& i:sequences)
+    if(i.data!=nullptr)
+      data.push_back(i.data.get());
+  std::sort(data.begin(),data.end());
+  data.erase(std::unique(data.begin(),data.end()),data.end());
+
+  size_t ret = 0;
+  for(auto i:data)
+    ret += i->samplesMemory();
+  return ret;
+  }
+
+void Animation::compress() {
+  static_assert(SAMPLE_TRACKS==PackedAnim::TRACKS,"PackedAnim must decode all sample tracks");
+  for(auto& i:sequences)
+    if(i.data!=nullptr)
+      i.data->compress(PackedAnim::ROT_TOLERANCE,PackedAnim::POS_TOLERANCE);
+  }
+
 Animation::Sequence& Animation::loadMAN(const std::string& name) {
   sequences.emplace_back(name);
   auto& ret = sequences.back();
@@ -278,12 +301,14 @@ Animation::Sequence::Sequence(const std::string &fname) {
   ZenLoad::ZenParser            zen(fname,idx);
   ZenLoad::ModelAnimationParser p(zen);
 
+  std::vector<ZenLoad::zCModelAniSample> aos;
   data = std::make_shared<AnimData>();
   while(true) {
     ZenLoad::ModelAnimationParser::EChunkType type = p.parse();
     switch(type) {
       case ZenLoad::ModelAnimationParser::CHUNK_EOF:{
-        setupMoveTr();
+        data->setupMoveTr(aos);
+        data->setupSamples(aos);
         return;
         }
       case ZenLoad::ModelAnimationParser::CHUNK_HEADER: {
@@ -295,7 +320,7 @@ Animation::Sequence::Sequence(const std::string &fname) {
         }
       case ZenLoad::ModelAnimationParser::CHUNK_RAWDATA:
         data->nodeIndex = std::move(p.getNodeIndex());
-        data->samples   = p.getSamples();
+        aos             = p.getSamples();
         break;
       case ZenLoad::ModelAnimationParser::CHUNK_ERROR:
         throw std::runtime_error("animation load error");
@@ -599,24 +624,79 @@ void Animation::Sequence::schemeName(char scheme[]) const {
     }
   }
 
-void Animation::Sequence::setupMoveTr() {
-  data->setupMoveTr();
+const float* Animation::AnimData::frame(size_t f, std::vector<float>& tmp) const {
+  if(packed==nullptr)
+    return &samples[f*stride*SAMPLE_TRACKS];
+  tmp.resize(stride*SAMPLE_TRACKS);
+  packed->frame(f,tmp.data());
+  return tmp.data();
+  }
+
+size_t Animation::AnimData::frameCount() const {
+  if(packed!=nullptr)
+    return packed->frameCount();
+  if(stride==0)
+    return 0;
+  return samples.size()/(stride*SAMPLE_TRACKS);
+  }
+
+size_t Animation::AnimData::samplesMemory() const {
+  if(packed!=nullptr)
+    return packed->memoryUsage();
+  return samples.size()*sizeof(float);
+  }
+
+void Animation::AnimData::compress(float rotTolerance, float posTolerance) {
+  const size_t frames = frameCount();
+  if(packed!=nullptr || !PackedAnim::canPack(frames))
+    return;
+  packed.reset(new PackedAnim(samples.data(),frames,nodeIndex.size(),stride,rotTolerance,posTolerance));
+  samples = std::vector<float>();
+  }
+
+void Animation::AnimData::setupSamples(const std::vector<ZenLoad::zCModelAniSample>& aos) {
+  const size_t sz = nodeIndex.size();
+  if(sz==0 || aos.size()%sz!=0)
+    return;
+
+  const size_t frames = aos.size()/sz;
+  stride = ((sz+SAMPLE_ALIGN-1)/SAMPLE_ALIGN)*SAMPLE_ALIGN;
+  samples.resize(frames*stride*SAMPLE_TRACKS);
+
+  for(size_t f=0; f<frames; ++f) {
+    float* dst = &samples[f*stride*SAMPLE_TRACKS];
+    for(size_t i=0; i<stride; ++i) {
+      if(i>=sz) {
+        // padding: identity rotation keeps blending math finite
+        dst[3*stride+i] = 1.f;
+        continue;
+        }
+      auto& s = aos[f*sz+i];
+      dst[0*stride+i] = s.rotation.x;
+      dst[1*stride+i] = s.rotation.y;
+      dst[2*stride+i] = s.rotation.z;
+      dst[3*stride+i] = s.rotation.w;
+      dst[4*stride+i] = s.position.x;
+      dst[5*stride+i] = s.position.y;
+      dst[6*stride+i] = s.position.z;
+      }
+    }
   }
 
-void Animation::AnimData::setupMoveTr() {
+void Animation::AnimData::setupMoveTr(const std::vector<ZenLoad::zCModelAniSample>& aos) {
   size_t sz = nodeIndex.size();
 
-  if(samples.size()>0 && samples.size()>=sz) {
-    auto& a = samples[0].position;
-    auto& b = samples[samples.size()-sz].position;
+  if(aos.size()>0 && aos.size()>=sz) {
+    auto& a = aos[0].position;
+    auto& b = aos[aos.size()-sz].position;
     moveTr.x = b.x-a.x;
     moveTr.y = b.y-a.y;
     moveTr.z = b.z-a.z;
 
-    tr.resize(samples.size()/sz);
-    for(size_t i=0,r=0;i<samples.size();i+=sz,++r){
+    tr.resize(aos.size()/sz);
+    for(size_t i=0,r=0;i<aos.size();i+=sz,++r){
       auto& p  = tr[r];
-      auto& bi = samples[i].position;
+      auto& bi = aos[i].position;
       p.x = bi.x-a.x;
       p.y = bi.y-a.y;
       p.z = bi.z-a.z;
@@ -630,10 +710,10 @@ void Animation::AnimData::setupMoveTr() {
       }
     }
 
-  if(samples.size()>0){
-    translate.x = samples[0].position.x;
-    translate.y = samples[0].position.y;
-    translate.z = samples[0].position.z;
+  if(aos.size()>0){
+    translate.x = aos[0].position.x;
+    translate.y = aos[0].position.y;
+    translate.z = aos[0].position.z;
     }
   }
 
@@ -4,6 +4,8 @@
 #include <Tempest/Vec>
 #include <memory>
 
+#include "packedanim.h"
+
 class Npc;
 class MdlVisual;
 class World;
@@ -19,6 +21,11 @@ class Animation final {
       Idle         = 0x00000010
       };
 
+    enum {
+      SAMPLE_TRACKS = 7,
+      SAMPLE_ALIGN  = 4,
+      };
+
     enum AnimClass : uint8_t {
       UnknownAnim=0,
       Transition,
@@ -43,7 +50,11 @@ class Animation final {
       Tempest::Vec3                               translate={};
       Tempest::Vec3                               moveTr={};
 
-      std::vector<ZenLoad::zCModelAniSample>      samples;
+      // samples in SoA layout: per frame 7 tracks (rotation xyzw, position xyz), each track is
+      // `stride` floats - node count, padded to SIMD width
+      std::vector<float>                          samples;
+      size_t                                      stride    =0;
+      std::unique_ptr<PackedAnim>                 packed;   // replaces `samples`, if compressed
       std::vector<uint32_t>                       nodeIndex;
       std::vector<Tempest::Vec3>                  tr;
       bool                                        hasMoveTr=false;
@@ -63,7 +74,14 @@ class Animation final {
       std::vector<uint64_t>                       defParFrame;
       std::vector<uint64_t>                       defWindow;
 
-      void                                        setupMoveTr();
+      // pointer to SoA frame; compressed frames are decoded into `tmp`
+      const float*                                frame(size_t f, std::vector<float>& tmp) const;
+      size_t                                      frameCount() const;
+      size_t                                      samplesMemory() const;
+      void                                        compress(float rotTolerance, float posTolerance);
+
+      void                                        setupSamples(const std::vector<ZenLoad::zCModelAniSample>& aos);
+      void                                        setupMoveTr(const std::vector<ZenLoad::zCModelAniSample>& aos);
       void                                        setupEvents(float fpsRate);
       };
 
@@ -107,7 +125,6 @@ class Animation final {
       std::shared_ptr<AnimData>              data;
 
       private:
-        void                                 setupMoveTr();
         static void                          processEvent(const ZenLoad::zCModelEvent& e, EvCount& ev, uint64_t time);
         bool                                 extractFrames(uint64_t &frameA, uint64_t &frameB, bool &invert, uint64_t barrier, uint64_t sTime, uint64_t now) const;
       };
@@ -118,6 +135,9 @@ class Animation final {
     const Sequence *sequenceAsc(const char* name) const;
     void            debug() const;
 
+    size_t          samplesMemory() const;
+    void            compress();
+
   private:
     Sequence& loadMAN(const std::string &name);
     void      setupIndex();
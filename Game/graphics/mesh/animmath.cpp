@@ -1,7 +1,16 @@
 #include "animmath.h"
 
+#include <algorithm>
 #include <cmath>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#include <emmintrin.h>
+#define ANIM_SSE
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define ANIM_NEON
+#endif
+
 static float mix(float x,float y,float a){
   return x+(y-x)*a;
   }
@@ -70,8 +79,8 @@ ZenLoad::zCModelAniSample mix(const ZenLoad::zCModelAniSample& x,const ZenLoad::
   return r;
   }
 
-static Tempest::Matrix4x4 mkMatrix(float x,float y,float z,float w,
-                                   float px,float py,float pz) {
+Tempest::Matrix4x4 mkMatrix(float x,float y,float z,float w,
+                            float px,float py,float pz) {
   float m[4][4]={};
 
   m[0][0] = w * w + x * x - y * y - z * z;
@@ -95,3 +104,181 @@ Tempest::Matrix4x4 mkMatrix(const ZenLoad::zCModelAniSample& s) {
   return mkMatrix(s.rotation.x,s.rotation.y,s.rotation.z,s.rotation.w,
                   s.position.x,s.position.y,s.position.z);
   }
+
+void decompose(const Tempest::Matrix4x4& m, size_t id, size_t stride, float* out) {
+  // same element order as in mkMatrix: at(i,j) is m[i][j]
+  const float m00 = m.at(0,0), m01 = m.at(0,1), m02 = m.at(0,2);
+  const float m10 = m.at(1,0), m11 = m.at(1,1), m12 = m.at(1,2);
+  const float m20 = m.at(2,0), m21 = m.at(2,1), m22 = m.at(2,2);
+  const float tr  = m00+m11+m22;
+
+  float x, y, z, w;
+  if(tr>0) {
+    const float s = std::sqrt(tr+1.f)*2.f;
+    w = 0.25f*s;
+    x = (m21-m12)/s;
+    y = (m02-m20)/s;
+    z = (m10-m01)/s;
+    }
+  else if(m00>m11 && m00>m22) {
+    const float s = std::sqrt(1.f+m00-m11-m22)*2.f;
+    w = (m21-m12)/s;
+    x = 0.25f*s;
+    y = (m01+m10)/s;
+    z = (m02+m20)/s;
+    }
+  else if(m11>m22) {
+    const float s = std::sqrt(1.f+m11-m00-m22)*2.f;
+    w = (m02-m20)/s;
+    x = (m01+m10)/s;
+    y = 0.25f*s;
+    z = (m12+m21)/s;
+    }
+  else {
+    const float s = std::sqrt(1.f+m22-m00-m11)*2.f;
+    w = (m10-m01)/s;
+    x = (m02+m20)/s;
+    y = (m12+m21)/s;
+    z = 0.25f*s;
+    }
+
+  out[0*stride+id] = x;
+  out[1*stride+id] = y;
+  out[2*stride+id] = z;
+  out[3*stride+id] = w;
+  out[4*stride+id] = m.at(3,0);
+  out[5*stride+id] = m.at(3,1);
+  out[6*stride+id] = m.at(3,2);
+  }
+
+namespace {
+#if defined(ANIM_SSE)
+using F4 = __m128;
+inline F4   load (const float* p)   { return _mm_loadu_ps(p);   }
+inline void store(float* p, F4 v)   { _mm_storeu_ps(p,v);       }
+inline F4   splat(float v)          { return _mm_set1_ps(v);    }
+inline F4   add  (F4 a, F4 b)       { return _mm_add_ps(a,b);   }
+inline F4   sub  (F4 a, F4 b)       { return _mm_sub_ps(a,b);   }
+inline F4   mul  (F4 a, F4 b)       { return _mm_mul_ps(a,b);   }
+inline F4   div  (F4 a, F4 b)       { return _mm_div_ps(a,b);   }
+inline F4   sqrt (F4 a)             { return _mm_sqrt_ps(a);    }
+inline F4   sign (F4 a)             { return _mm_and_ps(a,_mm_set1_ps(-0.f));    }
+inline F4   abs  (F4 a)             { return _mm_andnot_ps(_mm_set1_ps(-0.f),a); }
+inline F4   flip (F4 a, F4 sgn)     { return _mm_xor_ps(a,sgn); }
+inline int  less (F4 a, F4 b)       { return _mm_movemask_ps(_mm_cmplt_ps(a,b)); }
+#elif defined(ANIM_NEON)
+using F4 = float32x4_t;
+inline F4   load (const float* p)   { return vld1q_f32(p);      }
+inline void store(float* p, F4 v)   { vst1q_f32(p,v);           }
+inline F4   splat(float v)          { return vdupq_n_f32(v);    }
+inline F4   add  (F4 a, F4 b)       { return vaddq_f32(a,b);    }
+inline F4   sub  (F4 a, F4 b)       { return vsubq_f32(a,b);    }
+inline F4   mul  (F4 a, F4 b)       { return vmulq_f32(a,b);    }
+inline F4   div  (F4 a, F4 b)       { return vdivq_f32(a,b);    }
+inline F4   sqrt (F4 a)             { return vsqrtq_f32(a);     }
+inline F4   sign (F4 a)             { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a),vdupq_n_u32(0x80000000u))); }
+inline F4   abs  (F4 a)             { return vabsq_f32(a);      }
+inline F4   flip (F4 a, F4 sgn)     { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a),vreinterpretq_u32_f32(sgn))); }
+inline int  less (F4 a, F4 b)       {
+  uint32x4_t m = vcltq_f32(a,b);
+  return int((vgetq_lane_u32(m,0)&1u) | (vgetq_lane_u32(m,1)&2u) | (vgetq_lane_u32(m,2)&4u) | (vgetq_lane_u32(m,3)&8u));
+  }
+#else
+struct F4 { float v[4]; };
+template<class Fn>
+inline F4   map  (F4 a, F4 b, Fn fn) { F4 r; for(int i=0; i<4; ++i) r.v[i] = fn(a.v[i],b.v[i]); return r; }
+inline F4   load (const float* p)   { F4 r; for(int i=0; i<4; ++i) r.v[i] = p[i]; return r; }
+inline void store(float* p, F4 v)   { for(int i=0; i<4; ++i) p[i] = v.v[i]; }
+inline F4   splat(float v)          { return F4{{v,v,v,v}}; }
+inline F4   add  (F4 a, F4 b)       { return map(a,b,[](float x, float y){ return x+y; }); }
+inline F4   sub  (F4 a, F4 b)       { return map(a,b,[](float x, float y){ return x-y; }); }
+inline F4   mul  (F4 a, F4 b)       { return map(a,b,[](float x, float y){ return x*y; }); }
+inline F4   div  (F4 a, F4 b)       { return map(a,b,[](float x, float y){ return x/y; }); }
+inline F4   sqrt (F4 a)             { return map(a,a,[](float x, float)  { return std::sqrt(x); }); }
+inline F4   sign (F4 a)             { return map(a,a,[](float x, float)  { return std::signbit(x) ? -0.f : 0.f; }); }
+inline F4   abs  (F4 a)             { return map(a,a,[](float x, float)  { return std::fabs(x); }); }
+inline F4   flip (F4 a, F4 sgn)     { return map(a,sgn,[](float x, float s){ return std::signbit(s) ? -x : x; }); }
+inline int  less (F4 a, F4 b)       {
+  int m = 0;
+  for(int i=0; i<4; ++i)
+    if(a.v[i]<b.v[i])
+      m |= (1<<i);
+  return m;
+  }
+#endif
+}
+
+void mix(const float* x, const float* y, float a, size_t count, size_t stride, float* out) {
+  const F4 t  = splat(a);
+  const F4 t1 = splat(1.f-a);
+  const F4 nl = splat(0.95f);
+
+  // 4 nodes at once: nlerp for all lanes, exact slerp fixup for lanes with large angle
+  for(size_t i=0; i<count; i+=4) {
+    const F4 ax = load(x+0*stride+i), ay = load(x+1*stride+i), az = load(x+2*stride+i), aw = load(x+3*stride+i);
+    F4       bx = load(y+0*stride+i), by = load(y+1*stride+i), bz = load(y+2*stride+i), bw = load(y+3*stride+i);
+
+    F4 dot = add(add(mul(ax,bx),mul(ay,by)),add(mul(az,bz),mul(aw,bw)));
+    // shortest arc
+    const F4 sgn = sign(dot);
+    bx  = flip(bx,sgn);
+    by  = flip(by,sgn);
+    bz  = flip(bz,sgn);
+    bw  = flip(bw,sgn);
+    dot = abs(dot);
+
+    F4 qx = add(mul(ax,t1),mul(bx,t));
+    F4 qy = add(mul(ay,t1),mul(by,t));
+    F4 qz = add(mul(az,t1),mul(bz,t));
+    F4 qw = add(mul(aw,t1),mul(bw,t));
+    const F4 l = sqrt(add(add(mul(qx,qx),mul(qy,qy)),add(mul(qz,qz),mul(qw,qw))));
+    store(out+0*stride+i,div(qx,l));
+    store(out+1*stride+i,div(qy,l));
+    store(out+2*stride+i,div(qz,l));
+    store(out+3*stride+i,div(qw,l));
+
+    if(int m = less(dot,nl)) {
+      for(size_t r=0; r<4 && i+r<count; ++r) {
+        if((m&(1<<r))==0)
+          continue;
+        const size_t  id = i+r;
+        ZMath::float4 q1, q2;
+        q1.x = x[0*stride+id]; q1.y = x[1*stride+id]; q1.z = x[2*stride+id]; q1.w = x[3*stride+id];
+        q2.x = y[0*stride+id]; q2.y = y[1*stride+id]; q2.z = y[2*stride+id]; q2.w = y[3*stride+id];
+        auto q = slerp(q1,q2,a);
+        out[0*stride+id] = q.x;
+        out[1*stride+id] = q.y;
+        out[2*stride+id] = q.z;
+        out[3*stride+id] = q.w;
+        }
+      }
+
+    for(size_t k=4; k<7; ++k) {
+      const F4 pa = load(x+k*stride+i);
+      const F4 pb = load(y+k*stride+i);
+      store(out+k*stride+i,add(pa,mul(sub(pb,pa),t)));
+      }
+    }
+  }
+
+std::vector<size_t> parentsFirst(const std::vector<size_t>& parent) {
+  std::vector<std::vector<size_t>> child(parent.size());
+  std::vector<size_t>              stk, order;
+  for(size_t i=0;i<parent.size();++i) {
+    if(parent[i]==size_t(-1))
+      stk.push_back(i);
+    else if(parent[i]<parent.size())
+      child[parent[i]].push_back(i);
+    }
+  std::reverse(stk.begin(),stk.end());
+
+  order.reserve(parent.size());
+  while(!stk.empty()) {
+    size_t id = stk.back();
+    stk.pop_back();
+    order.push_back(id);
+    for(auto c=child[id].rbegin(); c!=child[id].rend(); ++c)
+      stk.push_back(*c);
+    }
+  return order;
+  }
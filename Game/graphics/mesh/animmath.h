@@ -3,6 +3,17 @@
 #include <zenload/zTypes.h>
 #include <Tempest/Matrix4x4>
 #include <Tempest/Point>
+#include <cstddef>
+#include <vector>
 
 ZenLoad::zCModelAniSample mix(const ZenLoad::zCModelAniSample& x,const ZenLoad::zCModelAniSample& y,float a);
 Tempest::Matrix4x4        mkMatrix(const ZenLoad::zCModelAniSample& s);
+Tempest::Matrix4x4        mkMatrix(float x, float y, float z, float w, float px, float py, float pz);
+
+// blends two frames in SoA layout (see Animation::AnimData::samples); stride must be multiple of 4
+void                      mix(const float* x, const float* y, float a, size_t count, size_t stride, float* out);
+// inverse of mkMatrix for rigid transform: writes quaternion and translation of node `id` into SoA frame
+void                      decompose(const Tempest::Matrix4x4& m, size_t id, size_t stride, float* out);
+// depth-first order of nodes from roots (parent is size_t(-1)), parents before children;
+// nodes with broken parent link are not reachable
+std::vector<size_t>       parentsFirst(const std::vector<size_t>& parent);
@@ -18,6 +18,8 @@ Landscape::Landscape(WorldView& owner, VisualObjects& visual, const PackedMesh &
   Matrix4x4 ident;
   ident.identity();
 
+  // landscape lives as long as the world: textures are evictable after world change
+  Resources::OwnedScope scope;
   for(auto& i:mesh.subMeshes) {
     auto material = Resources::loadMaterial(i.material,true);
     if(material.alpha==Material::AdditiveLight || i.indices.size()==0)
@@ -0,0 +1,258 @@
+#include "packedanim.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float    sqrt2     = 1.41421356f;
+static const uint16_t rotMask   = 0x7FFF;
+static const float    rotScale  = float(rotMask);
+// decode: v/rotScale*2-1, then /sqrt2 - as one multiply-add
+static const float    rotDecMul = 2.f/(rotScale*sqrt2);
+static const float    rotDecAdd = -1.f/sqrt2;
+
+constexpr float PackedAnim::ROT_TOLERANCE;
+constexpr float PackedAnim::POS_TOLERANCE;
+
+namespace {
+struct Quat final {
+  float v[4] = {};
+  };
+}
+
+static Quat loadQuat(const float* soa, size_t stride, size_t frame, size_t node) {
+  const float* f = soa + frame*stride*PackedAnim::TRACKS;
+  Quat q;
+  for(size_t i=0; i<4; ++i)
+    q.v[i] = f[i*stride+node];
+  return q;
+  }
+
+static float dot(const Quat& a, const Quat& b) {
+  return a.v[0]*b.v[0] + a.v[1]*b.v[1] + a.v[2]*b.v[2] + a.v[3]*b.v[3];
+  }
+
+static Quat nlerp(const Quat& a, const Quat& b, float t) {
+  const float sgn = dot(a,b)<0 ? -1.f : 1.f;
+  Quat  r;
+  float l = 0;
+  for(size_t i=0; i<4; ++i) {
+    r.v[i] = a.v[i]*(1.f-t) + b.v[i]*sgn*t;
+    l += r.v[i]*r.v[i];
+    }
+  if(l>0) {
+    l = 1.f/std::sqrt(l);
+    for(auto& i:r.v)
+      i*=l;
+    }
+  return r;
+  }
+
+static void encodeQuat(Quat q, uint16_t* dst) {
+  float l = std::sqrt(dot(q,q));
+  if(l>0)
+    for(auto& i:q.v)
+      i/=l;
+
+  size_t big = 0;
+  for(size_t i=1; i<4; ++i)
+    if(std::fabs(q.v[i])>std::fabs(q.v[big]))
+      big = i;
+  // q and -q are same rotation: keep largest component positive, so it can be restored from the rest
+  const float sgn = q.v[big]<0 ? -1.f : 1.f;
+  for(size_t i=0, r=0; i<4; ++i) {
+    if(i==big)
+      continue;
+    float v = (q.v[i]*sgn*sqrt2)*0.5f+0.5f;
+    v = std::max(0.f,std::min(1.f,v));
+    dst[r] = uint16_t(std::lround(v*rotScale));
+    ++r;
+    }
+  dst[0] = uint16_t(dst[0] | ((big&1)<<15));
+  dst[1] = uint16_t(dst[1] | ((big>>1)<<15));
+  }
+
+static Quat decodeQuat(const uint16_t* src) {
+  const size_t big = size_t(src[0]>>15) | size_t(src[1]>>15)<<1;
+  Quat  q;
+  float sum = 0;
+  for(size_t i=0, r=0; i<4; ++i) {
+    if(i==big)
+      continue;
+    float v = float(src[r]&rotMask)*rotDecMul+rotDecAdd;
+    q.v[i] = v;
+    sum   += v*v;
+    ++r;
+    }
+  q.v[big] = std::sqrt(std::max(0.f,1.f-sum));
+  return q;
+  }
+
+PackedAnim::PackedAnim(const float* soa, size_t frames, size_t count, size_t stride,
+                       float rotTolerance, float posTolerance)
+  :frames(frames), count(count), stride(stride) {
+  rotTrack.resize(count);
+  posTrack.resize(count);
+  posRange.resize(count*6);
+  for(size_t i=0; i<count; ++i) {
+    packRot(soa,i,rotTolerance);
+    packPos(soa,i,posTolerance);
+    }
+  }
+
+template<class Fn>
+void PackedAnim::selectKeys(size_t frames, std::vector<uint16_t>& keys, Fn ok) {
+  auto fits = [&ok](size_t a, size_t b) {
+    for(size_t m=a+1; m<b; ++m)
+      if(!ok(a,b,m))
+        return false;
+    return true;
+    };
+
+  keys.clear();
+  keys.push_back(0);
+  if(frames<=1)
+    return;
+
+  bool constant = true;
+  for(size_t m=1; m<frames && constant; ++m)
+    constant = ok(0,0,m);
+  if(constant)
+    return;
+
+  const size_t last = frames-1;
+  if(fits(0,last)) {
+    keys.push_back(uint16_t(last));
+    return;
+    }
+
+  size_t k = 0;
+  while(k<last) {
+    size_t j = k+1;
+    for(size_t e=k+2; e<=last && e<=k+MAX_SPAN; ++e) {
+      if(!fits(k,e))
+        break;
+      j = e;
+      }
+    keys.push_back(uint16_t(j));
+    k = j;
+    }
+  }
+
+void PackedAnim::packRot(const float* soa, size_t node, float tolerance) {
+  const float minDot = std::cos(tolerance*0.5f);
+  auto ok = [&](size_t a, size_t b, size_t m) {
+    const float t  = (a==b) ? 0.f : float(m-a)/float(b-a);
+    const Quat  qi = nlerp(loadQuat(soa,stride,a,node),loadQuat(soa,stride,b,node),t);
+    const Quat  qm = loadQuat(soa,stride,m,node);
+    const float lm = std::sqrt(dot(qm,qm));
+    return lm<=0 || std::fabs(dot(qi,qm))/lm>=minDot;
+    };
+
+  std::vector<uint16_t> keys;
+  selectKeys(frames,keys,ok);
+
+  auto& t = rotTrack[node];
+  t.first = uint32_t(rotFrame.size());
+  t.count = uint32_t(keys.size());
+  for(auto k:keys) {
+    uint16_t enc[3] = {};
+    encodeQuat(loadQuat(soa,stride,k,node),enc);
+    rotFrame.push_back(k);
+    rot.insert(rot.end(),enc,enc+3);
+    }
+  }
+
+void PackedAnim::packPos(const float* soa, size_t node, float tolerance) {
+  auto at = [&](size_t frame, size_t c) {
+    return soa[frame*stride*TRACKS + (4+c)*stride + node];
+    };
+  auto ok = [&](size_t a, size_t b, size_t m) {
+    const float t = (a==b) ? 0.f : float(m-a)/float(b-a);
+    for(size_t c=0; c<3; ++c) {
+      const float v = at(a,c) + (at(b,c)-at(a,c))*t;
+      if(std::fabs(v-at(m,c))>tolerance)
+        return false;
+      }
+    return true;
+    };
+
+  std::vector<uint16_t> keys;
+  selectKeys(frames,keys,ok);
+
+  float* range = &posRange[node*6];
+  for(size_t c=0; c<3; ++c) {
+    float mn = at(keys[0],c), mx = mn;
+    for(auto k:keys) {
+      mn = std::min(mn,at(k,c));
+      mx = std::max(mx,at(k,c));
+      }
+    range[c]   = mn;
+    range[c+3] = (mx-mn)/65535.f;
+    }
+
+  auto& t = posTrack[node];
+  t.first = uint32_t(posFrame.size());
+  t.count = uint32_t(keys.size());
+  for(auto k:keys) {
+    posFrame.push_back(k);
+    for(size_t c=0; c<3; ++c) {
+      const float step = range[c+3];
+      const float v    = step>0 ? (at(k,c)-range[c])/step : 0.f;
+      pos.push_back(uint16_t(std::lround(std::max(0.f,std::min(65535.f,v)))));
+      }
+    }
+  }
+
+size_t PackedAnim::findKey(const uint16_t* k, size_t cnt, size_t f) {
+  // last key, that is not after `f`
+  auto it = std::upper_bound(k,k+cnt,f);
+  if(it==k)
+    return 0;
+  return size_t(it-k)-1;
+  }
+
+void PackedAnim::frame(size_t f, float* out) const {
+  for(size_t i=0; i<count; ++i) {
+    const Track&    rt = rotTrack[i];
+    const uint16_t* rf = &rotFrame[rt.first];
+    const size_t    rk = findKey(rf,rt.count,f);
+    Quat q = decodeQuat(&rot[(rt.first+rk)*3]);
+    if(rk+1<rt.count) {
+      const float t = float(f-rf[rk])/float(rf[rk+1]-rf[rk]);
+      q = nlerp(q,decodeQuat(&rot[(rt.first+rk+1)*3]),t);
+      }
+    for(size_t c=0; c<4; ++c)
+      out[c*stride+i] = q.v[c];
+
+    const Track&    pt    = posTrack[i];
+    const uint16_t* pf    = &posFrame[pt.first];
+    const size_t    pk    = findKey(pf,pt.count,f);
+    const float*    range = &posRange[i*6];
+    const uint16_t* p0    = &pos[(pt.first+pk)*3];
+    if(pk+1<pt.count) {
+      const uint16_t* p1 = p0+3;
+      const float     t  = float(f-pf[pk])/float(pf[pk+1]-pf[pk]);
+      for(size_t c=0; c<3; ++c) {
+        const float a = float(p0[c]), b = float(p1[c]);
+        out[(4+c)*stride+i] = range[c] + (a+(b-a)*t)*range[c+3];
+        }
+      } else {
+      for(size_t c=0; c<3; ++c)
+        out[(4+c)*stride+i] = range[c] + float(p0[c])*range[c+3];
+      }
+    }
+
+  // padding: identity, same as in uncompressed samples
+  for(size_t i=count; i<stride; ++i) {
+    for(size_t c=0; c<TRACKS; ++c)
+      out[c*stride+i] = 0.f;
+    out[3*stride+i] = 1.f;
+    }
+  }
+
+size_t PackedAnim::memoryUsage() const {
+  return sizeof(*this) +
+         (rotTrack.size()+posTrack.size())*sizeof(Track) +
+         (rotFrame.size()+posFrame.size()+rot.size()+pos.size())*sizeof(uint16_t) +
+         posRange.size()*sizeof(float);
+  }
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Lossy compressed animation samples.
+// Rotations are stored as smallest-three quantized quaternions, positions are quantized within
+// per-track bounds. Keyframes are dropped, while linear interpolation of the remaining ones stays
+// within tolerance, so constant and linear tracks collapse to one or two keys.
+class PackedAnim final {
+  public:
+    // soa - samples in Animation::AnimData layout
+    PackedAnim(const float* soa, size_t frames, size_t count, size_t stride, float rotTolerance, float posTolerance);
+
+    // decodes frame `f` into SoA layout with the same stride
+    void   frame(size_t f, float* out) const;
+    size_t frameCount()  const { return frames; }
+    size_t memoryUsage() const;
+
+    static bool canPack(size_t frames) { return frames>0 && frames<=MAX_FRAMES; }
+
+    enum {
+      TRACKS = 7, // quaternion xyzw, position xyz; as Animation::SAMPLE_TRACKS
+      };
+    // ~0.1 degree and 1mm: below what is visible on the screen
+    static constexpr float ROT_TOLERANCE = 0.002f;
+    static constexpr float POS_TOLERANCE = 0.1f;
+
+  private:
+    enum {
+      MAX_FRAMES = 0xFFFF,
+      MAX_SPAN   = 16,
+      };
+
+    struct Track final {
+      uint32_t first = 0;
+      uint32_t count = 0;
+      };
+
+    void packRot(const float* soa, size_t node, float tolerance);
+    void packPos(const float* soa, size_t node, float tolerance);
+
+    template<class Fn>
+    static void selectKeys(size_t frames, std::vector<uint16_t>& keys, Fn err);
+    static size_t findKey(const uint16_t* k, size_t cnt, size_t f);
+
+    size_t                frames = 0;
+    size_t                count  = 0;
+    size_t                stride = 0;
+
+    std::vector<Track>    rotTrack, posTrack;
+    std::vector<uint16_t> rotFrame, posFrame;
+    std::vector<uint16_t> rot;      // 3 words per key
+    std::vector<uint16_t> pos;      // 3 words per key
+    std::vector<float>    posRange; // per track: min xyz, step xyz
+  };
@@ -8,6 +8,7 @@
 #include "skeleton.h"
 #include "animmath.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace Tempest;
@@ -112,6 +113,7 @@ void Pose::setSkeleton(const Skeleton* sk) {
   base = tr;
   for(size_t i=0;i<base.size() && i<skeleton->nodes.size();++i)
     base[i] = skeleton->nodes[i].tr;
+  resetKeyFrames();
 
   trY = skeleton->rootTr[1];
 
@@ -297,12 +299,70 @@ bool Pose::update(uint64_t tickCount) {
   return false;
   }
 
+void Pose::pushKeyFrame(bool changed, uint64_t tickCount) {
+  const size_t stride = (tr.size()+3)/4*4;
+  if(stride!=keyStride) {
+    keyStride = stride;
+    keyTime[1] = 0;
+    }
+
+  std::swap(key[0],key[1]);
+  keyTime[0] = keyTime[1];
+  keyTime[1] = tickCount;
+  keySame    = (!changed && keyTime[0]!=0);
+  if(keySame) {
+    key[1] = key[0];
+    } else {
+    // padding is identity, so SIMD lanes past the last bone stay finite
+    key[1].assign(stride*Animation::SAMPLE_TRACKS,0.f);
+    std::fill(key[1].begin()+ptrdiff_t(3*stride),key[1].begin()+ptrdiff_t(4*stride),1.f);
+    for(size_t i=0; i<tr.size(); ++i)
+      decompose(tr[i],i,stride,key[1].data());
+    }
+
+  if(keyTime[0]!=0)
+    mkRenderPalette(key[0]);
+  }
+
+bool Pose::blendKeyFrames(uint64_t tickCount) {
+  if(!hasRenderPalette() || keyTime[1]<=keyTime[0])
+    return false;
+  if(keySame)
+    return false; // palette on screen is the last key already
+  const float a = std::min(1.f,float(tickCount-keyTime[1])/float(keyTime[1]-keyTime[0]));
+  // nlerp of rotations and lerp of translations: bones stay rigid, unlike elementwise blend of matrices
+  static thread_local std::vector<float> smp;
+  smp.resize(keyStride*Animation::SAMPLE_TRACKS);
+  mix(key[0].data(),key[1].data(),a,tr.size(),keyStride,smp.data());
+  mkRenderPalette(smp);
+  return true;
+  }
+
+void Pose::resetKeyFrames() {
+  keyTime[0] = 0;
+  keyTime[1] = 0;
+  keySame    = false;
+  }
+
+bool Pose::hasRenderPalette() const {
+  return keyTime[0]!=0 && trRender.size()==tr.size();
+  }
+
+void Pose::mkRenderPalette(const std::vector<float>& key) {
+  const size_t stride = keyStride;
+  const float* q      = key.data();
+  trRender.resize(tr.size());
+  for(size_t i=0; i<tr.size(); ++i)
+    trRender[i] = mkMatrix(q[0*stride+i],q[1*stride+i],q[2*stride+i],q[3*stride+i],
+                           q[4*stride+i],q[5*stride+i],q[6*stride+i]);
+  }
+
 bool Pose::updateFrame(const Animation::Sequence &s,
                        uint64_t barrier, uint64_t sTime, uint64_t now) {
   auto&        d         = *s.data;
   const size_t numFrames = d.numFrames;
   const size_t idSize    = d.nodeIndex.size();
-  if(numFrames==0 || idSize==0 || d.samples.size()%idSize!=0)
+  if(numFrames==0 || idSize==0 || d.frameCount()<numFrames)
     return false;
   if(numFrames==1 && !needToUpdate)
     return false;
@@ -330,12 +390,19 @@ bool Pose::updateFrame(const Animation::Sequence &s,
     frameB = d.numFrames-1-frameB;
     }
 
-  auto* sampleA = &d.samples[size_t(frameA*idSize)];
-  auto* sampleB = &d.samples[size_t(frameB*idSize)];
+  static thread_local std::vector<float> smp, tmpA, tmpB;
+  const size_t stride = d.stride;
+  smp.resize(stride*Animation::SAMPLE_TRACKS);
+  mix(d.frame(size_t(frameA),tmpA),d.frame(size_t(frameB),tmpB),a,idSize,stride,smp.data());
 
+  const float* q      = smp.data();
+  const auto*  detail = (detailBones || skeleton==nullptr) ? nullptr : &skeleton->detail;
   for(size_t i=0;i<idSize;++i) {
-    auto smp = mix(sampleA[i],sampleB[i],a);
-    base[d.nodeIndex[i]] = mkMatrix(smp);
+    const size_t id = d.nodeIndex[i];
+    if(detail!=nullptr && id<detail->size() && (*detail)[id])
+      continue;
+    base[id] = mkMatrix(q[0*stride+i],q[1*stride+i],q[2*stride+i],q[3*stride+i],
+                        q[4*stride+i],q[5*stride+i],q[6*stride+i]);
     }
   return true;
   }
@@ -344,16 +411,14 @@ void Pose::mkSkeleton(const Animation::Sequence &s, BodyState bs) {
   if(skeleton==nullptr)
     return;
   Matrix4x4 m = mkBaseTranslation(&s,bs);
-  if(skeleton->ordered)
-    mkSkeleton(m); else
-    mkSkeleton(m,size_t(-1));
+  mkSkeleton(m);
   }
 
 void Pose::mkSkeleton(const Matrix4x4 &mt) {
   if(skeleton==nullptr)
     return;
   auto& nodes=skeleton->nodes;
-  for(size_t i=0; i<nodes.size(); ++i) {
+  for(auto i:skeleton->order) {
     if(nodes[i].parent==size_t(-1)) {
       tr[i] = mt*base[i];
       } else {
@@ -362,18 +427,6 @@ void Pose::mkSkeleton(const Matrix4x4 &mt) {
     }
   }
 
-void Pose::mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent) {
-  if(skeleton==nullptr)
-    return;
-  auto& nodes=skeleton->nodes;
-  for(size_t i=0;i<nodes.size();++i){
-    if(nodes[i].parent!=parent)
-      continue;
-    tr[i] = mt*base[i];
-    mkSkeleton(tr[i],i);
-    }
-  }
-
 const Animation::Sequence* Pose::getNext(const AnimationSolver &solver, const Layer& lay) {
   auto sq = lay.seq;
 
@@ -457,6 +510,20 @@ void Pose::processEvents(uint64_t &barrier, uint64_t now, Animation::EvCount &ev
   barrier=now;
   }
 
+uint64_t Pose::eventsHash() const {
+  uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](uint64_t v) {
+    h ^= v;
+    h *= 1099511628211ull;
+    };
+  mix(hasEvents);
+  for(auto& i:lay) {
+    mix(uint64_t(reinterpret_cast<uintptr_t>(i.seq)));
+    mix(i.sAnim);
+    }
+  return h;
+  }
+
 Tempest::Vec3 Pose::animMoveSpeed(uint64_t tickCount,uint64_t dt) const {
   Tempest::Vec3 ret;
   for(auto& i:lay) {
@@ -699,6 +766,14 @@ const Matrix4x4& Pose::transform(size_t id) const {
   return tr[id];
   }
 
+const std::vector<Matrix4x4>& Pose::renderTransform() const {
+  return hasRenderPalette() ? trRender : tr;
+  }
+
+const Matrix4x4& Pose::renderTransform(size_t id) const {
+  return hasRenderPalette() ? trRender[id] : tr[id];
+  }
+
 Matrix4x4 Pose::mkBaseTranslation(const Animation::Sequence *s, BodyState bs) {
   Matrix4x4 m;
   m.identity();
@@ -45,12 +45,20 @@ class Pose final {
     void               interrupt();
     void               stopAllAnim();
     bool               update(uint64_t tickCount);
+    void               setDetailBones(bool d) { detailBones = d; }
+    // throttled animation: palette is displayed with one step delay, blended between two last updates.
+    // Only render palette is delayed; bone() and transform() always give the last computed pose
+    void               pushKeyFrame(bool changed, uint64_t tickCount);
+    bool               blendKeyFrames(uint64_t tickCount);
+    void               resetKeyFrames();
     void               processLayers(AnimationSolver &solver, uint64_t tickCount);
 
     Tempest::Vec3      animMoveSpeed(uint64_t tickCount, uint64_t dt) const;
     void               processSfx(Npc &npc, uint64_t tickCount);
     void               processPfx(MdlVisual& visual, World& world, uint64_t tickCount);
     void               processEvents(uint64_t& barrier, uint64_t now, Animation::EvCount &ev) const;
+    // fingerprint of everything, that processEvents reads, besides its arguments
+    uint64_t           eventsHash() const;
     bool               isDefParWindow(uint64_t tickCount) const;
     bool               isDefWindow(uint64_t tickCount) const;
     bool               isDefence(uint64_t tickCount) const;
@@ -78,6 +86,9 @@ class Pose final {
 
     const std::vector<Tempest::Matrix4x4>& transform() const;
     const Tempest::Matrix4x4&              transform(size_t id) const;
+    // palette on screen: same as transform(), unless animation is throttled
+    const std::vector<Tempest::Matrix4x4>& renderTransform() const;
+    const Tempest::Matrix4x4&              renderTransform(size_t id) const;
 
   private:
     struct Layer final {
@@ -90,8 +101,9 @@ class Pose final {
     auto mkBaseTranslation(const Animation::Sequence *s, BodyState bs) -> Tempest::Matrix4x4;
     void mkSkeleton(const Animation::Sequence &s, BodyState bs);
     void mkSkeleton(const Tempest::Matrix4x4 &mt);
-    void mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent);
     void zeroSkeleton();
+    bool hasRenderPalette() const;
+    void mkRenderPalette(const std::vector<float>& key);
 
     bool updateFrame(const Animation::Sequence &s, uint64_t barrier, uint64_t sTime, uint64_t now);
 
@@ -116,7 +128,14 @@ class Pose final {
     uint64_t                        lastUpdate=0;
     uint16_t                        comboLen=0;
     bool                            needToUpdate = true;
+    bool                            detailBones  = true;
     uint8_t                         hasEvents = 0;
 
     std::vector<Tempest::Matrix4x4> tr;
+    std::vector<Tempest::Matrix4x4> trRender;
+    // bones of two last updates: quaternion and translation in SoA layout, as in Animation::AnimData
+    std::vector<float>              key[2];
+    size_t                          keyStride  = 0;
+    uint64_t                        keyTime[2] = {};
+    bool                            keySame    = false;
   };
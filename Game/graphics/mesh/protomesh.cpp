@@ -171,6 +171,15 @@ size_t ProtoMesh::skinedNodesCount() const {
   return ret;
   }
 
+size_t ProtoMesh::memoryUsage() const {
+  size_t ret=0;
+  for(auto& i:attach)
+    ret += i.vbo.size()*sizeof(StaticMesh::Vertex) + i.ibo.size()*sizeof(uint32_t);
+  for(auto& i:skined)
+    ret += i.vbo.size()*sizeof(AnimMesh::VertexA) + i.ibo.size()*sizeof(uint32_t);
+  return ret;
+  }
+
 Tempest::Matrix4x4 ProtoMesh::mapToRoot(size_t n) const {
   Tempest::Matrix4x4 m;
   m.identity();
@@ -87,6 +87,8 @@ class ProtoMesh {
     std::string                    scheme, fname;
 
     size_t                         skinedNodesCount() const;
+    // gpu geometry size, in bytes
+    size_t                         memoryUsage() const;
     Tempest::Matrix4x4             mapToRoot(size_t node) const;
 
   private:
@@ -1,7 +1,9 @@
 #include "skeleton.h"
 
 #include <cassert>
+#include <cctype>
 #include "resources.h"
+#include "animmath.h"
 
 using namespace Tempest;
 
@@ -25,15 +27,19 @@ Skeleton::Skeleton(const ZenLoad::zCModelMeshLib &src, std::string meshLib)
   for(auto& i:tr)
     i.identity();
 
-  for(size_t i=0;i<nodes.size();++i) {
-    if(nodes[i].parent>=i && nodes[i].parent!=size_t(-1)) {
-      ordered=false;
-      break;
-      }
-    }
   for(size_t i=0;i<nodes.size();++i)
     if(nodes[i].parent==size_t(-1))
       rootNodes.push_back(i);
+  mkOrder();
+
+  detail.resize(nodes.size());
+  for(size_t i=0;i<nodes.size();++i) {
+    std::string n = nodes[i].name;
+    for(auto& c:n)
+      c = char(std::toupper(c));
+    if(n.find("FINGER")!=std::string::npos || n.find("TOE")!=std::string::npos)
+      detail[i] = 1;
+    }
 
   anim = Resources::loadAnimation(this->meshLib);
 
@@ -81,18 +87,20 @@ float Skeleton::colisionRadius() const {
   return std::max(x,y); //TODO
   }
 
-void Skeleton::mkSkeleton() {
-  Matrix4x4 m;
-  m.identity();
-  mkSkeleton(m,size_t(-1));
+void Skeleton::mkOrder() {
+  std::vector<size_t> parent(nodes.size());
+  for(size_t i=0;i<nodes.size();++i)
+    parent[i] = nodes[i].parent;
+  order = parentsFirst(parent);
   }
 
-void Skeleton::mkSkeleton(const Tempest::Matrix4x4 &mt, size_t parent) {
-  for(size_t i=0;i<nodes.size();++i){
-    if(nodes[i].parent!=parent)
-      continue;
-    tr[i] = mt;
-    tr[i].mul(nodes[i].tr);
-    mkSkeleton(tr[i],i);
+void Skeleton::mkSkeleton() {
+  for(auto i:order) {
+    if(nodes[i].parent==size_t(-1)) {
+      tr[i] = nodes[i].tr;
+      } else {
+      tr[i] = tr[nodes[i].parent];
+      tr[i].mul(nodes[i].tr);
+      }
     }
   }
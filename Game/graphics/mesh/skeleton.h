@@ -18,9 +18,10 @@ class Skeleton final {
       std::string        name;
       };
 
-    bool                            ordered=true;
     std::vector<Node>               nodes;
     std::vector<size_t>             rootNodes;
+    std::vector<size_t>             order;  // parents before children
+    std::vector<uint8_t>            detail; // finger and toe bones, skipped by animation LOD
     std::vector<Tempest::Matrix4x4> tr;
     std::array<float,3>             rootTr={};
 
@@ -41,6 +42,6 @@ class Skeleton final {
     std::string      meshLib;
     const Animation* anim=nullptr;
 
+    void mkOrder();
     void mkSkeleton();
-    void mkSkeleton(const Tempest::Matrix4x4& mt,size_t parent);
   };
@@ -63,11 +63,11 @@ void MeshObjects::Mesh::setPose(const Pose &p,const Tempest::Matrix4x4& obj) {
   if(binder!=nullptr){
     for(size_t i=0;i<binder->bind.size();++i){
       auto id=binder->bind[i];
-      if(id>=p.transform().size())
+      if(id>=p.renderTransform().size())
         continue;
       auto mat=obj;
       mat.translate(ani->rootTr[0],ani->rootTr[1],ani->rootTr[2]);
-      mat.mul(p.transform(id));
+      mat.mul(p.renderTransform(id));
       sub[i].setObjMatrix(mat);
       }
     }
@@ -7,6 +7,7 @@
 #include "sceneglobals.h"
 
 #include "utils/workers.h"
+#include "drawlist.h"
 #include "visualobjects.h"
 #include "rendererstorage.h"
 
@@ -155,7 +156,7 @@ ObjectsBucket::Object& ObjectsBucket::implAlloc(const VboType type, const Bounds
   v->vboA       = nullptr;
   v->ibo        = nullptr;
   v->timeShift  = uint64_t(0-scene.tickCount);
-  v->visibility = owner.visGroup.get();
+  v->visibility = owner.visGroup.get(shaderType==Static);
   v->visibility.setBounds(bounds);
 
   if(!useSharedUbo) {
@@ -370,35 +371,50 @@ void ObjectsBucket::free(const size_t objId) {
     owner.resetIndex();
   }
 
-void ObjectsBucket::draw(Encoder<CommandBuffer>& cmd, uint8_t fId) {
+void ObjectsBucket::compactVisible() {
+  uint8_t mask[CAPACITY];
+  for(size_t i=0; i<valLast; ++i) {
+    auto& v = val[i];
+    bool  vis[SceneGlobals::V_Count] = {};
+    if(v.vboType!=NoVbo && v.vboType!=VboMorph) {
+      for(uint8_t c=0; c<SceneGlobals::V_Count; ++c)
+        vis[c] = v.visibility.isVisible(SceneGlobals::VisCamera(c));
+      }
+    mask[i] = DrawList::slotMask(v.vboType==NoVbo,v.vboType==VboMorph,vis,SceneGlobals::V_Count);
+    }
+  DrawList::compact(mask,valLast,SceneGlobals::V_Count,visList[0],CAPACITY,visSz);
+  }
+
+size_t ObjectsBucket::draw(Encoder<CommandBuffer>& cmd, uint8_t fId) {
   if(pMain==nullptr)
-    return;
-  drawCommon(cmd,fId,*pMain,SceneGlobals::V_Main);
+    return 0;
+  return drawCommon(cmd,fId,*pMain,SceneGlobals::V_Main);
   }
 
-void ObjectsBucket::drawGBuffer(Encoder<CommandBuffer>& cmd, uint8_t fId) {
+size_t ObjectsBucket::drawGBuffer(Encoder<CommandBuffer>& cmd, uint8_t fId) {
   if(pGbuffer==nullptr)
-    return;
-  drawCommon(cmd,fId,*pGbuffer,SceneGlobals::V_Main);
+    return 0;
+  return drawCommon(cmd,fId,*pGbuffer,SceneGlobals::V_Main);
   }
 
-void ObjectsBucket::drawShadow(Encoder<CommandBuffer>& cmd, uint8_t fId, int layer) {
+size_t ObjectsBucket::drawShadow(Encoder<CommandBuffer>& cmd, uint8_t fId, int layer) {
   if(pShadow==nullptr)
-    return;
-  drawCommon(cmd,fId,*pShadow,SceneGlobals::VisCamera(SceneGlobals::V_Shadow0+layer));
+    return 0;
+  return drawCommon(cmd,fId,*pShadow,SceneGlobals::VisCamera(SceneGlobals::V_Shadow0+layer));
   }
 
-void ObjectsBucket::drawCommon(Encoder<CommandBuffer>& cmd, uint8_t fId,
-                               const RenderPipeline& shader, SceneGlobals::VisCamera c) {
+size_t ObjectsBucket::drawCommon(Encoder<CommandBuffer>& cmd, uint8_t fId,
+                                 const RenderPipeline& shader, SceneGlobals::VisCamera c) {
   UboPush pushBlock = {};
   bool    sharedSet = false;
+  size_t  cnt       = 0;
 
-  for(size_t i=0; i<valLast; ++i) {
-    auto& v = val[i];
+  // slot may be released between compactVisible and draw
+  for(size_t r=0; r<visSz[c]; ++r) {
+    auto& v = val[visList[c][r]];
     if(v.vboType==NoVbo)
       continue;
-    if(v.vboType!=VboMorph && !v.visibility.isVisible(c))
-      continue;
+    ++cnt;
 
     updatePushBlock(pushBlock,v);
     if(!useSharedUbo) {
@@ -430,6 +446,7 @@ void ObjectsBucket::drawCommon(Encoder<CommandBuffer>& cmd, uint8_t fId,
         break;
       }
     }
+  return cnt;
   }
 
 void ObjectsBucket::draw(size_t id, Tempest::Encoder<Tempest::CommandBuffer>& p, uint8_t fId) {
@@ -482,11 +499,15 @@ void ObjectsBucket::setObjMatrix(size_t i, const Matrix4x4& m) {
 void ObjectsBucket::setPose(size_t i, const Pose& p) {
   if(shaderType!=Animated)
     return;
-  auto& v    = val[i];
-  auto& skel = storage.ani.element(v.storageAni);
-  auto& tr   = p.transform();
-  std::memcpy(&skel,tr.data(),std::min(tr.size(),boneCnt)*sizeof(tr[0]));
-  storage.ani.markAsChanged(v.storageAni);
+  auto&        v    = val[i];
+  auto&        skel = storage.ani.element(v.storageAni);
+  auto&        tr   = p.renderTransform();
+  const size_t sz   = std::min(tr.size(),boneCnt)*sizeof(tr[0]);
+  // skip upload, if palette is same: static poses and throttled animation LOD
+  if(std::memcmp(&skel,tr.data(),sz)==0)
+    return;
+  std::memcpy(&skel,tr.data(),sz);
+  storage.ani.markAsChanged(v.storageAni,boneCnt);
   }
 
 void ObjectsBucket::setBounds(size_t i, const Bounds& b) {
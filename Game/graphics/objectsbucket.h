@@ -86,6 +86,7 @@ class ObjectsBucket final {
         SkeletalStorage         ani;
         UboStorage<UboMaterial> mat;
         bool                    commitUbo(Tempest::Device &device, uint8_t fId);
+        size_t                  uploadedBytes() const { return ani.uploadedBytes()+mat.uploadedBytes(); }
       };
 
     ObjectsBucket(const Material& mat, const std::vector<ProtoMesh::Animation>& anim, size_t boneCount, VisualObjects& owner, const SceneGlobals& scene, Storage& storage, const Type type);
@@ -115,9 +116,11 @@ class ObjectsBucket final {
     void                      invalidateUbo();
 
     void                      preFrameUpdate(uint8_t fId);
-    void                      draw       (Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId);
-    void                      drawGBuffer(Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId);
-    void                      drawShadow (Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId, int layer=0);
+    // compact list of visible objects per camera; once per frame, after visibility pass
+    void                      compactVisible();
+    size_t                    draw       (Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId);
+    size_t                    drawGBuffer(Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId);
+    size_t                    drawShadow (Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId, int layer=0);
 
     void                      draw       (size_t id, Tempest::Encoder<Tempest::CommandBuffer>& p, uint8_t fId);
 
@@ -194,7 +197,7 @@ class ObjectsBucket final {
     bool    isSceneInfoRequired() const;
     void    updatePushBlock(UboPush& push, Object& v);
 
-    void    drawCommon(Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId, const Tempest::RenderPipeline& shader, SceneGlobals::VisCamera c);
+    size_t  drawCommon(Tempest::Encoder<Tempest::CommandBuffer>& cmd, uint8_t fId, const Tempest::RenderPipeline& shader, SceneGlobals::VisCamera c);
 
     const Bounds& bounds(size_t i) const;
 
@@ -208,6 +211,9 @@ class ObjectsBucket final {
     size_t                    polySz=0;
     size_t                    polyAvg=0;
 
+    uint8_t                   visList[SceneGlobals::V_Count][CAPACITY] = {};
+    size_t                    visSz  [SceneGlobals::V_Count] = {};
+
     const SceneGlobals&       scene;
     Storage&                  storage;
     Material                  mat;
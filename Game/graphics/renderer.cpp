@@ -134,7 +134,11 @@ void Renderer::draw(Tempest::Encoder<CommandBuffer>& cmd,
   wview->setFrameGlobals(sh,gothic.world()->tickCount(),frameId);
   wview->setGbuffer(textureCast(lightingBuf),textureCast(gbufDiffuse),textureCast(gbufNormal),textureCast(gbufDepth));
 
-  wview->visibilityPass(viewProj,shadow,Resources::ShadowLayers);
+  Vec3 camera;
+  auto vinv = view;
+  vinv.inverse();
+  vinv.project(camera.x,camera.y,camera.z);
+  wview->visibilityPass(camera,viewProj,shadow,Resources::ShadowLayers);
   for(uint8_t i=2;i>0;) {
     --i;
     cmd.setFramebuffer(fboShadow[i],shadowPass);
@@ -1,5 +1,9 @@
 #include "skeletalstorage.h"
 
+#include <algorithm>
+
+#include "dirtyranges.h"
+
 using namespace Tempest;
 
 struct SkeletalStorage::Impl {
@@ -8,19 +12,20 @@ struct SkeletalStorage::Impl {
   virtual size_t alloc(size_t bonesCount) = 0;
   virtual void   free (const size_t objId, const size_t bonesCount) = 0;
   virtual void   bind(Uniforms& ubo, uint8_t bind, uint8_t fId, size_t id) = 0;
-  virtual bool   commitUbo(Tempest::Device &device, uint8_t fId) = 0;
+  virtual bool   commitUbo(Tempest::Device &device, uint8_t fId, size_t& uploaded) = 0;
   virtual Matrix4x4* get(size_t id) = 0;
   virtual void   reserve(size_t n) = 0;
+  virtual void   markAsChanged(size_t elt, size_t bonesCount) = 0;
 
-  void           markAsChanged(size_t/*elt*/) {
-    for(auto& i:pf)
-      i.uboChanged=true;
-    }
-
-  struct PerFrame final {
-    std::atomic_bool uboChanged{false};  // invalidate ubo array
+  enum {
+    // one palette in flight per block is the common case; coalesce only neighbours
+    MergeGap  = 1,
+    MaxRanges = 64,
+    MinBlocks = 256,
     };
-  PerFrame           pf[Resources::MaxFramesInFlight];
+
+  DirtyRanges                     dirty;
+  std::vector<DirtyRanges::Range> ranges;
   };
 
 template<size_t BlkSz>
@@ -92,23 +97,36 @@ struct SkeletalStorage::TImpl : Impl {
     };
 
   TImpl() {
-    obj.resize(Padding);
+    grow(Padding);
     }
 
   size_t alloc(size_t bonesCount) override {
     size_t ret = freeList.alloc(bonesCount);
     if(ret!=size_t(-1)) {
-      markAsChanged(ret);
+      markAsChanged(ret,bonesCount);
       return ret;
       }
-    ret = obj.size()-Padding;
+    ret = objSz;
 
     const size_t increment = freeList.blockCount(bonesCount);
-    obj.resize(obj.size()+increment);
-    markAsChanged(ret);
+    objSz += increment;
+    if(objSz+Padding>obj.size())
+      grow(std::max<size_t>(obj.size()*2,std::max<size_t>(objSz+Padding,MinBlocks)));
+    markAsChanged(ret,bonesCount);
     return ret;
     }
 
+  void   markAsChanged(size_t elt, size_t bonesCount) override {
+    const size_t cnt = std::max<size_t>((bonesCount+BlkSz-1)/BlkSz,1);
+    dirty.mark(elt,elt+cnt);
+    }
+
+  void   grow(size_t sz) {
+    // geometric growth: gpu buffer is recreated (and descriptors invalidated) only log(n) times
+    obj.resize(sz);
+    dirty.resize(sz);
+    }
+
   void   free(const size_t objId, const size_t bonesCount) override {
     freeList.free(objId, bonesCount);
     auto m = &obj[objId];
@@ -121,17 +139,24 @@ struct SkeletalStorage::TImpl : Impl {
     ubo.set(bind,v,id);
     }
 
-  bool   commitUbo(Tempest::Device &device, uint8_t fId) override {
-    auto& frame = pf[fId];
-    if(!frame.uboChanged)
-      return false;
+  bool   commitUbo(Tempest::Device &device, uint8_t fId, size_t& uploaded) override {
+    auto&      ubo     = uboData[fId];
+    const bool realloc = ubo.size()!=obj.size();
+    if(realloc) {
+      dirty.clear(fId);
+      ubo       = device.ubo<Block>(obj.data(),obj.size());
+      uploaded += obj.size()*sizeof(Block);
+      return true;
+      }
 
-    const bool realloc = uboData[fId].size()!=obj.size();
-    if(realloc)
-      uboData[fId] = device.ubo<Block>(obj.data(),obj.size()); else
-      uboData[fId].update(obj.data(),0,obj.size());
-    frame.uboChanged = false;
-    return realloc;
+    if(!dirty.isDirty(fId))
+      return false;
+    dirty.take(fId,ranges,MergeGap,MaxRanges);
+    for(auto& r:ranges) {
+      ubo.update(obj.data()+r.begin,r.begin,r.end-r.begin);
+      uploaded += (r.end-r.begin)*sizeof(Block);
+      }
+    return false;
     }
 
   Matrix4x4* get(size_t id) override {
@@ -139,11 +164,14 @@ struct SkeletalStorage::TImpl : Impl {
     }
 
   void   reserve(size_t n) override {
-    obj.reserve(n);
+    if(n+Padding>obj.size())
+      grow(n+Padding);
     }
 
   FreeList<BlkSz,BlkSz>           freeList;
+  // sized to capacity of gpu buffer; [objSz,obj.size()) is unused tail, at least Padding long
   std::vector<Block>              obj;
+  size_t                          objSz = 0;
   Tempest::UniformBuffer<Block>   uboData[Resources::MaxFramesInFlight];
   };
 
@@ -187,14 +215,15 @@ void SkeletalStorage::bind(Uniforms& ubo, uint8_t bind, uint8_t fId, size_t id,
   }
 
 bool SkeletalStorage::commitUbo(Tempest::Device& device, uint8_t fId) {
-  if(!impl->commitUbo(device,fId))
-    return false;
-  updatesTotal++;
-  return true;
+  const size_t prev = uploaded;
+  const bool   ret  = impl->commitUbo(device,fId,uploaded);
+  if(uploaded!=prev)
+    updatesTotal++;
+  return ret;
   }
 
-void SkeletalStorage::markAsChanged(size_t elt) {
-  impl->markAsChanged(elt);
+void SkeletalStorage::markAsChanged(size_t elt, size_t bonesCount) {
+  impl->markAsChanged(elt,bonesCount);
   }
 
 Matrix4x4& SkeletalStorage::element(size_t i) {
@@ -22,10 +22,11 @@ class SkeletalStorage {
 
     void                     bind(Tempest::Uniforms& desc, uint8_t bind, uint8_t fId, size_t id, size_t boneCnt);
 
-    void                     markAsChanged(size_t elt);
+    void                     markAsChanged(size_t elt, size_t bonesCount);
     Tempest::Matrix4x4&      element(size_t i);
 
     void                     reserve(size_t sz);
+    size_t                   uploadedBytes() const { return uploaded; }
 
   private:
     struct Impl;
@@ -42,5 +43,6 @@ class SkeletalStorage {
     std::unique_ptr<Impl>           impl;
     size_t                          blockSize;
     size_t                          updatesTotal=0; // perf statistic
+    size_t                          uploaded=0;     // perf statistic, bytes
   };
 
@@ -4,8 +4,10 @@
 #include <Tempest/Uniforms>
 #include <Tempest/Device>
 
+#include <algorithm>
 #include <cassert>
 
+#include "dirtyranges.h"
 #include "resources.h"
 
 template<class Ubo>
@@ -23,17 +25,31 @@ class UboStorage {
     Ubo&                     element(size_t i){ return obj[i]; }
 
     void                     reserve(size_t sz);
+    size_t                   uploadedBytes() const { return uploaded; }
 
   private:
+    enum {
+      // coalesce dirty elements, that are this close, into one update
+      MergeGap  = (256+sizeof(Ubo)-1)/sizeof(Ubo),
+      MaxRanges = 64,
+      MinSize   = 64,
+      };
+
     struct PerFrame final {
       Tempest::UniformBuffer<Ubo>  uboData;
-      std::atomic_bool             uboChanged{false};  // invalidate ubo array
       };
 
+    void                        grow(size_t sz);
+
     PerFrame                    pf[Resources::MaxFramesInFlight];
+    // sized to capacity of gpu buffer; [objSz,obj.size()) is unused tail
     std::vector<Ubo>            obj;
+    size_t                      objSz=0;
     std::vector<size_t>         freeList;
+    DirtyRanges                 dirty;
+    std::vector<DirtyRanges::Range> ranges;
     size_t                      updatesTotal=0; // perf statistic
+    size_t                      uploaded=0;     // perf statistic, bytes
   };
 
 template<class Ubo>
@@ -45,11 +61,14 @@ size_t UboStorage<Ubo>::alloc() {
   if(freeList.size()>0){
     size_t id=freeList.back();
     freeList.pop_back();
+    markAsChanged(id);
     return id;
     }
-  obj.resize(obj.size()+1);
-  markAsChanged(obj.size()-1);
-  return obj.size()-1;
+  if(objSz==obj.size())
+    grow(std::max<size_t>(objSz*2,MinSize));
+  objSz++;
+  markAsChanged(objSz-1);
+  return objSz-1;
   }
 
 template<class Ubo>
@@ -59,26 +78,41 @@ void UboStorage<Ubo>::free(const size_t objId) {
   }
 
 template<class Ubo>
-void UboStorage<Ubo>::markAsChanged(size_t /*elt*/) {
-  for(auto& i:pf)
-    i.uboChanged=true;
+void UboStorage<Ubo>::markAsChanged(size_t elt) {
+  dirty.mark(elt,elt+1);
   }
 
 template<class Ubo>
 bool UboStorage<Ubo>::commitUbo(Tempest::Device& device,uint8_t fId) {
   auto&        frame   = pf[fId];
   const bool   realloc = frame.uboData.size()!=obj.size();
-  if(!frame.uboChanged)
+  if(!realloc && !dirty.isDirty(fId))
     return false;
   updatesTotal++;
-  if(realloc)
-    frame.uboData = device.ubo<Ubo>(obj.data(),obj.size()); else
-    frame.uboData.update(obj.data(),0,obj.size());
-  frame.uboChanged = false;
-  return realloc;
+  if(realloc) {
+    dirty.clear(fId);
+    frame.uboData = device.ubo<Ubo>(obj.data(),obj.size());
+    uploaded     += obj.size()*sizeof(Ubo);
+    return true;
+    }
+
+  dirty.take(fId,ranges,MergeGap,MaxRanges);
+  for(auto& r:ranges) {
+    frame.uboData.update(obj.data()+r.begin,r.begin,r.end-r.begin);
+    uploaded += (r.end-r.begin)*sizeof(Ubo);
+    }
+  return false;
   }
 
 template<class Ubo>
 void UboStorage<Ubo>::reserve(size_t sz){
-  obj.reserve(sz);
+  if(sz>obj.size())
+    grow(sz);
+  }
+
+template<class Ubo>
+void UboStorage<Ubo>::grow(size_t sz) {
+  // geometric growth: gpu buffer is recreated (and descriptors invalidated) only log(n) times
+  obj.resize(sz);
+  dirty.resize(sz);
   }
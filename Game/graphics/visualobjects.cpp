@@ -15,14 +15,24 @@ VisualObjects::VisualObjects(Device& device, const SceneGlobals& globals)
 ObjectsBucket& VisualObjects::getBucket(const Material& mat, const std::vector<ProtoMesh::Animation>& anim, size_t boneCnt, ObjectsBucket::Type type) {
   const std::vector<ProtoMesh::Animation>* a = anim.size()==0 ? nullptr : &anim;
 
-  for(auto& i:buckets)
-    if(i.material()==mat && i.morph()==a && i.type()==type && i.boneCount()==boneCnt && i.size()<ObjectsBucket::CAPACITY)
-      return i;
+  const size_t hash = bucketHash(mat,a,boneCnt,type);
+  auto ret = bucketsByKey.find(hash,[&](const ObjectsBucket& i){
+    return i.material()==mat && i.morph()==a && i.type()==type && i.boneCount()==boneCnt && i.size()<ObjectsBucket::CAPACITY;
+    });
+  if(ret!=nullptr)
+    return *ret;
 
   if(type==ObjectsBucket::Type::Static)
-    buckets.emplace_back(mat,anim,boneCnt,*this,globals,uboStatic,type); else
-    buckets.emplace_back(mat,anim,boneCnt,*this,globals,uboDyn,   type);
-  return buckets.back();
+    buckets.emplace_back(new ObjectsBucket(mat,anim,boneCnt,*this,globals,uboStatic,type)); else
+    buckets.emplace_back(new ObjectsBucket(mat,anim,boneCnt,*this,globals,uboDyn,   type));
+  bucketsByKey.push(hash,buckets.back().get());
+  return *buckets.back();
+  }
+
+size_t VisualObjects::bucketHash(const Material& mat, const std::vector<ProtoMesh::Animation>* anim,
+                                 size_t boneCnt, ObjectsBucket::Type type) {
+  // only fields, that are cheap to hash; Material::operator== resolves the rest
+  return BucketChain<ObjectsBucket>::keyHash(mat.tex,anim,size_t(mat.alpha),mat.isGhost,boneCnt,size_t(type));
   }
 
 ObjectsBucket::Item VisualObjects::get(const StaticMesh &mesh, const Material& mat,
@@ -71,17 +81,26 @@ ObjectsBucket::Item VisualObjects::get(const Tempest::VertexBuffer<Resources::Ve
 
 void VisualObjects::setupUbo() {
   for(auto& c:buckets)
-    c.setupUbo();
+    c->setupUbo();
   sky.setupUbo();
   }
 
 void VisualObjects::preFrameUpdate(uint8_t fId) {
   for(auto& c:buckets)
-    c.preFrameUpdate(fId);
+    c->preFrameUpdate(fId);
   }
 
 void VisualObjects::visibilityPass(const Matrix4x4& main, const Matrix4x4* sh, size_t shCount) {
   visGroup.pass(main,sh,shCount);
+  // empty buckets are compacted too, to drop draws of released objects from previous frame
+  Workers::parallelFor(buckets,[](std::unique_ptr<ObjectsBucket>& c){
+    c->compactVisible();
+    });
+  const size_t up = uboStatic.uploadedBytes()+uboDyn.uploadedBytes();
+  drawCur.uploaded = uint32_t(up-uploadMark);
+  uploadMark       = up;
+  drawLast         = drawCur;
+  drawCur          = DrawStats();
   }
 
 void VisualObjects::draw(Tempest::Encoder<Tempest::CommandBuffer>& enc, uint8_t fId) {
@@ -91,7 +110,8 @@ void VisualObjects::draw(Tempest::Encoder<Tempest::CommandBuffer>& enc, uint8_t
   sky.drawSky(enc,fId);
   for(size_t i=lastSolidBucket;i<index.size();++i) {
     auto c = index[i];
-    c->draw(enc,fId);
+    drawCur.objects += uint32_t(c->size());
+    drawCur.draws   += uint32_t(c->draw(enc,fId));
     }
   sky.drawFog(enc,fId);
   }
@@ -102,7 +122,8 @@ void VisualObjects::drawGBuffer(Tempest::Encoder<CommandBuffer>& enc, uint8_t fI
 
   for(size_t i=0;i<lastSolidBucket;++i) {
     auto c = index[i];
-    c->drawGBuffer(enc,fId);
+    drawCur.objects += uint32_t(c->size());
+    drawCur.draws   += uint32_t(c->drawGBuffer(enc,fId));
     }
   }
 
@@ -114,7 +135,8 @@ void VisualObjects::drawShadow(Tempest::Encoder<Tempest::CommandBuffer>& enc, ui
 
   for(size_t i=0;i<lastSolidBucket;++i) {
     auto c = index[i];
-    c->drawShadow(enc,fId,layer);
+    drawCur.objects += uint32_t(c->size());
+    drawCur.draws   += uint32_t(c->drawShadow(enc,fId,layer));
     }
   }
 
@@ -122,6 +144,14 @@ void VisualObjects::setWorld(const World& world) {
   sky.setWorld(world);
   }
 
+void VisualObjects::setSectors(const SectorVisibility* s) {
+  visGroup.setSectors(s);
+  }
+
+void VisualObjects::rebuildStaticTree() {
+  visGroup.rebuildStaticTree();
+  }
+
 void VisualObjects::setDayNight(float dayF) {
   sky.setDayNight(dayF);
   }
@@ -137,9 +167,9 @@ void VisualObjects::mkIndex() {
   index.resize(buckets.size());
   size_t id=0;
   for(auto& i:buckets) {
-    if(i.size()==0)
+    if(i->size()==0)
       continue;
-    index[id] = &i;
+    index[id] = i.get();
     ++id;
     }
   index.resize(id);
@@ -176,5 +206,5 @@ void VisualObjects::commitUbo(uint8_t fId) {
   if(!st && !dn)
     return;
   for(auto& c:buckets)
-    c.invalidateUbo();
+    c->invalidateUbo();
   }
@@ -1,15 +1,25 @@
 #pragma once
 
+#include <memory>
+
 #include "objectsbucket.h"
+#include "bucketchain.h"
 #include "graphics/sky/sky.h"
 
 class SceneGlobals;
+class SectorVisibility;
 class AnimMesh;
 
 class VisualObjects final {
   public:
     VisualObjects(Tempest::Device& device, const SceneGlobals& globals);
 
+    struct DrawStats {
+      uint32_t objects  = 0;
+      uint32_t draws    = 0;
+      uint32_t uploaded = 0; // bytes of ubo storages
+      };
+
     ObjectsBucket::Item get(const StaticMesh& mesh, const Material& mat, size_t iboOffset, size_t iboLen,
                             const std::vector<ProtoMesh::Animation>& anim, bool staticDraw);
     ObjectsBucket::Item get(const AnimMesh&   mesh, const Material& mat, size_t ibo, size_t iboLen);
@@ -21,17 +31,24 @@ class VisualObjects final {
     void setupUbo();
     void preFrameUpdate(uint8_t fId);
     void visibilityPass(const Tempest::Matrix4x4& main, const Tempest::Matrix4x4* sh, size_t shCount);
+    auto visibilityStats() const -> VisibilityGroup::Stats { return visGroup.stats(); }
+    // counters of previous frame: objects in drawn buckets vs draw calls issued, over all passes
+    auto drawStats()       const -> const DrawStats& { return drawLast; }
     void draw          (Tempest::Encoder<Tempest::CommandBuffer>& enc, uint8_t fId);
     void drawGBuffer   (Tempest::Encoder<Tempest::CommandBuffer>& enc, uint8_t fId);
     void drawShadow    (Tempest::Encoder<Tempest::CommandBuffer>& enc, uint8_t fId, int layer=0);
 
     void setWorld   (const World& world);
+    void setSectors (const SectorVisibility* s);
+    void rebuildStaticTree();
     void setDayNight(float dayF);
     void resetIndex();
 
   private:
     ObjectsBucket&                  getBucket(const Material& mat, const std::vector<ProtoMesh::Animation>& anim,
                                               size_t boneCnt, ObjectsBucket::Type type);
+    static size_t                   bucketHash(const Material& mat, const std::vector<ProtoMesh::Animation>* anim,
+                                               size_t boneCnt, ObjectsBucket::Type type);
     void                            mkIndex();
     void                            commitUbo(uint8_t fId);
 
@@ -41,12 +58,17 @@ class VisualObjects final {
     ObjectsBucket::Storage          uboStatic;
     ObjectsBucket::Storage          uboDyn;
 
-    std::list<ObjectsBucket>        buckets;
+    std::vector<std::unique_ptr<ObjectsBucket>> buckets;
+    BucketChain<ObjectsBucket>      bucketsByKey;
     std::vector<ObjectsBucket*>     index;
     size_t                          lastSolidBucket = 0;
 
     Sky                             sky;
 
+    DrawStats                       drawCur;
+    DrawStats                       drawLast;
+    size_t                          uploadMark = 0;
+
   friend class ObjectsBucket;
   friend class ObjectsBucket::Item;
   };
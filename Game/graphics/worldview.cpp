@@ -12,9 +12,10 @@
 using namespace Tempest;
 
 WorldView::WorldView(const World &world, const PackedMesh &wmesh, const RendererStorage &storage)
-  : owner(world),storage(storage),sGlobal(storage),visuals(storage.device,sGlobal),
+  : owner(world),storage(storage),sGlobal(storage),sectors(world.bspTree(),wmesh),visuals(storage.device,sGlobal),
     objGroup(visuals),pfxGroup(*this,sGlobal,visuals),land(*this,visuals,wmesh) {
   visuals.setWorld(owner);
+  visuals.setSectors(&sectors);
   pfxGroup.resetTicks();
   }
 
@@ -92,7 +93,10 @@ void WorldView::dbgLights(DbgPainter& p) const {
   sGlobal.lights.dbgLights(p);
   }
 
-void WorldView::visibilityPass(const Matrix4x4& main, const Matrix4x4* sh, size_t shCount) {
+void WorldView::visibilityPass(const Vec3& cam, const Matrix4x4& main, const Matrix4x4* sh, size_t shCount) {
+  camera      = cam;
+  cameraValid = true;
+  sectors.update(camera,main);
   visuals.visibilityPass(main,sh,shCount);
   }
 
@@ -177,6 +181,10 @@ void WorldView::updateLight() {
   visuals.setDayNight(std::min(std::max(pulse*3.f,0.f),1.f));
   }
 
+void WorldView::rebuildStaticTree() {
+  visuals.rebuildStaticTree();
+  }
+
 void WorldView::setupUbo() {
   // cmd buffers must not be in use
   sGlobal.lights.setupUbo();
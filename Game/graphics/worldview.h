@@ -10,6 +10,7 @@
 #include "graphics/meshobjects.h"
 #include "graphics/mesh/protomesh.h"
 #include "graphics/pfx/pfxobjects.h"
+#include "graphics/dynamic/sectorvisibility.h"
 #include "lightsource.h"
 #include "sceneglobals.h"
 #include "visualobjects.h"
@@ -36,10 +37,17 @@ class WorldView {
     void setFrameGlobals(const Tempest::Texture2d* shadow[], uint64_t tickCount, uint8_t fId);
     void setGbuffer     (const Tempest::Texture2d& lightingBuf, const Tempest::Texture2d& diffuse, const Tempest::Texture2d& norm, const Tempest::Texture2d& depth);
     void setupUbo();
+    // static objects are complete: build culling tree once, instead of on every spawn
+    void rebuildStaticTree();
 
     void dbgLights    (DbgPainter& p) const;
 
-    void visibilityPass(const Tempest::Matrix4x4& main, const Tempest::Matrix4x4* sh, size_t shCount);
+    void visibilityPass(const Tempest::Vec3& camera, const Tempest::Matrix4x4& main, const Tempest::Matrix4x4* sh, size_t shCount);
+    // eye position of the last rendered frame
+    bool hasCamera()      const { return cameraValid; }
+    auto cameraPosition() const -> const Tempest::Vec3& { return camera; }
+    auto visibilityStats() const -> VisibilityGroup::Stats { return visuals.visibilityStats(); }
+    auto drawStats()       const -> VisualObjects::DrawStats { return visuals.drawStats(); }
     void drawShadow    (Tempest::Encoder<Tempest::CommandBuffer> &cmd, uint8_t frameId, uint8_t layer);
     void drawGBuffer   (Tempest::Encoder<Tempest::CommandBuffer> &cmd, uint8_t frameId);
     void drawMain      (Tempest::Encoder<Tempest::CommandBuffer> &cmd, uint8_t frameId);
@@ -56,12 +64,15 @@ class WorldView {
     const RendererStorage&  storage;
 
     SceneGlobals            sGlobal;
+    SectorVisibility        sectors;
     VisualObjects           visuals;
 
     MeshObjects             objGroup;
     PfxObjects              pfxGroup;
     Landscape               land;
 
+    Tempest::Vec3           camera;
+    bool                    cameraValid     = false;
     bool                    needToUpdateUbo = false;
 
     bool needToUpdateCmd(uint8_t frameId) const;
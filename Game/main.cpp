@@ -9,6 +9,7 @@
 #endif
 
 #include "utils/crashlog.h"
+#include "world/worldcache.h"
 #include "gothic.h"
 #include "mainwindow.h"
 
@@ -57,6 +58,10 @@ int main(int argc,const char** argv) {
 
   Tempest::Device      device{*api,selectDevice(*api),Resources::MaxFramesInFlight};
   Resources            resources{gothic,device};
+  if(gothic.doBakeCache()) {
+    WorldCache::bakeAll(gothic);
+    return 0;
+    }
   GameMusic            music(gothic);
 
   MainWindow           wx(gothic,device);
@@ -192,11 +192,35 @@ void MainWindow::paintEvent(PaintEvent& event) {
     }
 
   if(gothic.doFrate()) {
-    char fpsT[64]={};
-    std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f %s",fps.get(),info);
+    char fpsT[128]={};
+    if(world!=nullptr) {
+      auto& st = world->aiLodStats();
+      std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f %s ai = %u/%u/%u skip = %u",fps.get(),info,
+                    st.normal,st.far,st.far2,st.skipped);
+      } else {
+      std::snprintf(fpsT,sizeof(fpsT),"fps = %.2f %s",fps.get(),info);
+      }
 
     auto& fnt = Resources::font();
     fnt.drawText(p,5,30,fpsT);
+    if(world!=nullptr) {
+      auto& st = world->animLodStats();
+      DynamicWorld::GroundCacheStats gc;
+      if(auto ph = world->physic())
+        gc = ph->groundCacheStats();
+      char aniT[128]={};
+      std::snprintf(aniT,sizeof(aniT),"anim lod = %u/%u/%u %.2f/%.2f ms ground = %u/%u %.2f ms",st.full,st.reduced,st.low,
+                    double(st.us)/1000.0,double(st.cpuUs)/1000.0,gc.hit,gc.fallback,double(gc.us)/1000.0);
+      fnt.drawText(p,5,30+int(fnt.pixelSize()),aniT);
+      }
+    if(auto wview = gothic.worldView()) {
+      auto vs = wview->visibilityStats();
+      auto ds = wview->drawStats();
+      char visT[160]={};
+      std::snprintf(visT,sizeof(visT),"sectors = %u/%u portal culled = %u draws = %u/%u upload = %u kb",
+                    vs.visible,vs.sectors,vs.culled,ds.draws,ds.objects,ds.uploaded/1024);
+      fnt.drawText(p,5,30+2*int(fnt.pixelSize()),visT);
+      }
     }
   }
 
@@ -0,0 +1,55 @@
+#include "capsulesweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool capsuleSweep(const btVector3& pa, const btVector3& pb, float r,
+                  const btVector3& s, const btVector3& e, float& frac) {
+  const btVector3 ba   = pb-pa;
+  const btVector3 oa   = s-pa;
+  const float     baba = ba.dot(ba);
+  const float     len  = (e-s).length();
+  if(r<=0.f)
+    return false;
+
+  const float ax = baba>0.f ? std::max(0.f,std::min(1.f,oa.dot(ba)/baba)) : 0.f;
+  if((oa-ba*ax).length2()<=r*r) {
+    frac = 0.f;
+    return true;
+    }
+  if(len<=0.f)
+    return false;
+
+  const btVector3 rd   = (e-s)/len;
+  const float     bard = ba.dot(rd);
+  const float     baoa = ba.dot(oa);
+  float           t    = std::numeric_limits<float>::max();
+
+  // cylinder body
+  const float a = baba - bard*bard;
+  if(a>0.f) {
+    const float b = baba*rd.dot(oa) - baoa*bard;
+    const float c = baba*oa.dot(oa) - baoa*baoa - r*r*baba;
+    const float h = b*b - a*c;
+    if(h>=0.f) {
+      const float tc = (-b-std::sqrt(h))/a;
+      const float y  = baoa + tc*bard;
+      if(tc>=0.f && y>0.f && y<baba)
+        t = tc;
+      }
+    }
+  // spherical caps
+  for(auto& p:{pa,pb}) {
+    const btVector3 oc = s-p;
+    const float     b  = rd.dot(oc);
+    const float     h  = b*b - (oc.dot(oc)-r*r);
+    if(h>=0.f && -b-std::sqrt(h)>=0.f)
+      t = std::min(t,-b-std::sqrt(h));
+    }
+
+  if(t>len)
+    return false;
+  frac = t/len;
+  return true;
+  }
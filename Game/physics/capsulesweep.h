@@ -0,0 +1,16 @@
+#pragma once
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+#include <LinearMath/btVector3.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+// Segment [s,e] vs capsule with axis [pa,pb] and radius r: fraction of first contact along the segment.
+// Segment, that starts inside of capsule, hits at 0.
+bool capsuleSweep(const btVector3& pa, const btVector3& pb, float r,
+                  const btVector3& s, const btVector3& e, float& frac);
@@ -9,6 +9,7 @@
 #include <BulletCollision/CollisionDispatch/btDefaultCollisionConfiguration.h>
 #include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <BulletCollision/CollisionShapes/btConvexShape.h>
 
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
@@ -16,6 +17,8 @@
 
 #include "dynamicworld.h"
 
+#include <algorithm>
+
 struct CollisionWorld::Broadphase : btDbvtBroadphase {
   struct BroadphaseRayTester : btDbvt::ICollide {
     btBroadphaseRayCallback& m_rayCallback;
@@ -149,6 +152,29 @@ bool CollisionWorld::hasCollision(btRigidBody& it, Tempest::Vec3& normal) {
   return callback.count>0;
   }
 
+void CollisionWorld::addCollisionObject(btCollisionObject* obj, int group, int mask) {
+  btCollisionWorld::addCollisionObject(obj,group,mask);
+  touchRays(*obj);
+  }
+
+void CollisionWorld::removeCollisionObject(btCollisionObject* obj) {
+  touchRays(*obj);
+  btCollisionWorld::removeCollisionObject(obj);
+  }
+
+void CollisionWorld::setObjTransform(btCollisionObject& obj, const btTransform& tr) {
+  obj.setWorldTransform(tr);
+  updateSingleAabb(&obj);
+  touchRays(obj);
+  }
+
+void CollisionWorld::touchRays(const btCollisionObject& obj) {
+  // rays only see landscape and objects; items and npc's are not in the way
+  const int cat = obj.getUserIndex();
+  if(cat==DynamicWorld::C_Landscape || cat==DynamicWorld::C_Water || cat==DynamicWorld::C_Object)
+    ++rayEp;
+  }
+
 void CollisionWorld::addRigidBody(btRigidBody* body) {
   addCollisionObject(body);
   rigid.push_back(body);
@@ -156,6 +182,13 @@ void CollisionWorld::addRigidBody(btRigidBody* body) {
 
 void CollisionWorld::removeRigidBody(btRigidBody* body) {
   removeCollisionObject(body);
+  for(size_t i=0; i<moved.size(); ++i) {
+    if(moved[i]==body) {
+      moved[i] = moved.back();
+      moved.pop_back();
+      break;
+      }
+    }
   for(size_t i=0; i<rigid.size(); ++i) {
     if(rigid[i]==body) {
       rigid[i] = rigid.back();
@@ -168,13 +201,20 @@ void CollisionWorld::removeRigidBody(btRigidBody* body) {
 void CollisionWorld::tick(uint64_t dt) {
   const float dtF = float(dt);
 
+  moved.clear();
+  updateAabbs();
   for(auto& i:rigid) {
     i->setLinearVelocity(i->getLinearVelocity()+gravity*dtF);
 
-    uint64_t cnt    = uint64_t(i->getLinearVelocity().length());
-    bool     active = cnt>0;
-    for(uint64_t r=1; active && r<=(cnt*dt) && r<150; ++r)
-      active &= tick(1.f/float(cnt*dt),*i);
+    // same travel distance, as with former fixed sub-steps: velocity per frame, but no more than 149 steps of 1/dt
+    const uint64_t cnt   = uint64_t(i->getLinearVelocity().length());
+    const uint64_t steps = std::min<uint64_t>(cnt*dt,149);
+    bool           active = false;
+    if(steps>0) {
+      const btVector3 dpos = i->getLinearVelocity()*(float(steps)/float(cnt*dt));
+      active = sweep(*i,dpos);
+      moved.push_back(i);
+      }
 
     if(active) {
       i->setDeactivationTime(0);
@@ -187,20 +227,67 @@ void CollisionWorld::tick(uint64_t dt) {
     }
   }
 
-bool CollisionWorld::tick(float step, btRigidBody& body) {
-  Tempest::Vec3 norm;
+bool CollisionWorld::sweep(btRigidBody& body, const btVector3& dpos) {
+  struct CallBack : btCollisionWorld::ClosestConvexResultCallback {
+    const btCollisionObject* self = nullptr;
 
-  btTransform prev = body.getWorldTransform();
-  auto  trans = prev;
-  auto& at    = trans.getOrigin();
+    CallBack(const btCollisionObject* self, const btVector3& from, const btVector3& to)
+      :ClosestConvexResultCallback(from,to), self(self) {
+      m_collisionFilterMask = btBroadphaseProxy::DefaultFilter | btBroadphaseProxy::StaticFilter;
+      }
 
-  at+=body.getLinearVelocity()*step;
-  body.setWorldTransform(trans);
+    bool needsCollision(btBroadphaseProxy* proxy0) const override {
+      auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+      if(obj==self || obj->getUserIndex()==DynamicWorld::C_Water)
+        return false;
+      return ClosestConvexResultCallback::needsCollision(proxy0);
+      }
+    };
 
-  if(hasCollision(body,norm)) {
-    body.setWorldTransform(prev);
+  auto shape = body.getCollisionShape();
+  if(shape==nullptr || !shape->isConvex())
     return false;
+
+  const btTransform from = body.getWorldTransform();
+  btTransform       to   = from;
+  to.getOrigin() += dpos;
+
+  // time of impact: move till first contact in one query, instead of sub-stepping
+  CallBack callback(&body,from.getOrigin(),to.getOrigin());
+  convexSweepTest(static_cast<const btConvexShape*>(shape),from,to,callback);
+
+  if(callback.hasHit()) {
+    // step back a little, to not start next sweep in penetration
+    const btScalar len  = dpos.length();
+    const btScalar frac = len>0 ? std::max<btScalar>(0,callback.m_closestHitFraction-1.f/len) : 0;
+    to.setOrigin(from.getOrigin()+dpos*frac);
+    body.setWorldTransform(to);
+    updateSingleAabb(&body);
+    return false;
+    }
+
+  // sweep doesn't report contacts, that were there from the start
+  Tempest::Vec3 norm;
+  body.setWorldTransform(to);
+  if(!hasCollision(body,norm)) {
+    updateSingleAabb(&body);
+    return true;
+    }
+
+  // destination overlaps: bisect for the last free position on the way, as former sub-steps
+  // would stop right before the first overlapping step; at most 8 tests, resolution is 1cm
+  const btScalar len = dpos.length();
+  btScalar       lo  = 0, hi = 1;
+  for(int i=0; i<8 && (hi-lo)*len>1.f; ++i) {
+    const btScalar mid = (lo+hi)*0.5f;
+    to.setOrigin(from.getOrigin()+dpos*mid);
+    body.setWorldTransform(to);
+    if(hasCollision(body,norm))
+      hi = mid; else
+      lo = mid;
     }
+  to.setOrigin(from.getOrigin()+dpos*lo);
+  body.setWorldTransform(to);
   updateSingleAabb(&body);
-  return true;
+  return false;
   }
@@ -22,6 +22,20 @@ class CollisionWorld : public btCollisionWorld {
     void addRigidBody   (btRigidBody* body);
     void removeRigidBody(btRigidBody* body);
 
+    void addCollisionObject   (btCollisionObject* obj,
+                               int group = btBroadphaseProxy::DefaultFilter,
+                               int mask  = btBroadphaseProxy::AllFilter) override;
+    void removeCollisionObject(btCollisionObject* obj) override;
+    // moves static or movable object; rigid bodies are moved by tick
+    void setObjTransform(btCollisionObject& obj, const btTransform& tr);
+
+    // changes, whenever collision seen by land and water rays may change: object moved, added or removed.
+    // Result of a ray, computed at same epoch, is still valid
+    uint64_t rayEpoch() const { return rayEp; }
+
+    // bodies, moved by last tick
+    auto movedBodies() const -> const std::vector<btRigidBody*>& { return moved; }
+
   private:
     struct Broadphase;
     struct ContructInfo;
@@ -29,7 +43,7 @@ class CollisionWorld : public btCollisionWorld {
     CollisionWorld(std::unique_ptr<btCollisionConfiguration>&& conf);
     CollisionWorld(ContructInfo ci);
 
-    bool tick(float step, btRigidBody& body);
+    bool sweep(btRigidBody& body, const btVector3& dpos);
     bool hasCollision(btRigidBody& it, Tempest::Vec3& normal);
 
     std::unique_ptr<btCollisionConfiguration>   conf;
@@ -37,8 +51,12 @@ class CollisionWorld : public btCollisionWorld {
     std::unique_ptr<btBroadphaseInterface>      broad;
 
     std::vector<btRigidBody*>                   rigid;
+    std::vector<btRigidBody*>                   moved;
     btVector3                                   gravity = {};
 
     mutable uint32_t aabbChanged = 0;
+    uint64_t         rayEp       = 0;
+
+    void touchRays(const btCollisionObject& obj);
   };
 
@@ -21,32 +21,58 @@
 #include <BulletCollision/CollisionShapes/btTriangleMesh.h>
 #include <BulletCollision/CollisionShapes/btConeShape.h>
 #include <BulletCollision/CollisionShapes/btMultimaterialTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
 #include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
 #include <BulletCollision/CollisionDispatch/btSimulationIslandManager.h>
 #include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
 #include <LinearMath/btDefaultMotionState.h>
 #include <LinearMath/btScalar.h>
 
+#include "capsulesweep.h"
 #include "collisionworld.h"
+#include "groundcache.h"
+#include "physiccache.h"
 #include "physicmeshshape.h"
 #include "physicvbo.h"
+#include "raybatch.h"
+#include "sweepaxis.h"
 #include "graphics/mesh/skeleton.h"
 
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
 
+#include <Tempest/Application>
+#include <Tempest/Log>
+
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 
-#include "graphics/mesh/submesh/packedmesh.h"
 #include "world/objects/item.h"
 #include "world/bullet.h"
+#include "world/world.h"
+#include "utils/workers.h"
 
 const float DynamicWorld::ghostPadding=50-22.5f;
 const float DynamicWorld::ghostHeight =140;
 const float DynamicWorld::worldHeight =20000;
 
+// uses serialized bvh from `bvh` if any, otherwise builds new one and stores it's serialized copy in `bvh`
+static btMultimaterialTriangleMeshShape* mkShape(PhysicVbo& mesh, PhysicCache::BvhBuffer& bvh) {
+  if(bvh.size()>0) {
+    auto ret = new btMultimaterialTriangleMeshShape(&mesh,mesh.useQuantization(),false);
+    if(auto b = btOptimizedBvh::deSerializeInPlace(&bvh[0],unsigned(size_t(bvh.size())*sizeof(btVector3)),false)) {
+      ret->setOptimizedBvh(b);
+      return ret;
+      }
+    delete ret;
+    }
+  auto ret = new btMultimaterialTriangleMeshShape(&mesh,mesh.useQuantization(),true);
+  PhysicCache::serialize(*ret->getOptimizedBvh(),bvh);
+  return ret;
+  }
+
 struct DynamicWorld::HumShape:btCapsuleShape {
   HumShape(btScalar radius, btScalar height):btCapsuleShape(height<=0.f ? 0.f : radius,height) {}
 
@@ -71,8 +97,7 @@ struct DynamicWorld::NpcBody : btRigidBody {
   Tempest::Vec3 pos={};
   float         r=0, h=0, rX=0, rZ=0;
   bool          enable=true;
-  size_t        frozen=size_t(-1);
-  uint64_t      lastMove=0;
+  size_t        slot=0;
 
   Npc* getNpc() {
     return reinterpret_cast<Npc*>(getUserPointer());
@@ -89,14 +114,8 @@ struct DynamicWorld::NpcBody : btRigidBody {
   };
 
 struct DynamicWorld::NpcBodyList final {
-  struct Record final {
-    NpcBody* body     = nullptr;
-    float    x        = 0.f;
-    };
-
   NpcBodyList(DynamicWorld& wrld):wrld(wrld){
     body.reserve(1024);
-    frozen.reserve(1024);
     }
 
   NpcBody* create(const ZMath::float3 &min, const ZMath::float3 &max) {
@@ -122,48 +141,16 @@ struct DynamicWorld::NpcBodyList final {
     //world->addCollisionObject(obj);
     add(obj);
     resize(*obj,height,dx,dz);
+    maxShapeR = std::max(maxShapeR,dim*0.5f);
     return obj;
     }
 
   void add(NpcBody* b){
-    Record r;
-    r.body = b;
-    r.x    = b->pos.x;
-    body.push_back(r);
+    body.add(b);
     }
 
-  bool del(void* b){
-    if(del(b,body))
-      return true;
-    if(del(b,frozen)){
-      srt=false;
-      return true;
-      }
-    return false;
-    }
-
-  bool del(void* b,std::vector<Record>& arr){
-    for(size_t i=0;i<arr.size();++i){
-      if(arr[i].body!=b)
-        continue;
-      arr[i]=arr.back();
-      arr.pop_back();
-      return true;
-      }
-    return false;
-    }
-
-  bool delMisordered(NpcBody* b,std::vector<Record>& arr){
-    auto&       fr = arr[b->frozen];
-    const float x  = fr.x;
-    if((b->frozen==0 || arr[b->frozen-1].x<x) &&
-       (b->frozen+1==arr.size() || x<arr[b->frozen+1].x)) {
-      fr.x = fr.body->pos.x;
-      return false;
-      } else {
-      fr.body = nullptr;
-      return true;
-      }
+  bool del(NpcBody* b){
+    return body.del(b);
     }
 
   void resize(NpcBody& n, float h, float dx, float dz){
@@ -178,66 +165,34 @@ struct DynamicWorld::NpcBodyList final {
     }
 
   void onMove(NpcBody& n){
-    if(n.frozen!=size_t(-1)) {
-      if(delMisordered(&n,frozen)){
-        n.lastMove = tick;
-        n.frozen   = size_t(-1);
-
-        Record r;
-        r.body = &n;
-        body.push_back(r);
-        }
-      } else {
-      n.lastMove = tick;
-      }
-    }
-
-  bool rayTest(NpcBody& npc, const btVector3& s, const btVector3& e) {
-    struct CallBack:btCollisionWorld::ClosestRayResultCallback {
-      using ClosestRayResultCallback::ClosestRayResultCallback;
-      };
-    CallBack callback{s,e};
-
-    btTransform rayFromTrans,rayToTrans;
-    rayFromTrans.setIdentity();
-    rayFromTrans.setOrigin(s);
-    rayToTrans.setIdentity();
-    rayToTrans.setOrigin(e);
-
-    return rayTestSingle(rayFromTrans, rayToTrans, npc, callback);
+    body.onMove(n);
     }
 
-  NpcBody* rayTest(const btVector3& s, const btVector3& e) {
-    struct CallBack:btCollisionWorld::ClosestRayResultCallback {
-      using ClosestRayResultCallback::ClosestRayResultCallback;
-      };
-    CallBack callback{s,e};
-
-    btTransform rayFromTrans,rayToTrans;
-    rayFromTrans.setIdentity();
-    rayFromTrans.setOrigin(s);
-    rayToTrans.setIdentity();
-    rayToTrans.setOrigin(e);
-
-    for(auto i:body)
-      if(rayTestSingle(rayFromTrans, rayToTrans, *i.body, callback))
-        return i.body;
-    for(auto i:frozen)
-      if(i.body!=nullptr && rayTestSingle(rayFromTrans, rayToTrans, *i.body, callback))
-        return i.body;
-    return nullptr;
-    }
-
-  bool rayTestSingle(const btTransform& s,
-                     const btTransform& e, NpcBody& npc,
-                     btCollisionWorld::RayResultCallback& callback){
+  // segment vs npc capsule; fraction of first contact along [s,e]. Segment, starting inside, hits at 0
+  static bool sweepTest(const NpcBody& npc, const btVector3& s, const btVector3& e, float& frac) {
     if(!npc.enable)
       return false;
-    wrld.world->rayTestSingle(s, e, &npc,
-                              npc.getCollisionShape(),
-                              npc.getWorldTransform(),
-                              callback);
-    return callback.hasHit();
+    auto&           shape = static_cast<const HumShape&>(*npc.getCollisionShape());
+    const btVector3 up    = btVector3(0,shape.getHalfHeight(),0);
+    const btVector3 c     = npc.getWorldTransform().getOrigin();
+    return capsuleSweep(c-up,c+up,shape.getRadius(),s,e,frac);
+    }
+
+  // closest npc along the segment; shooter is not hit by own bullet
+  NpcBody* rayTest(const btVector3& s, const btVector3& e, const Npc* shooter) const {
+    NpcBody* ret  = nullptr;
+    float    frac = 1.f;
+    auto     rg   = body.range(std::min(s.x(),e.x())-maxShapeR, std::max(s.x(),e.x())+maxShapeR);
+    for(auto i=rg.first; i!=rg.second; ++i) {
+      if(shooter!=nullptr && i->body->getNpc()==shooter)
+        continue;
+      float f = 0;
+      if(sweepTest(*i->body,s,e,f) && f<=frac) {
+        frac = f;
+        ret  = i->body;
+        }
+      }
+    return ret;
     }
 
   bool hasCollision(const DynamicWorld::NpcItem& obj,Tempest::Vec3& normal) {
@@ -245,41 +200,19 @@ struct DynamicWorld::NpcBodyList final {
     if(disable)
       return false;
 
-    const NpcBody* pn = dynamic_cast<const NpcBody*>(obj.obj);
+    const NpcBody* pn = obj.obj;
     if(pn==nullptr)
       return false;
     const NpcBody& n = *pn;
 
-    if(srt){
-      if(hasCollision(n,frozen,normal,true))
-        return true;
-      return hasCollision(n,body,normal,false);
-      } else {
-      if(hasCollision(n,body,normal,false))
-        return true;
-      //adjustSort();
-      return hasCollision(n,frozen,normal,false);
-      }
-    }
-
-  bool hasCollision(const NpcBody& n,const std::vector<Record>& arr,Tempest::Vec3& normal, bool sorted) {
-    auto l = arr.begin();
-    auto r = arr.end();
-
-    if(sorted) {
-      const float dX = maxR+n.r;
-      l = std::lower_bound(arr.begin(),arr.end(),n.pos.x-dX,[](const Record& b,float x){ return b.x<x; });
-      r = std::upper_bound(arr.begin(),arr.end(),n.pos.x+dX,[](float x,const Record& b){ return x<b.x; });
-      }
-
-    const auto dist = std::distance(l,r);
-    if(dist<=1)
-      return false;
+    // n may be moved by tryMove, without updating it's own record - range is taken from actual position
+    const float dX = maxR+n.r;
+    auto        rg = body.range(n.pos.x-dX,n.pos.x+dX);
 
     bool ret=false;
-    for(;l!=r;++l){
-      auto& v = (*l);
-      if(v.body!=nullptr && v.body->enable && hasCollision(n,*v.body,normal))
+    for(auto i=rg.first; i!=rg.second; ++i){
+      auto& v = *i->body;
+      if(v.enable && hasCollision(n,v,normal))
         ret = true;
       }
     return ret;
@@ -302,54 +235,22 @@ struct DynamicWorld::NpcBodyList final {
     return true;
     }
 
-  void adjustSort() {
-    srt=true;
-    std::sort(frozen.begin(),frozen.end(),[](Record& a,Record& b){
-      return a.x < b.x;
-      });
-    for(size_t i=0; i<frozen.size(); ++i)
-      frozen[i].body->frozen = i;
-    }
-
-  void tickAabbs() {
-    for(size_t i=0;i<body.size();) {
-      if(body[i].body->lastMove!=tick){
-        auto b = body[i];
-        body[i]=body.back();
-        body.pop_back();
-
-        b.x = b.body->pos.x;
-        frozen.push_back(b);
-        } else {
-        ++i;
-        }
-      }
-
-    for(size_t i=0;i<frozen.size();) {
-      if(frozen[i].body==nullptr) {
-        frozen[i]=frozen.back();
-        frozen.pop_back();
-        }
-      else if(frozen[i].body->lastMove==tick){
-        frozen[i].body->frozen=size_t(-1);
-        body.push_back(frozen[i]);
-        frozen[i]=frozen.back();
-        frozen.pop_back();
-        }
-      else {
-        ++i;
-        }
-      }
-
-    adjustSort();
-    tick++;
-    }
-
   DynamicWorld&         wrld;
-  std::vector<Record>   body, frozen;
-  bool                  srt=false;
-  uint64_t              tick=0;
+  SweepAxis<NpcBody>    body;
   float                 maxR=0;
+  float                 maxShapeR=0;
+  };
+
+// collision probe of a single bullet step; computed in parallel, applied serially
+struct DynamicWorld::BulletStep final {
+  BulletBody*       body  = nullptr;
+  btVector3         s     = {};
+  btVector3         e     = {};
+  BBoxBody*         bbox  = nullptr;
+  NpcBody*          npc   = nullptr;
+  uint8_t           matId = ZenLoad::NUM_MAT_GROUPS;
+  float             frac  = 1.f;
+  btVector3         norm  = {};
   };
 
 struct DynamicWorld::BulletsList final {
@@ -357,42 +258,48 @@ struct DynamicWorld::BulletsList final {
     }
 
   BulletBody* add(BulletCallback* cb) {
-    BulletBody b(&wrld,cb);
-    body.push_front(std::move(b));
-    return &body.front();
+    body.emplace_back(new BulletBody(&wrld,cb));
+    body.back()->slot = body.size()-1;
+    return body.back().get();
     }
 
   void del(BulletBody* b) {
-    for(auto i=body.begin(), e=body.end();i!=e;++i){
-      if(&(*i)==b) {
-        body.erase(i);
-        return;
-        }
-      }
+    if(b==nullptr || b->slot>=body.size() || body[b->slot].get()!=b)
+      return;
+    // keep insertion order: callbacks are applied in it
+    body.erase(body.begin()+std::ptrdiff_t(b->slot));
+    for(size_t i=b->slot; i<body.size(); ++i)
+      body[i]->slot = i;
     }
 
   void tick(uint64_t dt) {
-    for(auto& i:body) {
-      wrld.moveBullet(i,i.dir.x,i.dir.y,i.dir.z,dt);
-      if(i.cb!=nullptr)
-        i.cb->onMove();
+    if(body.empty())
+      return;
+    step.resize(body.size());
+    for(size_t i=0; i<body.size(); ++i) {
+      step[i]      = BulletStep();
+      step[i].body = body[i].get();
       }
-    }
 
-  void onMoveNpc(NpcBody& npc, NpcBodyList& list){
-    for(auto& i:body) {
-      btVector3 s = {i.lastPos.x,i.lastPos.y,i.lastPos.z};
-      btVector3 e = {i.pos.x,i.pos.y,i.pos.z};
+    // npc's don't move and world doesn't change during physics tick, so all probes are independent
+    wrld.world->updateAabbs();
+    Workers::parallelFor(step,[this,dt](BulletStep& st){
+      wrld.probeBullet(st,dt);
+      });
 
-      if(i.cb!=nullptr && list.rayTest(npc,s,e)) {
-        i.cb->onCollide(*npc.getNpc());
-        i.cb->onStop();
-        }
+    // newest bullet first, same as former push_front list
+    for(size_t i=step.size(); i>0; ) {
+      --i;
+      auto& st = step[i];
+      wrld.moveBullet(st,dt);
+      if(st.body->cb!=nullptr)
+        st.body->cb->onMove();
       }
     }
 
-  std::list<BulletBody> body;
-  DynamicWorld&         wrld;
+  std::vector<std::unique_ptr<BulletBody>> body;
+  std::vector<BulletStep>                  step;
+  DynamicWorld&                            wrld;
   };
 
 struct DynamicWorld::BBoxList final {
@@ -444,45 +351,56 @@ struct DynamicWorld::BBoxList final {
   DynamicWorld&        wrld;
   };
 
-DynamicWorld::DynamicWorld(World&,const ZenLoad::zCMesh& worldMesh) {
+DynamicWorld::DynamicWorld(World&, PhysicCache& cache) {
   //solver.reset(new btSequentialImpulseConstraintSolver());
   world.reset(new CollisionWorld());
 
-  PackedMesh pkg(worldMesh,PackedMesh::PK_PhysicZoned);
-  sectors.resize(pkg.subMeshes.size());
-  for(size_t i=0;i<sectors.size();++i)
-    sectors[i] = pkg.subMeshes[i].material.matName;
+  const uint64_t time  = Tempest::Application::tickCount();
+  const bool     fresh = !cache.isLoaded();
 
-  landVbo.resize(pkg.vertices.size());
-  for(size_t i=0;i<pkg.vertices.size();++i) {
-    auto& p = pkg.vertices[i].Position;
-    landVbo[i].setValue(p.x,p.y,p.z);
-    }
+  sectors = std::move(cache.sectors);
+  landVbo = std::move(cache.vertices);
 
   landMesh .reset(new PhysicVbo(&landVbo));
   waterMesh.reset(new PhysicVbo(&landVbo));
 
-  for(size_t i=0;i<pkg.subMeshes.size();++i) {
-    auto& sm = pkg.subMeshes[i];
-    if(!sm.material.noCollDet && sm.indices.size()>0) {
-      if(sm.material.matGroup==ZenLoad::MaterialGroup::WATER) {
-        waterMesh->addIndex(std::move(sm.indices),sm.material.matGroup);
-        } else {
-        landMesh ->addIndex(std::move(sm.indices),sm.material.matGroup,sectors[i].c_str());
-        }
+  for(auto& sm:cache.meshes) {
+    // fresh meshes are saved to cache afterwards
+    std::vector<uint32_t> index;
+    if(fresh)
+      index = sm.indices; else
+      index = std::move(sm.indices);
+    if(sm.water) {
+      waterMesh->addIndex(std::move(index),sm.mat);
+      } else {
+      landMesh ->addIndex(std::move(index),sm.mat,sectors[sm.sector].c_str());
       }
     }
 
   if(!landMesh->isEmpty()) {
-    landShape.reset(new btMultimaterialTriangleMeshShape(landMesh.get(),landMesh->useQuantization(),true));
+    auto shape = mkShape(*landMesh,cache.landBvh);
+    landShape.reset(shape);
     landBody = landObj();
+    ground.reset(new GroundCache(landVbo,*shape,*world));
     }
 
   if(!waterMesh->isEmpty()) {
-    waterShape.reset(new btMultimaterialTriangleMeshShape(waterMesh.get(),waterMesh->useQuantization(),true));
+    waterShape.reset(mkShape(*waterMesh,cache.waterBvh));
     waterBody = waterObj();
     }
 
+  if(fresh) {
+    cache.sectors  = sectors;
+    cache.vertices = landVbo;
+    cache.save();
+    } else {
+    // deserialized bvh lives in cache buffers
+    landBvh .swap(cache.landBvh);
+    waterBvh.swap(cache.waterBvh);
+    }
+  Tempest::Log::i("physics: ",(fresh ? "built" : "loaded from cache")," in ",
+                  Tempest::Application::tickCount()-time,"ms");
+
   if(landBody!=nullptr)
     world->addCollisionObject(landBody.get());
   if(waterBody!=nullptr)
@@ -494,6 +412,28 @@ DynamicWorld::DynamicWorld(World&,const ZenLoad::zCMesh& worldMesh) {
   bboxList  .reset(new BBoxList   (*this));
   }
 
+bool DynamicWorld::bakeCache(const std::string& name, const ZenLoad::zCMesh& worldMesh) {
+  PhysicCache cache(name,worldMesh);
+  if(cache.isLoaded())
+    return true;
+  cache.pack(worldMesh);
+
+  PhysicVbo land (&cache.vertices);
+  PhysicVbo water(&cache.vertices);
+  for(auto& sm:cache.meshes) {
+    if(sm.water)
+      water.addIndex(std::vector<uint32_t>(sm.indices),sm.mat); else
+      land .addIndex(std::vector<uint32_t>(sm.indices),sm.mat,cache.sectors[sm.sector].c_str());
+    }
+  // shapes are needed only to build and serialize bvh
+  std::unique_ptr<btCollisionShape> shape;
+  if(!land.isEmpty())
+    shape.reset(mkShape(land,cache.landBvh));
+  if(!water.isEmpty())
+    shape.reset(mkShape(water,cache.waterBvh));
+  return cache.save();
+  }
+
 DynamicWorld::~DynamicWorld(){
   if(waterBody!=nullptr)
     world->removeCollisionObject(waterBody.get());
@@ -501,18 +441,110 @@ DynamicWorld::~DynamicWorld(){
     world->removeCollisionObject(landBody .get());
   }
 
+// accumulates wall time of ground probes; probes may run on worker threads
+struct DynamicWorld::ProbeTimer final {
+  explicit ProbeTimer(std::atomic<uint64_t>& ns):ns(ns),t0(std::chrono::steady_clock::now()) {}
+  ~ProbeTimer() {
+    auto dt = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-t0);
+    ns.fetch_add(uint64_t(dt.count()),std::memory_order_relaxed);
+    }
+  std::atomic<uint64_t>&                ns;
+  std::chrono::steady_clock::time_point t0;
+  };
+
 DynamicWorld::RayLandResult DynamicWorld::landRay(float x, float y, float z, float maxDy) const {
-  world->updateAabbs();
+  ProbeTimer timer(landRayNs);
   if(maxDy==0)
     maxDy = worldHeight;
+  RayLandResult ret;
+  if(groundRay(x,y+ghostPadding,y-maxDy,z,ret))
+    return ret;
+  world->updateAabbs();
   return ray(x,y+ghostPadding,z, x,y-maxDy,z);
   }
 
+void DynamicWorld::landRayBatch(const std::vector<Tempest::Vec3>& at, std::vector<RayLandResult>& out, float maxDy) const {
+  landRayBatch(at,std::vector<float>(at.size(),maxDy),out);
+  }
+
+void DynamicWorld::landRayBatch(const std::vector<Tempest::Vec3>& at, const std::vector<float>& maxDy, std::vector<RayLandResult>& out) const {
+  ProbeTimer timer(landRayNs);
+  out.resize(at.size());
+
+  // pure landscape is answered by ground cache, only the rest goes to real rays
+  std::vector<size_t>  id(at.size());
+  std::vector<uint8_t> cached(at.size());
+  for(size_t i=0; i<id.size(); ++i)
+    id[i] = i;
+  Workers::parallelFor(id,[this,&at,&maxDy,&out,&cached](size_t& i){
+    const float dy = (maxDy[i]==0 ? worldHeight : maxDy[i]);
+    cached[i] = groundRay(at[i].x,at[i].y+ghostPadding,at[i].y-dy,at[i].z,out[i]) ? 1 : 0;
+    });
+
+  std::vector<RayQuery> q;
+  id.clear();
+  for(size_t i=0; i<at.size(); ++i) {
+    if(cached[i])
+      continue;
+    const float dy = (maxDy[i]==0 ? worldHeight : maxDy[i]);
+    RayQuery r;
+    r.from = Tempest::Vec3(at[i].x,at[i].y+ghostPadding,at[i].z);
+    r.to   = Tempest::Vec3(at[i].x,at[i].y-dy,          at[i].z);
+    q .push_back(r);
+    id.push_back(i);
+    }
+
+  std::vector<RayLandResult> ret;
+  rayBatch(q,ret);
+  for(size_t i=0; i<id.size(); ++i)
+    out[id[i]] = ret[i];
+  }
+
+bool DynamicWorld::groundRay(float x, float y0, float y1, float z, RayLandResult& out) const {
+  GroundCache::Hit hit;
+  if(ground==nullptr || !ground->landRay(x,y0,y1,z,hit))
+    return false;
+
+  out = RayLandResult();
+  if(hit.hasCol) {
+    out.v      = Tempest::Vec3(x,hit.y,z);
+    out.n      = hit.n;
+    out.mat    = landMesh->getMaterialId(size_t(hit.part));
+    out.sector = landMesh->getSectorName(size_t(hit.part));
+    out.hasCol = true;
+    } else {
+    out.v      = Tempest::Vec3(x,y1,z);
+    out.n      = Tempest::Vec3(0,1,0);
+    }
+  return true;
+  }
+
+void DynamicWorld::rayBatch(const std::vector<RayQuery>& q, std::vector<RayLandResult>& out) const {
+  out.resize(q.size());
+  world->updateAabbs();
+  RayBatch::run(q,[this,&q,&out](size_t i){
+    auto& r = q[i];
+    out[i] = ray(r.from.x,r.from.y,r.from.z, r.to.x,r.to.y,r.to.z);
+    });
+  }
+
 DynamicWorld::RayWaterResult DynamicWorld::waterRay(float x, float y, float z) const {
   world->updateAabbs();
   return implWaterRay(x,y,z, x,y+worldHeight,z);
   }
 
+void DynamicWorld::waterRayBatch(const std::vector<Tempest::Vec3>& at, std::vector<RayWaterResult>& out) const {
+  out.resize(at.size());
+  std::vector<size_t> id(at.size());
+  for(size_t i=0; i<id.size(); ++i)
+    id[i] = i;
+
+  world->updateAabbs();
+  Workers::parallelFor(id,[this,&at,&out](size_t& i){
+    out[i] = implWaterRay(at[i].x,at[i].y,at[i].z, at[i].x,at[i].y+worldHeight,at[i].z);
+    });
+  }
+
 DynamicWorld::RayWaterResult DynamicWorld::implWaterRay(float x0, float y0, float z0, float x1, float y1, float z1) const {
   struct CallBack:btCollisionWorld::ClosestRayResultCallback {
     using ClosestRayResultCallback::ClosestRayResultCallback;
@@ -746,6 +778,7 @@ DynamicWorld::Item DynamicWorld::createObj(btCollisionShape* shape, bool ownShap
     case IT_Movable:
     case IT_Static:
       world->addCollisionObject(obj.get());
+      invalidateGround(obj.get());
       break;
     case IT_Dynamic:
       world->addRigidBody(obj.get());
@@ -779,17 +812,18 @@ DynamicWorld::BBoxBody* DynamicWorld::bboxObj(BBoxCallback* cb, const ZMath::flo
   return bboxList->add(cb,bbox);
   }
 
-void DynamicWorld::moveBullet(BulletBody &b, float dx, float dy, float dz, uint64_t dt) {
-  float k  = float(dt)/1000.f;
-  const bool isSpell = b.isSpell();
+void DynamicWorld::probeBullet(BulletStep& st, uint64_t dt) const {
+  auto&       b       = *st.body;
+  const float k       = float(dt)/1000.f;
+  const bool  isSpell = b.isSpell();
 
   auto  p  = b.pos;
   float x0 = p.x;
   float y0 = p.y;
   float z0 = p.z;
-  float x1 = x0+dx*k;
-  float y1 = y0+dy*k - (isSpell ? 0 : gravity*k*k);
-  float z1 = z0+dz*k;
+  float x1 = x0+b.dir.x*k;
+  float y1 = y0+b.dir.y*k - (isSpell ? 0 : gravity*k*k);
+  float z1 = z0+b.dir.z*k;
 
   struct CallBack:btCollisionWorld::ClosestRayResultCallback {
     using ClosestRayResultCallback::ClosestRayResultCallback;
@@ -815,37 +849,66 @@ void DynamicWorld::moveBullet(BulletBody &b, float dx, float dy, float dz, uint6
       }
     };
 
-  btVector3 s(x0,y0,z0), e(x1,y1,z1);
-  CallBack callback{s,e};
+  st.s = btVector3(x0,y0,z0);
+  st.e = btVector3(x1,y1,z1);
+  st.bbox = bboxList->rayTest(st.s,st.e);
+
+  // npc's may have walked into previous segment of the bullet since last tick
+  const btVector3 prev(b.lastPos.x,b.lastPos.y,b.lastPos.z);
+  const Npc*      shooter = b.cb!=nullptr ? b.cb->owner() : nullptr;
+  st.npc = npcList->rayTest(prev,st.s,shooter);
+  if(st.npc==nullptr)
+    st.npc = npcList->rayTest(st.s,st.e,shooter);
+  if(st.npc!=nullptr)
+    return;
+
+  CallBack callback{st.s,st.e};
   callback.m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
+  rayTest(st.s,st.e,callback);
 
-  if(auto ptr = bboxList->rayTest(s,e)) {
+  st.matId = callback.matId;
+  st.frac  = callback.m_closestHitFraction;
+  st.norm  = callback.m_hitNormalWorld;
+  }
+
+void DynamicWorld::moveBullet(BulletStep& st, uint64_t dt) {
+  auto&       b       = *st.body;
+  const float k       = float(dt)/1000.f;
+  const bool  isSpell = b.isSpell();
+
+  float x0 = st.s.x();
+  float y0 = st.s.y();
+  float z0 = st.s.z();
+  float x1 = st.e.x();
+  float y1 = st.e.y();
+  float z1 = st.e.z();
+
+  if(auto ptr = st.bbox) {
     if(ptr->cb!=nullptr) {
       ptr->cb->onCollide(b);
       }
     }
 
-  if(auto ptr = npcList->rayTest(s,e)) {
+  if(auto ptr = st.npc) {
     if(b.cb!=nullptr) {
       b.cb->onCollide(*ptr->getNpc());
       b.cb->onStop();
       }
     return;
     }
-  rayTest(s,e,callback);
 
-  if(callback.matId<ZenLoad::NUM_MAT_GROUPS) {
+  if(st.matId<ZenLoad::NUM_MAT_GROUPS) {
     if( isSpell ){
       if(b.cb!=nullptr) {
-        b.cb->onCollide(callback.matId);
+        b.cb->onCollide(st.matId);
         b.cb->onStop();
         }
       } else {
-      if(callback.matId==ZenLoad::MaterialGroup::METAL ||
-         callback.matId==ZenLoad::MaterialGroup::STONE) {
+      if(st.matId==ZenLoad::MaterialGroup::METAL ||
+         st.matId==ZenLoad::MaterialGroup::STONE) {
         auto d = b.dir;
         btVector3 m = {d.x,d.y,d.z};
-        btVector3 n = callback.m_hitNormalWorld;
+        btVector3 n = st.norm;
 
         n.normalize();
         const float l = b.speed();
@@ -854,18 +917,18 @@ void DynamicWorld::moveBullet(BulletBody &b, float dx, float dy, float dz, uint6
         btVector3 dir = m - 2*m.dot(n)*n;
         dir*=(l*0.5f); //slow-down
 
-        float a = callback.m_closestHitFraction;
+        float a = st.frac;
         b.move(x0+(x1-x0)*a,y0+(y1-y0)*a,z0+(z1-z0)*a);
         if(l*a>10.f) {
           b.setDirection(dir.x(),dir.y(),dir.z());
           b.addPathLen(l*a);
           }
         } else {
-        float a = callback.m_closestHitFraction;
+        float a = st.frac;
         b.move(x0+(x1-x0)*a,y0+(y1-y0)*a,z0+(z1-z0)*a);
         }
       if(b.cb!=nullptr) {
-        b.cb->onCollide(callback.matId);
+        b.cb->onCollide(st.matId);
         b.cb->onStop();
         }
       }
@@ -884,12 +947,20 @@ void DynamicWorld::moveBullet(BulletBody &b, float dx, float dy, float dz, uint6
 void DynamicWorld::tick(uint64_t dt) {
   static bool dynamic = true;
 
-  npcList->tickAabbs();
+  {
+    auto st = groundCacheTotal();
+    groundFrame.tiles    = st.tiles;
+    groundFrame.hit      = st.hit     -groundTotal.hit;
+    groundFrame.fallback = st.fallback-groundTotal.fallback;
+    groundFrame.us       = st.us      -groundTotal.us;
+    groundTotal          = st;
+    }
+
   bulletList->tick(dt);
   if(dynamic)
     world->tick(dt);
 
-  for(auto i:dynItems)
+  for(auto i:world->movedBodies())
     if(auto ptr = reinterpret_cast<::Item*>(i->getUserPointer())) {
       auto& t = i->getWorldTransform();
       Tempest::Matrix4x4 mt;
@@ -905,10 +976,24 @@ void DynamicWorld::tick(uint64_t dt) {
     }
   }
 
+uint64_t DynamicWorld::rayEpoch() const {
+  return world->rayEpoch();
+  }
+
 void DynamicWorld::updateSingleAabb(btCollisionObject *obj) {
   world->updateSingleAabb(obj);
   }
 
+void DynamicWorld::invalidateGround(btCollisionObject* obj) {
+  if(obj->getUserIndex()!=C_Object)
+    return;
+  if(ground==nullptr)
+    return;
+  btVector3 aabbMin, aabbMax;
+  obj->getCollisionShape()->getAabb(obj->getWorldTransform(),aabbMin,aabbMax);
+  ground->invalidate(aabbMin,aabbMax);
+  }
+
 void DynamicWorld::deleteObj(NpcBody *obj) {
   if(!obj)
     return;
@@ -976,11 +1061,28 @@ const char* DynamicWorld::validateSectorName(const char* name) const {
   return landMesh->validateSectorName(name);
   }
 
+DynamicWorld::GroundCacheStats DynamicWorld::groundCacheStats() const {
+  return groundFrame;
+  }
+
+DynamicWorld::GroundCacheStats DynamicWorld::groundCacheTotal() const {
+  GroundCacheStats ret;
+  if(ground!=nullptr) {
+    auto st = ground->stats();
+    ret.tiles    = st.tiles;
+    ret.hit      = st.hit;
+    ret.fallback = st.fallback;
+    }
+  ret.us = uint32_t(landRayNs.load(std::memory_order_relaxed)/1000);
+  return ret;
+  }
+
 void DynamicWorld::deleteObj(btCollisionObject *obj) {
   if(obj==nullptr)
     return;
 
   std::unique_ptr<btCollisionObject> ref{obj};
+  invalidateGround(obj);
   world->touchAabbs();
   for(size_t i=0; i<dynItems.size(); ++i)
     if(dynItems[i]==obj) {
@@ -1069,7 +1171,6 @@ void DynamicWorld::NpcItem::setPosition(const Tempest::Vec3& pos) {
   if(obj) {
     implSetPosition(pos);
     owner->npcList->onMove(*obj);
-    owner->bulletList->onMoveNpc(*obj,*owner->npcList);
     }
   }
 
@@ -1153,7 +1254,6 @@ bool DynamicWorld::NpcItem::tryMove(const Tempest::Vec3& dp, Tempest::Vec3& norm
       }
     }
   owner->npcList->onMove(*obj);
-  owner->bulletList->onMoveNpc(*obj,*owner->npcList);
   return true;
   }
 
@@ -1176,8 +1276,9 @@ void DynamicWorld::Item::setObjMatrix(const Tempest::Matrix4x4 &m) {
     trans.setFromOpenGLMatrix(reinterpret_cast<const btScalar*>(&m));
     if(obj->getWorldTransform()==trans)
       return;
-    obj->setWorldTransform(trans);
-    owner->updateSingleAabb(obj);
+    owner->invalidateGround(obj);
+    owner->world->setObjTransform(*obj,trans);
+    owner->invalidateGround(obj);
     }
   }
 
@@ -1191,7 +1292,7 @@ DynamicWorld::BulletBody::BulletBody(DynamicWorld* wrld, DynamicWorld::BulletCal
 
 DynamicWorld::BulletBody::BulletBody(DynamicWorld::BulletBody&& other)
   : pos(other.pos), lastPos(other.lastPos),
-    dir(other.dir), dirL(other.dirL), totalL(other.totalL), spl(other.spl){
+    dir(other.dir), dirL(other.dirL), totalL(other.totalL), spl(other.spl), slot(other.slot){
   std::swap(owner,other.owner);
   std::swap(cb,other.cb);
   }
@@ -4,8 +4,20 @@
 #include <zenload/zTypes.h>
 #include <zenload/zCMaterial.h>
 #include <Tempest/Matrix4x4>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#endif
+#include <LinearMath/btAlignedObjectArray.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <atomic>
 #include <memory>
 #include <limits>
+#include <vector>
 
 class btTriangleIndexVertexArray;
 class btCollisionShape;
@@ -14,7 +26,9 @@ class btRigidBody;
 class btVector3;
 
 class PhysicMeshShape;
+class PhysicCache;
 class PhysicVbo;
+class GroundCache;
 class PackedMesh;
 class Bounds;
 
@@ -28,9 +42,11 @@ class CollisionWorld;
 class DynamicWorld final {
   private:
     struct HumShape;
+    struct ProbeTimer;
     struct NpcBody;
     struct NpcBodyList;
     struct BulletsList;
+    struct BulletStep;
     struct BBoxList;
 
   public:
@@ -40,10 +56,14 @@ class DynamicWorld final {
     static constexpr float spellSpeed  = 1000; // per sec
     static const     float ghostPadding;
 
-    DynamicWorld(World &world, const ZenLoad::zCMesh& mesh);
+    // cache is either loaded or packed from landscape mesh; fresh one is saved
+    DynamicWorld(World &world, PhysicCache& cache);
     DynamicWorld(const DynamicWorld&)=delete;
     ~DynamicWorld();
 
+    // build on-disk physics cache of the world, without creating collision world
+    static bool bakeCache(const std::string& name, const ZenLoad::zCMesh& mesh);
+
     enum Category {
       C_Null      = 1,
       C_Landscape = 2,
@@ -125,6 +145,18 @@ class DynamicWorld final {
       const char*         sector  = nullptr;
       };
 
+    struct RayQuery {
+      Tempest::Vec3       from={};
+      Tempest::Vec3       to  ={};
+      };
+
+    struct GroundCacheStats {
+      uint32_t            tiles    = 0;
+      uint32_t            hit      = 0;
+      uint32_t            fallback = 0;
+      uint32_t            us       = 0; // time spent in landRay and landRayBatch
+      };
+
     struct RayWaterResult {
       float               wdepth  = 0.f;
       bool                hasCol = false;
@@ -136,6 +168,7 @@ class DynamicWorld final {
       virtual void onMove(){}
       virtual void onCollide(uint8_t matId){(void)matId;}
       virtual void onCollide(Npc& other){(void)other;}
+      virtual Npc* owner() const { return nullptr; }
       };
 
     struct BulletBody final {
@@ -169,6 +202,7 @@ class DynamicWorld final {
         float               dirL=0.f;
         float               totalL=0.f;
         int                 spl=std::numeric_limits<int>::max();
+        size_t              slot=0;
 
       friend class DynamicWorld;
       };
@@ -198,6 +232,13 @@ class DynamicWorld final {
     RayWaterResult waterRay   (float x, float y, float z) const;
 
     RayLandResult  ray        (float x0, float y0, float z0, float x1, float y1, float z1) const;
+    // many rays at once: one aabb update, spatially sorted and spread over workers;
+    // read-only, so may run from parallel phase, as long as nothing moves physical objects meanwhile
+    void           rayBatch    (const std::vector<RayQuery>& q, std::vector<RayLandResult>& out) const;
+    void           landRayBatch(const std::vector<Tempest::Vec3>& at, std::vector<RayLandResult>& out, float maxDy=0) const;
+    // same as landRay, with own maxDy for each point
+    void           landRayBatch(const std::vector<Tempest::Vec3>& at, const std::vector<float>& maxDy, std::vector<RayLandResult>& out) const;
+    void           waterRayBatch(const std::vector<Tempest::Vec3>& at, std::vector<RayWaterResult>& out) const;
     float          soundOclusion(float x0, float y0, float z0, float x1, float y1, float z1) const;
 
     NpcItem        ghostObj  (const char* visual);
@@ -217,6 +258,12 @@ class DynamicWorld final {
     static float   materialDensity (ZenLoad::MaterialGroup mat);
 
     const char*    validateSectorName(const char* name) const;
+    // changes, whenever collision of landRay/waterRay/ray may change: object moved, created or removed
+    uint64_t       rayEpoch() const;
+    // hit, fallback and time are counted over the last tick
+    GroundCacheStats groundCacheStats() const;
+    // counted since world creation
+    GroundCacheStats groundCacheTotal() const;
 
   private:
     enum ItemType : uint8_t {
@@ -231,7 +278,8 @@ class DynamicWorld final {
     void           deleteObj(btCollisionObject* obj);
 
 
-    void           moveBullet(BulletBody& b, float dx, float dy, float dz, uint64_t dt);
+    void           probeBullet(BulletStep& st, uint64_t dt) const;
+    void           moveBullet (BulletStep& st, uint64_t dt);
     RayWaterResult implWaterRay (float x0, float y0, float z0, float x1, float y1, float z1) const;
     bool           hasCollision(const NpcItem &it, Tempest::Vec3& normal);
 
@@ -242,15 +290,24 @@ class DynamicWorld final {
     std::unique_ptr<btRigidBody> waterObj();
 
     void           updateSingleAabb(btCollisionObject* obj);
+    void           invalidateGround(btCollisionObject* obj);
+    bool           groundRay(float x, float y0, float y1, float z, RayLandResult& out) const;
 
     std::unique_ptr<CollisionWorld>             world;
 
     std::vector<std::string>                    sectors;
 
     std::vector<btVector3>                      landVbo;
+    // storage of bvh's, deserialized from physics cache
+    btAlignedObjectArray<btVector3>             landBvh;
+    btAlignedObjectArray<btVector3>             waterBvh;
     std::unique_ptr<PhysicVbo>                  landMesh;
     std::unique_ptr<btCollisionShape>           landShape;
     std::unique_ptr<btRigidBody>                landBody;
+    std::unique_ptr<GroundCache>                ground;
+    GroundCacheStats                            groundFrame;
+    GroundCacheStats                            groundTotal;
+    mutable std::atomic<uint64_t>               landRayNs{0};
 
     std::unique_ptr<btCollisionShape>           waterShape;
     std::unique_ptr<btRigidBody>                waterBody;
@@ -0,0 +1,244 @@
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+
+#include "groundcache.h"
+
+#include <BulletCollision/CollisionDispatch/btCollisionWorld.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleCallback.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include "dynamicworld.h"
+
+#include <algorithm>
+#include <cmath>
+
+// same as in btTriangleRaycastCallback: back-faces are filtered, so only upward facing triangles can be hit
+static bool inside(const btVector3* v, float x, float z) {
+  auto edge = [x,z](const btVector3& a, const btVector3& b) {
+    return (b.x()-a.x())*(z-a.z()) - (b.z()-a.z())*(x-a.x());
+    };
+  float e0  = edge(v[0],v[1]);
+  float e1  = edge(v[1],v[2]);
+  float e2  = edge(v[2],v[0]);
+  float sum = e0+e1+e2;
+  if(sum<0) {
+    e0 = -e0; e1 = -e1; e2 = -e2; sum = -sum;
+    }
+  const float eps = -1e-5f*sum;
+  return e0>=eps && e1>=eps && e2>=eps;
+  }
+
+GroundCache::GroundCache(const std::vector<btVector3>& vbo, const btBvhTriangleMeshShape& land, btCollisionWorld& world)
+  :land(land), world(world) {
+  bbox[0] = btVector3(0,0,0);
+  bbox[1] = btVector3(0,0,0);
+  if(vbo.empty())
+    return;
+  bbox[0] = vbo[0];
+  bbox[1] = vbo[0];
+  for(auto& i:vbo) {
+    bbox[0].setMin(i);
+    bbox[1].setMax(i);
+    }
+  tilesX = size_t((bbox[1].x()-bbox[0].x())/TILE_SIZE)+1;
+  tilesZ = size_t((bbox[1].z()-bbox[0].z())/TILE_SIZE)+1;
+  grid.reset(new std::atomic<Tile*>[tilesX*tilesZ]);
+  for(size_t i=0; i<tilesX*tilesZ; ++i)
+    grid[i].store(nullptr);
+  }
+
+GroundCache::~GroundCache() {
+  }
+
+bool GroundCache::landRay(float x, float y0, float y1, float z, Hit& out) const {
+  const float fx = (x-bbox[0].x())/float(TILE_SIZE);
+  const float fz = (z-bbox[0].z())/float(TILE_SIZE);
+  if(!(fx>=0 && fz>=0 && fx<float(tilesX) && fz<float(tilesZ))) {
+    fallback.fetch_add(1,std::memory_order_relaxed);
+    return false;
+    }
+
+  const size_t tx = size_t(fx), tz = size_t(fz);
+  const Tile&  t  = *tile(tx,tz);
+  const size_t cx = std::min(size_t((fx-float(tx))*TILE_CELLS),size_t(TILE_CELLS-1));
+  const size_t cz = std::min(size_t((fz-float(tz))*TILE_CELLS),size_t(TILE_CELLS-1));
+  const Cell&  c  = t.cell[cz*TILE_CELLS+cx];
+  if(c.blocked.load(std::memory_order_relaxed)) {
+    fallback.fetch_add(1,std::memory_order_relaxed);
+    return false;
+    }
+
+  // closest hit to ray origin is the highest one, that is still below of it
+  out = Hit();
+  for(size_t i=0; i<c.count; ++i) {
+    const Tri& tr = t.tri[t.index[c.first+i]];
+    if(!inside(tr.v,x,z))
+      continue;
+    const btVector3& v = tr.v[0];
+    const float      h = v.y() - (tr.n.x()*(x-v.x()) + tr.n.z()*(z-v.z()))/tr.n.y();
+    if(h>y0 || h<y1 || (out.hasCol && h<=out.y))
+      continue;
+    out.hasCol = true;
+    out.y      = h;
+    out.n      = Tempest::Vec3(tr.n.x(),tr.n.y(),tr.n.z());
+    out.part   = tr.part;
+    }
+  hit.fetch_add(1,std::memory_order_relaxed);
+  return true;
+  }
+
+void GroundCache::invalidate(const btVector3& aabbMin, const btVector3& aabbMax) {
+  size_t bx=0, ex=0, bz=0, ez=0;
+  if(!cellRange(aabbMin.x(),aabbMax.x(),bbox[0].x(),tilesX*TILE_CELLS,bx,ex) ||
+     !cellRange(aabbMin.z(),aabbMax.z(),bbox[0].z(),tilesZ*TILE_CELLS,bz,ez))
+    return;
+
+  // not yet built tiles pick objects from broadphase, once needed
+  std::lock_guard<std::mutex> guard(sync);
+  for(size_t tz=bz/TILE_CELLS; tz<=(ez-1)/TILE_CELLS; ++tz)
+    for(size_t tx=bx/TILE_CELLS; tx<=(ex-1)/TILE_CELLS; ++tx) {
+      Tile* t = grid[tz*tilesX+tx].load(std::memory_order_relaxed);
+      if(t!=nullptr)
+        block(*t,tx,tz,aabbMin,aabbMax);
+      }
+  }
+
+GroundCache::Stats GroundCache::stats() const {
+  Stats st;
+  {
+    std::lock_guard<std::mutex> guard(sync);
+    st.tiles = uint32_t(storage.size());
+  }
+  st.hit      = hit.load();
+  st.fallback = fallback.load();
+  return st;
+  }
+
+GroundCache::Tile* GroundCache::tile(size_t tx, size_t tz) const {
+  auto& g = grid[tz*tilesX+tx];
+  if(Tile* t = g.load(std::memory_order_acquire))
+    return t;
+
+  std::lock_guard<std::mutex> guard(sync);
+  if(Tile* t = g.load(std::memory_order_relaxed))
+    return t;
+  Tile* t = buildTile(tx,tz);
+  g.store(t,std::memory_order_release);
+  return t;
+  }
+
+GroundCache::Tile* GroundCache::buildTile(size_t tx, size_t tz) const {
+  struct Collect : btTriangleCallback {
+    std::vector<Tri>& tri;
+    explicit Collect(std::vector<Tri>& tri):tri(tri){}
+
+    void processTriangle(btVector3* v, int partId, int) override {
+      Tri t;
+      t.n = (v[1]-v[0]).cross(v[2]-v[0]);
+      const float l = t.n.length();
+      if(l<=0)
+        return;
+      t.n /= l;
+      if(t.n.y()<=1e-3f)
+        return;
+      for(int i=0; i<3; ++i)
+        t.v[i] = v[i];
+      t.part = partId;
+      tri.push_back(t);
+      }
+    };
+
+  struct Objects : btBroadphaseAabbCallback {
+    const GroundCache& owner;
+    Tile&              t;
+    size_t             tx, tz;
+    Objects(const GroundCache& owner, Tile& t, size_t tx, size_t tz):owner(owner),t(t),tx(tx),tz(tz){}
+
+    bool process(const btBroadphaseProxy* proxy) override {
+      auto obj = reinterpret_cast<const btCollisionObject*>(proxy->m_clientObject);
+      if(obj->getUserIndex()==DynamicWorld::C_Object)
+        owner.block(t,tx,tz,proxy->m_aabbMin,proxy->m_aabbMax);
+      return true;
+      }
+    };
+
+  std::unique_ptr<Tile> t(new Tile());
+  const float x0 = bbox[0].x()+float(tx*TILE_SIZE);
+  const float z0 = bbox[0].z()+float(tz*TILE_SIZE);
+  const btVector3 aabbMin(x0,          bbox[0].y()-1.f,z0);
+  const btVector3 aabbMax(x0+TILE_SIZE,bbox[1].y()+1.f,z0+TILE_SIZE);
+
+  Collect collect(t->tri);
+  land.processAllTriangles(&collect,aabbMin,aabbMax);
+
+  // bin triangles by xz bounds: count, offsets, fill
+  std::vector<uint16_t> pos;
+  for(int pass=0; pass<2; ++pass) {
+    for(size_t i=0; i<t->tri.size() && i<=0xFFFF; ++i) {
+      auto&  tr = t->tri[i];
+      size_t bx=0, ex=0, bz=0, ez=0;
+      if(!cellRange(std::min({tr.v[0].x(),tr.v[1].x(),tr.v[2].x()}),std::max({tr.v[0].x(),tr.v[1].x(),tr.v[2].x()}),x0,TILE_CELLS,bx,ex) ||
+         !cellRange(std::min({tr.v[0].z(),tr.v[1].z(),tr.v[2].z()}),std::max({tr.v[0].z(),tr.v[1].z(),tr.v[2].z()}),z0,TILE_CELLS,bz,ez))
+        continue;
+      for(size_t z=bz; z<ez; ++z)
+        for(size_t x=bx; x<ex; ++x) {
+          auto& c = t->cell[z*TILE_CELLS+x];
+          if(pass==0) {
+            c.count++;
+            } else {
+            t->index[c.first+pos[z*TILE_CELLS+x]] = uint16_t(i);
+            pos[z*TILE_CELLS+x]++;
+            }
+          }
+      }
+    if(pass==0) {
+      uint32_t off = 0;
+      for(auto& c:t->cell) {
+        c.first = off;
+        off    += c.count;
+        }
+      t->index.resize(off);
+      pos.resize(TILE_CELLS*TILE_CELLS);
+      }
+    }
+
+  const bool overflow = t->tri.size()>0xFFFF;
+  for(auto& c:t->cell)
+    if(c.count>MAX_TRI || overflow)
+      c.blocked.store(1,std::memory_order_relaxed);
+
+  Objects objects(*this,*t,tx,tz);
+  world.getBroadphase()->aabbTest(aabbMin,aabbMax,objects);
+
+  storage.emplace_back(std::move(t));
+  return storage.back().get();
+  }
+
+void GroundCache::block(Tile& t, size_t tx, size_t tz, const btVector3& aabbMin, const btVector3& aabbMax) const {
+  size_t bx=0, ex=0, bz=0, ez=0;
+  const float x0 = bbox[0].x()+float(tx*TILE_SIZE);
+  const float z0 = bbox[0].z()+float(tz*TILE_SIZE);
+  if(!cellRange(aabbMin.x(),aabbMax.x(),x0,TILE_CELLS,bx,ex) ||
+     !cellRange(aabbMin.z(),aabbMax.z(),z0,TILE_CELLS,bz,ez))
+    return;
+  for(size_t z=bz; z<ez; ++z)
+    for(size_t x=bx; x<ex; ++x)
+      t.cell[z*TILE_CELLS+x].blocked.store(1,std::memory_order_relaxed);
+  }
+
+bool GroundCache::cellRange(float v0, float v1, float org, size_t cnt, size_t& b, size_t& e) {
+  const float fb = std::floor((v0-org)/float(CELL_SIZE));
+  const float fe = std::floor((v1-org)/float(CELL_SIZE))+1.f;
+  if(fe<=0 || fb>=float(cnt))
+    return false;
+  b = size_t(std::max(fb,0.f));
+  e = size_t(std::min(fe,float(cnt)));
+  return b<e;
+  }
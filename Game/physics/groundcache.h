@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+#include <LinearMath/btVector3.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+class btBvhTriangleMeshShape;
+class btCollisionWorld;
+
+// Lazily built grid of landscape triangles, for vertical ground queries.
+// Each cell keeps upward facing landscape triangles, so a vertical ray is resolved by few
+// point-in-triangle tests, instead of bvh traversal. Cells, touched by static or movable objects, or
+// with too complex geometry are not cached - caller has to fallback to a real ray test.
+class GroundCache final {
+  public:
+    GroundCache(const std::vector<btVector3>& vbo, const btBvhTriangleMeshShape& land, btCollisionWorld& world);
+    GroundCache(const GroundCache&)=delete;
+    ~GroundCache();
+
+    struct Hit {
+      bool          hasCol = false;
+      float         y      = 0;
+      Tempest::Vec3 n      = {};
+      int           part   = 0;
+      };
+
+    struct Stats {
+      uint32_t tiles    = 0;
+      uint32_t hit      = 0;
+      uint32_t fallback = 0;
+      };
+
+    // vertical ray from y0 down to y1; false, if cache can't answer
+    bool  landRay(float x, float y0, float y1, float z, Hit& out) const;
+    // object has been added or moved: area is no longer pure landscape
+    void  invalidate(const btVector3& aabbMin, const btVector3& aabbMax);
+    Stats stats() const;
+
+  private:
+    enum {
+      CELL_SIZE  = 100,
+      TILE_CELLS = 32,
+      TILE_SIZE  = CELL_SIZE*TILE_CELLS,
+      MAX_TRI    = 16,
+      };
+
+    struct Tri {
+      btVector3 v[3];
+      btVector3 n;
+      int       part = 0;
+      };
+
+    struct Cell {
+      uint32_t             first   = 0;
+      uint32_t             count   = 0;
+      // set by invalidate on main thread, while worker threads may query
+      std::atomic<uint8_t> blocked{0};
+      };
+
+    struct Tile {
+      Cell                  cell[TILE_CELLS*TILE_CELLS];
+      std::vector<Tri>      tri;
+      std::vector<uint16_t> index;
+      };
+
+    Tile* tile(size_t tx, size_t tz) const;
+    Tile* buildTile(size_t tx, size_t tz) const;
+    void  block(Tile& t, size_t tx, size_t tz, const btVector3& aabbMin, const btVector3& aabbMax) const;
+    static bool cellRange(float v0, float v1, float org, size_t cnt, size_t& b, size_t& e);
+
+    const btBvhTriangleMeshShape&               land;
+    btCollisionWorld&                           world;
+    btVector3                                   bbox[2];
+    size_t                                      tilesX = 0;
+    size_t                                      tilesZ = 0;
+
+    mutable std::mutex                          sync;
+    std::unique_ptr<std::atomic<Tile*>[]>       grid;
+    mutable std::vector<std::unique_ptr<Tile>>  storage;
+
+    mutable std::atomic<uint32_t>               hit{0};
+    mutable std::atomic<uint32_t>               fallback{0};
+  };
@@ -0,0 +1,208 @@
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+
+#include "physiccache.h"
+
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+#include <LinearMath/btScalar.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <Tempest/File>
+#include <Tempest/Log>
+#include <cstring>
+
+#include "graphics/mesh/submesh/packedmesh.h"
+#include "utils/fileext.h"
+#include "utils/fileutil.h"
+#include "resources.h"
+
+using namespace Tempest;
+
+struct PhysicCache::Header {
+  char     tag[4]   = {'P','H','Y','C'};
+  uint32_t version  = 1;
+  uint32_t scalar   = sizeof(btScalar);
+  uint32_t bullet   = BT_BULLET_VERSION;
+  uint64_t archives = 0;
+  uint32_t vertices = 0;
+  uint32_t indices  = 0;
+  };
+
+template<class T>
+static void writeVec(WFile& f, const std::vector<T>& v) {
+  uint32_t sz = uint32_t(v.size());
+  f.write(&sz,sizeof(sz));
+  f.write(v.data(),sz*sizeof(T));
+  }
+
+template<class T>
+static bool readVec(RFile& f, std::vector<T>& v) {
+  uint32_t sz = 0;
+  if(f.read(&sz,sizeof(sz))!=sizeof(sz) || sz*sizeof(T)>f.size())
+    return false;
+  v.resize(sz);
+  return f.read(v.data(),sz*sizeof(T))==sz*sizeof(T);
+  }
+
+static void writeBvh(WFile& f, const PhysicCache::BvhBuffer& v) {
+  uint32_t sz = uint32_t(v.size());
+  f.write(&sz,sizeof(sz));
+  if(sz>0)
+    f.write(&v[0],sz*sizeof(btVector3));
+  }
+
+static bool readBvh(RFile& f, PhysicCache::BvhBuffer& v) {
+  uint32_t sz = 0;
+  if(f.read(&sz,sizeof(sz))!=sizeof(sz) || sz*sizeof(btVector3)>f.size())
+    return false;
+  v.resize(int(sz));
+  if(sz==0)
+    return true;
+  return f.read(&v[0],sz*sizeof(btVector3))==sz*sizeof(btVector3);
+  }
+
+PhysicCache::PhysicCache(const std::string& world, const ZenLoad::zCMesh& mesh)
+  :PhysicCache(world,uint32_t(mesh.getVertices().size()),uint32_t(mesh.getIndices().size())) {
+  }
+
+PhysicCache::PhysicCache(const std::string& world, uint32_t meshVertices, uint32_t meshIndices)
+  :path(FileUtil::cachePath(FileExt::cacheName("physic_",world))) {
+  vertCount  = meshVertices;
+  indexCount = meshIndices;
+  loaded     = load();
+  if(!loaded) {
+    sectors.clear();
+    vertices.clear();
+    meshes.clear();
+    landBvh.clear();
+    waterBvh.clear();
+    }
+  }
+
+PhysicCache::Header PhysicCache::header() const {
+  Header h;
+  h.archives = Resources::archivesStamp();
+  h.vertices = vertCount;
+  h.indices  = indexCount;
+  return h;
+  }
+
+void PhysicCache::pack(const ZenLoad::zCMesh& mesh) {
+  vertCount  = uint32_t(mesh.getVertices().size());
+  indexCount = uint32_t(mesh.getIndices().size());
+
+  PackedMesh pkg(mesh,PackedMesh::PK_PhysicZoned);
+
+  vertices.resize(pkg.vertices.size());
+  for(size_t i=0;i<pkg.vertices.size();++i) {
+    auto& p = pkg.vertices[i].Position;
+    vertices[i].setValue(p.x,p.y,p.z);
+    }
+
+  for(auto& sm:pkg.subMeshes) {
+    if(sm.material.noCollDet || sm.indices.size()==0)
+      continue;
+    Mesh m;
+    m.indices = std::move(sm.indices);
+    m.mat     = sm.material.matGroup;
+    m.water   = (sm.material.matGroup==ZenLoad::MaterialGroup::WATER);
+    if(!m.water) {
+      m.sector = uint32_t(sectors.size());
+      sectors.push_back(sm.material.matName);
+      }
+    meshes.push_back(std::move(m));
+    }
+  }
+
+bool PhysicCache::load() {
+  if(path.empty())
+    return false;
+  try {
+    RFile  f(path.c_str());
+    Header hdr, expect = header();
+    if(f.read(&hdr,sizeof(hdr))!=sizeof(hdr) || std::memcmp(&hdr,&expect,sizeof(hdr))!=0)
+      return false;
+
+    uint32_t cnt = 0;
+    if(f.read(&cnt,sizeof(cnt))!=sizeof(cnt) || cnt>f.size())
+      return false;
+    sectors.resize(cnt);
+    for(auto& i:sectors) {
+      std::vector<char> str;
+      if(!readVec(f,str))
+        return false;
+      i.assign(str.begin(),str.end());
+      }
+
+    if(!readVec(f,vertices))
+      return false;
+
+    if(f.read(&cnt,sizeof(cnt))!=sizeof(cnt) || cnt>f.size())
+      return false;
+    meshes.resize(cnt);
+    for(auto& i:meshes) {
+      uint8_t water = 0;
+      if(!readVec(f,i.indices) ||
+         f.read(&i.mat,   sizeof(i.mat))   !=sizeof(i.mat) ||
+         f.read(&water,   sizeof(water))   !=sizeof(water) ||
+         f.read(&i.sector,sizeof(i.sector))!=sizeof(i.sector))
+        return false;
+      i.water = (water!=0);
+      if(!i.water && i.sector>=sectors.size())
+        return false;
+      }
+
+    return readBvh(f,landBvh) && readBvh(f,waterBvh);
+    }
+  catch(...) {
+    return false;
+    }
+  }
+
+bool PhysicCache::save() const {
+  if(path.empty())
+    return false;
+  try {
+    WFile  f(path.c_str());
+    Header hdr = header();
+    f.write(&hdr,sizeof(hdr));
+
+    uint32_t cnt = uint32_t(sectors.size());
+    f.write(&cnt,sizeof(cnt));
+    for(auto& i:sectors)
+      writeVec(f,std::vector<char>(i.begin(),i.end()));
+
+    writeVec(f,vertices);
+
+    cnt = uint32_t(meshes.size());
+    f.write(&cnt,sizeof(cnt));
+    for(auto& i:meshes) {
+      uint8_t water = i.water ? 1 : 0;
+      writeVec(f,i.indices);
+      f.write(&i.mat,   sizeof(i.mat));
+      f.write(&water,   sizeof(water));
+      f.write(&i.sector,sizeof(i.sector));
+      }
+
+    writeBvh(f,landBvh);
+    writeBvh(f,waterBvh);
+    return true;
+    }
+  catch(...) {
+    Log::e("unable to write physics cache: ",path);
+    return false;
+    }
+  }
+
+void PhysicCache::serialize(const btOptimizedBvh& bvh, BvhBuffer& out) {
+  const unsigned size = bvh.calculateSerializeBufferSize();
+  out.resize(int((size+sizeof(btVector3)-1)/sizeof(btVector3)));
+  if(out.size()==0 || !bvh.serializeInPlace(&out[0],size,false))
+    out.clear();
+  }
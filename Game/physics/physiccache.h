@@ -0,0 +1,62 @@
+#pragma once
+
+#include <zenload/zCMesh.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+#include <LinearMath/btVector3.h>
+#include <LinearMath/btAlignedObjectArray.h>
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class btOptimizedBvh;
+
+// On-disk cache of world collision data: packed landscape/water meshes and serialized bvh's.
+// File is keyed by world name, archives timestamps and mesh size; any mismatch means rebuild from zCMesh.
+class PhysicCache final {
+  public:
+    PhysicCache(const std::string& world, const ZenLoad::zCMesh& mesh);
+    // mesh size, as stored by WorldCache: no need to parse world file
+    PhysicCache(const std::string& world, uint32_t meshVertices, uint32_t meshIndices);
+
+    struct Mesh {
+      std::vector<uint32_t> indices;
+      uint8_t               mat    = 0;
+      bool                  water  = false;
+      uint32_t              sector = 0;
+      };
+
+    bool isLoaded() const { return loaded; }
+    void pack(const ZenLoad::zCMesh& mesh);
+    bool save() const;
+
+    // 16-byte aligned storage, as required by btOptimizedBvh::deSerializeInPlace;
+    // std::allocator gives no such guarantee before c++17
+    using BvhBuffer = btAlignedObjectArray<btVector3>;
+    static void serialize(const btOptimizedBvh& bvh, BvhBuffer& out);
+
+    std::vector<std::string> sectors;
+    std::vector<btVector3>   vertices;
+    std::vector<Mesh>        meshes;
+    BvhBuffer                landBvh;
+    BvhBuffer                waterBvh;
+
+  private:
+    struct Header;
+
+    Header header() const;
+    bool   load();
+
+    std::string path;
+    uint32_t    vertCount  = 0;
+    uint32_t    indexCount = 0;
+    bool        loaded     = false;
+  };
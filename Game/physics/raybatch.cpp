@@ -0,0 +1,22 @@
+#include "raybatch.h"
+
+// interleave bits of x and z
+static uint64_t spread(uint32_t v) {
+  uint64_t x = v;
+  x = (x | (x<<16)) & 0x0000FFFF0000FFFFull;
+  x = (x | (x<< 8)) & 0x00FF00FF00FF00FFull;
+  x = (x | (x<< 4)) & 0x0F0F0F0F0F0F0F0Full;
+  x = (x | (x<< 2)) & 0x3333333333333333ull;
+  x = (x | (x<< 1)) & 0x5555555555555555ull;
+  return x;
+  }
+
+// 1m cells
+static uint32_t cell(float v) {
+  float c = std::max(0.f,std::min(v/100.f+float(1<<20),float((1u<<21)-1)));
+  return uint32_t(c);
+  }
+
+uint64_t RayBatch::key(const Tempest::Vec3& from, const Tempest::Vec3& to) {
+  return spread(cell((from.x+to.x)*0.5f)) | (spread(cell((from.z+to.z)*0.5f))<<1);
+  }
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+#include "utils/workers.h"
+
+// Traversal order of a batch of rays: by Morton code of XZ midpoint, so neighbour rays walk the same
+// part of landscape BVH; rays run on worker pool. Query type needs `from` and `to` fields.
+class RayBatch final {
+  public:
+    static uint64_t key(const Tempest::Vec3& from, const Tempest::Vec3& to);
+
+    // calls fn(i) for every query i; fn must be safe to run in parallel
+    template<class Q, class Fn>
+    static void run(const std::vector<Q>& q, const Fn& fn) {
+      std::vector<Job> job(q.size());
+      for(size_t i=0; i<q.size(); ++i) {
+        job[i].key = key(q[i].from,q[i].to);
+        job[i].id  = i;
+        }
+      std::sort(job.begin(),job.end(),[](const Job& a, const Job& b){ return a.key<b.key; });
+      Workers::parallelFor(job,[&fn](Job& j){ fn(j.id); });
+      }
+
+  private:
+    struct Job {
+      uint64_t key = 0;
+      size_t   id  = 0;
+      };
+  };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bodies sorted by x: sort-and-sweep along one axis. Moving, standing and disabled bodies are kept alike;
+// npc's move by few santimeters per frame, so order is restored incrementally, on every move.
+// Body needs `pos.x` and `size_t slot` fields. Engine independent, to be testable without world.
+template<class Body>
+class SweepAxis final {
+  public:
+    struct Record final {
+      Body* body = nullptr;
+      float x    = 0.f;
+      };
+
+    void reserve(size_t n) { rec.reserve(n); }
+    size_t size() const    { return rec.size(); }
+
+    void add(Body* b) {
+      Record r;
+      r.body  = b;
+      r.x     = b->pos.x;
+      b->slot = rec.size();
+      rec.push_back(r);
+      onMove(*b);
+      }
+
+    bool del(Body* b) {
+      if(b->slot>=rec.size() || rec[b->slot].body!=b)
+        return false;
+      rec.erase(rec.begin()+std::ptrdiff_t(b->slot));
+      for(size_t i=b->slot; i<rec.size(); ++i)
+        rec[i].body->slot = i;
+      return true;
+      }
+
+    void onMove(Body& n) {
+      size_t      i = n.slot;
+      const float x = n.pos.x;
+      rec[i].x = x;
+      while(i>0 && x<rec[i-1].x) {
+        std::swap(rec[i],rec[i-1]);
+        rec[i].body->slot = i;
+        --i;
+        }
+      while(i+1<rec.size() && rec[i+1].x<x) {
+        std::swap(rec[i],rec[i+1]);
+        rec[i].body->slot = i;
+        ++i;
+        }
+      n.slot = i;
+      }
+
+    // bodies, with x in range [x0,x1]
+    std::pair<const Record*,const Record*> range(float x0, float x1) const {
+      auto l = std::lower_bound(rec.data(),rec.data()+rec.size(),x0,[](const Record& b,float x){ return b.x<x; });
+      auto r = std::upper_bound(l,         rec.data()+rec.size(),x1,[](float x,const Record& b){ return x<b.x; });
+      return std::make_pair(l,r);
+      }
+
+  private:
+    std::vector<Record> rec;
+  };
@@ -17,7 +17,9 @@
 #include <zenload/zenParser.h>
 #include <zenload/ztex2dds.h>
 
+#include <algorithm>
 #include <fstream>
+#include <unordered_set>
 
 #include "graphics/mesh/submesh/staticmesh.h"
 #include "graphics/mesh/submesh/animmesh.h"
@@ -32,6 +34,8 @@
 #include "dmusic/directmusic.h"
 #include "utils/fileext.h"
 #include "utils/gthfont.h"
+#include "utils/loadcache.h"
+#include "utils/workers.h"
 
 #include "gothic.h"
 
@@ -39,6 +43,15 @@ using namespace Tempest;
 
 Resources* Resources::inst=nullptr;
 
+// default residency budgets in MB, overridden by GAME.*CacheBudget settings
+static const int defaultMeshBudget      = 256;
+static const int defaultTextureBudget   = 512;
+static const int defaultAnimationBudget = 128;
+static const int defaultBundleBudget    = 64;
+
+// depth of Resources::OwnedScope on this thread
+static thread_local uint32_t ownedScope = 0;
+
 static void emplaceTag(char* buf, char tag){
   for(size_t i=1;buf[i];++i){
     if(buf[i]==tag && buf[i-1]=='_' && buf[i+1]=='0'){
@@ -86,9 +99,6 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
   dxMusic->addPath(gothic.nestedPath({u"_work",u"Data",u"Music",u"menu_men"}, Dir::FT_Dir));
   dxMusic->addPath(gothic.nestedPath({u"_work",u"Data",u"Music",u"orchestra"},Dir::FT_Dir));
 
-  fBuff .reserve(8*1024*1024);
-  ddsBuf.reserve(8*1024*1024);
-
   {
   Pixmap pm(1,1,Pixmap::Format::RGBA);
   uint8_t* pix = reinterpret_cast<uint8_t*>(pm.data());
@@ -113,8 +123,17 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
            std::make_tuple(bIsMod,b.time,int(b.ord));
     });
 
-  for(auto& i:archives)
+  // FNV-1a
+  gothicAssetsStamp = 0xcbf29ce484222325ull;
+  auto stamp = [this](uint64_t v) {
+    gothicAssetsStamp = (gothicAssetsStamp^v)*0x100000001b3ull;
+    };
+  for(auto& i:archives) {
     gothicAssets.loadVDF(i.name);
+    for(auto c:i.name)
+      stamp(uint64_t(c));
+    stamp(uint64_t(i.time));
+    }
   gothicAssets.finalizeLoad();
 
   //for(auto& i:gothicAssets.getKnownFiles())
@@ -126,6 +145,8 @@ Resources::Resources(Gothic &gothic, Tempest::Device &device)
   }
 
 Resources::~Resources() {
+  // async loads in flight refer to caches of this instance
+  Workers::waitFor(asyncLeft);
   inst=nullptr;
   }
 
@@ -138,6 +159,40 @@ void Resources::waitDeviceIdle() {
   return inst->device.waitIdle();
   }
 
+// rough estimate: bundles are dominated by vob records
+static size_t vobMemory(const ZenLoad::zCVobData& vob) {
+  size_t ret = sizeof(vob);
+  for(auto& i:vob.childVobs)
+    ret += vobMemory(i);
+  return ret;
+  }
+
+static size_t bundleMemory(const ZenLoad::oCWorldData& bundle) {
+  size_t ret = sizeof(bundle);
+  for(auto& i:bundle.rootVobs)
+    ret += vobMemory(i);
+  return ret;
+  }
+
+static size_t textureMemory(const Texture2d& t) {
+  return size_t(t.w())*size_t(t.h())*4;
+  }
+
+static void collectTextures(const Material& m, std::unordered_set<const void*>& out) {
+  out.insert(m.tex);
+  for(auto i:m.frames)
+    out.insert(i);
+  }
+
+static void collectTextures(const ProtoMesh& m, std::unordered_set<const void*>& out) {
+  for(auto& i:m.attach)
+    for(auto& s:i.sub)
+      collectTextures(s.material,out);
+  for(auto& i:m.skined)
+    for(auto& s:i.sub)
+      collectTextures(s.material,out);
+  }
+
 static Sampler2d implShadowSampler() {
   Tempest::Sampler2d smp;
   smp.setClamping(Tempest::ClampMode::ClampToBorder);
@@ -202,6 +257,10 @@ VDFS::FileIndex& Resources::vdfsIndex() {
   return inst->gothicAssets;
   }
 
+uint64_t Resources::archivesStamp() {
+  return inst->gothicAssetsStamp;
+  }
+
 const Tempest::VertexBuffer<Resources::VertexFsq> &Resources::fsqVbo() {
   return inst->fsq;
   }
@@ -229,75 +288,97 @@ int64_t Resources::vdfTimestamp(const std::u16string& name) {
     }
   }
 
+static bool decodePixmap(const std::vector<uint8_t>& data, Pixmap& pm) {
+  try {
+    Tempest::MemReader rd(data.data(),data.size());
+    pm = Tempest::Pixmap(rd);
+    return true;
+    }
+  catch(...){
+    return false;
+    }
+  }
+
 Tempest::Texture2d* Resources::implLoadTexture(TextureCache& cache,const char* cname) {
   std::string name = cname;
   if(name.size()==0)
     return nullptr;
 
-  auto it=cache.find(name);
-  if(it!=cache.end())
-    return it->second.get();
+  // decode without lock; same texture may be decoded twice by racing threads - first one wins
+  Pixmap pm;
+  try {
+    return LoadCache::load(sync,cache,name,counters.texture,
+                           [&]() { return implDecodeTexture(cname,pm); },
+                           [&](bool ok) {
+                             if(!ok)
+                               return std::unique_ptr<Texture2d>();
+                             return std::unique_ptr<Texture2d>(new Texture2d(device.loadTexture(pm)));
+                             },
+                           [this](const Texture2d* t) { implUseTexture(t); });
+    }
+  catch(...){
+    return nullptr;
+    }
+  }
+
+bool Resources::implDecodeTexture(const char* cname, Pixmap& pm) {
+  // per-thread scratch buffers: textures are decoded concurrently
+  thread_local std::vector<uint8_t> fBuff, ddsBuf;
 
+  std::string name = cname;
   if(FileExt::hasExt(name,"TGA")){
     name.resize(name.size()+2);
     std::memcpy(&name[0]+name.size()-6,"-C.TEX",6);
     if(hasFile(name)) {
       if(!getFileData(name.c_str(),fBuff)) {
         Log::e("unable to load texture \"",name,"\"");
-        return nullptr;
+        return false;
         }
       ddsBuf.clear();
       ZenLoad::convertZTEX2DDS(fBuff,ddsBuf);
-      auto t = implLoadTexture(cache,cname,ddsBuf);
-      if(t!=nullptr) {
-        return t;
-        }
+      if(decodePixmap(ddsBuf,pm))
+        return true;
       }
     }
 
   if(getFileData(cname,fBuff))
-    return implLoadTexture(cache,cname,fBuff);
-
-  cache[name]=nullptr;
-  return nullptr;
-  }
-
-Texture2d *Resources::implLoadTexture(TextureCache& cache,std::string&& name,const std::vector<uint8_t> &data) {
-  try {
-    Tempest::MemReader rd(data.data(),data.size());
-    Tempest::Pixmap    pm(rd);
-
-    std::unique_ptr<Texture2d> t{new Texture2d(device.loadTexture(pm))};
-    Texture2d* ret=t.get();
-    cache[std::move(name)] = std::move(t);
-    return ret;
-    }
-  catch(...){
-    return nullptr;
-    }
+    return decodePixmap(fBuff,pm);
+  return false;
   }
 
 ProtoMesh* Resources::implLoadMesh(const std::string &name) {
   if(name.size()==0)
     return nullptr;
 
-  auto it=aniMeshCache.find(name);
-  if(it!=aniMeshCache.end())
-    return it->second.get();
-
   if(FileExt::hasExt(name,"TGA")){
     Log::e("decals should be loaded by Resources::implDecalMesh instead");
     return nullptr;
     }
 
-  try {
-    std::vector<ZenLoad::zCMorphMesh::Animation> aniList;
-    ZenLoad::PackedMesh        packed;
-    ZenLoad::zCModelMeshLib    library;
-    auto                       code=loadMesh(packed,aniList,library,name);
+  OwnedScope scope;
+  std::vector<ZenLoad::zCMorphMesh::Animation> aniList;
+  ZenLoad::PackedMesh        packed;
+  ZenLoad::zCModelMeshLib    library;
+  auto decode = [&]() {
+    MeshLoadCode code=MeshLoadCode::Error;
+    try {
+      code=loadMesh(packed,aniList,library,name);
+      }
+    catch(...){
+      code=MeshLoadCode::Error;
+      }
+    // decode textures out of lock, so ProtoMesh only picks them from cache
+    for(auto& i:packed.subMeshes)
+      implLoadTexture(texCache,i.material.texture.c_str());
+    return code;
+    };
+
+  // ProtoMesh uploads geometry and loads materials
+  auto make = [&](MeshLoadCode code) {
     std::unique_ptr<ProtoMesh> t;
     switch(code) {
       case MeshLoadCode::Error:
+        Log::e("unable to load mesh \"",name,"\"");
         break;
       case MeshLoadCode::Static:
         t.reset(new ProtoMesh(std::move(packed),name));
@@ -309,11 +390,12 @@ ProtoMesh* Resources::implLoadMesh(const std::string &name) {
         t.reset(new ProtoMesh(library,name));
         break;
       }
-    ProtoMesh* ret=t.get();
-    aniMeshCache[name] = std::move(t);
-    if(code==MeshLoadCode::Error)
-      throw std::runtime_error("load failed");
-    return ret;
+    return t;
+    };
+
+  try {
+    return LoadCache::load(sync,aniMeshCache,name,counters.mesh,decode,make,
+                           [this](const ProtoMesh* m) { residency.touch(m); });
     }
   catch(...){
     Log::e("unable to load mesh \"",name,"\"");
@@ -322,7 +404,8 @@ ProtoMesh* Resources::implLoadMesh(const std::string &name) {
   }
 
 ProtoMesh* Resources::implDecalMesh(const ZenLoad::zCVobData& vob) {
-  DecalK key;
+  OwnedScope scope;
+  DecalK     key;
   key.mat         = Material(vob);
   key.sX          = vob.visualChunk.zCDecal.decalDim.x;
   key.sY          = vob.visualChunk.zCDecal.decalDim.y;
@@ -332,8 +415,12 @@ ProtoMesh* Resources::implDecalMesh(const ZenLoad::zCVobData& vob) {
     return nullptr;
 
   auto it = decalMeshCache.find(key);
-  if(it!=decalMeshCache.end())
+  if(it!=decalMeshCache.end()) {
+    counters.decal.hit++;
+    residency.touch(it->second.get());
     return it->second.get();
+    }
+  counters.decal.miss++;
 
   Resources::Vertex vbo[8] = {
     {{-1.f, -1.f, 0.f},{0,0,-1},{0,1}, 0xFFFFFFFF},
@@ -361,6 +448,7 @@ ProtoMesh* Resources::implDecalMesh(const ZenLoad::zCVobData& vob) {
 
   auto ret = t.get();
   decalMeshCache[key] = std::move(t);
+  residency.touch(ret);
   return ret;
   }
 
@@ -371,15 +459,30 @@ Skeleton* Resources::implLoadSkeleton(std::string name) {
   FileExt::exchangeExt(name,"MDS","MDH") ||
   FileExt::exchangeExt(name,"ASC","MDL");
 
+  {
+  std::lock_guard<std::recursive_mutex> g(sync);
   auto it=skeletonCache.find(name);
-  if(it!=skeletonCache.end())
+  if(it!=skeletonCache.end()) {
+    counters.skeleton.hit++;
+    residency.touch(it->second.get());
     return it->second.get();
+    }
+  }
 
   try {
     ZenLoad::zCModelMeshLib library(name,gothicAssets,1.f);
     std::unique_ptr<Skeleton> t{new Skeleton(library,name)};
+
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=skeletonCache.find(name);
+    if(it!=skeletonCache.end()) {
+      residency.touch(it->second.get());
+      return it->second.get();
+      }
     Skeleton* ret=t.get();
     skeletonCache[name] = std::move(t);
+    residency.touch(ret);
+    counters.skeleton.miss++;
     if(!hasFile(name))
       throw std::runtime_error("load failed");
     return ret;
@@ -394,12 +497,19 @@ Animation* Resources::implLoadAnimation(std::string name) {
   if(name.size()<4)
     return nullptr;
 
+  {
+  std::lock_guard<std::recursive_mutex> g(sync);
   auto it=animCache.find(name);
-  if(it!=animCache.end())
+  if(it!=animCache.end()) {
+    counters.animation.hit++;
+    residency.touch(it->second.get());
     return it->second.get();
+    }
+  }
 
+  const std::string key = name;
   try {
-    Animation* ret=nullptr;
+    std::unique_ptr<Animation> t;
     if(gothic.version().game==2){
       FileExt::exchangeExt(name,"MDS","MSB") ||
       FileExt::exchangeExt(name,"MDH","MSB") ||
@@ -407,19 +517,31 @@ Animation* Resources::implLoadAnimation(std::string name) {
 
       ZenLoad::ZenParser            zen(name,gothicAssets);
       ZenLoad::MdsParserBin         p(zen);
-
-      std::unique_ptr<Animation> t{new Animation(p,name.substr(0,name.size()-4),false)};
-      ret=t.get();
-      animCache[name] = std::move(t);
+      t.reset(new Animation(p,name.substr(0,name.size()-4),false));
       } else {
       FileExt::exchangeExt(name,"MDH","MDS");
       ZenLoad::ZenParser zen(name,gothicAssets);
       ZenLoad::MdsParserTxt p(zen);
+      t.reset(new Animation(p,name.substr(0,name.size()-4),true));
+      }
+
+    const size_t raw = t->samplesMemory();
+    if(gothic.doAniCompression())
+      t->compress();
+    const size_t packed = t->samplesMemory();
 
-      std::unique_ptr<Animation> t{new Animation(p,name.substr(0,name.size()-4),true)};
-      ret=t.get();
-      animCache[name] = std::move(t);
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it=animCache.find(key);
+    if(it!=animCache.end()) {
+      residency.touch(it->second.get());
+      return it->second.get();
       }
+    Animation* ret=t.get();
+    animCache[key] = std::move(t);
+    residency.touch(ret);
+    counters.animation.miss++;
+    counters.aniSamplesRaw    += raw;
+    counters.aniSamplesPacked += packed;
     if(!hasFile(name))
       throw std::runtime_error("load failed");
     return ret;
@@ -436,6 +558,7 @@ Dx8::PatternList Resources::implLoadDxMusic(const char* name) {
   }
 
 Tempest::Sound Resources::implLoadSoundBuffer(const char *name) {
+  thread_local std::vector<uint8_t> fBuff;
   if(name[0]=='\0')
     return Tempest::Sound();
 
@@ -531,17 +654,15 @@ PfxEmitterMesh* Resources::implLoadEmiterMesh(const char* name) {
   }
 
 bool Resources::hasFile(const std::string &fname) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // file index is immutable after construction
   return inst->gothicAssets.hasFile(fname);
   }
 
 const Texture2d *Resources::loadTexture(const char *name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadTexture(inst->texCache,name);
   }
 
 const Tempest::Texture2d* Resources::loadTexture(const std::string &name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadTexture(inst->texCache,name.c_str());
   }
 
@@ -611,7 +732,6 @@ Material Resources::loadMaterial(const ZenLoad::zCMaterialData& src, bool enable
   }
 
 const ProtoMesh *Resources::loadMesh(const std::string &name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadMesh(name);
   }
 
@@ -625,15 +745,30 @@ const PfxEmitterMesh* Resources::loadEmiterMesh(const char* name) {
 const Skeleton *Resources::loadSkeleton(const char* name) {
   if(FileExt::hasExt(name,"3ds") || FileExt::hasExt(name,"MMS"))
     return nullptr;
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadSkeleton(name);
   }
 
 const Animation *Resources::loadAnimation(const std::string &name) {
-  std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadAnimation(name);
   }
 
+Resources::Async<Texture2d> Resources::loadTextureAsync(const std::string& name) {
+  // prefetch only warms up the cache; actual user pins texture, if it has to
+  return Async<Texture2d>::run([name]() { OwnedScope scope; return loadTexture(name); },inst->asyncLeft);
+  }
+
+Resources::Async<ProtoMesh> Resources::loadMeshAsync(const std::string& name) {
+  return Async<ProtoMesh>::run([name]() { return loadMesh(name); },inst->asyncLeft);
+  }
+
+Resources::Async<Skeleton> Resources::loadSkeletonAsync(const std::string& name) {
+  return Async<Skeleton>::run([name]() { return loadSkeleton(name.c_str()); },inst->asyncLeft);
+  }
+
+Resources::Async<Animation> Resources::loadAnimationAsync(const std::string& name) {
+  return Async<Animation>::run([name]() { return loadAnimation(name); },inst->asyncLeft);
+  }
+
 Tempest::Sound Resources::loadSoundBuffer(const std::string &name) {
   std::lock_guard<std::recursive_mutex> g(inst->sync);
   return inst->implLoadSoundBuffer(name.c_str());
@@ -661,8 +796,12 @@ ZenLoad::oCWorldData Resources::loadVobBundle(const std::string& name) {
 
 ZenLoad::oCWorldData& Resources::implLoadVobBundle(const std::string& filename) {
   auto i = zenCache.find(filename);
-  if(i!=zenCache.end())
+  if(i!=zenCache.end()) {
+    counters.bundle.hit++;
+    residency.touch(&i->second);
     return i->second;
+    }
+  counters.bundle.miss++;
 
   ZenLoad::oCWorldData bundle;
   try {
@@ -679,9 +818,203 @@ ZenLoad::oCWorldData& Resources::implLoadVobBundle(const std::string& filename)
     }
 
   auto ret = zenCache.insert(std::make_pair(filename,std::move(bundle)));
+  residency.touch(&ret.first->second);
   return ret.first->second;
   }
 
+Resources::OwnedScope::OwnedScope() {
+  ownedScope++;
+  }
+
+Resources::OwnedScope::~OwnedScope() {
+  ownedScope--;
+  }
+
+void Resources::implUseTexture(const Tempest::Texture2d* t) {
+  residency.touch(t);
+  if(ownedScope==0)
+    residency.pin(t);
+  }
+
+void Resources::beginEpoch() {
+  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  inst->residency.beginEpoch();
+  }
+
+void Resources::trimResidency() {
+  auto budget = [](const char* name, int def) {
+    const int v = inst->gothic.settingsGetI("GAME",name);
+    return size_t(v>0 ? v : def)*1024*1024;
+    };
+  const size_t meshBudget = budget("meshCacheBudget",     defaultMeshBudget);
+  const size_t texBudget  = budget("textureCacheBudget",  defaultTextureBudget);
+  const size_t aniBudget  = budget("animationCacheBudget",defaultAnimationBudget);
+  const size_t zenBudget  = budget("bundleCacheBudget",   defaultBundleBudget);
+
+  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  // evicted resources may still be in flight on gpu
+  inst->device.waitIdle();
+  // meshes and skeletons go first: survivors keep their textures and animations
+  const size_t mesh   = inst->implTrimMeshes(meshBudget);
+  const size_t ani    = inst->implTrimAnimations(aniBudget);
+  const size_t tex    = inst->implTrimTextures(texBudget);
+  const size_t bundle = inst->implTrimBundles(zenBudget);
+  if(mesh>0 || tex>0 || ani>0 || bundle>0)
+    Log::i("resources: evicted ",mesh," meshes, ",tex," textures, ",ani," animations, ",bundle," vob bundles");
+  }
+
+size_t Resources::implTrimMeshes(size_t budget) {
+  // only meshes, not used by current world, are candidates: world objects keep raw pointers
+  std::vector<Residency::Entry> all;
+  for(auto& i:aniMeshCache)
+    if(i.second!=nullptr)
+      all.push_back({i.second.get(),i.second->memoryUsage()});
+  for(auto& i:decalMeshCache)
+    all.push_back({i.second.get(),i.second->memoryUsage()});
+
+  auto victim = residency.evict(all,budget);
+  if(victim.empty())
+    return 0;
+
+  std::unordered_set<const void*> drop(victim.begin(),victim.end());
+  for(auto i=bindCache.begin();i!=bindCache.end();) {
+    if(drop.count(std::get<1>(i->first)))
+      i = bindCache.erase(i); else
+      ++i;
+    }
+  for(auto i=aniMeshCache.begin();i!=aniMeshCache.end();) {
+    if(drop.count(i->second.get()))
+      i = aniMeshCache.erase(i); else
+      ++i;
+    }
+  for(auto i=decalMeshCache.begin();i!=decalMeshCache.end();) {
+    if(drop.count(i->second.get()))
+      i = decalMeshCache.erase(i); else
+      ++i;
+    }
+  return victim.size();
+  }
+
+size_t Resources::implTrimTextures(size_t budget) {
+  // materials of cached meshes point to textures
+  std::unordered_set<const void*> keep;
+  for(auto& i:aniMeshCache)
+    if(i.second!=nullptr)
+      collectTextures(*i.second,keep);
+  for(auto& i:decalMeshCache) {
+    collectTextures(i.first.mat,keep);
+    collectTextures(*i.second,keep);
+    }
+
+  std::vector<Residency::Entry> all;
+  for(auto& i:texCache)
+    if(i.second!=nullptr)
+      all.push_back({i.second.get(),textureMemory(*i.second)});
+
+  auto victim = residency.evict(all,budget,keep);
+  if(victim.empty())
+    return 0;
+
+  std::unordered_set<const void*> drop(victim.begin(),victim.end());
+  for(auto i=texCache.begin();i!=texCache.end();) {
+    if(drop.count(i->second.get()))
+      i = texCache.erase(i); else
+      ++i;
+    }
+  return victim.size();
+  }
+
+size_t Resources::implTrimAnimations(size_t budget) {
+  // animation goes together with skeletons, that refer to it; so all of them must be evictable
+  std::unordered_set<const void*> keep;
+  for(auto& i:skeletonCache)
+    if(i.second!=nullptr && !residency.isEvictable(i.second.get()))
+      keep.insert(i.second->animation());
+
+  std::vector<Residency::Entry> all;
+  for(auto& i:animCache)
+    if(i.second!=nullptr)
+      all.push_back({i.second.get(),i.second->samplesMemory()});
+
+  auto victim = residency.evict(all,budget,keep);
+  if(victim.empty())
+    return 0;
+
+  std::unordered_set<const void*> drop(victim.begin(),victim.end());
+  std::unordered_set<const void*> dropSk;
+  for(auto i=skeletonCache.begin();i!=skeletonCache.end();) {
+    if(i->second!=nullptr && drop.count(i->second->animation())) {
+      dropSk.insert(i->second.get());
+      residency.forget(i->second.get());
+      i = skeletonCache.erase(i);
+      } else {
+      ++i;
+      }
+    }
+  for(auto i=bindCache.begin();i!=bindCache.end();) {
+    if(dropSk.count(std::get<0>(i->first)))
+      i = bindCache.erase(i); else
+      ++i;
+    }
+  for(auto i=animCache.begin();i!=animCache.end();) {
+    if(drop.count(i->second.get()))
+      i = animCache.erase(i); else
+      ++i;
+    }
+  return victim.size();
+  }
+
+size_t Resources::implTrimBundles(size_t budget) {
+  // bundles are returned by copy, only residency matters
+  std::vector<Residency::Entry> all;
+  for(auto& i:zenCache)
+    all.push_back({&i.second,bundleMemory(i.second)});
+
+  auto victim = residency.evict(all,budget);
+  std::unordered_set<const void*> drop(victim.begin(),victim.end());
+  for(auto i=zenCache.begin();i!=zenCache.end();) {
+    if(drop.count(&i->second))
+      i = zenCache.erase(i); else
+      ++i;
+    }
+  return victim.size();
+  }
+
+Resources::Stats Resources::stats() {
+  std::lock_guard<std::recursive_mutex> g(inst->sync);
+  Stats ret = inst->counters;
+  for(auto& i:inst->texCache) {
+    if(i.second==nullptr)
+      continue;
+    ret.texture.count++;
+    ret.texture.bytes += size_t(i.second->w())*size_t(i.second->h())*4;
+    }
+  for(auto& i:inst->aniMeshCache) {
+    if(i.second==nullptr)
+      continue;
+    ret.mesh.count++;
+    ret.mesh.bytes += i.second->memoryUsage();
+    }
+  for(auto& i:inst->decalMeshCache) {
+    ret.decal.count++;
+    ret.decal.bytes += i.second->memoryUsage();
+    }
+  for(auto& i:inst->skeletonCache)
+    if(i.second!=nullptr)
+      ret.skeleton.count++;
+  for(auto& i:inst->animCache) {
+    if(i.second==nullptr)
+      continue;
+    ret.animation.count++;
+    ret.animation.bytes += i.second->samplesMemory();
+    }
+  for(auto& i:inst->zenCache) {
+    ret.bundle.count++;
+    ret.bundle.bytes += bundleMemory(i.second);
+    }
+  return ret;
+  }
+
 bool Resources::getFileData(const char *name, std::vector<uint8_t> &dat) {
   dat.clear();
   return inst->gothicAssets.getFileData(name,dat);
@@ -12,10 +12,15 @@
 #include <zenload/zCMorphMesh.h>
 #include <zenload/zTypes.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <tuple>
 
 #include "graphics/material.h"
+#include "utils/async.h"
 #include "sound/soundfx.h"
+#include "utils/residency.h"
 
 class Gothic;
 class StaticMesh;
@@ -53,6 +58,29 @@ class Resources final {
 
     static const size_t MAX_NUM_SKELETAL_NODES = 96;
 
+    // handle to resource, that is being loaded on worker threads
+    template<class T>
+    using Async = ::Async<T>;
+
+    struct CacheStats {
+      size_t   count = 0;
+      size_t   bytes = 0;
+      uint64_t hit   = 0;
+      uint64_t miss  = 0;
+      };
+
+    struct Stats {
+      CacheStats texture;
+      CacheStats mesh;
+      CacheStats decal;
+      CacheStats skeleton;
+      CacheStats animation;
+      CacheStats bundle;
+      // animation samples loaded so far, before and after -anicompress
+      uint64_t   aniSamplesRaw    = 0;
+      uint64_t   aniSamplesPacked = 0;
+      };
+
     struct Vertex {
       float    pos[3];
       float    norm[3];
@@ -104,6 +132,12 @@ class Resources final {
     static const Skeleton*           loadSkeleton  (const char*        name);
     static const Animation*          loadAnimation (const std::string& name);
 
+    // decoding runs on worker threads; only cache update and gpu upload are serialized
+    static Async<Tempest::Texture2d> loadTextureAsync  (const std::string& name);
+    static Async<ProtoMesh>          loadMeshAsync     (const std::string& name);
+    static Async<Skeleton>           loadSkeletonAsync (const std::string& name);
+    static Async<Animation>          loadAnimationAsync(const std::string& name);
+
     static Tempest::Sound            loadSoundBuffer(const std::string& name);
     static Tempest::Sound            loadSoundBuffer(const char*        name);
 
@@ -126,9 +160,27 @@ class Resources final {
 
     static bool                      hasFile(const std::string& fname);
     static VDFS::FileIndex&          vdfsIndex();
+    // hash of names and timestamps of all loaded archives - changes, when game data is patched
+    static uint64_t                  archivesStamp();
 
     static const Tempest::VertexBuffer<VertexFsq>& fsqVbo();
 
+    // residency of meshes, textures, animations and vob bundles: entries, not used since last beginEpoch,
+    // are evicted by trimResidency in least-recently-used order, until cache fits into budget from settings.
+    // trimResidency waits for device idle - call it from main thread, when previous world is gone
+    static void                      beginEpoch();
+    static void                      trimResidency();
+    static Stats                     stats();
+
+    // textures, loaded in this scope, are owned by an evictable resource (mesh, landscape) and follow
+    // its residency; any other texture is handed out to owner of unknown lifetime, so it's pinned
+    class OwnedScope final {
+      public:
+        OwnedScope();
+        ~OwnedScope();
+        OwnedScope(const OwnedScope&)=delete;
+      };
+
   private:
     static Resources* inst;
 
@@ -165,7 +217,7 @@ class Resources final {
     void                  detectVdf(std::vector<Archive>& ret, const std::u16string& root);
 
     Tempest::Texture2d*   implLoadTexture(TextureCache& cache, const char* cname);
-    Tempest::Texture2d*   implLoadTexture(TextureCache& cache, std::string &&name, const std::vector<uint8_t> &data);
+    bool                  implDecodeTexture(const char* cname, Tempest::Pixmap& pm);
     ProtoMesh*            implLoadMesh(const std::string &name);
     ProtoMesh*            implDecalMesh(const ZenLoad::zCVobData& vob);
     Skeleton*             implLoadSkeleton(std::string name);
@@ -175,6 +227,11 @@ class Resources final {
     GthFont&              implLoadFont(const char* fname, FontType type);
     PfxEmitterMesh*       implLoadEmiterMesh(const char* name);
     ZenLoad::oCWorldData& implLoadVobBundle(const std::string& name);
+    void                  implUseTexture(const Tempest::Texture2d* t);
+    size_t                implTrimMeshes(size_t budget);
+    size_t                implTrimTextures(size_t budget);
+    size_t                implTrimAnimations(size_t budget);
+    size_t                implTrimBundles(size_t budget);
 
     MeshLoadCode          loadMesh(ZenLoad::PackedMesh &sPacked,
                                    std::vector<ZenLoad::zCMorphMesh::Animation>& aniList,
@@ -205,11 +262,12 @@ class Resources final {
     Tempest::Device&      device;
     Tempest::SoundDevice  sound;
     std::recursive_mutex  sync;
+    std::atomic<size_t>   asyncLeft{0};
     std::unique_ptr<Dx8::DirectMusic> dxMusic;
     Gothic&               gothic;
     VDFS::FileIndex       gothicAssets;
+    uint64_t              gothicAssetsStamp = 0;
 
-    std::vector<uint8_t>  fBuff, ddsBuf;
     Tempest::VertexBuffer<VertexFsq>         fsq;
 
     TextureCache                                                          texCache;
@@ -222,4 +280,7 @@ class Resources final {
     std::unordered_map<std::string,std::unique_ptr<PfxEmitterMesh>>       emiMeshCache;
     std::unordered_map<FontK,std::unique_ptr<GthFont>,Hash>               gothicFnt;
     std::unordered_map<std::string,ZenLoad::oCWorldData>                  zenCache;
+
+    Residency                                                             residency;
+    Stats                                                                 counters;
   };
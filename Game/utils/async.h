@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Tempest/Log>
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <utility>
+
+#include "workers.h"
+
+// Handle to a value, that is being loaded by a detached task on worker pool.
+// Engine independent, to be testable without resources.
+template<class T>
+class Async final {
+  public:
+    Async()=default;
+
+    bool     isReady() const { return st==nullptr || st->ready.load(std::memory_order_acquire); }
+    // blocks until loaded; calling thread helps worker pool meanwhile
+    const T* get()     const { if(st==nullptr) return nullptr; Workers::waitFor(st->ready); return st->value; }
+
+    // fn returns pointer to loaded value, or nullptr; `left` counts tasks in flight
+    template<class F>
+    static Async run(F&& fn, std::atomic<size_t>& left) {
+      Async ret;
+      ret.st = std::make_shared<State>();
+      left.fetch_add(1);
+      Workers::async([st=ret.st,fn=std::forward<F>(fn),&left]() {
+        // waiters must be released even if load failed
+        try {
+          st->value = fn();
+          }
+        catch(const std::exception& e) {
+          Tempest::Log::e("async load failed: ",e.what());
+          }
+        st->ready.store(true,std::memory_order_release);
+        left.fetch_sub(1);
+        });
+      return ret;
+      }
+
+  private:
+    struct State {
+      std::atomic<bool> ready{false};
+      const T*          value = nullptr;
+      };
+    std::shared_ptr<State> st;
+  };
@@ -53,4 +53,13 @@ namespace FileExt {
       s[off+i] = extOut[i];
     return true;
     }
+
+  // name of on-disk cache file for a world; vdfs names are case-insensitive
+  inline std::string cacheName(const char* prefix, const std::string& world) {
+    std::string ret = prefix;
+    for(auto c:world)
+      ret.push_back(char(std::tolower(c)));
+    ret += ".cache";
+    return ret;
+    }
   }
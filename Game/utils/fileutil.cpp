@@ -3,11 +3,16 @@
 #include <Tempest/Platform>
 #include <Tempest/TextCodec>
 
+#include <cerrno>
+#include <cstdlib>
+
 #ifdef __WINDOWS__
 #include <windows.h>
 #include <shlwapi.h>
+#include <io.h>
 #else
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 using namespace Tempest;
@@ -60,3 +65,42 @@ std::u16string FileUtil::nestedPath(const std::u16string& gpath, const std::init
     path = caseInsensitiveSegment(path,segment, (segment==*(name.end()-1)) ? type : Dir::FT_Dir);
   return path;
   }
+
+// per-user directory, not shared with other users of the machine; empty if there is none
+static std::string cacheDir() {
+#ifdef __WINDOWS__
+  const char* base = std::getenv("LOCALAPPDATA");
+  if(base==nullptr || base[0]=='\0')
+    return "";
+  std::string ret = std::string(base)+"\\OpenGothic";
+  if(!CreateDirectoryA(ret.c_str(),nullptr) && GetLastError()!=ERROR_ALREADY_EXISTS)
+    return "";
+  return ret+"\\";
+#else
+  std::string ret;
+  const char* xdg  = std::getenv("XDG_CACHE_HOME");
+  const char* home = std::getenv("HOME");
+  if(xdg!=nullptr && xdg[0]=='/')
+    ret = xdg;
+  else if(home!=nullptr && home[0]=='/')
+    ret = std::string(home)+"/.cache";
+  else
+    return "";
+  mkdir(ret.c_str(),0700);
+  ret += "/opengothic";
+  if(mkdir(ret.c_str(),0700)!=0 && errno!=EEXIST)
+    return "";
+  // must be a real directory of this user, accessible only by this user
+  struct stat st = {};
+  if(lstat(ret.c_str(),&st)!=0 || !S_ISDIR(st.st_mode) || st.st_uid!=getuid() || (st.st_mode&077)!=0)
+    return "";
+  return ret+"/";
+#endif
+  }
+
+std::string FileUtil::cachePath(const std::string& name) {
+  static const std::string dir = cacheDir();
+  if(dir.empty())
+    return "";
+  return dir+name;
+  }
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <mutex>
+#include <utility>
+
+// Cache of loaded assets, shared by loader threads: lookup and insert are done under lock, decoding out of it.
+// Same asset may be decoded twice by racing threads - first insert wins, other copy is dropped.
+// Engine independent, to be testable without Device and game data.
+namespace LoadCache {
+  // `decode()` runs without lock; `make(decoded)` runs under lock and returns std::unique_ptr to value,
+  // that is cached, nullptr included. `use(value)` runs under lock for every returned value.
+  // Exception of `make` propagates, nothing is cached then.
+  template<class Map, class Stats, class Decode, class Make, class Use>
+  auto load(std::recursive_mutex& sync, Map& cache, const typename Map::key_type& key, Stats& stats,
+            Decode&& decode, Make&& make, Use&& use) -> typename Map::mapped_type::element_type* {
+    {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = cache.find(key);
+    if(it!=cache.end()) {
+      stats.hit++;
+      use(it->second.get());
+      return it->second.get();
+      }
+    }
+
+    auto data = decode();
+
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = cache.find(key);
+    if(it!=cache.end()) {
+      use(it->second.get());
+      return it->second.get();
+      }
+    stats.miss++;
+    auto val = make(std::move(data));
+    auto ret = val.get();
+    cache[key] = std::move(val);
+    use(ret);
+    return ret;
+    }
+  }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+// Result of a pure query, computed ahead of time (e.g. in parallel phase of npc tick).
+// It is handed out only for exactly the same input and epoch of the data, that query reads;
+// so consumer observes same value as if query would run in place.
+template<class Key,class Value>
+class Prefetched final {
+  public:
+    void set(const Key& k, uint64_t ep, const Value& v) {
+      key   = k;
+      epoch = ep;
+      value = v;
+      valid = true;
+      }
+
+    bool take(const Key& k, uint64_t ep, Value& out) {
+      if(!valid || epoch!=ep || !(key==k))
+        return false;
+      out   = std::move(value);
+      valid = false;
+      return true;
+      }
+
+    void reset() { valid = false; }
+    bool isValid() const { return valid; }
+
+  private:
+    Key      key   = {};
+    Value    value = {};
+    uint64_t epoch = 0;
+    bool     valid = false;
+  };
@@ -0,0 +1,57 @@
+#include "residency.h"
+
+#include <algorithm>
+
+void Residency::touch(const void* res) {
+  if(res!=nullptr)
+    lastUse[res] = epoch;
+  }
+
+void Residency::pin(const void* res) {
+  if(res!=nullptr)
+    pinned.insert(res);
+  }
+
+void Residency::forget(const void* res) {
+  lastUse.erase(res);
+  pinned.erase(res);
+  }
+
+bool Residency::isEvictable(const void* res) const {
+  if(pinned.count(res))
+    return false;
+  auto it = lastUse.find(res);
+  return it!=lastUse.end() && it->second!=epoch;
+  }
+
+std::vector<const void*> Residency::evict(const std::vector<Entry>& all, size_t budget,
+                                          const std::unordered_set<const void*>& keep) {
+  struct Victim {
+    uint32_t    epoch = 0;
+    size_t      bytes = 0;
+    const void* res   = nullptr;
+    };
+
+  size_t              total = 0;
+  std::vector<Victim> victim;
+  for(auto& i:all) {
+    total += i.bytes;
+    if(!isEvictable(i.res) || keep.count(i.res))
+      continue;
+    victim.push_back({lastUse.find(i.res)->second,i.bytes,i.res});
+    }
+
+  std::vector<const void*> ret;
+  if(total<=budget)
+    return ret;
+
+  std::stable_sort(victim.begin(),victim.end(),[](const Victim& a, const Victim& b){ return a.epoch<b.epoch; });
+  for(auto& i:victim) {
+    if(total<=budget)
+      break;
+    total -= i.bytes;
+    ret.push_back(i.res);
+    lastUse.erase(i.res);
+    }
+  return ret;
+  }
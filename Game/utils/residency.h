@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Epoch based residency of cached resources: every use stamps resource with current epoch, evict()
+// picks least recently used resources, until cache fits into budget. Resources of current epoch,
+// pinned ones (handed out to owner of unknown lifetime) and ones in `keep` are never evicted.
+class Residency final {
+  public:
+    struct Entry {
+      const void* res   = nullptr;
+      size_t      bytes = 0;
+      };
+
+    void     beginEpoch() { ++epoch; }
+    uint32_t currentEpoch() const { return epoch; }
+
+    void     touch (const void* res);
+    void     pin   (const void* res);
+    void     forget(const void* res);
+    bool     isEvictable(const void* res) const;
+
+    // returns resources to drop from `all`; they are forgotten by residency
+    std::vector<const void*> evict(const std::vector<Entry>& all, size_t budget,
+                                   const std::unordered_set<const void*>& keep = {});
+
+  private:
+    uint32_t                                 epoch = 0;
+    std::unordered_map<const void*,uint32_t> lastUse;
+    std::unordered_set<const void*>          pinned;
+  };
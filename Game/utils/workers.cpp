@@ -4,20 +4,27 @@
 
 using namespace Tempest;
 
+// index of the queue owned by current thread; threads outside of pool share the last one
+static thread_local size_t queueId = size_t(-1);
+
 Workers::Workers() {
-  size_t id=0;
-  for(auto& i:th) {
-    i = std::thread([this,id]() noexcept {
+  size_t cnt = std::thread::hardware_concurrency();
+  cnt = std::max<size_t>(1,std::min<size_t>(cnt,MAX_THREADS));
+  // caller of parallelFor helps, so spawn one thread less
+  th.resize(cnt-1);
+  for(size_t id=0; id<th.size(); ++id) {
+    th[id] = std::thread([this,id]() noexcept {
       threadFunc(id);
       });
-    ++id;
     }
   }
 
 Workers::~Workers() {
-  running   = false;
-  workTasks = MAX_THREADS;
-  execWork();
+  {
+    std::unique_lock<std::mutex> lck(sync);
+    running.store(false);
+  }
+  workWait.notify_all();
   for(auto& i:th)
     i.join();
   }
@@ -28,45 +35,172 @@ Workers &Workers::inst() {
   }
 
 void Workers::threadFunc(size_t id) {
+  queueId = id;
   while(true) {
-    {
+    Job job;
+    if(pop(job,nullptr) || popAsync(job)) {
+      job.exec(job.ctx,job.begin,job.end);
+      continue;
+      }
+
     std::unique_lock<std::mutex> lck(sync);
-    while(!workInc[id])
+    sleeping.fetch_add(1);
+    while(running.load() && queued.load()==0 && asyncQueued.load()==0)
       workWait.wait(lck);
-    workInc[id]=false;
+    sleeping.fetch_sub(1);
+    if(!running.load())
+      return;
     }
+  }
 
-    if(!running) {
-      workDone.fetch_add(1);
-      return;
-      }
+void Workers::push(const Job& j) {
+  size_t id = queueId<th.size() ? queueId : MAX_THREADS;
+  queued.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lck(queues[id].sync);
+    queues[id].jobs.push_back(j);
+  }
+  if(sleeping.load()>0) {
+    std::lock_guard<std::mutex> lck(sync);
+    workWait.notify_one();
+    }
+  }
+
+void Workers::pushAsync(const Job& j) {
+  if(th.empty()) {
+    // no pool: nobody else would pick it up
+    j.exec(j.ctx,j.begin,j.end);
+    return;
+    }
+  asyncQueued.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lck(asyncJobs.sync);
+    asyncJobs.jobs.push_back(j);
+  }
+  if(sleeping.load()>0) {
+    std::lock_guard<std::mutex> lck(sync);
+    workWait.notify_one();
+    }
+  }
 
-    size_t b = std::min((id  )*batchSize, workSize);
-    size_t e = std::min((id+1)*batchSize, workSize);
-    // Log::d("worker: id = ",id," [",b, ", ",e,"]");
+bool Workers::pop(Job& j, const void* owner) {
+  if(queued.load()==0)
+    return false;
 
-    if(b!=e) {
-      void* d = &workSet[b*workEltSize];
-      workFunc(d,e-b);
+  const size_t own = queueId<th.size() ? queueId : MAX_THREADS;
+  {
+    // own work first, newest first: better locality for recursive splits
+    auto& q = queues[own];
+    std::lock_guard<std::mutex> lck(q.sync);
+    for(size_t i=q.jobs.size(); i>0; --i) {
+      auto it = q.jobs.begin()+std::ptrdiff_t(i-1);
+      if(owner!=nullptr && it->owner!=owner)
+        continue;
+      j = *it;
+      q.jobs.erase(it);
+      queued.fetch_sub(1);
+      return true;
       }
+  }
 
-    workDone.fetch_add(1);
+  // steal oldest (biggest) job from others
+  const size_t cnt  = th.size();
+  const size_t slot = (own==MAX_THREADS ? cnt : own);
+  for(size_t i=1; i<=cnt; ++i) {
+    size_t id = (slot+i)%(cnt+1);
+    if(id==cnt)
+      id = MAX_THREADS;
+    auto& q = queues[id];
+    std::lock_guard<std::mutex> lck(q.sync);
+    for(auto it=q.jobs.begin(); it!=q.jobs.end(); ++it) {
+      if(owner!=nullptr && it->owner!=owner)
+        continue;
+      j = *it;
+      q.jobs.erase(it);
+      queued.fetch_sub(1);
+      return true;
+      }
     }
+  return false;
   }
 
-void Workers::execWork() {
-  {
-    std::unique_lock<std::mutex> lck(sync);
-    for(size_t i=0; i<workTasks; ++i)
-      workInc[i]=true;
-    workWait.notify_all();
+bool Workers::popAsync(Job& j) {
+  if(asyncQueued.load()==0)
+    return false;
+  std::lock_guard<std::mutex> lck(asyncJobs.sync);
+  if(asyncJobs.jobs.empty())
+    return false;
+  j = asyncJobs.jobs.front();
+  asyncJobs.jobs.pop_front();
+  asyncQueued.fetch_sub(1);
+  return true;
+  }
+
+void Workers::wait(const std::atomic<size_t>& left, const void* owner) {
+  // help only with own jobs: nesting depth is bounded by the depth of the awaited work itself
+  while(left.load(std::memory_order_acquire)!=0) {
+    Job job;
+    if(pop(job,owner))
+      job.exec(job.ctx,job.begin,job.end); else
+      std::this_thread::yield();
+    }
   }
-  std::this_thread::yield();
 
+void Workers::waitAsync(const std::atomic<bool>* ready, const std::atomic<size_t>* left) {
   while(true) {
-    int expect = int(workTasks);
-    if(workDone.compare_exchange_strong(expect,0,std::memory_order::memory_order_acq_rel))
-      break;
-    std::this_thread::yield();
+    if(ready!=nullptr && ready->load(std::memory_order_acquire))
+      return;
+    if(left!=nullptr && left->load(std::memory_order_acquire)==0)
+      return;
+    Job job;
+    if(popAsync(job))
+      job.exec(job.ctx,job.begin,job.end); else
+      std::this_thread::yield();
     }
   }
+
+void Workers::waitFor(const std::atomic<bool>& ready) {
+  inst().waitAsync(&ready,nullptr);
+  }
+
+void Workers::waitFor(const std::atomic<size_t>& left) {
+  inst().waitAsync(nullptr,&left);
+  }
+
+void Workers::execAsync(const void* ctx, size_t, size_t) {
+  std::unique_ptr<std::function<void()>> fn(reinterpret_cast<std::function<void()>*>(const_cast<void*>(ctx)));
+  try {
+    (*fn)();
+    }
+  catch(const std::exception& e) {
+    Log::e("async task failed: ",e.what());
+    }
+  catch(...) {
+    Log::e("async task failed");
+    }
+  }
+
+void Workers::TaskGroup::execTask(const void* ctx, size_t, size_t) {
+  auto& t = *reinterpret_cast<const Task*>(ctx);
+  try {
+    t.fn();
+    }
+  catch(...) {
+    t.owner->err.store(std::current_exception());
+    }
+  t.owner->left.fetch_sub(1,std::memory_order_acq_rel);
+  }
+
+void Workers::TaskGroup::join() {
+  Workers::inst().wait(left,this);
+  tasks.clear();
+  }
+
+void Workers::TaskGroup::wait() {
+  join();
+  auto e = err.ptr;
+  err.ptr = nullptr;
+  err.set.store(false);
+  if(e)
+    std::rethrow_exception(e);
+  }
@@ -2,26 +2,84 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
+#include <deque>
+#include <memory>
 #include <functional>
 #include <atomic>
 #include <algorithm>
-
-#include "semaphore.h"
+#include <exception>
 
 class Workers final {
   public:
     Workers();
     ~Workers();
 
+  private:
+    // first exception of a parallel context; rethrown on the waiting thread
+    struct Error {
+      std::atomic<bool>  set{false};
+      std::exception_ptr ptr;
+
+      void store(std::exception_ptr e) { if(!set.exchange(true)) ptr = e; }
+      void rethrow() const             { if(ptr) std::rethrow_exception(ptr); }
+      };
+
+  public:
+    // fork-join group: tasks spawned by run() may run in parallel; wait() executes pending jobs
+    // of this group on the calling thread until every task is done. Nesting is allowed, so a task
+    // may spawn and wait its own sub-group - this is how dependencies are expressed.
+    // First exception, thrown by a task, is rethrown from wait().
+    class TaskGroup final {
+      public:
+        TaskGroup()=default;
+        TaskGroup(const TaskGroup&)=delete;
+        ~TaskGroup() { join(); }
+
+        template<class F>
+        void run(F&& f) {
+          tasks.emplace_back(new Task{this,std::function<void()>(std::forward<F>(f))});
+          left.fetch_add(1);
+          Workers::inst().push(Job{&TaskGroup::execTask,tasks.back().get(),this,0,1});
+          }
+
+        void wait();
+
+      private:
+        struct Task {
+          TaskGroup*            owner;
+          std::function<void()> fn;
+          };
+        static void execTask(const void* ctx, size_t b, size_t e);
+        void        join();
+
+        std::vector<std::unique_ptr<Task>> tasks;
+        std::atomic<size_t>                left{0};
+        Error                              err;
+      };
+
+    // detached, low priority task: executed by pool threads, when there is no other work,
+    // or by threads in waitFor. Exceptions are logged and dropped - task must report failure on its own
+    template<class F>
+    static void async(F&& f) {
+      auto fn = new std::function<void()>(std::forward<F>(f));
+      inst().pushAsync(Job{&execAsync,fn,nullptr,0,1});
+      }
+
+    // wait for detached tasks: execute pending async jobs on calling thread, until `ready` is set
+    // or `left` drops to zero
+    static void waitFor(const std::atomic<bool>&   ready);
+    static void waitFor(const std::atomic<size_t>& left);
+
     template<class T,class F>
     static void parallelFor(T* b, T* e, const F& func) {
-      inst().runParallelFor(b,std::distance(b,e),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(b,size_t(std::distance(b,e)),inst().threadCount(),func);
       }
 
     template<class T,class F>
     static void parallelFor(std::vector<T>& data, const F& func) {
-      inst().runParallelFor(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      inst().runParallelFor(data.data(),data.size(),inst().threadCount(),func);
       }
 
     template<class T,class F>
@@ -30,43 +88,103 @@ class Workers final {
       }
 
   private:
-    enum { MAX_THREADS=16 };
+    enum {
+      MAX_THREADS = 16,
+      // leaf jobs per participating thread; more leafs - better balance for uneven per-item cost
+      SPLIT_RATE  = 8,
+      };
+
+    // owner - context, that job belongs to (ForCtx or TaskGroup); waiter helps only with jobs of own context,
+    // so a frame-critical parallelFor never picks up unrelated long running work
+    struct Job {
+      void        (*exec)(const void* ctx, size_t b, size_t e) = nullptr;
+      const void*   ctx   = nullptr;
+      const void*   owner = nullptr;
+      size_t        begin = 0;
+      size_t        end   = 0;
+      };
+
+    struct Queue {
+      std::mutex      sync;
+      std::deque<Job> jobs;
+      };
 
-    void threadFunc(size_t id);
-    void execWork();
+    template<class T,class F>
+    struct ForCtx {
+      T*                  data;
+      const F*            func;
+      size_t              grain;
+      std::atomic<size_t> left;
+      Error               err;
+      };
+
+    void   threadFunc(size_t id);
+    size_t threadCount() const { return th.size()+1; }
     static Workers& inst();
 
+    void   push     (const Job& j);
+    void   pushAsync(const Job& j);
+    // owner==nullptr: any job (pool threads), otherwise only jobs of this owner
+    bool   pop      (Job& j, const void* owner);
+    bool   popAsync (Job& j);
+    void   wait     (const std::atomic<size_t>& left, const void* owner);
+    void   waitAsync(const std::atomic<bool>* ready, const std::atomic<size_t>* left);
+    static void execAsync(const void* ctx, size_t b, size_t e);
+
     template<class T,class F>
-    void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
-      workSet     = reinterpret_cast<uint8_t*>(data);
-      workSize    = sz;
-      workEltSize = sizeof(T);
-
-      workFunc = [&func](void* data,size_t sz) {
-        T* tdata = reinterpret_cast<T*>(data);
-        for(size_t i=0;i<sz;++i)
-          func(tdata[i]);
-        };
-
-      if(maxTh>MAX_THREADS)
-        workTasks = MAX_THREADS; else
-        workTasks = maxTh;
-
-      batchSize = std::max<size_t>(16,(sz+workTasks-1)/workTasks);
-      execWork();
+    static void execFor(const void* c, size_t b, size_t e) {
+      auto& ctx = *reinterpret_cast<ForCtx<T,F>*>(const_cast<void*>(c));
+      // lazy binary splitting: give away upper half, keep working on lower one
+      while(e-b>ctx.grain) {
+        size_t mid = b+(e-b)/2;
+        inst().push(Job{&execFor<T,F>,c,c,mid,e});
+        e = mid;
+        }
+      // after first failure rest of range is skipped, but still accounted
+      if(!ctx.err.set.load(std::memory_order_relaxed)) {
+        try {
+          for(size_t i=b; i<e; ++i)
+            (*ctx.func)(ctx.data[i]);
+          }
+        catch(...) {
+          ctx.err.store(std::current_exception());
+          }
+        }
+      ctx.left.fetch_sub(e-b,std::memory_order_acq_rel);
       }
 
-    std::thread                       th     [MAX_THREADS];
-    bool                              workInc[MAX_THREADS];
+    template<class T,class F>
+    void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
+      if(sz==0)
+        return;
+      if(maxTh<=1 || sz==1 || th.empty()) {
+        for(size_t i=0; i<sz; ++i)
+          func(data[i]);
+        return;
+        }
+
+      ForCtx<T,F> ctx;
+      ctx.data  = data;
+      ctx.func  = &func;
+      ctx.grain = std::max<size_t>(1,sz/(std::min(maxTh,threadCount())*SPLIT_RATE));
+      ctx.left.store(sz);
+
+      execFor<T,F>(&ctx,0,sz);
+      wait(ctx.left,&ctx);
+      ctx.err.rethrow();
+      }
 
-    bool                              running=true;
+    std::vector<std::thread>          th;
+    // one queue per worker + one shared by threads outside of the pool
+    Queue                             queues[MAX_THREADS+1];
+    // detached tasks; never stolen by waiters of parallelFor/TaskGroup
+    Queue                             asyncJobs;
 
-    uint8_t*                          workSet=nullptr;
-    size_t                            workSize=0, batchSize=0, workEltSize=0;
-    size_t                            workTasks=0;
-    std::function<void(void*,size_t)> workFunc;
+    std::atomic<bool>                 running{true};
+    std::atomic<size_t>               queued{0};
+    std::atomic<size_t>               asyncQueued{0};
+    std::atomic<size_t>               sleeping{0};
 
     std::mutex                        sync;
     std::condition_variable           workWait;
-    std::atomic_int                   workDone{0};
   };
@@ -37,7 +37,7 @@ class Bullet final : public DynamicWorld::BulletCallback {
     int32_t  spellId() const;
 
     void     setOwner(Npc* n);
-    Npc*     owner() const;
+    Npc*     owner() const override;
 
     Flg      flags()     const { return flg;  }
     void     setFlags(Flg f) { flg=f; }
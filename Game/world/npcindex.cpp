@@ -0,0 +1,76 @@
+#include "npcindex.h"
+
+#include <algorithm>
+
+#include "world/objects/npc.h"
+
+NpcIndex::NpcIndex(const std::vector<std::unique_ptr<Npc>>& npc)
+  :npc(npc) {
+  }
+
+void NpcIndex::update() {
+  ensureBuilt();
+  }
+
+void NpcIndex::onMove(const Npc& n, const Tempest::Vec3& pos) {
+  if(dirty.load(std::memory_order_acquire))
+    return; // picked up by next rebuild
+  auto it = byPointer.find(&n);
+  if(it==byPointer.end())
+    return; // not in world yet
+  grid.move(it->second,pos);
+  }
+
+void NpcIndex::ensureBuilt() const {
+  if(!dirty.load(std::memory_order_acquire))
+    return;
+  std::lock_guard<std::mutex> guard(buildSync);
+  if(!dirty.load(std::memory_order_relaxed))
+    return;
+  build();
+  dirty.store(false,std::memory_order_release);
+  }
+
+void NpcIndex::build() const {
+  std::vector<Tempest::Vec3> pos(npc.size());
+  byPointer.clear();
+  byInstance.clear();
+  maxSenses = 0;
+
+  for(size_t i=0; i<npc.size(); ++i) {
+    auto& n = *npc[i];
+    pos[i]  = n.position();
+
+    byPointer[&n] = uint32_t(i);
+    // first npc in array order wins, same as linear search did
+    byInstance.emplace(n.handle()->instanceSymbol,uint32_t(i));
+    maxSenses = std::max(maxSenses,float(n.handle()->senses_range));
+    }
+  grid.build(pos);
+  }
+
+void NpcIndex::find(const Tempest::Vec3& p, float R, std::vector<uint32_t>& out) const {
+  ensureBuilt();
+  grid.find(p,R,out);
+  }
+
+uint32_t NpcIndex::indexOf(const Npc* ptr) const {
+  ensureBuilt();
+  auto it = byPointer.find(ptr);
+  if(it==byPointer.end())
+    return uint32_t(-1);
+  return it->second;
+  }
+
+Npc* NpcIndex::findByInstance(size_t instance) const {
+  ensureBuilt();
+  auto it = byInstance.find(instance);
+  if(it==byInstance.end())
+    return nullptr;
+  return npc[it->second].get();
+  }
+
+float NpcIndex::maxSensesRange() const {
+  ensureBuilt();
+  return maxSenses;
+  }
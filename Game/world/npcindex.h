@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+#include "pointgrid.h"
+
+class Npc;
+
+// Uniform grid over npc positions (XZ plane) plus lookup tables by pointer and by instance.
+// Index is rebuilt, when invalidated: npc added or removed or npc array reordered; npc movement is tracked by onMove.
+// Mutations are main-thread only; queries may run from parallel phase of tick, rebuild is done once under lock.
+class NpcIndex final {
+  public:
+    NpcIndex(const std::vector<std::unique_ptr<Npc>>& npc);
+
+    void     invalidate() { dirty.store(true,std::memory_order_release); }
+    // rebuild now, if invalidated: keeps parallel phase from ever waiting on lock
+    void     update();
+    void     onMove(const Npc& npc, const Tempest::Vec3& pos);
+
+    // returns indices in npc array, in ascending order; npc's are within R from p on XZ plane
+    void     find(const Tempest::Vec3& p, float R, std::vector<uint32_t>& out) const;
+    uint32_t indexOf(const Npc* npc) const;
+    Npc*     findByInstance(size_t instance) const;
+    float    maxSensesRange() const;
+
+  private:
+    const std::vector<std::unique_ptr<Npc>>& npc;
+
+    mutable std::mutex                       buildSync;
+    mutable std::atomic<bool>                dirty{true};
+    mutable PointGrid                        grid;
+    mutable std::unordered_map<const Npc*,uint32_t> byPointer;
+    mutable std::unordered_map<size_t,uint32_t>     byInstance;
+    mutable float                            maxSenses = 0;
+
+    void            ensureBuilt() const;
+    void            build() const;
+  };
@@ -857,6 +857,7 @@ void Interactive::marchInteractives(DbgPainter &p) const {
 void Interactive::moveEvent() {
   Vob::moveEvent();
   visual.setObjMatrix(transform());
+  world.invalidateVobIndex(*this);
   }
 
 const char *Interactive::Pos::posTag() const {
@@ -111,7 +111,6 @@ void Item::setPhysicsEnable(DynamicWorld& p) {
 
 void Item::setPhysicsDisable() {
   physic = DynamicWorld::Item();
-  world.invalidateVobIndex();
   }
 
 bool Item::isDynamic() const {
@@ -239,5 +238,5 @@ void Item::updateMatrix() {
   }
 
 void Item::moveEvent() {
-  world.invalidateVobIndex();
+  world.invalidateVobIndex(*this);
   }
@@ -4,6 +4,7 @@
 #include <Tempest/Log>
 
 #include <zenload/zCMaterial.h>
+#include <cstring>
 
 #include "graphics/mesh/skeleton.h"
 #include "graphics/mesh/animmath.h"
@@ -329,6 +330,7 @@ void Npc::loadAiState(Serialize& fin) {
 bool Npc::setPosition(float ix, float iy, float iz) {
   if(x==ix && y==iy && z==iz)
     return false;
+  owner.updateNpcIndex(*this,Vec3{ix,iy,iz});
   x = ix;
   y = iy;
   z = iz;
@@ -343,6 +345,7 @@ bool Npc::setPosition(const Tempest::Vec3& pos) {
   }
 
 void Npc::setViewPosition(const Tempest::Vec3& pos) {
+  owner.updateNpcIndex(*this,pos);
   x = pos.x;
   y = pos.y;
   z = pos.z;
@@ -1676,9 +1679,30 @@ Npc* Npc::updateNearestBody() {
   return ret;
   }
 
+bool Npc::tickPrepare(uint64_t dt, MoveAlgo::Probe& probe) {
+  // no side effects outside of own prefetch buffers - safe to run in parallel for all npc's
+  auto&              pose = visual.pose();
+  const EventsKey    key  = {owner.tickCount(),lastEventTime,pose.eventsHash()};
+  uint64_t           barrier = lastEventTime;
+  Animation::EvCount ev;
+  pose.processEvents(barrier,key.now,ev);
+  prefEvents.set(key,0,ev);
+
+  return mvAlgo.predictProbe(dt,probe);
+  }
+
+void Npc::setPrefetchedProbe(const MoveAlgo::Probe& probe, uint64_t rayEpoch,
+                             const DynamicWorld::RayLandResult& land, const DynamicWorld::RayWaterResult& water) {
+  mvAlgo.setPrefetched(probe,rayEpoch,land,water);
+  }
+
 void Npc::tick(uint64_t dt) {
   Animation::EvCount ev;
-  visual.pose().processEvents(lastEventTime,owner.tickCount(),ev);
+  // events from parallel phase are valid, only if no one has touched animation layers since then
+  const EventsKey key = {owner.tickCount(),lastEventTime,visual.pose().eventsHash()};
+  if(prefEvents.take(key,0,ev))
+    lastEventTime = key.now; else
+    visual.pose().processEvents(lastEventTime,owner.tickCount(),ev);
   visual.processLayers(owner);
   visual.setNpcEffect(owner,*this,hnpc.effect,hnpc.flags);
 
@@ -1736,6 +1760,38 @@ void Npc::tick(uint64_t dt) {
   implAiTick(dt);
   }
 
+void Npc::tickRoutineOnly(uint64_t dt) {
+  if(isDead())
+    return;
+  tickRegen(hnpc.attribute[ATR_HITPOINTS],hnpc.attribute[ATR_HITPOINTSMAX],
+            hnpc.attribute[ATR_REGENERATEHP],dt);
+  tickRegen(hnpc.attribute[ATR_MANA],hnpc.attribute[ATR_MANAMAX],
+            hnpc.attribute[ATR_REGENERATEMANA],dt);
+
+  // state of current routine is still running
+  if(aiState.funcIni.isValid() && owner.time()<aiState.eTime)
+    return;
+
+  // routine has changed: npc appears at point of next one; its state is started by tickRoutine, once npc is near
+  auto& r  = currentRoutine();
+  auto  at = r.point;
+  if(at==nullptr || (currentFp!=nullptr && std::strcmp(hnpc.wp.c_str(),at->name.c_str())==0))
+    return;
+  if(at->isLocked()) {
+    auto p = owner.findNextPoint(*at);
+    if(p!=nullptr)
+      at = p;
+    }
+  clearAiQueue();
+  clearGoTo();
+  setInteraction(nullptr,true);
+  clearState(true);
+  hnpc.wp = r.point->name;
+  setPosition (at->x, at->y, at->z);
+  setDirection(at->dirX,at->dirY,at->dirZ);
+  attachToPoint(at);
+  }
+
 void Npc::nextAiAction(uint64_t dt) {
   if(aiQueue.size()==0)
     return;
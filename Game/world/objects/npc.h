@@ -33,6 +33,13 @@ class Npc final {
       AiFar2
       };
 
+    // per-frame decision of ai level of detail scheduler
+    enum AiTickState : uint8_t {
+      AiTickNew,  // not seen by scheduler yet
+      AiTickDue,
+      AiTickSkip,
+      };
+
     using JumpStatus = MoveAlgo::JumpStatus;
 
     enum PercType : uint8_t {
@@ -209,11 +216,21 @@ class Npc final {
 
     void       setProcessPolicy(ProcessPolicy t);
     auto       processPolicy() const -> ProcessPolicy { return aiPolicy; }
+    auto       skippedTickTime() const -> uint64_t { return aiSkippedTime; }
+    void       setSkippedTickTime(uint64_t t) { aiSkippedTime = t; }
+    auto       aiTickState() const -> AiTickState { return aiTick; }
+    void       setAiTickState(AiTickState s) { aiTick = s; }
 
     bool       isPlayer() const;
     void       setWalkMode(WalkBit m);
     auto       walkMode() const { return wlkMode; }
+    // parallel phase of world tick: pure part of tick(dt), results are kept only for tick itself
+    bool       tickPrepare(uint64_t dt, MoveAlgo::Probe& probe);
+    void       setPrefetchedProbe(const MoveAlgo::Probe& probe, uint64_t rayEpoch,
+                                  const DynamicWorld::RayLandResult& land, const DynamicWorld::RayWaterResult& water);
     void       tick(uint64_t dt);
+    // AiFar2: keeps up with daily routine only, without perception, animation events and state scripts
+    void       tickRoutineOnly(uint64_t dt);
     bool       startClimb(JumpStatus jump);
 
     auto       world() -> World&;
@@ -229,6 +246,7 @@ class Npc final {
     float      qDistTo(const Interactive& p) const;
 
     void       updateAnimation();
+    auto       animLod() const -> MdlVisual::AnimLod { return visual.animLod(); }
     void       updateTransform();
 
     const char*displayName() const;
@@ -517,6 +535,14 @@ class Npc final {
       void                         set(const Tempest::Vec3& to);
       };
 
+    // input of Pose::processEvents
+    struct EventsKey final {
+      uint64_t now     = 0;
+      uint64_t barrier = 0;
+      uint64_t layers  = 0;
+      bool operator == (const EventsKey& k) const { return now==k.now && barrier==k.barrier && layers==k.layers; }
+      };
+
     void      updateWeaponSkeleton();
     void      tickTimedEvt(Animation::EvCount &ev);
     void      tickRegen(int32_t& v,const int32_t max,const int32_t chg, const uint64_t dt);
@@ -627,6 +653,8 @@ class Npc final {
     uint64_t                       faiWaitTime=0;
     uint64_t                       aiOutputBarrier=0;
     ProcessPolicy                  aiPolicy=ProcessPolicy::AiNormal;
+    uint64_t                       aiSkippedTime=0;
+    AiTickState                    aiTick=AiTickNew;
     AiState                        aiState;
     ScriptFn                       aiPrevState;
     AiQueue                        aiQueue;
@@ -652,6 +680,7 @@ class Npc final {
     MoveAlgo                       mvAlgo;
     FightAlgo                      fghAlgo;
     uint64_t                       lastEventTime=0;
+    Prefetched<EventsKey,Animation::EvCount> prefEvents;
 
     Sound                          sfxWeapon;
 
@@ -89,17 +89,12 @@ bool Vob::isDynamic() const {
   }
 
 void Vob::recalculateTransform() {
-  auto old = position();
   if(parent!=nullptr) {
     pos = parent->transform();
     pos.mul(local);
     } else {
     pos = local;
     }
-  if(old != position()) {
-    if(childContent!=cbNone)
-      world.invalidateVobIndex();
-    }
   moveEvent();
   for(auto& i:child) {
     i->recalculateTransform();
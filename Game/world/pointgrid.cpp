@@ -0,0 +1,67 @@
+#include "pointgrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PointGrid::build(const std::vector<Tempest::Vec3>& pos) {
+  point = pos;
+  grid.resize(pos.size());
+  for(size_t i=0; i<pos.size(); ++i) {
+    grid[i].key = cellKey(pos[i]);
+    grid[i].id  = uint32_t(i);
+    }
+  std::sort(grid.begin(),grid.end());
+  }
+
+void PointGrid::move(uint32_t id, const Tempest::Vec3& pos) {
+  const uint64_t prev = cellKey(point[id]);
+  const uint64_t next = cellKey(pos);
+  point[id] = pos;
+  if(prev==next)
+    return;
+
+  // moving one entry over sorted array: points cross cells rarely, that is cheaper than full rebuild
+  auto     from = std::lower_bound(grid.begin(),grid.end(),Cell{prev,id});
+  auto     to   = std::lower_bound(grid.begin(),grid.end(),Cell{next,id});
+  if(from<to) {
+    std::rotate(from,from+1,to);
+    (to-1)->key = next;
+    } else {
+    std::rotate(to,from,from+1);
+    to->key = next;
+    }
+  }
+
+void PointGrid::find(const Tempest::Vec3& p, float R, std::vector<uint32_t>& out) const {
+  out.clear();
+  const int32_t x0 = cellCoord(p.x-R), x1 = cellCoord(p.x+R);
+  const int32_t z0 = cellCoord(p.z-R), z1 = cellCoord(p.z+R);
+
+  for(int32_t x=x0; x<=x1; ++x) {
+    auto b = std::lower_bound(grid.begin(),grid.end(),Cell{cellKey(x,z0),0});
+    auto e = std::upper_bound(b,grid.end(),Cell{cellKey(x,z1),uint32_t(-1)});
+    for(auto i=b; i!=e; ++i) {
+      auto& pos = point[i->id];
+      float dx  = pos.x-p.x;
+      float dz  = pos.z-p.z;
+      if(dx*dx+dz*dz<=R*R)
+        out.push_back(i->id);
+      }
+    }
+  std::sort(out.begin(),out.end());
+  }
+
+int32_t PointGrid::cellCoord(float v) {
+  const float lim = float(1<<28);
+  float c = std::floor(v/CELL_SIZE);
+  return int32_t(std::max(-lim,std::min(c,lim)));
+  }
+
+uint64_t PointGrid::cellKey(int32_t x, int32_t z) {
+  // bias signed coordinates, so keys of one x-row are sorted by z
+  return (uint64_t(uint32_t(x)+0x80000000u)<<32) | uint64_t(uint32_t(z)+0x80000000u);
+  }
+
+uint64_t PointGrid::cellKey(const Tempest::Vec3& p) {
+  return cellKey(cellCoord(p.x),cellCoord(p.z));
+  }
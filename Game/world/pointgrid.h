@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Flat uniform grid over points on XZ plane; point is identified by its index in the array, given to build.
+// Every point is bucketed by its exact position: callers report each move, cell changes are re-bucketed in place.
+// Engine independent, to be testable without world.
+class PointGrid final {
+  public:
+    static constexpr float CELL_SIZE = 1000.f;
+
+    void     build(const std::vector<Tempest::Vec3>& pos);
+    void     move(uint32_t id, const Tempest::Vec3& pos);
+    size_t   size() const { return point.size(); }
+
+    // returns ids within R from p on XZ plane, in ascending order
+    void     find(const Tempest::Vec3& p, float R, std::vector<uint32_t>& out) const;
+
+  private:
+    struct Cell {
+      uint64_t key;
+      uint32_t id;
+      bool operator < (const Cell& other) const { return key<other.key || (key==other.key && id<other.id); }
+      };
+
+    std::vector<Cell>          grid;
+    std::vector<Tempest::Vec3> point;
+
+    static int32_t  cellCoord(float v);
+    static uint64_t cellKey(int32_t x, int32_t z);
+    static uint64_t cellKey(const Tempest::Vec3& p);
+  };
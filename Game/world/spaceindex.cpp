@@ -1,131 +1,163 @@
 #include "spaceindex.h"
 
+#include <cmath>
+
 #include "world/objects/vob.h"
 
 void BaseSpaceIndex::clear() {
   arr.clear();
-  index.clear();
-  dynamic.clear();
+  entry.clear();
+  slot.clear();
+  grid.clear();
+  dirty.clear();
+  rebuild = false;
   }
 
 void BaseSpaceIndex::invalidate() {
-  index.clear();
-  dynamic.clear();
+  rebuild = true;
+  }
+
+void BaseSpaceIndex::invalidate(const Vob* v) {
+  auto it = slot.find(v);
+  if(it==slot.end())
+    return;
+  auto& e = entry[it->second];
+  if(e.dirty)
+    return;
+  e.dirty = true;
+  dirty.push_back(v);
   }
 
 void BaseSpaceIndex::add(Vob* v) {
+  slot[v] = arr.size();
   arr.push_back(v);
-  index.reserve(arr.size());
-  index.clear();
-  dynamic.clear();
+  entry.emplace_back();
+  // position is not final yet, bin on next query
+  entry.back().dirty = true;
+  dirty.push_back(v);
   }
 
 void BaseSpaceIndex::del(Vob* v) {
-  for(size_t i=0;i<arr.size();++i) {
-    if(arr[i]==v) {
-      arr[i] = arr.back();
-      arr.pop_back();
-      index.clear();
-      dynamic.clear();
-      return;
-      }
+  auto it = slot.find(v);
+  if(it==slot.end())
+    return;
+  const size_t id = it->second;
+  slot.erase(it);
+  unbin(id);
+
+  if(id+1!=arr.size()) {
+    arr  [id] = arr.back();
+    entry[id] = entry.back();
+    slot[arr[id]] = id;
     }
+  arr.pop_back();
+  entry.pop_back();
   }
 
 bool BaseSpaceIndex::hasObject(const Vob* v) const {
   if(v==nullptr)
     return false;
-  for(size_t i=0;i<arr.size();++i)
-    if(arr[i]==v)
-      return true;
-  return false;
+  return slot.find(v)!=slot.end();
   }
 
 void BaseSpaceIndex::find(const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
-  if(index.size()==0)
-    buildIndex();
-  for(auto& i:dynamic)
-    (*func)(ctx,i);
-  implFind(index.data(),index.size(),0,p,R,ctx,func);
-  }
+  updateIndex();
 
-void BaseSpaceIndex::buildIndex() {
-  size_t cnt = 0;
-  index.resize(arr.size());
-  dynamic.clear();
-  for(size_t i=0; i<arr.size(); ++i) {
-    if(arr[i]->isDynamic()) {
-      dynamic.push_back(arr[i]);
-      } else {
-      index[cnt] = arr[i];
-      ++cnt;
-      }
+  const int32_t x0 = cellCoord(p.x-R), x1 = cellCoord(p.x+R);
+  const int32_t z0 = cellCoord(p.z-R), z1 = cellCoord(p.z+R);
+  const uint64_t area = uint64_t(int64_t(x1)-x0+1)*uint64_t(int64_t(z1)-z0+1);
+
+  if(area>grid.size()) {
+    // huge radius: cheaper to walk over non-empty cells
+    for(auto& i:grid)
+      findInCell(i.second,p,R,ctx,func);
+    return;
     }
-  index.resize(cnt);
-  buildIndex(index.data(),index.size(),0);
+
+  for(int32_t x=x0; x<=x1; ++x)
+    for(int32_t z=z0; z<=z1; ++z) {
+      auto it = grid.find(cellKey(x,z));
+      if(it!=grid.end())
+        findInCell(it->second,p,R,ctx,func);
+      }
   }
 
-void BaseSpaceIndex::buildIndex(Vob** v, size_t cnt, uint8_t depth) {
-  depth%=3;
-  sort(v,cnt,depth);
-  size_t mid = cnt/2;
-  if(mid>0) {
-    // [0..mid)
-    buildIndex(v,mid,uint8_t(depth+1u));
-    }
-  if(mid+1<cnt) {
-    // (mid..cnt)
-    buildIndex(v+mid+1,cnt-mid-1,uint8_t(depth+1u));
+void BaseSpaceIndex::findInCell(const std::vector<Vob*>& cell, const Tempest::Vec3& p, float R,
+                                const void* ctx, void (*func)(const void*, Vob*)) {
+  for(size_t i=0; i<cell.size(); ++i) {
+    auto v = cell[i];
+    if((v->position()-p).quadLength()<=R*R)
+      func(ctx,v);
     }
   }
 
-void BaseSpaceIndex::sort(Vob** v, size_t cnt, uint8_t component) {
-  bool (*predicate)(const Vob* a, const Vob* b) = nullptr;
-  switch(component) {
-    case 0:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().x < b->position().x; };
-      break;
-    case 1:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().y < b->position().y; };
-      break;
-    case 2:
-      predicate = [](const Vob* a, const Vob* b){ return a->position().z < b->position().z; };
-      break;
-    }
-  std::sort(v,v+cnt,predicate);
+int32_t BaseSpaceIndex::cellCoord(float v) {
+  const float lim = float(1<<28);
+  float c = std::floor(v/CELL_SIZE);
+  return int32_t(std::max(-lim,std::min(c,lim)));
   }
 
-void BaseSpaceIndex::implFind(Vob** v, size_t cnt, uint8_t depth,
-                              const Tempest::Vec3& p, float R, const void* ctx, void (*func)(const void*, Vob*)) {
-  if(cnt==0)
-    return;
+uint64_t BaseSpaceIndex::cellKey(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x))<<32) | uint64_t(uint32_t(z));
+  }
 
-  auto mid = cnt/2;
-  auto pos = v[mid]->position();
+uint64_t BaseSpaceIndex::cellKey(const Tempest::Vec3& p) {
+  return cellKey(cellCoord(p.x),cellCoord(p.z));
+  }
 
-  if((pos-p).quadLength()<=R*R) {
-    func(ctx,v[mid]);
+void BaseSpaceIndex::updateIndex() {
+  if(rebuild) {
+    grid.clear();
+    dirty.clear();
+    for(size_t i=0; i<arr.size(); ++i) {
+      entry[i].binned = false;
+      entry[i].dirty  = false;
+      bin(i);
+      }
+    rebuild = false;
+    return;
     }
 
-  depth%=3;
-  switch(depth) {
-    case 0:
-      if(p.x-R<=pos.x)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.x+R>=pos.x)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
-    case 1:
-      if(p.y-R<=pos.y)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.y+R>=pos.y)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
-    case 2:
-      if(p.z-R<=pos.z)
-        implFind(v,mid,uint8_t(depth+1u),p,R, ctx,func);
-      if(p.z+R>=pos.z)
-        implFind(v+mid+1,cnt-mid-1,uint8_t(depth+1u),p,R, ctx,func);
-      break;
+  for(auto v:dirty) {
+    auto it = slot.find(v);
+    if(it==slot.end())
+      continue; // removed since
+    const size_t id = it->second;
+    if(!entry[id].dirty)
+      continue;
+    entry[id].dirty = false;
+    const uint64_t key = cellKey(arr[id]->position());
+    if(entry[id].binned && entry[id].cell==key)
+      continue;
+    unbin(id);
+    bin(id);
     }
+  dirty.clear();
+  }
+
+void BaseSpaceIndex::bin(size_t id) {
+  auto& e = entry[id];
+  e.cell   = cellKey(arr[id]->position());
+  e.binned = true;
+  grid[e.cell].push_back(arr[id]);
+  }
+
+void BaseSpaceIndex::unbin(size_t id) {
+  auto& e = entry[id];
+  if(!e.binned)
+    return;
+  e.binned = false;
+
+  auto it = grid.find(e.cell);
+  if(it==grid.end())
+    return;
+  auto& cell = it->second;
+  for(size_t i=0; i<cell.size(); ++i)
+    if(cell[i]==arr[id]) {
+      cell[i] = cell.back();
+      cell.pop_back();
+      break;
+      }
+  if(cell.empty())
+    grid.erase(it);
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <unordered_map>
 #include <cstdint>
 #include <algorithm>
 #include <array>
@@ -16,6 +17,7 @@ class BaseSpaceIndex {
     void   clear();
     size_t size() const { return arr.size(); }
     void   invalidate();
+    void   invalidate(const Vob* v);
 
   protected:
     BaseSpaceIndex() = default;
@@ -30,14 +32,30 @@ class BaseSpaceIndex {
     Vob*const*         data() const { return arr.data(); }
 
   private:
-    std::vector<Vob*>  arr;
-    std::vector<Vob*>  index;
-    std::vector<Vob*>  dynamic;
-
-    void               buildIndex();
-    void               buildIndex(Vob** v, size_t cnt, uint8_t depth);
-    void               sort(Vob** v, size_t cnt, uint8_t component);
-    void               implFind(Vob** v, size_t cnt, uint8_t depth, const Tempest::Vec3& p, float R, const void* ctx, void(*func)(const void*, Vob*));
+    // loose grid over XZ plane; objects are binned by center position
+    static constexpr float CELL_SIZE = 1000.f;
+
+    struct Entry {
+      uint64_t cell   = 0;
+      bool     binned = false;
+      bool     dirty  = false;
+      };
+
+    std::vector<Vob*>                               arr;
+    std::vector<Entry>                              entry;
+    std::unordered_map<const Vob*,size_t>           slot;
+    std::unordered_map<uint64_t,std::vector<Vob*>>  grid;
+    std::vector<const Vob*>                         dirty;
+    bool                                            rebuild = false;
+
+    static int32_t     cellCoord(float v);
+    static uint64_t    cellKey(int32_t x, int32_t z);
+    static uint64_t    cellKey(const Tempest::Vec3& p);
+
+    void               updateIndex();
+    void               bin  (size_t id);
+    void               unbin(size_t id);
+    void               findInCell(const std::vector<Vob*>& cell, const Tempest::Vec3& p, float R, const void* ctx, void(*func)(const void*, Vob*));
   };
 
 template<class Func>
@@ -0,0 +1,243 @@
+#include "waygraph.h"
+
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <cmath>
+#include <limits>
+
+#include "waypoint.h"
+
+namespace {
+// per-thread search state, so wayTo doesn't have to touch WayPoint's
+struct SearchScratch {
+  struct Node {
+    int32_t  f;
+    int32_t  g;
+    uint32_t id;
+    };
+
+  std::vector<int32_t>  g;
+  std::vector<uint32_t> parent;
+  std::vector<uint32_t> stamp;
+  uint32_t              gen = 0;
+  std::vector<Node>     heap;
+
+  void reset(size_t size) {
+    if(stamp.size()!=size) {
+      g     .resize(size);
+      parent.resize(size);
+      stamp .assign(size,0);
+      gen = 0;
+      }
+    gen++;
+    if(gen==0) {
+      std::fill(stamp.begin(),stamp.end(),0);
+      gen = 1;
+      }
+    heap.clear();
+    }
+  };
+}
+
+static constexpr int32_t wayInfinity = std::numeric_limits<int32_t>::max();
+
+void WayGraph::build(const std::vector<WayPoint>& wp) {
+  points = wp.data();
+  count  = wp.size();
+  buildComponents();
+  buildLandmarks();
+
+  std::lock_guard<std::mutex> guard(cacheSync);
+  cacheLru.clear();
+  cacheMap.clear();
+  }
+
+bool WayGraph::isConnected(uint32_t a, uint32_t b) const {
+  return a<count && b<count && component[a]==component[b];
+  }
+
+bool WayGraph::route(uint32_t begin, uint32_t end, std::vector<uint32_t>& path) const {
+  const uint64_t key = (uint64_t(begin)<<32) | uint64_t(end);
+  path.clear();
+  {
+    std::lock_guard<std::mutex> guard(cacheSync);
+    auto it = cacheMap.find(key);
+    if(it!=cacheMap.end()) {
+      cacheLru.splice(cacheLru.begin(),cacheLru,it->second);
+      path = it->second->path;
+      return true;
+      }
+  }
+
+  if(!findPath(begin,end,path))
+    return false;
+
+  std::lock_guard<std::mutex> guard(cacheSync);
+  if(cacheMap.find(key)==cacheMap.end()) {
+    cacheLru.emplace_front();
+    cacheLru.front().key  = key;
+    cacheLru.front().path = path;
+    cacheMap[key] = cacheLru.begin();
+    if(cacheLru.size()>PATH_CACHE_SIZE) {
+      cacheMap.erase(cacheLru.back().key);
+      cacheLru.pop_back();
+      }
+    }
+  return true;
+  }
+
+uint32_t WayGraph::indexOf(const WayPoint* p) const {
+  return uint32_t(std::distance(points,p));
+  }
+
+void WayGraph::buildComponents() {
+  component.assign(count,uint32_t(-1));
+  std::vector<uint32_t> stk;
+  uint32_t              cId = 0;
+  for(size_t i=0; i<count; ++i) {
+    if(component[i]!=uint32_t(-1))
+      continue;
+    component[i] = cId;
+    stk.push_back(uint32_t(i));
+    while(stk.size()>0) {
+      auto id = stk.back();
+      stk.pop_back();
+      for(auto& c:points[id].connections()) {
+        auto cn = indexOf(c.point);
+        if(component[cn]!=uint32_t(-1))
+          continue;
+        component[cn] = cId;
+        stk.push_back(cn);
+        }
+      }
+    ++cId;
+    }
+  }
+
+void WayGraph::buildLandmarks() {
+  landmarkCount = std::min<size_t>(LANDMARK_COUNT,count);
+  landmarkDist.assign(count*landmarkCount,wayInfinity);
+  if(landmarkCount==0)
+    return;
+
+  // farthest point selection: spread landmarks over the map
+  std::vector<float> minDist(count,std::numeric_limits<float>::max());
+  std::vector<int32_t> dist;
+  uint32_t lm = 0;
+  for(size_t l=0; l<landmarkCount; ++l) {
+    if(l==0) {
+      float d = -1;
+      for(size_t i=0; i<count; ++i) {
+        float q = points[i].qDistTo(points[0].x,points[0].y,points[0].z);
+        if(q>d) {
+          d  = q;
+          lm = uint32_t(i);
+          }
+        }
+      }
+
+    dijkstra(lm,dist);
+    for(size_t i=0; i<count; ++i)
+      landmarkDist[i*landmarkCount+l] = dist[i];
+
+    auto& p = points[lm];
+    float d = -1;
+    for(size_t i=0; i<count; ++i) {
+      minDist[i] = std::min(minDist[i],points[i].qDistTo(p.x,p.y,p.z));
+      if(minDist[i]>d) {
+        d  = minDist[i];
+        lm = uint32_t(i);
+        }
+      }
+    }
+  }
+
+void WayGraph::dijkstra(uint32_t from, std::vector<int32_t>& dist) const {
+  using Node = std::pair<int32_t,uint32_t>;
+  std::priority_queue<Node,std::vector<Node>,std::greater<Node>> queue;
+
+  dist.assign(count,wayInfinity);
+  dist[from] = 0;
+  queue.emplace(0,from);
+  while(!queue.empty()) {
+    auto n = queue.top();
+    queue.pop();
+    if(n.first!=dist[n.second])
+      continue;
+    for(auto& c:points[n.second].connections()) {
+      auto    cn = indexOf(c.point);
+      int32_t l  = n.first+c.len;
+      if(l<dist[cn]) {
+        dist[cn] = l;
+        queue.emplace(l,cn);
+        }
+      }
+    }
+  }
+
+int32_t WayGraph::heuristic(uint32_t from, uint32_t to) const {
+  auto&   a = points[from];
+  auto&   b = points[to];
+  int32_t h = int32_t(std::sqrt(a.qDistTo(b.x,b.y,b.z)));
+
+  const int32_t* la = &landmarkDist[from*landmarkCount];
+  const int32_t* lb = &landmarkDist[to  *landmarkCount];
+  for(size_t i=0; i<landmarkCount; ++i) {
+    if(la[i]==wayInfinity || lb[i]==wayInfinity)
+      continue;
+    h = std::max(h,std::abs(la[i]-lb[i]));
+    }
+  return h;
+  }
+
+bool WayGraph::findPath(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const {
+  static thread_local SearchScratch s;
+  s.reset(count);
+
+  auto cmp = [](const SearchScratch::Node& a, const SearchScratch::Node& b){ return a.f>b.f; };
+
+  s.g     [begin] = 0;
+  s.parent[begin] = begin;
+  s.stamp [begin] = s.gen;
+  s.heap.push_back({heuristic(begin,end),0,begin});
+
+  bool found = false;
+  while(s.heap.size()>0) {
+    std::pop_heap(s.heap.begin(),s.heap.end(),cmp);
+    auto n = s.heap.back();
+    s.heap.pop_back();
+
+    const uint32_t id = n.id;
+    if(id==end) {
+      found = true;
+      break;
+      }
+    const int32_t g0 = s.g[id];
+    if(n.g>g0)
+      continue; // outdated entry
+
+    for(auto& c:points[id].connections()) {
+      auto    cn = indexOf(c.point);
+      int32_t g1 = g0+c.len;
+      if(s.stamp[cn]==s.gen && s.g[cn]<=g1)
+        continue;
+      s.stamp [cn] = s.gen;
+      s.g     [cn] = g1;
+      s.parent[cn] = id;
+      s.heap.push_back({g1+heuristic(cn,end),g1,cn});
+      std::push_heap(s.heap.begin(),s.heap.end(),cmp);
+      }
+    }
+
+  if(!found)
+    return false;
+
+  out.clear();
+  for(uint32_t i=end; ; i=s.parent[i]) {
+    out.push_back(i);
+    if(i==begin)
+      break;
+    }
+  return true;
+  }
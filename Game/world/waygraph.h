@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+
+class WayPoint;
+
+// Shortest routes over connected waypoints: A* with heuristic, that is max of straight-line distance and
+// landmark (ALT) bounds, plus LRU cache of recent routes. Search state is per thread, so queries are thread-safe.
+class WayGraph final {
+  public:
+    // waypoints must be connected already; graph refers to them until next build
+    void build(const std::vector<WayPoint>& wp);
+    bool isConnected(uint32_t a, uint32_t b) const;
+    // route is stored end-to-begin, same as WayPath expects
+    bool route(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const;
+
+  private:
+    enum {
+      LANDMARK_COUNT  = 8,
+      PATH_CACHE_SIZE = 4096, // enough for routine changes of all npc's in a world
+      };
+
+    struct CachedPath {
+      uint64_t              key=0;
+      std::vector<uint32_t> path;
+      };
+
+    const WayPoint*                       points = nullptr;
+    size_t                                count  = 0;
+    std::vector<uint32_t>                 component;
+    std::vector<int32_t>                  landmarkDist;
+    size_t                                landmarkCount=0;
+
+    mutable std::mutex                    cacheSync;
+    mutable std::list<CachedPath>         cacheLru;
+    mutable std::unordered_map<uint64_t,std::list<CachedPath>::iterator> cacheMap;
+
+    uint32_t               indexOf(const WayPoint* p) const;
+    void                   buildComponents();
+    void                   buildLandmarks();
+    void                   dijkstra(uint32_t from, std::vector<int32_t>& dist) const;
+    int32_t                heuristic(uint32_t from, uint32_t to) const;
+    bool                   findPath(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) const;
+  };
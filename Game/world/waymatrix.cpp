@@ -2,6 +2,7 @@
 
 #include <Tempest/Log>
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "game/movealgo.h"
@@ -27,9 +28,6 @@ WayMatrix::WayMatrix(World &world, const ZenLoad::zCWayNetData &dat)
   for(auto& i:wayPoints)
     if(i.name.find("START")!=std::string::npos)
       startPoints.push_back(i);
-
-  stk[0].reserve(256);
-  stk[1].reserve(256);
   }
 
 void WayMatrix::buildIndex() {
@@ -37,16 +35,11 @@ void WayMatrix::buildIndex() {
   adjustWaypoints(wayPoints);
   adjustWaypoints(freePoints);
   adjustWaypoints(startPoints);
+
   std::sort(indexPoints.begin(),indexPoints.end(),[](const WayPoint* a,const WayPoint* b){
     return a->name<b->name;
     });
 
-  for(auto& i:freePoints)
-    fpInd.push_back(&i);
-  std::sort(fpInd.begin(),fpInd.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
-
   for(auto& i:edges){
     if(i.first<wayPoints.size() && i.second<wayPoints.size()){
       auto& a = wayPoints[i.first ];
@@ -56,22 +49,44 @@ void WayMatrix::buildIndex() {
       b.connect(a);
       }
     }
+
+  graph.build(wayPoints);
+  buildNameIndex();
+
+  std::vector<const WayPoint*> pt;
+  for(auto& i:wayPoints)
+    pt.push_back(&i);
+  wayGrid.build(pt);
+  allGrid.build(std::vector<const WayPoint*>(indexPoints.begin(),indexPoints.end()));
+  fpIndex.clear();
   }
 
-const WayPoint *WayMatrix::findWayPoint(const Vec3& at, const std::function<bool(const WayPoint&)>& filter) const {
-  const WayPoint* ret =nullptr;
-  float           dist=std::numeric_limits<float>::max();
-  for(auto& w:wayPoints) {
-    if(!filter(w))
-      continue;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-    if(l<dist){
-      ret  = &w;
-      dist = l;
+void WayMatrix::buildNameIndex() {
+  nameTokens.clear();
+  fpTokens.clear();
+
+  auto tokens = [](const std::string& name, const std::function<void(std::string&&)>& f) {
+    // same tokenization as WayPoint::checkName
+    size_t i0 = 0;
+    for(size_t i=0; i<=name.size(); ++i) {
+      if(i==name.size() || name[i]=='_') {
+        f(name.substr(i0,i-i0));
+        i0 = i+1;
+        }
       }
-    }
-  return ret;
+    };
+  for(auto i:indexPoints)
+    tokens(i->name,[this,i](std::string&& t){ nameTokens.emplace(std::move(t),i); });
+  for(auto& i:freePoints)
+    tokens(i.name,[this,&i](std::string&& t){
+      auto& v = fpTokens[std::move(t)];
+      if(v.empty() || v.back()!=&i)
+        v.push_back(&i);
+      });
+  }
+
+const WayPoint *WayMatrix::findWayPoint(const Vec3& at, const std::function<bool(const WayPoint&)>& filter) const {
+  return wayGrid.nearest(at,std::numeric_limits<float>::max(),filter);
   }
 
 const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const char *name, const std::function<bool(const WayPoint&)>& filter) const {
@@ -80,21 +95,11 @@ const WayPoint *WayMatrix::findFreePoint(const Vec3& at, const char *name, const
   }
 
 const WayPoint *WayMatrix::findNextPoint(const Vec3& at) const {
-  const WayPoint* ret   = nullptr;
-  float           dist  = 20.f*100.f; // see scripting doc
-
-  dist*=dist;
-  for(auto pw:indexPoints){
-    auto& w  = *pw;
-    auto  dp = w.position()-at;
-    float l  = dp.quadLength();
-
-    if(l<dist && dp.z*dp.z<300*300 && !w.isLocked()){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+  const float dist = 20.f*100.f; // see scripting doc
+  return allGrid.nearest(at,dist,[&at](const WayPoint& w){
+    auto dp = w.position()-at;
+    return dp.z*dp.z<300*300 && !w.isLocked();
+    });
   }
 
 void WayMatrix::addFreePoint(const Vec3& pos, const Vec3& dir, const char *name) {
@@ -133,9 +138,9 @@ const WayPoint* WayMatrix::findPoint(const char *name, bool inexact) const {
     return *it;
   if(!inexact)
     return nullptr;
-  for(auto i:indexPoints)
-    if(i->checkName(name))
-      return i;
+  auto tk = nameTokens.find(name);
+  if(tk!=nameTokens.end())
+    return tk->second;
   return nullptr;
   }
 
@@ -162,9 +167,15 @@ void WayMatrix::marchPoints(DbgPainter &p) const {
   }
 
 void WayMatrix::adjustWaypoints(std::vector<WayPoint> &wp) {
-  for(auto& w:wp) {
-    w.y = world.physic()->landRay(w.x,w.y,w.z).v.y;
-    indexPoints.push_back(&w);
+  std::vector<Tempest::Vec3>                 at(wp.size());
+  std::vector<DynamicWorld::RayLandResult>   ret;
+  for(size_t i=0; i<wp.size(); ++i)
+    at[i] = Tempest::Vec3(wp[i].x,wp[i].y,wp[i].z);
+  world.physic()->landRayBatch(at,ret);
+
+  for(size_t i=0; i<wp.size(); ++i) {
+    wp[i].y = ret[i].v.y;
+    indexPoints.push_back(&wp[i]);
     }
   }
 
@@ -178,15 +189,10 @@ const WayMatrix::FpIndex &WayMatrix::findFpIndex(const char *name) const {
 
   FpIndex id;
   id.key = name;
-  for(auto& w:freePoints){
-    if(!w.checkName(name))
-      continue;
-    id.index.push_back(&w);
-    }
-  // TODO: good index, not sort by 'x' :)
-  std::sort(id.index.begin(),id.index.end(),[](const WayPoint* a,const WayPoint* b){
-    return a->x<b->x;
-    });
+  auto tk = fpTokens.find(name);
+  if(tk!=fpTokens.end())
+    id.index.build(tk->second); else
+    id.index.build({});
 
   it = fpIndex.insert(it,std::move(id));
   return *it;
@@ -196,34 +202,14 @@ const WayPoint *WayMatrix::findFreePoint(float x, float y, float z, const FpInde
                                          const std::function<bool(const WayPoint&)>& filter) const {
   // float R = 20.f*100.f; // see scripting doc
   float R = 5.f*100.f; // scripting doc says 20m, but number seems to be incorrect
-  auto b = std::lower_bound(ind.index.begin(),ind.index.end(), x-R ,[](const WayPoint *a, float b){
-    return a->x<b;
-    });
-  auto e = std::upper_bound(ind.index.begin(),ind.index.end(), x+R ,[](float a,const WayPoint *b){
-    return a<b->x;
-    });
-
-  const WayPoint *ret=nullptr;
-  auto  count = std::distance(b,e);(void) count;
-  float dist  = R*R;
-  for(auto i=b;i!=e;++i){
-    auto& w  = **i;
-    if(!filter(w))
-      continue;
-    float dx = w.x-x;
-    float dy = w.y-y;
+  return ind.index.nearest(Vec3(x,y,z),R,[z,&filter](const WayPoint& w){
     float dz = w.z-z;
-    float l=dx*dx+dy*dy+dz*dz;
-    if(l<dist && dz*dz<300*300){
-      ret  = &w;
-      dist = l;
-      }
-    }
-  return ret;
+    return dz*dz<300*300 && filter(w);
+    });
   }
 
 WayPath WayMatrix::wayTo(const WayPoint& begin, const WayPoint& end) const {
-  intptr_t endId = std::distance<const WayPoint*>(&wayPoints[0],&end);
+  intptr_t endId = std::distance<const WayPoint*>(wayPoints.data(),&end);
   if(endId<0 || size_t(endId)>=wayPoints.size()){
     if(end.name.find("FP_")==0) {
       WayPath ret;
@@ -233,57 +219,25 @@ WayPath WayMatrix::wayTo(const WayPoint& begin, const WayPoint& end) const {
     return WayPath();
     }
 
-  pathGen++;
-  if(pathGen==1){
-    // new cycle
-    for(auto& i:wayPoints)
-      i.pathGen=0;
-    }
-  begin.pathLen = 0;
-  begin.pathGen = pathGen;
-
-  std::vector<const WayPoint*> *front=&stk[0], *back=&stk[1];
-  stk[0].clear();
-  stk[1].clear();
-
-  front->push_back(&begin);
-
-  while(end.pathGen!=pathGen && front->size()>0){
-    for(auto& wp:*front){
-      int32_t l0 = wp->pathLen;
-
-      for(auto i:wp->connections()){
-        auto& w  = *i.point;
-        int32_t l1 = l0+i.len;
-        if(w.pathGen!=pathGen || w.pathLen>l1){
-          w.pathLen = l1;
-          w.pathGen = pathGen;
-          back->push_back(&w);
-          }
-        }
-      }
-    std::swap(front,back);
-    back->clear();
+  if(&begin==&end) {
+    WayPath ret;
+    ret.add(end);
+    return ret;
     }
 
-  WayPath ret;
-  ret.add(end);
-  const WayPoint* current = &end;
-  while(current!=&begin) {
-    int32_t l0 = current->pathLen, l1=l0;
-
-    const WayPoint* next=nullptr;
-    for(auto i:current->connections()){
-      if(i.point->pathGen==pathGen && i.point->pathLen+i.len<=l0 && i.point->pathLen<l1){
-        next = i.point;
-        l1   = i.point->pathLen;
-        }
-      }
-    if(next==nullptr)
-      return WayPath();
-    ret.add(*next);
-    current=next;
-    }
+  intptr_t beginId = std::distance<const WayPoint*>(wayPoints.data(),&begin);
+  if(beginId<0 || size_t(beginId)>=wayPoints.size())
+    return WayPath();
+  if(!graph.isConnected(uint32_t(beginId),uint32_t(endId)))
+    return WayPath();
 
+  std::vector<uint32_t> path;
+  if(!graph.route(uint32_t(beginId),uint32_t(endId),path))
+    return WayPath();
+
+  // path is stored end-to-begin, same as WayPath expects
+  WayPath ret;
+  for(auto i:path)
+    ret.add(wayPoints[i]);
   return ret;
   }
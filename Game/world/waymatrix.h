@@ -5,8 +5,11 @@
 
 #include <zenload/zTypes.h>
 #include <vector>
+#include <unordered_map>
 #include <functional>
 
+#include "waygraph.h"
+#include "waypointgrid.h"
 #include "waypath.h"
 #include "waypoint.h"
 
@@ -41,20 +44,23 @@ class WayMatrix final {
     std::vector<WayPoint>  freePoints, startPoints;
     std::vector<WayPoint*> indexPoints;
 
-    std::vector<WayPoint*> fpInd;
+    WayPointGrid           wayGrid, allGrid;
+    // name token -> first matching point, for inexact search by name
+    std::unordered_map<std::string,const WayPoint*>              nameTokens;
+    std::unordered_map<std::string,std::vector<const WayPoint*>> fpTokens;
 
     struct FpIndex {
       std::string                  key;
-      std::vector<const WayPoint*> index;
+      WayPointGrid                 index;
       };
     mutable std::vector<FpIndex>          fpIndex;
 
-    mutable uint16_t                      pathGen=0;
-    mutable std::vector<const WayPoint*>  stk[2];
+    WayGraph                              graph;
 
     void                   adjustWaypoints(std::vector<WayPoint> &wp);
 
     const FpIndex&         findFpIndex(const char* name) const;
+    void                   buildNameIndex();
     const WayPoint*        findFreePoint(float x, float y, float z, const FpIndex &ind,
                                          const std::function<bool(const WayPoint&)>& filter) const;
   };
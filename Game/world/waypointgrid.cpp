@@ -0,0 +1,113 @@
+#include "waypointgrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "waypoint.h"
+
+using namespace Tempest;
+
+void WayPointGrid::build(const std::vector<const WayPoint*>& pt) {
+  cells.resize(pt.size());
+  minX = minZ = std::numeric_limits<int32_t>::max();
+  maxX = maxZ = std::numeric_limits<int32_t>::min();
+  for(size_t i=0; i<pt.size(); ++i) {
+    int32_t x = cellCoord(pt[i]->x);
+    int32_t z = cellCoord(pt[i]->z);
+    minX = std::min(minX,x);
+    maxX = std::max(maxX,x);
+    minZ = std::min(minZ,z);
+    maxZ = std::max(maxZ,z);
+    cells[i] = Cell(cellKey(x,z),pt[i]);
+    }
+  std::stable_sort(cells.begin(),cells.end(),[](const Cell& a, const Cell& b){
+    return a.first<b.first;
+    });
+  }
+
+int32_t WayPointGrid::cellCoord(float v) {
+  const float lim = float(1<<28);
+  float c = std::floor(v/CELL_SIZE);
+  return int32_t(std::max(-lim,std::min(c,lim)));
+  }
+
+uint64_t WayPointGrid::cellKey(int32_t x, int32_t z) {
+  return (uint64_t(uint32_t(x)+0x80000000u)<<32) | uint64_t(uint32_t(z)+0x80000000u);
+  }
+
+void WayPointGrid::collect(int32_t x, int32_t z0, int32_t z1, std::vector<const WayPoint*>& out) const {
+  if(x<minX || x>maxX)
+    return;
+  z0 = std::max(z0,minZ);
+  z1 = std::min(z1,maxZ);
+  if(z0>z1)
+    return;
+  auto b = std::lower_bound(cells.begin(),cells.end(),cellKey(x,z0),[](const Cell& c, uint64_t k){ return c.first<k; });
+  auto e = std::upper_bound(b,cells.end(),cellKey(x,z1),[](uint64_t k, const Cell& c){ return k<c.first; });
+  for(auto i=b; i!=e; ++i)
+    out.push_back(i->second);
+  }
+
+const WayPoint* WayPointGrid::nearest(const Vec3& at, float maxDist,
+                                      const std::function<bool(const WayPoint&)>& filter) const {
+  if(cells.empty())
+    return nullptr;
+
+  // walk rings of cells around 'at'; filter (often a raycast) is called in order of distance,
+  // only for points that are guaranteed to be closer than anything in not yet visited rings
+  const bool    inf = !(maxDist<std::numeric_limits<float>::max());
+  const int32_t cx  = cellCoord(at.x), cz = cellCoord(at.z);
+  // cells, that may contain points within maxDist
+  const int32_t x0  = inf ? minX : std::max(minX,cellCoord(at.x-maxDist));
+  const int32_t x1  = inf ? maxX : std::min(maxX,cellCoord(at.x+maxDist));
+  const int32_t z0  = inf ? minZ : std::max(minZ,cellCoord(at.z-maxDist));
+  const int32_t z1  = inf ? maxZ : std::min(maxZ,cellCoord(at.z+maxDist));
+  if(x0>x1 || z0>z1)
+    return nullptr;
+  const int32_t maxRing  = std::max(std::max(cx-x0,x1-cx),std::max(cz-z0,z1-cz));
+  const float   maxQDist = inf ? maxDist : maxDist*maxDist;
+
+  // called per npc many times in a tick: keep allocations per thread
+  static thread_local std::vector<const WayPoint*>                 ring;
+  static thread_local std::vector<std::pair<float,const WayPoint*>> pending;
+  pending.clear();
+  for(int32_t r=0; r<=maxRing; ++r) {
+    ring.clear();
+    if(r==0) {
+      collect(cx,cz,cz,ring);
+      } else {
+      const int32_t rz0 = std::max(cz-r,z0), rz1 = std::min(cz+r,z1);
+      if(cx-r>=x0)
+        collect(cx-r,rz0,rz1,ring);
+      if(cx+r<=x1)
+        collect(cx+r,rz0,rz1,ring);
+      for(int32_t x=std::max(cx-r+1,x0); x<=std::min(cx+r-1,x1); ++x) {
+        if(cz-r>=z0)
+          collect(x,cz-r,cz-r,ring);
+        if(cz+r<=z1)
+          collect(x,cz+r,cz+r,ring);
+        }
+      }
+    for(auto w:ring) {
+      float l = (w->position()-at).quadLength();
+      if(l<maxQDist)
+        pending.emplace_back(l,w);
+      }
+
+    const bool  last  = (r>=maxRing);
+    const float bound = float(r)*CELL_SIZE;
+    std::sort(pending.begin(),pending.end(),[](const std::pair<float,const WayPoint*>& a, const std::pair<float,const WayPoint*>& b){
+      return a.first<b.first;
+      });
+    size_t i=0;
+    for(; i<pending.size(); ++i) {
+      if(!last && pending[i].first>=bound*bound)
+        break;
+      if(filter(*pending[i].second))
+        return pending[i].second;
+      }
+    pending.erase(pending.begin(),pending.begin()+int(i));
+    }
+  return nullptr;
+  }
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+class WayPoint;
+
+// Static uniform grid over XZ plane for nearest waypoint queries; cells are stored as sorted (cell,point) pairs.
+// Engine independent, to be testable without world.
+class WayPointGrid final {
+  public:
+    static constexpr float CELL_SIZE = 500.f;
+
+    void            build(const std::vector<const WayPoint*>& pt);
+    // nearest point within maxDist, that passes filter; filter is called in order of distance
+    const WayPoint* nearest(const Tempest::Vec3& at, float maxDist, const std::function<bool(const WayPoint&)>& filter) const;
+
+  private:
+    using Cell = std::pair<uint64_t,const WayPoint*>;
+
+    std::vector<Cell> cells;
+    int32_t           minX=0, maxX=-1, minZ=0, maxZ=-1;
+
+    static int32_t  cellCoord(float v);
+    static uint64_t cellKey(int32_t x, int32_t z);
+    void            collect(int32_t x, int32_t z0, int32_t z1, std::vector<const WayPoint*>& out) const;
+  };
@@ -4,7 +4,9 @@
 #include <fstream>
 #include <functional>
 #include <cctype>
+#include <unordered_set>
 
+#include <Tempest/Application>
 #include <Tempest/Log>
 #include <Tempest/Painter>
 
@@ -17,85 +19,175 @@
 #include "world/objects/interactive.h"
 #include "game/globaleffects.h"
 #include "game/serialize.h"
+#include "physics/physiccache.h"
+#include "world/worldcache.h"
+#include "utils/fileext.h"
+#include "utils/workers.h"
 #include "gothic.h"
 #include "focus.h"
 #include "resources.h"
 
-World::World(Gothic& gothic, GameSession& game, const RendererStorage &storage, std::string file, std::function<void(int)> loadProgress)
-  :wname(std::move(file)),game(game),wsound(gothic,game,*this),wobj(*this) {
-  using namespace Daedalus::GameState;
-
-  ZenLoad::ZenParser parser(wname,Resources::vdfsIndex());
-
-  loadProgress(1);
-  parser.readHeader();
-
-  loadProgress(10);
-  ZenLoad::oCWorldData world;
-
-  auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
-  if(gothic.version().game==2)
-    fver = ZenLoad::ZenParser::FileVersion::Gothic2;
-  parser.readWorld(world,fver);
-
-  ZenLoad::zCMesh* worldMesh = parser.getWorldMesh();
-  PackedMesh vmesh(*worldMesh,PackedMesh::PK_VisualLnd);
-
-  loadProgress(50);
-  wdynamic.reset(new DynamicWorld(*this,*worldMesh));
-  wview.reset   (new WorldView(*this,vmesh,storage));
-  loadProgress(70);
+namespace {
+// visuals, referenced by vob tree and landscape: decoded by worker threads, while world is being set up
+struct Prefetch final {
+  std::unordered_set<std::string>                    names;
+  std::vector<Resources::Async<Tempest::Texture2d>>  tex;
+  std::vector<Resources::Async<ProtoMesh>>           mesh;
+  std::vector<Resources::Async<Skeleton>>            skel;
+
+  void texture(const std::string& name) {
+    if(!name.empty() && names.insert(name).second)
+      tex.push_back(Resources::loadTextureAsync(name));
+    }
 
-  globFx.reset(new GlobalEffects(*this));
+  void visual(const ZenLoad::zCVobData& vob) {
+    const std::string& v = vob.visual;
+    if(v.empty() || FileExt::hasExt(v,"ZEN") || FileExt::hasExt(v,"PFX")) {
+      // nothing to prefetch
+      }
+    else if(FileExt::hasExt(v,"TGA")) {
+      if(vob.visualCamAlign==0)
+        texture(v);
+      }
+    else if(names.insert(v).second) {
+      mesh.push_back(Resources::loadMeshAsync(v));
+      skel.push_back(Resources::loadSkeletonAsync(v));
+      }
+    for(auto& i:vob.childVobs)
+      visual(i);
+    }
 
-  wmatrix.reset(new WayMatrix(*this,world.waynet));
-  if(1){
-    for(auto& vob:world.rootVobs)
-      wobj.addRoot(std::move(vob),true);
+  // progress is reported in range [from,to], as handles are completed
+  void wait(int from, int to, const std::function<void(int)>& loadProgress) {
+    const size_t total = tex.size()+mesh.size()+skel.size();
+    size_t       done  = 0;
+    int          prev  = -1;
+    auto step = [&]() {
+      ++done;
+      const int p = from + int(size_t(to-from)*done/total);
+      if(p!=prev)
+        loadProgress(p);
+      prev = p;
+      };
+    for(auto& i:tex) {
+      i.get();
+      step();
+      }
+    for(auto& i:mesh) {
+      i.get();
+      step();
+      }
+    for(auto& i:skel) {
+      i.get();
+      step();
+      }
+    tex.clear();
+    mesh.clear();
+    skel.clear();
     }
-  wmatrix->buildIndex();
-  bsp = std::move(world.bspTree);
-  bspSectors.resize(bsp.sectors.size());
-  loadProgress(100);
+  };
+}
+
+World::World(Gothic& gothic, GameSession& game, const RendererStorage &storage, std::string file, std::function<void(int)> loadProgress)
+  :wname(std::move(file)),game(game),wsound(gothic,game,*this),wobj(*this) {
+  implLoad(gothic,storage,loadProgress,true);
   }
 
 World::World(Gothic& gothic, GameSession &game, const RendererStorage &storage,
              Serialize &fin, std::function<void(int)> loadProgress)
   :wname(fin.read<std::string>()),game(game),wsound(gothic,game,*this),wobj(*this) {
-  using namespace Daedalus::GameState;
+  implLoad(gothic,storage,loadProgress,false);
+  }
 
-  ZenLoad::ZenParser parser(wname,Resources::vdfsIndex());
+void World::implLoad(Gothic& gothic, const RendererStorage& storage, const std::function<void(int)>& loadProgress, bool startup) {
+  const uint64_t t0 = Tempest::Application::tickCount();
+  const auto     r0 = gothic.doAniCompression() ? Resources::stats() : Resources::Stats();
+  wobj.setupAiLod(gothic);
+  wobj.setupAnimLod(gothic);
+  // previous world is gone at this point: whatever it alone used becomes evictable
+  Resources::beginEpoch();
 
-  loadProgress(1);
-  parser.readHeader();
+  // cached world data replaces ZenParser completely, if physics is cached as well
+  WorldCache  wcache(wname);
+  PhysicCache pcache(wname,wcache.meshVertices(),wcache.meshIndices());
+  const bool  cached = wcache.isLoaded() && pcache.isLoaded();
 
+  std::unique_ptr<ZenLoad::ZenParser> parser;
+  ZenLoad::zCMesh*                    worldMesh = nullptr;
+  ZenLoad::oCWorldData                world;
+  loadProgress(1);
+  if(cached) {
+    world = std::move(wcache.world);
+    } else {
+    parser.reset(new ZenLoad::ZenParser(wname,Resources::vdfsIndex()));
+    parser->readHeader();
+
+    loadProgress(5);
+    auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
+    if(gothic.version().game==2)
+      fver = ZenLoad::ZenParser::FileVersion::Gothic2;
+    parser->readWorld(world,fver);
+    worldMesh = parser->getWorldMesh();
+    if(!pcache.isLoaded())
+      pcache = PhysicCache(wname,*worldMesh);
+    }
   loadProgress(10);
-  ZenLoad::oCWorldData world;
-
-  auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
-  if(gothic.version().game==2)
-    fver = ZenLoad::ZenParser::FileVersion::Gothic2;
-  parser.readWorld(world,fver);
+  const uint64_t t1 = Tempest::Application::tickCount();
+
+  // physics packs and indexes same mesh on its own: run it aside of visual part
+  Workers::TaskGroup physicTask;
+  physicTask.run([this,&pcache,worldMesh]() {
+    if(!pcache.isLoaded())
+      pcache.pack(*worldMesh);
+    wdynamic.reset(new DynamicWorld(*this,pcache));
+    });
 
-  ZenLoad::zCMesh* worldMesh = parser.getWorldMesh();
-  PackedMesh vmesh(*worldMesh,PackedMesh::PK_VisualLnd);
+  Prefetch prefetch;
+  for(auto& vob:world.rootVobs)
+    prefetch.visual(vob);
+  if(!wcache.isLoaded()) {
+    // vobs are moved out of world data below: cache is written right away
+    wcache.pack(*worldMesh);
+    wcache.save(world);
+    }
+  const PackedMesh& vmesh = wcache.land;
+  for(auto& i:vmesh.subMeshes)
+    prefetch.texture(i.material.texture);
+  const size_t prefetchCnt = prefetch.names.size();
+  prefetch.wait(10,80,loadProgress);
+  const uint64_t t2 = Tempest::Application::tickCount();
 
-  loadProgress(50);
-  wdynamic.reset(new DynamicWorld(*this,*worldMesh));
-  wview.reset   (new WorldView(*this,vmesh,storage));
-  loadProgress(70);
+  bsp = std::move(world.bspTree);
+  bspSectors.resize(bsp.sectors.size());
+  wview.reset(new WorldView(*this,vmesh,storage));
+  physicTask.wait();
+  loadProgress(85);
+  const uint64_t t3 = Tempest::Application::tickCount();
 
   globFx.reset(new GlobalEffects(*this));
 
   wmatrix.reset(new WayMatrix(*this,world.waynet));
   if(1){
     for(auto& vob:world.rootVobs)
-      wobj.addRoot(std::move(vob),false);
+      wobj.addRoot(std::move(vob),startup);
     }
+  loadProgress(95);
+  const uint64_t t4 = Tempest::Application::tickCount();
+  const auto     g0 = wdynamic->groundCacheTotal();
   wmatrix->buildIndex();
-  bsp = std::move(world.bspTree);
-  bspSectors.resize(bsp.sectors.size());
-
+  const auto     g1 = wdynamic->groundCacheTotal();
+  const uint64_t t5 = Tempest::Application::tickCount();
+
+  // the only load-time report: total and per stage, measured on real world data
+  Tempest::Log::i("world \"",wname,"\" loaded in ",t5-t0," ms: zen = ",t1-t0," ms, visuals = ",t2-t1," ms (",prefetchCnt," assets",
+                  wcache.isLoaded() ? ", cached landscape" : "","), view+physics = ",t3-t2," ms, vobs = ",t4-t3," ms",
+                  ", waynet = ",t5-t4," ms (ground probes = ",(g1.us-g0.us)/1000," ms, hit = ",g1.hit-g0.hit,
+                  ", fallback = ",g1.fallback-g0.fallback,")");
+  if(gothic.doAniCompression()) {
+    const auto r1 = Resources::stats();
+    Tempest::Log::i("animation samples of \"",wname,"\": ",(r1.aniSamplesRaw-r0.aniSamplesRaw)/1024,"kb -> ",
+                    (r1.aniSamplesPacked-r0.aniSamplesPacked)/1024,"kb");
+    }
   loadProgress(100);
   }
 
@@ -757,6 +849,15 @@ bool World::isInPfxRange(const Tempest::Vec3& p) const {
   return wview->isInPfxRange(p);
   }
 
+Tempest::Vec3 World::cameraPosition() const {
+  // camera of previous frame; player is the best guess, until first frame is rendered
+  if(wview->hasCamera())
+    return wview->cameraPosition();
+  if(npcPlayer!=nullptr)
+    return npcPlayer->position();
+  return Tempest::Vec3();
+  }
+
 void World::addDlgSound(const char* s, const Tempest::Vec3& pos, float range, uint64_t& timeLen) {
   auto sfx = wsound.addDlgSound(s,pos.x,pos.y,pos.z,range,timeLen);
   sfx.play();
@@ -791,8 +892,12 @@ void World::addSound(const ZenLoad::zCVobData& vob) {
     }
   }
 
-void World::invalidateVobIndex() {
-  wobj.invalidateVobIndex();
+void World::invalidateVobIndex(const Vob& v) {
+  wobj.invalidateVobIndex(v);
+  }
+
+void World::updateNpcIndex(const Npc& npc, const Tempest::Vec3& pos) {
+  wobj.updateNpcIndex(npc,pos);
   }
 
 void World::triggerOnStart(bool firstTime) {
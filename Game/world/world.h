@@ -79,6 +79,7 @@ class World final {
     WayPath              wayTo(const Npc& pos,const WayPoint& end) const;
 
     WorldView*           view()     const { return wview.get();    }
+    auto                 bspTree()  const -> const ZenLoad::zCBspTreeData& { return bsp; }
     WorldSound*          sound()          { return &wsound;         }
     DynamicWorld*        physic()   const { return wdynamic.get(); }
     GlobalEffects*       globalFx() const { return globFx.get();   }
@@ -117,6 +118,10 @@ class World final {
     void                 scaleTime(uint64_t& dt);
     void                 tick(uint64_t dt);
     uint64_t             tickCount() const;
+    auto                 aiLodStats() const -> const WorldObjects::AiLodStats& { return wobj.aiLodStats(); }
+    auto                 animLodStats() const -> const WorldObjects::AnimLodStats& { return wobj.animLodStats(); }
+    auto                 animLod() const -> const WorldObjects::AnimLod& { return wobj.animLod(); }
+    Tempest::Vec3        cameraPosition() const;
     void                 setDayTime(int32_t h,int32_t min);
     gtime                time() const;
 
@@ -175,7 +180,8 @@ class World final {
     void                 addFreePoint  (const Tempest::Vec3& pos, const Tempest::Vec3& dir, const char* name);
     void                 addSound      (const ZenLoad::zCVobData& vob);
 
-    void                 invalidateVobIndex();
+    void                 invalidateVobIndex(const Vob& v);
+    void                 updateNpcIndex(const Npc& npc, const Tempest::Vec3& pos);
 
   private:
     std::string                           wname;
@@ -197,5 +203,6 @@ class World final {
     auto         roomAt(const ZenLoad::zCBspNode &node) -> const std::string &;
     auto         portalAt(const std::string& tag) -> BspSector*;
 
+    void         implLoad(Gothic& gothic, const RendererStorage& storage, const std::function<void(int)>& loadProgress, bool startup);
     void         initScripts(bool firstTime);
   };
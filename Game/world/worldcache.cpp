@@ -0,0 +1,133 @@
+#include "worldcache.h"
+
+#include <Tempest/Application>
+#include <Tempest/File>
+#include <Tempest/Log>
+
+#include <zenload/zenParser.h>
+
+#include <cstring>
+
+#include "physics/dynamicworld.h"
+#include "physics/physiccache.h"
+#include "utils/fileext.h"
+#include "utils/fileutil.h"
+#include "worldcacheio.h"
+#include "gothic.h"
+#include "resources.h"
+
+using namespace Tempest;
+
+struct WorldCache::Header {
+  char     tag[4]   = {'W','R','L','C'};
+  uint32_t version  = 3;
+  uint32_t vertex   = sizeof(PackedMesh::WorldVertex);
+  uint32_t reserved = 0; // explicit padding: header is compared with memcmp
+  uint64_t archives = 0;
+  };
+
+WorldCache::WorldCache(const std::string& name)
+  :path(FileUtil::cachePath(FileExt::cacheName("world_",name))) {
+  loaded = load();
+  if(!loaded) {
+    land       = PackedMesh();
+    world      = ZenLoad::oCWorldData();
+    vertCount  = 0;
+    indexCount = 0;
+    }
+  }
+
+WorldCache::Header WorldCache::header() const {
+  Header h;
+  h.archives = Resources::archivesStamp();
+  return h;
+  }
+
+void WorldCache::pack(const ZenLoad::zCMesh& mesh) {
+  vertCount  = uint32_t(mesh.getVertices().size());
+  indexCount = uint32_t(mesh.getIndices().size());
+  land       = PackedMesh(mesh,PackedMesh::PK_VisualLnd);
+  }
+
+bool WorldCache::load() {
+  if(path.empty())
+    return false;
+  try {
+    RFile  f(path.c_str());
+    Header hdr, expect = header();
+    if(f.read(&hdr,sizeof(hdr))!=sizeof(hdr) || std::memcmp(&hdr,&expect,sizeof(hdr))!=0)
+      return false;
+
+    if(f.read(&vertCount, sizeof(vertCount)) !=sizeof(vertCount) ||
+       f.read(&indexCount,sizeof(indexCount))!=sizeof(indexCount))
+      return false;
+    return WorldCacheIo::read(f,land) && WorldCacheIo::read(f,world);
+    }
+  catch(...) {
+    return false;
+    }
+  }
+
+bool WorldCache::save(const ZenLoad::oCWorldData& data) const {
+  if(path.empty())
+    return false;
+  try {
+    WFile  f(path.c_str());
+    Header hdr = header();
+    f.write(&hdr,sizeof(hdr));
+
+    f.write(&vertCount, sizeof(vertCount));
+    f.write(&indexCount,sizeof(indexCount));
+    WorldCacheIo::write(f,land);
+    WorldCacheIo::write(f,data);
+    return true;
+    }
+  catch(...) {
+    Log::e("unable to write world cache: ",path);
+    return false;
+    }
+  }
+
+void WorldCache::bakeAll(const Gothic& gothic) {
+  auto fver = ZenLoad::ZenParser::FileVersion::Gothic1;
+  if(gothic.version().game==2)
+    fver = ZenLoad::ZenParser::FileVersion::Gothic2;
+
+  auto& vdfs = Resources::vdfsIndex();
+  for(auto& name:vdfs.getKnownFiles()) {
+    if(!FileExt::hasExt(name,"ZEN"))
+      continue;
+    try {
+      {
+      // nothing to parse, if both caches are up to date
+      WorldCache  cache(name);
+      if(cache.isLoaded() && PhysicCache(name,cache.meshVertices(),cache.meshIndices()).isLoaded())
+        continue;
+      }
+
+      const uint64_t       time = Application::tickCount();
+      ZenLoad::ZenParser   parser(name,vdfs);
+      ZenLoad::oCWorldData world;
+      parser.readHeader();
+      parser.readWorld(world,fver);
+
+      // vob bundles have no landscape
+      ZenLoad::zCMesh* mesh = parser.getWorldMesh();
+      if(mesh==nullptr || mesh->getVertices().empty())
+        continue;
+      const uint64_t zen = Application::tickCount();
+
+      WorldCache cache(name);
+      bool       ok = true;
+      if(!cache.isLoaded()) {
+        cache.pack(*mesh);
+        ok = cache.save(world);
+        }
+      ok = DynamicWorld::bakeCache(name,*mesh) && ok;
+      Log::i("bake \"",name,"\": zen = ",zen-time," ms, cache = ",Application::tickCount()-zen," ms",ok ? "" : " (failed)");
+      }
+    catch(...) {
+      Log::e("unable to bake world cache: \"",name,"\"");
+      }
+    }
+  }
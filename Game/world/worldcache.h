@@ -0,0 +1,43 @@
+#pragma once
+
+#include <zenload/zCMesh.h>
+#include <zenload/zTypes.h>
+
+#include <string>
+#include <cstdint>
+
+#include "graphics/mesh/submesh/packedmesh.h"
+
+class Gothic;
+
+// On-disk cache of world file content, next to PhysicCache: packed landscape mesh, vob tree, waynet and bsp.
+// File is keyed by world name and archives timestamps; on hit ZenParser is not used at all, any mismatch
+// means reparse of .zen. Landscape mesh size is stored, so PhysicCache can be validated without zCMesh.
+class WorldCache final {
+  public:
+    explicit WorldCache(const std::string& name);
+
+    bool     isLoaded() const { return loaded; }
+    void     pack(const ZenLoad::zCMesh& mesh);
+    bool     save(const ZenLoad::oCWorldData& data) const;
+
+    uint32_t meshVertices() const { return vertCount;  }
+    uint32_t meshIndices()  const { return indexCount; }
+
+    // prebuild visual and physics caches for every world, found in game archives
+    static void bakeAll(const Gothic& gothic);
+
+    PackedMesh           land;
+    ZenLoad::oCWorldData world;
+
+  private:
+    struct Header;
+
+    Header header() const;
+    bool   load();
+
+    std::string path;
+    uint32_t    vertCount  = 0;
+    uint32_t    indexCount = 0;
+    bool        loaded     = false;
+  };
@@ -0,0 +1,294 @@
+#include "worldcacheio.h"
+
+#include <type_traits>
+
+using namespace Tempest;
+
+template<class T>
+static void put(WFile& f, const T& v) {
+  static_assert(std::is_trivially_copyable<T>::value,"pod expected");
+  f.write(&v,sizeof(v));
+  }
+
+static void put(WFile& f, const std::string& v) {
+  uint32_t sz = uint32_t(v.size());
+  f.write(&sz,sizeof(sz));
+  f.write(v.data(),sz);
+  }
+
+template<class T>
+static void put(WFile& f, const std::vector<T>& v) {
+  static_assert(std::is_trivially_copyable<T>::value,"pod expected");
+  uint32_t sz = uint32_t(v.size());
+  f.write(&sz,sizeof(sz));
+  f.write(v.data(),sz*sizeof(T));
+  }
+
+template<class T>
+static bool get(RFile& f, T& v) {
+  static_assert(std::is_trivially_copyable<T>::value,"pod expected");
+  return f.read(&v,sizeof(v))==sizeof(v);
+  }
+
+static bool get(RFile& f, std::string& v) {
+  uint32_t sz = 0;
+  if(!get(f,sz) || sz>f.size())
+    return false;
+  v.resize(sz);
+  return f.read(&v[0],sz)==sz;
+  }
+
+template<class T>
+static bool get(RFile& f, std::vector<T>& v) {
+  static_assert(std::is_trivially_copyable<T>::value,"pod expected");
+  uint32_t sz = 0;
+  if(!get(f,sz) || sz*sizeof(T)>f.size())
+    return false;
+  v.resize(sz);
+  return f.read(v.data(),sz*sizeof(T))==sz*sizeof(T);
+  }
+
+// only fields, used by Material and PackedMesh, are stored
+static void put(WFile& f, const ZenLoad::zCMaterialData& m) {
+  put(f,m.matName);
+  put(f,m.matGroup);
+  put(f,m.texture);
+  put(f,m.texAniFPS);
+  put(f,m.texAniMapMode);
+  put(f,m.texAniMapDir);
+  put(f,m.noCollDet);
+  put(f,m.alphaFunc);
+  }
+
+static bool get(RFile& f, ZenLoad::zCMaterialData& m) {
+  return get(f,m.matName)       &&
+         get(f,m.matGroup)      &&
+         get(f,m.texture)       &&
+         get(f,m.texAniFPS)     &&
+         get(f,m.texAniMapMode) &&
+         get(f,m.texAniMapDir)  &&
+         get(f,m.noCollDet)     &&
+         get(f,m.alphaFunc);
+  }
+
+namespace {
+
+// same field list is used to write and to read world data
+class Writer final {
+  public:
+    explicit Writer(WFile& f):f(f){}
+
+    template<class T>
+    void operator()(const T& v) { put(f,v); }
+
+    template<class T,class Fn>
+    void array(const std::vector<T>& v, Fn fn) {
+      put(f,uint32_t(v.size()));
+      for(auto& i:v)
+        fn(i);
+      }
+
+  private:
+    WFile& f;
+  };
+
+class Reader final {
+  public:
+    explicit Reader(RFile& f):f(f){}
+
+    template<class T>
+    void operator()(T& v) { ok = ok && get(f,v); }
+
+    template<class T,class Fn>
+    void array(std::vector<T>& v, Fn fn) {
+      uint32_t sz = 0;
+      (*this)(sz);
+      if(!ok || sz>f.size()) {
+        ok = false;
+        return;
+        }
+      v.resize(sz);
+      for(size_t i=0; i<v.size() && ok; ++i)
+        fn(v[i]);
+      }
+
+    bool ok = true;
+
+  private:
+    RFile& f;
+  };
+
+}
+
+// only fields, used by world objects, triggers, sounds and lights, are stored:
+// new field in any of them must be added here, together with version bump of WorldCache header
+template<class F,class VobData>
+static void visitVob(F& f, VobData& vob) {
+  f(vob.vobType);
+  f(vob.vobName);
+  f(vob.visual);
+  f(vob.showVisual);
+  f(vob.visualCamAlign);
+  f(vob.cdStatic);
+  f(vob.cdDyn);
+  f(vob.zBias);
+  f(vob.bbox);
+  f(vob.position);
+  f(vob.rotationMatrix);
+  f(vob.worldMatrix);
+
+  auto& decal = vob.visualChunk.zCDecal;
+  f(decal.decalDim);
+  f(decal.decalAlphaFunc);
+  f(decal.decalTexAniFPS);
+  f(decal.decal2Sided);
+
+  auto& light = vob.zCVobLight;
+  f(light.range);
+  f(light.color);
+  f(light.dynamic.rangeAniScale);
+  f(light.dynamic.rangeAniFPS);
+  f(light.dynamic.rangeAniSmooth);
+  f(light.dynamic.colorAniList);
+  f(light.dynamic.colorAniListFPS);
+  f(light.dynamic.colorAniSmooth);
+
+  auto& snd = vob.zCVobSound;
+  f(snd.sndType);
+  f(snd.sndStartOn);
+  f(snd.sndRandDelay);
+  f(snd.sndRandDelayVar);
+  f(snd.sndName);
+  f(snd.sndRadius);
+  f(vob.zCVobSoundDaytime.sndStartTime);
+  f(vob.zCVobSoundDaytime.sndEndTime);
+  f(vob.zCVobSoundDaytime.sndName2);
+
+  f(vob.oCItem.instanceName);
+  f(vob.oCMOB.focusName);
+  f(vob.oCMOB.focusOverride);
+  f(vob.oCMOB.owner);
+  f(vob.oCMobInter.stateNum);
+  f(vob.oCMobInter.triggerTarget);
+  f(vob.oCMobInter.useWithItem);
+  f(vob.oCMobInter.conditionFunc);
+  f(vob.oCMobInter.onStateFunc);
+  f(vob.oCMobInter.rewind);
+  f(vob.oCMobLockable.locked);
+  f(vob.oCMobLockable.keyInstance);
+  f(vob.oCMobLockable.pickLockStr);
+  f(vob.oCMobContainer.contains);
+  f(vob.oCMobFire.fireSlot);
+  f(vob.oCMobFire.fireVobtreeName);
+
+  auto& trigger = vob.zCTrigger;
+  f(trigger.triggerTarget);
+  f(trigger.flags);
+  f(trigger.filterFlags);
+  f(trigger.numCanBeActivated);
+
+  auto& mover = vob.zCMover;
+  f(mover.moverBehavior);
+  f(mover.moverLocked);
+  f(mover.keyframes);
+  f(mover.moveSpeed);
+  f(mover.stayOpenTimeSec);
+  f(mover.sfxOpenStart);
+  f(mover.sfxOpenEnd);
+  f(mover.sfxMoving);
+  f(mover.sfxCloseEnd);
+
+  f(vob.zCTriggerList.listProcess);
+  f.array(vob.zCTriggerList.list,[&f](auto& i) {
+    f(i.triggerTarget);
+    f(i.fireDelay);
+    });
+  f(vob.zCTriggerScript.scriptFunc);
+  f(vob.zCMessageFilter.triggerTarget);
+  f(vob.zCMessageFilter.onTrigger);
+  f(vob.zCMessageFilter.onUntrigger);
+
+  auto& master = vob.zCCodeMaster;
+  f(master.triggerTarget);
+  f(master.triggerTargetFailure);
+  f(master.orderRelevant);
+  f(master.firstFalseIsFailure);
+  f.array(master.slaveVobName,[&f](auto& i) { f(i); });
+
+  f(vob.oCTriggerWorldStart.triggerTarget);
+  f(vob.oCTriggerWorldStart.fireOnlyFirstTime);
+  f(vob.oCTriggerChangeLevel.levelName);
+  f(vob.oCTriggerChangeLevel.startVobName);
+  f(vob.oCTouchDamage.damage);
+  f(vob.oCTouchDamage.touchDamage);
+  f(vob.oCTouchDamage.damageRepeatDelaySec);
+  f(vob.zCPFXControler.pfxName);
+  f(vob.zCPFXControler.killVobWhenDone);
+  f(vob.zCPFXControler.pfxStartOn);
+
+  f.array(vob.childVobs,[&f](auto& i) { visitVob(f,i); });
+  }
+
+template<class F,class Data>
+static void visitWorld(F& f, Data& world) {
+  f.array(world.rootVobs,[&f](auto& i) { visitVob(f,i); });
+
+  f.array(world.waynet.waypoints,[&f](auto& i) {
+    f(i.wpName);
+    f(i.position);
+    f(i.direction);
+    });
+  f.array(world.waynet.edges,[&f](auto& i) {
+    f(i.first);
+    f(i.second);
+    });
+
+  auto& bsp = world.bspTree;
+  f(bsp.nodes);
+  f(bsp.leafIndices);
+  f.array(bsp.sectors,[&f](auto& i) {
+    f(i.name);
+    f(i.bspNodeIndices);
+    });
+  }
+
+void WorldCacheIo::write(WFile& f, const PackedMesh& land) {
+  put(f,land.vertices);
+  put(f,land.bbox[0]);
+  put(f,land.bbox[1]);
+
+  put(f,uint32_t(land.subMeshes.size()));
+  for(auto& i:land.subMeshes) {
+    put(f,i.material);
+    put(f,i.indices);
+    }
+  }
+
+bool WorldCacheIo::read(RFile& f, PackedMesh& land) {
+  if(!get(f,land.vertices) || !get(f,land.bbox[0]) || !get(f,land.bbox[1]))
+    return false;
+
+  uint32_t cnt = 0;
+  if(!get(f,cnt) || cnt>f.size())
+    return false;
+  land.subMeshes.resize(cnt);
+  for(auto& i:land.subMeshes) {
+    if(!get(f,i.material) || !get(f,i.indices))
+      return false;
+    for(auto id:i.indices)
+      if(id>=land.vertices.size())
+        return false;
+    }
+  return true;
+  }
+
+void WorldCacheIo::write(WFile& f, const ZenLoad::oCWorldData& world) {
+  Writer wr(f);
+  visitWorld(wr,world);
+  }
+
+bool WorldCacheIo::read(RFile& f, ZenLoad::oCWorldData& world) {
+  Reader rd(f);
+  visitWorld(rd,world);
+  return rd.ok;
+  }
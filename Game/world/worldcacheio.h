@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Tempest/File>
+
+#include <zenload/zTypes.h>
+
+#include "graphics/mesh/submesh/packedmesh.h"
+
+// binary format of WorldCache content; read functions validate sizes and indices, but not the header
+namespace WorldCacheIo {
+  void write(Tempest::WFile& f, const PackedMesh& land);
+  bool read (Tempest::RFile& f, PackedMesh& land);
+
+  // only fields of vobs, used by the engine, are stored
+  void write(Tempest::WFile& f, const ZenLoad::oCWorldData& world);
+  bool read (Tempest::RFile& f, ZenLoad::oCWorldData& world);
+  }
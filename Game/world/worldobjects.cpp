@@ -12,6 +12,7 @@
 #include "world/objects/interactive.h"
 #include "world/objects/vob.h"
 #include "world.h"
+#include "gothic.h"
 #include "utils/workers.h"
 #include "utils/dbgpainter.h"
 
@@ -19,6 +20,8 @@
 #include <Tempest/Application>
 #include <Tempest/Log>
 
+#include <chrono>
+
 using namespace Tempest;
 using namespace Daedalus::GameState;
 
@@ -57,7 +60,7 @@ WorldObjects::SearchOpt::SearchOpt(float rangeMin, float rangeMax, float azi, Ta
   :rangeMin(rangeMin),rangeMax(rangeMax),azi(azi),collectAlgo(collectAlgo),flags(flags) {
   }
 
-WorldObjects::WorldObjects(World& owner):owner(owner){
+WorldObjects::WorldObjects(World& owner):owner(owner),npcIndex(npcArr){
   npcNear.reserve(512);
   }
 
@@ -73,6 +76,7 @@ void WorldObjects::load(Serialize &fin) {
     npcArr.emplace_back(std::make_unique<Npc>(owner,size_t(-1),nullptr));
   for(auto& i:npcArr)
     i->load(fin);
+  npcIndex.invalidate();
 
   fin.read(sz);
   itemArr.clear();
@@ -87,6 +91,7 @@ void WorldObjects::load(Serialize &fin) {
     throw std::logic_error("inconsistent *.sav vs world");
   for(auto& i:rootVobs)
     i->loadVobTree(fin);
+  invalidateVobIndex();
   if(fin.version()>=10) {
     uint32_t sz = 0;
     fin.read(sz);
@@ -139,12 +144,35 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   std::sort(npcArr.begin(),npcArr.end(),[](std::unique_ptr<Npc>& a, std::unique_ptr<Npc>& b){
     return a->handle()->id<b->handle()->id;
     });
+  npcIndex.invalidate();
+  npcIndex.update();
+  scheduleNpcTicks(dt);
+  prepareNpcTicks(dtPlayer);
+
+  // serial phase: script calls and world mutations, in deterministic order.
+  // Scheduler state is kept by npc, since scripts may insert or remove npc's during this loop
   for(size_t i=0; i<npcArr.size(); ++i) {
-    auto& npc = *npcArr[i];
-    if(npc.isPlayer())
-      npc.tick(dtPlayer); else
-      npc.tick(dt);
+    auto& npc   = *npcArr[i];
+    auto  state = npc.aiTickState();
+    if(state==Npc::AiTickSkip)
+      continue;
+    npc.setAiTickState(Npc::AiTickSkip);
+    if(npc.isPlayer()) {
+      npc.tick(dtPlayer);
+      continue;
+      }
+    // npc's spawned by scripts during this loop are not scheduled yet - tick them right away, with frame dt
+    if(state==Npc::AiTickNew)
+      npc.setSkippedTickTime(npc.skippedTickTime()+dt);
+    // step is truncated to maxDt, rest is carried to next ticks
+    const uint64_t skipped = npc.skippedTickTime();
+    const uint64_t t       = std::min(skipped,lod.maxDt);
+    npc.setSkippedTickTime(skipped-t);
+    if(npc.processPolicy()==Npc::AiFar2)
+      npc.tickRoutineOnly(t); else
+      npc.tick(t);
     }
+  npcIndex.invalidate();
 
   for(auto& i:routines) {
     auto s = i.stateByTime(owner.time());
@@ -181,8 +209,20 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   const float nearDist = 3000*3000;
   const float farDist  = 6000*6000;
 
+  // everyone outside of far-radius is AiFar2; grid gives the few, that are closer
+  std::vector<uint32_t> near;
   auto plPos = pl->position();
-  for(auto& i:npcArr) {
+  npcIndex.find(plPos,6000,near);
+
+  auto nr = near.begin();
+  for(size_t id=0; id<npcArr.size(); ++id) {
+    auto& i = npcArr[id];
+    if(nr==near.end() || *nr!=id) {
+      i->setProcessPolicy(Npc::ProcessPolicy::AiFar2);
+      continue;
+      }
+    ++nr;
+
     float dist = (i->position()-plPos).quadLength();
     if(dist<nearDist){
       npcNear.push_back(i.get());
@@ -198,15 +238,41 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
   tickNear(dt);
   tickTriggers(dt);
 
-  for(auto& ptr:npcArr) {
-    Npc& i = *ptr;
+  // pairs of (listener,message), sorted in listener order; only listeners within senses range are collected
+  std::vector<std::pair<uint32_t,uint32_t>> percList;
+  const float maxSenses = npcIndex.maxSensesRange();
+  for(size_t k=0; k<passive.size(); ++k) {
+    npcIndex.find(passive[k].pos,maxSenses,near);
+    for(auto id:near)
+      percList.emplace_back(id,uint32_t(k));
+    }
+  std::sort(percList.begin(),percList.end());
+
+  // perception scripts may insert or remove npc's: ids are valid for snapshot only,
+  // and npc is checked to be still in world, before it's touched
+  std::vector<Npc*> listeners(npcArr.size());
+  for(size_t id=0; id<npcArr.size(); ++id)
+    listeners[id] = npcArr[id].get();
+
+  auto perc = percList.begin();
+  for(size_t id=0; id<listeners.size(); ++id) {
+    auto percBegin = perc;
+    while(perc!=percList.end() && perc->first==id)
+      ++perc;
+
+    if(!isNpcInWorld(listeners[id]))
+      continue;
+    Npc& i = *listeners[id];
     if(i.isPlayer() || i.isDead())
       continue;
 
     if(i.processPolicy()==Npc::AiNormal) {
-      for(auto& r:passive) {
+      for(auto p=percBegin; p!=perc; ++p) {
+        auto& r = passive[p->second];
         if(r.self==&i)
           continue;
+        if(!isNpcInWorld(&i))
+          break;
         float l = i.qDistTo(r.pos.x,r.pos.y,r.pos.z);
         if(r.item!=size_t(-1) && r.other!=nullptr)
           owner.script().setInstanceItem(*r.other,r.item);
@@ -223,19 +289,21 @@ void WorldObjects::tick(uint64_t dt, uint64_t dtPlayer) {
         }
       }
 
-    if(i.percNextTime()>owner.tickCount())
+    if(!isNpcInWorld(&i) || i.percNextTime()>owner.tickCount())
       continue;
     i.perceptionProcess(*pl);
     }
   }
 
+bool WorldObjects::isNpcInWorld(const Npc* ptr) const {
+  // by pointer only: removed npc may be already destroyed
+  return npcIndex.indexOf(ptr)!=uint32_t(-1);
+  }
+
 uint32_t WorldObjects::npcId(const Npc *ptr) const {
   if(ptr==nullptr)
     return uint32_t(-1);
-  for(size_t i=0;i<npcArr.size();++i)
-    if(npcArr[i].get()==ptr)
-      return uint32_t(i);
-  return uint32_t(-1);
+  return npcIndex.indexOf(ptr);
   }
 
 uint32_t WorldObjects::itmId(const void *ptr) const {
@@ -275,6 +343,7 @@ Npc *WorldObjects::addNpc(size_t npcInstance, const Daedalus::ZString& at) {
     }
 
   npcArr.emplace_back(npc);
+  npcIndex.invalidate();
   return npc;
   }
 
@@ -285,6 +354,7 @@ Npc* WorldObjects::addNpc(size_t npcInstance, const Vec3& pos) {
   npc->updateTransform();
 
   npcArr.emplace_back(npc);
+  npcIndex.invalidate();
   return npc;
   }
 
@@ -307,6 +377,7 @@ Npc* WorldObjects::insertPlayer(std::unique_ptr<Npc> &&npc, const Daedalus::ZStr
     npc->updateTransform();
     }
   npcArr.emplace_back(std::move(npc));
+  npcIndex.invalidate();
   return npcArr.back().get();
   }
 
@@ -317,12 +388,145 @@ std::unique_ptr<Npc> WorldObjects::takeNpc(const Npc* ptr) {
       auto ret=std::move(npcArr[i]);
       npcArr[i] = std::move(npcArr.back());
       npcArr.pop_back();
+      npcIndex.invalidate();
       return ret;
       }
     }
   return nullptr;
   }
 
+void WorldObjects::setupAiLod(const Gothic& gothic) {
+  const int farInt  = gothic.settingsGetI("GAME","aiFarTickInterval");
+  const int far2Int = gothic.settingsGetI("GAME","aiFar2TickInterval");
+  const int budget  = gothic.settingsGetI("GAME","aiFarTickBudget");
+  if(farInt>0)
+    lod.farInterval  = uint64_t(farInt);
+  if(far2Int>0)
+    lod.far2Interval = uint64_t(far2Int);
+  if(budget>0)
+    lod.budget       = uint32_t(budget);
+  }
+
+void WorldObjects::setupAnimLod(const Gothic& gothic) {
+  const int reducedDist = gothic.settingsGetI("GAME","aniLodReducedDist");
+  const int lowDist     = gothic.settingsGetI("GAME","aniLodLowDist");
+  const int reducedInt  = gothic.settingsGetI("GAME","aniLodReducedInterval");
+  const int lowInt      = gothic.settingsGetI("GAME","aniLodLowInterval");
+  if(reducedDist>0)
+    aniLod.reducedDist     = float(reducedDist);
+  if(lowDist>0)
+    aniLod.lowDist         = float(lowDist);
+  if(reducedInt>0)
+    aniLod.reducedInterval = uint64_t(reducedInt);
+  if(lowInt>0)
+    aniLod.lowInterval     = uint64_t(lowInt);
+  }
+
+void WorldObjects::prepareNpcTicks(uint64_t dtPlayer) {
+  // parallel phase: pure part of npc tick - animation events and predicted ground/water probes.
+  // Npc::tick consumes them only for unchanged input, so outcome is same as of plain serial tick
+  struct Prep {
+    Npc*            npc      = nullptr;
+    uint64_t        dt       = 0;
+    MoveAlgo::Probe probe;
+    bool            hasProbe = false;
+    };
+  std::vector<Prep> prep;
+  prep.reserve(npcArr.size());
+  for(auto& i:npcArr) {
+    auto& npc = *i;
+    // AiFar2 npc's have no movement to probe for: see Npc::tickRoutineOnly
+    if(npc.aiTickState()!=Npc::AiTickDue || npc.processPolicy()==Npc::AiFar2)
+      continue;
+    Prep  p;
+    p.npc = &npc;
+    p.dt  = npc.isPlayer() ? dtPlayer : std::min(npc.skippedTickTime(),lod.maxDt);
+    prep.push_back(p);
+    }
+
+  Workers::parallelFor(prep,[](Prep& p){
+    p.hasProbe = p.npc->tickPrepare(p.dt,p.probe);
+    });
+
+  auto physic = owner.physic();
+  if(physic==nullptr)
+    return;
+  std::vector<Prep*>         id;
+  std::vector<Vec3>          land, water;
+  std::vector<float>         dy;
+  for(auto& p:prep) {
+    if(!p.hasProbe)
+      continue;
+    id   .push_back(&p);
+    land .push_back(p.probe.land);
+    dy   .push_back(p.probe.dy);
+    water.push_back(p.probe.water);
+    }
+
+  std::vector<DynamicWorld::RayLandResult>  landRet;
+  std::vector<DynamicWorld::RayWaterResult> waterRet;
+  physic->landRayBatch (land,dy,landRet);
+  physic->waterRayBatch(water,waterRet);
+  const uint64_t ep = physic->rayEpoch();
+  for(size_t i=0; i<id.size(); ++i)
+    id[i]->npc->setPrefetchedProbe(id[i]->probe,ep,landRet[i],waterRet[i]);
+  }
+
+void WorldObjects::scheduleNpcTicks(uint64_t dt) {
+  const size_t n = npcArr.size();
+  lodStats = AiLodStats();
+
+  for(auto& i:npcArr) {
+    auto& npc = *i;
+    if(npc.isPlayer()) {
+      npc.setAiTickState(Npc::AiTickDue);
+      continue;
+      }
+    // far npc that stays starved for long must not build up a backlog of steps; near npc keeps all of its time
+    const uint64_t skipped = npc.skippedTickTime()+dt;
+    if(npc.processPolicy()==Npc::AiFar || npc.processPolicy()==Npc::AiFar2)
+      npc.setSkippedTickTime(std::min(skipped,lod.maxCarry)); else
+      npc.setSkippedTickTime(skipped);
+    if(npc.processPolicy()==Npc::AiNormal) {
+      npc.setAiTickState(Npc::AiTickDue);
+      ++lodStats.normal;
+      } else {
+      npc.setAiTickState(Npc::AiTickSkip);
+      }
+    }
+  if(n==0)
+    return;
+
+  // far npc's are ticked with accumulated dt, once per interval; round-robin keeps the
+  // per-frame count within budget without starving anyone. npcArr is sorted by script id,
+  // cursor is the id to continue from, so it survives insertion and removal of npc's
+  const size_t first = size_t(std::lower_bound(npcArr.begin(),npcArr.end(),lod.cursor,[](const std::unique_ptr<Npc>& a, int64_t id){
+    return int64_t(a->handle()->id)<id;
+    })-npcArr.begin());
+  uint32_t budget = lod.budget;
+  int64_t  next   = lod.cursor;
+  for(size_t k=0; k<n; ++k) {
+    const size_t i   = (first+k)%n;
+    auto&        npc = *npcArr[i];
+    const auto   pl  = npc.processPolicy();
+    if(pl!=Npc::AiFar && pl!=Npc::AiFar2)
+      continue;
+    if(npc.skippedTickTime()<(pl==Npc::AiFar ? lod.farInterval : lod.far2Interval))
+      continue;
+    if(budget==0) {
+      ++lodStats.skipped;
+      continue;
+      }
+    --budget;
+    npc.setAiTickState(Npc::AiTickDue);
+    next = int64_t(npc.handle()->id)+1;
+    if(pl==Npc::AiFar)
+      ++lodStats.far; else
+      ++lodStats.far2;
+    }
+  lod.cursor = next;
+  }
+
 void WorldObjects::tickNear(uint64_t /*dt*/) {
   for(Npc* i:npcNear) {
     auto pos=i->position();
@@ -364,9 +568,27 @@ void WorldObjects::execTriggerEvent(const TriggerEvent& e) {
   }
 
 void WorldObjects::updateAnimation() {
-  Workers::parallelFor(npcArr,[](std::unique_ptr<Npc>& i){
+  using Clock = std::chrono::steady_clock;
+  std::atomic<uint64_t> cpuNs{0};
+  const auto            t0 = Clock::now();
+  Workers::parallelFor(npcArr,[&cpuNs](std::unique_ptr<Npc>& i){
+    const auto t = Clock::now();
     i->updateAnimation();
+    cpuNs.fetch_add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now()-t).count()),
+                    std::memory_order_relaxed);
     });
+  const auto wall = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now()-t0);
+
+  aniStats       = AnimLodStats();
+  aniStats.us    = uint32_t(wall.count());
+  aniStats.cpuUs = uint32_t(cpuNs.load()/1000);
+  for(auto& i:npcArr) {
+    switch(i->animLod()) {
+      case MdlVisual::LodFull:    ++aniStats.full;    break;
+      case MdlVisual::LodReduced: ++aniStats.reduced; break;
+      case MdlVisual::LodLow:     ++aniStats.low;     break;
+      }
+    }
   interactiveObj.parallelFor([](Interactive& i){
     i.updateAnimation();
     });
@@ -400,10 +622,7 @@ Npc *WorldObjects::findHero() {
   }
 
 Npc *WorldObjects::findNpcByInstance(size_t instance) {
-  for(auto& i:npcArr)
-    if(i->handle()->instanceSymbol==instance)
-      return i.get();
-  return nullptr;
+  return npcIndex.findByInstance(instance);
   }
 
 void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
@@ -413,22 +632,30 @@ void WorldObjects::detectNpcNear(const std::function<void(Npc&)>& f) {
 
 void WorldObjects::detectNpc(const float x, const float y, const float z,
                              const float r, const std::function<void(Npc&)>& f) {
+  // collect first: callback may spawn or remove npc's
+  std::vector<uint32_t> id;
+  npcIndex.find(Vec3(x,y,z),r,id);
+
+  std::vector<Npc*> ret;
+  ret.reserve(id.size());
   float maxDist=r*r;
-  for(auto& i:npcArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
+  for(auto i:id) {
+    auto qDist = (npcArr[i]->position()-Vec3(x,y,z)).quadLength();
     if(qDist<maxDist)
-      f(*i);
+      ret.push_back(npcArr[i].get());
     }
+  for(auto i:ret)
+    f(*i);
   }
 
 void WorldObjects::detectItem(const float x, const float y, const float z,
                               const float r, const std::function<void(Item&)>& f) {
   float maxDist=r*r;
-  for(auto& i:itemArr) {
-    auto qDist = (i->position()-Vec3(x,y,z)).quadLength();
+  items.find(Vec3(x,y,z),r,[&](Item& i){
+    auto qDist = (i.position()-Vec3(x,y,z)).quadLength();
     if(qDist<maxDist)
-      f(*i);
-    }
+      f(i);
+    });
   }
 
 void WorldObjects::addTrigger(AbstractTrigger* tg) {
@@ -562,6 +789,15 @@ void WorldObjects::invalidateVobIndex() {
   interactiveObj.invalidate();
   }
 
+void WorldObjects::updateNpcIndex(const Npc& npc, const Vec3& pos) {
+  npcIndex.onMove(npc,pos);
+  }
+
+void WorldObjects::invalidateVobIndex(const Vob& v) {
+  items.invalidate(&v);
+  interactiveObj.invalidate(&v);
+  }
+
 Interactive* WorldObjects::validateInteractive(Interactive *def) {
   return interactiveObj.hasObject(def) ? def : nullptr;
   }
@@ -569,10 +805,7 @@ Interactive* WorldObjects::validateInteractive(Interactive *def) {
 Npc *WorldObjects::validateNpc(Npc *def) {
   if(def==nullptr)
     return nullptr;
-  for(auto& i:npcArr)
-    if(i.get()==def)
-      return def;
-  return nullptr;
+  return npcIndex.indexOf(def)!=uint32_t(-1) ? def : nullptr;
   }
 
 Item *WorldObjects::validateItem(Item *def) {
@@ -735,6 +968,7 @@ void WorldObjects::resetPositionToTA() {
       } else {
       npcInvalid.emplace_back(std::move(npcArr[i]));
       npcArr.erase(npcArr.begin()+int(i));
+      npcIndex.invalidate();
 
       auto& npc = *npcInvalid.back();
       npc.attachToPoint(nullptr);
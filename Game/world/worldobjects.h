@@ -7,6 +7,7 @@
 
 #include "bullet.h"
 #include "spaceindex.h"
+#include "npcindex.h"
 #include "game/gametime.h"
 #include "game/perceptionmsg.h"
 #include "game/constants.h"
@@ -20,6 +21,7 @@ class World;
 class Serialize;
 class TriggerEvent;
 class AbstractTrigger;
+class Gothic;
 
 class WorldObjects final {
   public:
@@ -44,9 +46,39 @@ class WorldObjects final {
       SearchFlg     flags       = NoFlg;
       };
 
+    // npc ticks of the last frame, by process policy
+    struct AiLodStats final {
+      uint32_t normal  = 0;
+      uint32_t far     = 0;
+      uint32_t far2    = 0;
+      uint32_t skipped = 0;
+      };
+
+    // skeletal animation LOD by distance to camera, see MdlVisual::AnimLod
+    struct AnimLod final {
+      float    reducedDist     = 2000;
+      float    lowDist         = 4000;
+      uint64_t reducedInterval = 66;
+      uint64_t lowInterval     = 200;
+      };
+
+    // npc's by skeletal animation LOD, see MdlVisual::AnimLod
+    struct AnimLodStats final {
+      uint32_t full    = 0;
+      uint32_t reduced = 0;
+      uint32_t low     = 0;
+      uint32_t us      = 0; // wall time of npc animation update in last frame
+      uint32_t cpuUs   = 0; // same, summed over workers
+      };
+
     void           load(Serialize& fout);
     void           save(Serialize& fout);
     void           tick(uint64_t dt, uint64_t dtPlayer);
+    void           setupAiLod(const Gothic& gothic);
+    auto           aiLodStats() const -> const AiLodStats& { return lodStats; }
+    void           setupAnimLod(const Gothic& gothic);
+    auto           animLod() const -> const AnimLod& { return aniLod; }
+    auto           animLodStats() const -> const AnimLodStats& { return aniStats; }
 
     Npc*           addNpc(size_t itemInstance, const Daedalus::ZString& at);
     Npc*           addNpc(size_t itemInstance, const Tempest::Vec3&     at);
@@ -97,6 +129,8 @@ class WorldObjects final {
     void           addStatic     (StaticObj*           obj);
     void           addRoot       (ZenLoad::zCVobData&& vob, bool startup);
     void           invalidateVobIndex();
+    void           invalidateVobIndex(const Vob& v);
+    void           updateNpcIndex(const Npc& npc, const Tempest::Vec3& pos);
 
     Interactive*   validateInteractive(Interactive *def);
     Npc*           validateNpc        (Npc         *def);
@@ -135,6 +169,16 @@ class WorldObjects final {
       uint64_t timeUntil = 0;
       };
 
+    // reduced tick rate for npc's far away from player
+    struct AiLod {
+      uint64_t farInterval  = 100;
+      uint64_t far2Interval = 500;
+      uint32_t budget       = 64;   // far ticks per frame
+      uint64_t maxDt        = 1000; // longer steps are split over next ticks
+      uint64_t maxCarry     = 2000; // upper bound of accumulated skipped time
+      int64_t  cursor       = 0;    // round-robin position: script id of npc to start from
+      };
+
     World&                             owner;
     std::vector<std::unique_ptr<Vob>>  rootVobs;
 
@@ -151,6 +195,11 @@ class WorldObjects final {
     std::vector<std::unique_ptr<Npc>>  npcArr;
     std::vector<std::unique_ptr<Npc>>  npcInvalid;
     std::vector<Npc*>                  npcNear;
+    NpcIndex                           npcIndex;
+    AiLod                              lod;
+    AiLodStats                         lodStats;
+    AnimLod                            aniLod;
+    AnimLodStats                       aniStats;
 
     std::vector<AbstractTrigger*>      triggers;
     std::vector<AbstractTrigger*>      triggersZn;
@@ -169,7 +218,10 @@ class WorldObjects final {
 
     void             setMobState(const char* scheme, int32_t st);
 
+    void             scheduleNpcTicks(uint64_t dt);
+    void             prepareNpcTicks(uint64_t dtPlayer);
     void             tickNear(uint64_t dt);
     void             tickTriggers(uint64_t dt);
+    bool             isNpcInWorld(const Npc* ptr) const;
     static bool      isTargetedBy(Npc& npc,Npc& by);
   };
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "graphics/mesh/animmath.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Pose evaluation of a crowd: 1000 humanoids, each playing one of many sequences at own time.
+// SoA path (Animation::AnimData samples, SIMD blend, parents-before-children pass, as Pose does now)
+// is checked and timed against AoS path with scalar blend and recursive skeleton walk, as Pose did before.
+namespace {
+
+struct Node {
+  std::string name;
+  size_t      parent = size_t(-1);
+  };
+
+// humanoid skeleton, like HUMANS.MDH: in file order children may come before parents
+std::vector<Node> mkHumanoid(std::mt19937& rng) {
+  std::vector<std::pair<std::string,std::string>> def = {
+    {"BIP01",""},{"BIP01 PELVIS","BIP01"},{"BIP01 SPINE","BIP01 PELVIS"},{"BIP01 SPINE1","BIP01 SPINE"},
+    {"BIP01 SPINE2","BIP01 SPINE1"},{"BIP01 NECK","BIP01 SPINE2"},{"BIP01 HEAD","BIP01 NECK"},
+    {"ZS_HELMET","BIP01 HEAD"},{"ZS_LONGSWORD","BIP01 SPINE2"},{"ZS_BOW","BIP01 SPINE2"},{"ZS_SWORD","BIP01 PELVIS"},
+    };
+  for(const char* s:{"L","R"}) {
+    const std::string b = std::string("BIP01 ")+s+" ";
+    def.push_back({b+"CLAVICLE","BIP01 NECK"});
+    def.push_back({b+"UPPERARM",b+"CLAVICLE"});
+    def.push_back({b+"FOREARM", b+"UPPERARM"});
+    def.push_back({b+"HAND",    b+"FOREARM"});
+    for(int f=0; f<5; ++f) {
+      const std::string fn = b+"FINGER"+std::to_string(f);
+      def.push_back({fn,b+"HAND"});
+      def.push_back({fn+"1",fn});
+      def.push_back({fn+"2",fn+"1"});
+      }
+    def.push_back({b+"THIGH",   "BIP01 PELVIS"});
+    def.push_back({b+"CALF",    b+"THIGH"});
+    def.push_back({b+"FOOT",    b+"CALF"});
+    def.push_back({b+"TOE0",    b+"FOOT"});
+    def.push_back({std::string("ZS_")+(s[0]=='L' ? "LEFTHAND" : "RIGHTHAND"),b+"HAND"});
+    }
+  std::shuffle(def.begin(),def.end(),rng);
+
+  std::vector<Node> nodes(def.size());
+  for(size_t i=0; i<def.size(); ++i) {
+    nodes[i].name = def[i].first;
+    for(size_t r=0; r<def.size(); ++r)
+      if(def[r].first==def[i].second)
+        nodes[i].parent = r;
+    }
+  return nodes;
+  }
+
+std::vector<size_t> mkOrder(const std::vector<Node>& nodes) {
+  std::vector<size_t> parent(nodes.size());
+  for(size_t i=0; i<nodes.size(); ++i)
+    parent[i] = nodes[i].parent;
+  return parentsFirst(parent);
+  }
+
+ZenLoad::zCModelAniSample mkSample(float ax, float ay, float az, float angle, float px, float py, float pz) {
+  const float l = std::sqrt(ax*ax+ay*ay+az*az);
+  const float s = std::sin(angle*0.5f)/l;
+  ZenLoad::zCModelAniSample smp;
+  smp.rotation.x = ax*s;
+  smp.rotation.y = ay*s;
+  smp.rotation.z = az*s;
+  smp.rotation.w = std::cos(angle*0.5f);
+  smp.position.x = px;
+  smp.position.y = py;
+  smp.position.z = pz;
+  return smp;
+  }
+
+struct Sequence {
+  size_t                                 frames = 0;
+  std::vector<ZenLoad::zCModelAniSample> aos;    // frame-major, as zCModelAniSample array of .MAN
+  std::vector<float>                     soa;    // as Animation::AnimData::samples
+  };
+
+Sequence mkSequence(size_t nodes, size_t stride, size_t frames, std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+  std::vector<float> axis(nodes*3), amp(nodes), freq(nodes), ph(nodes), off(nodes*3);
+  for(size_t i=0; i<nodes; ++i) {
+    for(size_t k=0; k<3; ++k) {
+      axis[i*3+k] = u(rng)+(k==i%3 ? 2.f : 0.f);
+      off [i*3+k] = u(rng)*20.f;
+      }
+    amp [i] = 0.2f+std::fabs(u(rng));
+    // a few bones swing fast enough, so that neighbour frames are far apart: slerp lanes
+    freq[i] = (i%9==0) ? 1.5f : 0.1f+std::fabs(u(rng))*0.2f;
+    ph  [i] = u(rng)*3.f;
+    }
+
+  Sequence s;
+  s.frames = frames;
+  s.aos.resize(frames*nodes);
+  s.soa.resize(frames*stride*7);
+  for(size_t f=0; f<frames; ++f) {
+    float* dst = &s.soa[f*stride*7];
+    for(size_t i=0; i<stride; ++i)
+      dst[3*stride+i] = 1.f;
+    for(size_t i=0; i<nodes; ++i) {
+      const float a   = amp[i]*std::sin(float(f)*freq[i]+ph[i]);
+      const float bob = (i==0) ? std::sin(float(f)*0.3f)*5.f : 0.f;
+      auto smp = mkSample(axis[i*3],axis[i*3+1],axis[i*3+2],a,off[i*3],off[i*3+1]+bob,off[i*3+2]);
+      s.aos[f*nodes+i] = smp;
+      dst[0*stride+i] = smp.rotation.x;
+      dst[1*stride+i] = smp.rotation.y;
+      dst[2*stride+i] = smp.rotation.z;
+      dst[3*stride+i] = smp.rotation.w;
+      dst[4*stride+i] = smp.position.x;
+      dst[5*stride+i] = smp.position.y;
+      dst[6*stride+i] = smp.position.z;
+      }
+    }
+  return s;
+  }
+
+struct Humanoid {
+  size_t                 seq  = 0;
+  uint64_t               time = 0;
+  std::vector<Matrix4x4> base, tr;
+  };
+
+void frameOf(const Sequence& s, uint64_t time, size_t& fa, size_t& fb, float& a) {
+  const uint64_t frame = time*25; // 25 fps, time in ms
+  fa = size_t(frame/1000)%s.frames;
+  fb = (fa+1)%s.frames;
+  a  = float(frame%1000)/1000.f;
+  }
+
+namespace Legacy {
+
+void mkSkeleton(const std::vector<Node>& nodes, Humanoid& h, const Matrix4x4& mt, size_t parent) {
+  for(size_t i=0; i<nodes.size(); ++i) {
+    if(nodes[i].parent!=parent)
+      continue;
+    h.tr[i] = mt*h.base[i];
+    mkSkeleton(nodes,h,h.tr[i],i);
+    }
+  }
+
+void evaluate(const std::vector<Node>& nodes, const Sequence& s, Humanoid& h) {
+  size_t fa, fb;
+  float  a;
+  frameOf(s,h.time,fa,fb,a);
+  const auto* sampleA = &s.aos[fa*nodes.size()];
+  const auto* sampleB = &s.aos[fb*nodes.size()];
+  for(size_t i=0; i<nodes.size(); ++i) {
+    auto smp = mix(sampleA[i],sampleB[i],a);
+    h.base[i] = mkMatrix(smp);
+    }
+  Matrix4x4 mt;
+  mt.identity();
+  mkSkeleton(nodes,h,mt,size_t(-1));
+  }
+
+}
+
+void evaluate(const std::vector<Node>& nodes, const std::vector<size_t>& order, size_t stride,
+              const Sequence& s, Humanoid& h, std::vector<float>& smp) {
+  size_t fa, fb;
+  float  a;
+  frameOf(s,h.time,fa,fb,a);
+  smp.resize(stride*7);
+  mix(&s.soa[fa*stride*7],&s.soa[fb*stride*7],a,nodes.size(),stride,smp.data());
+  const float* q = smp.data();
+  for(size_t i=0; i<nodes.size(); ++i)
+    h.base[i] = mkMatrix(q[0*stride+i],q[1*stride+i],q[2*stride+i],q[3*stride+i],
+                         q[4*stride+i],q[5*stride+i],q[6*stride+i]);
+  Matrix4x4 mt;
+  mt.identity();
+  for(auto i:order) {
+    if(nodes[i].parent==size_t(-1))
+      h.tr[i] = mt*h.base[i]; else
+      h.tr[i] = h.tr[nodes[i].parent]*h.base[i];
+    }
+  }
+
+float maxDiff(const std::vector<Matrix4x4>& a, const std::vector<Matrix4x4>& b) {
+  float d = 0;
+  for(size_t i=0; i<a.size(); ++i)
+    for(int r=0; r<4; ++r)
+      for(int c=0; c<4; ++c)
+        d = std::max(d,std::fabs(a[i].at(r,c)-b[i].at(r,c)));
+  return d;
+  }
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(17);
+
+  // SIMD blend against per-node scalar blend, over random rotations: opposite hemispheres and large angles included
+  {
+    const size_t count = 61, stride = 64;
+    std::uniform_real_distribution<float> u(-1.f,1.f);
+    std::vector<ZenLoad::zCModelAniSample> x(count), y(count);
+    std::vector<float> sx(stride*7,0.f), sy(stride*7,0.f), out(stride*7,0.f);
+    float err = 0;
+    for(int iter=0; iter<200; ++iter) {
+      for(size_t i=0; i<count; ++i) {
+        x[i] = mkSample(u(rng),u(rng),u(rng)+0.1f,u(rng)*3.1f,u(rng),u(rng),u(rng));
+        y[i] = mkSample(u(rng),u(rng),u(rng)+0.1f,u(rng)*3.1f,u(rng),u(rng),u(rng));
+        if(i%3==0)
+          y[i] = mkSample(1,0,0,u(rng)*0.2f,0,0,0); // small angle: nlerp lanes
+        const ZenLoad::zCModelAniSample* s[2] = {&x[i],&y[i]};
+        float*                           d[2] = {sx.data(),sy.data()};
+        for(int k=0; k<2; ++k) {
+          d[k][0*stride+i] = s[k]->rotation.x;
+          d[k][1*stride+i] = s[k]->rotation.y;
+          d[k][2*stride+i] = s[k]->rotation.z;
+          d[k][3*stride+i] = s[k]->rotation.w;
+          d[k][4*stride+i] = s[k]->position.x;
+          d[k][5*stride+i] = s[k]->position.y;
+          d[k][6*stride+i] = s[k]->position.z;
+          }
+        }
+      const float a = float(iter%10)/10.f;
+      mix(sx.data(),sy.data(),a,count,stride,out.data());
+      for(size_t i=0; i<count; ++i) {
+        auto r = mix(x[i],y[i],a);
+        const float ref[7] = {r.rotation.x,r.rotation.y,r.rotation.z,r.rotation.w,r.position.x,r.position.y,r.position.z};
+        for(size_t k=0; k<7; ++k)
+          err = std::max(err,std::fabs(out[k*stride+i]-ref[k]));
+        }
+      }
+    std::printf("blend: max deviation from scalar path %g\n",double(err));
+    CHECK(err<1e-5f);
+  }
+
+  // crowd
+  const auto   nodes  = mkHumanoid(rng);
+  const auto   order  = mkOrder(nodes);
+  const size_t stride = (nodes.size()+3)/4*4;
+  CHECK(order.size()==nodes.size());
+  {
+  std::vector<size_t> at(nodes.size(),size_t(-1));
+  for(size_t i=0; i<order.size(); ++i)
+    at[order[i]] = i;
+  size_t misordered = 0;
+  for(size_t i=0; i<nodes.size(); ++i)
+    if(nodes[i].parent!=size_t(-1) && !(at[nodes[i].parent]<at[i]))
+      ++misordered;
+  CHECK(misordered==0);
+  // broken parent link: node and its children are not reachable
+  CHECK(parentsFirst({size_t(-1),0,7,2}).size()==2);
+  }
+
+  std::vector<Sequence> seq;
+  for(size_t i=0; i<24; ++i)
+    seq.push_back(mkSequence(nodes.size(),stride,40+i*3,rng));
+
+  const size_t count = 1000;
+  std::vector<Humanoid> soa(count), aos(count);
+  std::uniform_int_distribution<uint64_t> start(0,10000);
+  for(size_t i=0; i<count; ++i) {
+    for(auto h:{&soa[i],&aos[i]}) {
+      h->seq  = i%seq.size();
+      h->base.resize(nodes.size());
+      h->tr  .resize(nodes.size());
+      }
+    soa[i].time = aos[i].time = start(rng);
+    }
+
+  std::vector<float> smp;
+  double tSoa = 0, tAos = 0;
+  float  err  = 0;
+  const size_t ticks = 30;
+  for(size_t t=0; t<ticks; ++t) {
+    auto t0 = Clock::now();
+    for(auto& h:soa)
+      evaluate(nodes,order,stride,seq[h.seq],h,smp);
+    auto t1 = Clock::now();
+    for(auto& h:aos)
+      Legacy::evaluate(nodes,seq[h.seq],h);
+    auto t2 = Clock::now();
+    tSoa += std::chrono::duration<double,std::milli>(t1-t0).count();
+    tAos += std::chrono::duration<double,std::milli>(t2-t1).count();
+
+    for(size_t i=0; i<count; ++i) {
+      err = std::max(err,maxDiff(soa[i].tr,aos[i].tr));
+      soa[i].time += 33;
+      aos[i].time += 33;
+      }
+    }
+
+  std::printf("poses: %zu x %zu nodes, ticks: %zu, soa: %.3f ms (%.2f us/pose), aos: %.3f ms (%.2f us/pose)\n",
+              count,nodes.size(),ticks,
+              tSoa,tSoa*1000.0/double(count*ticks),
+              tAos,tAos*1000.0/double(count*ticks));
+  std::printf("max deviation of bone transforms: %g\n",double(err));
+  CHECK(err<1e-3f);
+
+  return TEST_RESULT();
+  }
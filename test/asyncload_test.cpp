@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/async.h"
+#include "utils/loadcache.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+// Asset loading of a world: vob tree references meshes, meshes reference textures. Textures are stored
+// run-length and delta coded, decoding unpacks them and builds mip chain - stand-in for ZTEX->DDS and Pixmap.
+// Former Resources held one lock over decode and upload, and world asked assets one at a time; now all visuals
+// are prefetched through Async handles and cached by LoadCache::load: decoded without lock, only cache insert and
+// upload are serialized. Decoder and device are fakes; timings are printed only, load results are checked.
+namespace {
+
+struct File {
+  uint32_t             w = 0, h = 0;
+  std::vector<uint8_t> data;
+  };
+
+struct Texture {
+  uint32_t w = 0, h = 0, mips = 0;
+  uint64_t hash = 0;
+  };
+
+struct Mesh {
+  std::vector<const Texture*> tex;
+  };
+
+File mkFile(uint32_t w, uint32_t h, uint32_t seed) {
+  File f;
+  f.w = w;
+  f.h = h;
+  // runs of deltas: (count, value) pairs
+  uint32_t s = seed*2654435761u+1u;
+  size_t   n = size_t(w)*h*4;
+  while(n>0) {
+    s = s*1664525u+1013904223u;
+    const size_t cnt = std::min<size_t>(n,1+((s>>24)&15));
+    f.data.push_back(uint8_t(cnt));
+    f.data.push_back(uint8_t(s>>8));
+    n -= cnt;
+    }
+  return f;
+  }
+
+std::vector<uint8_t> decode(const File& f, uint32_t& mips) {
+  const size_t         size = size_t(f.w)*f.h*4;
+  std::vector<uint8_t> px(size);
+  size_t  at   = 0;
+  uint8_t prev = 0;
+  for(size_t i=0; i+1<f.data.size(); i+=2) {
+    for(size_t r=0; r<f.data[i]; ++r) {
+      prev = uint8_t(prev+f.data[i+1]);
+      px[at++] = prev;
+      }
+    }
+
+  // mip chain, box filter
+  mips = 1;
+  uint32_t w = f.w, h = f.h;
+  size_t   src = 0;
+  px.reserve(size*2);
+  while(w>1 && h>1) {
+    const uint32_t nw = w/2, nh = h/2;
+    const size_t   dst = px.size();
+    px.resize(dst+size_t(nw)*nh*4);
+    for(uint32_t y=0; y<nh; ++y)
+      for(uint32_t x=0; x<nw; ++x)
+        for(uint32_t c=0; c<4; ++c) {
+          auto p = [&](uint32_t xx, uint32_t yy) { return uint32_t(px[src+(size_t(yy)*w+xx)*4+c]); };
+          px[dst+(size_t(y)*nw+x)*4+c] = uint8_t((p(2*x,2*y)+p(2*x+1,2*y)+p(2*x,2*y+1)+p(2*x+1,2*y+1))/4);
+          }
+    src = dst;
+    w   = nw;
+    h   = nh;
+    mips++;
+    }
+  return px;
+  }
+
+uint64_t hashOf(const std::vector<uint8_t>& px) {
+  uint64_t h = 1469598103934665603ull;
+  for(auto i:px)
+    h = (h^i)*1099511628211ull;
+  return h;
+  }
+
+struct Assets {
+  std::unordered_map<std::string,File>                     files;
+  std::unordered_map<std::string,std::vector<std::string>> meshes;
+  };
+
+// device upload: serialized, copies texels out
+struct Device {
+  std::vector<uint8_t> vram;
+  size_t               uploads = 0;
+
+  Texture* upload(const File& f, const std::vector<uint8_t>& px, uint32_t mips) {
+    vram.resize(px.size());
+    std::copy(px.begin(),px.end(),vram.begin());
+    uploads++;
+    auto t  = new Texture();
+    t->w    = f.w;
+    t->h    = f.h;
+    t->mips = mips;
+    t->hash = hashOf(vram);
+    return t;
+    }
+  };
+
+}
+
+namespace Legacy {
+
+// previous Resources: one lock over lookup, decode and upload
+struct Resources {
+  const Assets&         assets;
+  Device                device;
+  std::recursive_mutex  sync;
+  std::unordered_map<std::string,std::unique_ptr<Texture>> texCache;
+  std::unordered_map<std::string,std::unique_ptr<Mesh>>    meshCache;
+
+  explicit Resources(const Assets& a):assets(a) {}
+
+  const Texture* loadTexture(const std::string& name) {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = texCache.find(name);
+    if(it!=texCache.end())
+      return it->second.get();
+    auto&    f    = assets.files.at(name);
+    uint32_t mips = 0;
+    auto     px   = decode(f,mips);
+    auto     ret  = device.upload(f,px,mips);
+    texCache[name].reset(ret);
+    return ret;
+    }
+
+  const Mesh* loadMesh(const std::string& name) {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = meshCache.find(name);
+    if(it!=meshCache.end())
+      return it->second.get();
+    std::unique_ptr<Mesh> m(new Mesh());
+    for(auto& t:assets.meshes.at(name))
+      m->tex.push_back(loadTexture(t));
+    auto ret = m.get();
+    meshCache[name] = std::move(m);
+    return ret;
+    }
+  };
+
+}
+
+struct Stats {
+  uint64_t hit  = 0;
+  uint64_t miss = 0;
+  };
+
+// Resources with fake decoder: caches go through LoadCache::load, prefetch through Async, as in Resources
+struct Resources {
+  const Assets&         assets;
+  Device                device;
+  std::recursive_mutex  sync;
+  std::atomic<size_t>   asyncLeft{0};
+  std::atomic<size_t>   decoded{0};
+  Stats                 texStats, meshStats;
+  std::unordered_map<std::string,std::unique_ptr<Texture>> texCache;
+  std::unordered_map<std::string,std::unique_ptr<Mesh>>    meshCache;
+
+  explicit Resources(const Assets& a):assets(a) {}
+  ~Resources() { Workers::waitFor(asyncLeft); }
+
+  const Texture* loadTexture(const std::string& name) {
+    auto&    f    = assets.files.at(name);
+    uint32_t mips = 0;
+    return LoadCache::load(sync,texCache,name,texStats,
+                           [&]() { decoded.fetch_add(1); return decode(f,mips); },
+                           [&](std::vector<uint8_t> px) { return std::unique_ptr<Texture>(device.upload(f,px,mips)); },
+                           [](const Texture*) {});
+    }
+
+  const Mesh* loadMesh(const std::string& name) {
+    std::vector<const Texture*> tex;
+    return LoadCache::load(sync,meshCache,name,meshStats,
+                           [&]() {
+                             for(auto& t:assets.meshes.at(name))
+                               tex.push_back(loadTexture(t));
+                             return tex.size();
+                             },
+                           [&](size_t) { std::unique_ptr<Mesh> m(new Mesh()); m->tex = tex; return m; },
+                           [](const Mesh*) {});
+    }
+
+  Async<Mesh> loadMeshAsync(const std::string& name) {
+    return Async<Mesh>::run([this,name](){ return loadMesh(name); },asyncLeft);
+    }
+  };
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(17);
+
+  // assets: textures of 64..512 texels, meshes with 1..4 of them
+  Assets assets;
+  const size_t texCount = 600, meshCount = 400, vobCount = 6000;
+  for(size_t i=0; i<texCount; ++i) {
+    const uint32_t w = 64u<<(i%4), h = 64u<<((i/4)%3);
+    assets.files["TEX_"+std::to_string(i)+".TGA"] = mkFile(w,h,uint32_t(i));
+    }
+  std::uniform_int_distribution<size_t> anyTex(0,texCount-1);
+  for(size_t i=0; i<meshCount; ++i) {
+    auto& m = assets.meshes["MESH_"+std::to_string(i)+".3DS"];
+    for(size_t k=0; k<=i%4; ++k)
+      m.push_back("TEX_"+std::to_string(anyTex(rng))+".TGA");
+    }
+  // vob tree: popular meshes are used a lot
+  std::vector<std::string> vobs;
+  std::geometric_distribution<size_t> popular(0.01);
+  for(size_t i=0; i<vobCount; ++i)
+    vobs.push_back("MESH_"+std::to_string(popular(rng)%meshCount)+".3DS");
+
+  // previous: vob by vob, under lock
+  std::vector<const Mesh*> a, b;
+  Legacy::Resources legacy(assets);
+  auto t0 = Clock::now();
+  for(auto& v:vobs)
+    a.push_back(legacy.loadMesh(v));
+  auto t1 = Clock::now();
+
+  // now: prefetch of all visuals, then vob tree mostly hits cache
+  Resources res(assets);
+  auto t2 = Clock::now();
+  {
+  std::unordered_map<std::string,Async<Mesh>> prefetch;
+  for(auto& v:vobs)
+    if(prefetch.find(v)==prefetch.end())
+      prefetch[v] = res.loadMeshAsync(v);
+  for(auto& i:prefetch)
+    i.second.get();
+  }
+  for(auto& v:vobs)
+    b.push_back(res.loadMesh(v));
+  auto t3 = Clock::now();
+
+  const double tLegacy = std::chrono::duration<double,std::milli>(t1-t0).count();
+  const double tAsync  = std::chrono::duration<double,std::milli>(t3-t2).count();
+  std::printf("vobs: %zu, meshes: %zu, textures: %zu, hw threads %u\n",
+              vobs.size(),res.meshCache.size(),res.texCache.size(),std::thread::hardware_concurrency());
+  std::printf("world load: serial %.3f ms, async %.3f ms; uploads %zu, decoded %zu\n",
+              tLegacy,tAsync,res.device.uploads,res.decoded.load());
+
+  // same textures for every vob
+  size_t wrong = 0;
+  for(size_t i=0; i<vobs.size(); ++i) {
+    if(a[i]==nullptr || b[i]==nullptr || a[i]->tex.size()!=b[i]->tex.size()) {
+      ++wrong;
+      continue;
+      }
+    for(size_t k=0; k<a[i]->tex.size(); ++k) {
+      auto& x = *a[i]->tex[k];
+      auto& y = *b[i]->tex[k];
+      if(x.hash!=y.hash || x.w!=y.w || x.h!=y.h || x.mips!=y.mips)
+        ++wrong;
+      }
+    }
+  CHECK(wrong==0);
+  CHECK(res.meshCache.size()==legacy.meshCache.size());
+  CHECK(res.texCache.size()==legacy.texCache.size());
+  // racing decodes are dropped, one upload per texture
+  CHECK(res.device.uploads==res.texCache.size());
+  CHECK(res.decoded.load()>=res.texCache.size());
+  CHECK(res.asyncLeft.load()==0);
+  CHECK(res.texStats.miss==res.texCache.size());
+  CHECK(res.meshStats.miss==res.meshCache.size());
+
+  // many threads ask same mesh: one object for everybody
+  {
+  Resources r(assets);
+  std::vector<Async<Mesh>> h;
+  for(int i=0; i<64; ++i)
+    h.push_back(r.loadMeshAsync("MESH_3.3DS"));
+  const Mesh* m = h[0].get();
+  size_t differ = 0;
+  for(auto& i:h)
+    differ += (i.get()!=m) ? 1 : 0;
+  CHECK(m!=nullptr);
+  CHECK(differ==0);
+  CHECK(r.meshCache.size()==1);
+  CHECK(r.device.uploads==r.texCache.size());
+  }
+
+  // failed load still releases waiters
+  {
+  Resources r(assets);
+  auto h = Async<Mesh>::run([&r](){ return r.loadMesh("NOT_THERE.3DS"); },r.asyncLeft);
+  CHECK(h.get()==nullptr);
+  CHECK(h.isReady());
+  }
+  CHECK(Async<Mesh>().get()==nullptr);
+
+  return TEST_RESULT();
+  }
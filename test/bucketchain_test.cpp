@@ -0,0 +1,226 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "graphics/bucketchain.h"
+
+#include "testing.h"
+
+// Instantiation of a world of G2 size into draw buckets: thousands of materials with few popular ones, static and
+// movable vobs, few morph meshes; then npc's spawn and despawn with skinned meshes, leaving holes in old buckets.
+// Bucket is found same way as VisualObjects::getBucket, against linear scan over std::list, that it did before.
+namespace {
+
+enum {
+  CAPACITY = 128,
+  };
+
+enum Type : uint8_t {
+  Static,
+  Movable,
+  Animated,
+  };
+
+struct Material {
+  const void* tex     = nullptr;
+  uint8_t     alpha   = 0;
+  bool        isGhost = false;
+
+  bool operator == (const Material& o) const { return tex==o.tex && alpha==o.alpha && isGhost==o.isGhost; }
+  };
+
+struct Key {
+  Material    mat;
+  const void* morph = nullptr;
+  size_t      bones = 0;
+  Type        type  = Static;
+  };
+
+struct Bucket {
+  Key    key;
+  size_t size = 0;
+
+  bool accepts(const Key& k) const {
+    return key.mat==k.mat && key.morph==k.morph && key.type==k.type && key.bones==k.bones && size<CAPACITY;
+    }
+  };
+
+size_t bucketHash(const Key& k) {
+  return BucketChain<Bucket>::keyHash(k.mat.tex,k.morph,size_t(k.mat.alpha),k.mat.isGhost,k.bones,size_t(k.type));
+  }
+
+struct Objects {
+  std::vector<std::unique_ptr<Bucket>> buckets;
+  BucketChain<Bucket>                  bucketsByKey;
+
+  Bucket& getBucket(const Key& k) {
+    const size_t hash = bucketHash(k);
+    auto ret = bucketsByKey.find(hash,[&k](const Bucket& b){ return b.accepts(k); });
+    if(ret!=nullptr)
+      return *ret;
+    buckets.emplace_back(new Bucket{k,0});
+    bucketsByKey.push(hash,buckets.back().get());
+    return *buckets.back();
+    }
+  };
+
+}
+
+namespace Legacy {
+
+// previous VisualObjects: every bucket is compared, oldest first
+struct Objects {
+  std::list<Bucket> buckets;
+
+  Bucket& getBucket(const Key& k) {
+    for(auto& i:buckets)
+      if(i.accepts(k))
+        return i;
+    buckets.push_back(Bucket{k,0});
+    return buckets.back();
+    }
+  };
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(23);
+
+  // textures: mostly unique, few popular (walls, ground, wood)
+  std::vector<int> textures(3000);
+  std::vector<int> anims(40);
+  std::geometric_distribution<size_t> popular(0.004);
+  std::uniform_real_distribution<float> u(0.f,1.f);
+
+  // meshes of world: 1..4 submeshes each
+  const size_t meshCount = 1500, vobCount = 30000;
+  std::vector<std::vector<Key>> meshes(meshCount);
+  for(size_t i=0; i<meshCount; ++i) {
+    const bool movable = (i%9==0);  // doors, chests, beds
+    const bool morph   = (i%53==0); // water, flags
+    for(size_t s=0; s<1+i%4; ++s) {
+      Key k;
+      k.mat.tex     = &textures[popular(rng)%textures.size()];
+      k.mat.alpha   = uint8_t((i%17==0) ? 2 : 0);
+      k.mat.isGhost = (i%211==0);
+      k.morph       = morph ? &anims[i%anims.size()] : nullptr;
+      k.type        = movable ? Movable : Static;
+      meshes[i].push_back(k);
+      }
+    }
+  std::vector<size_t> vobs(vobCount);
+  for(auto& v:vobs)
+    v = popular(rng)%meshCount;
+
+  // npc's: skinned body, head and armor; few textures, shared by everybody
+  std::vector<std::vector<Key>> npcMeshes(60);
+  for(size_t i=0; i<npcMeshes.size(); ++i)
+    for(size_t s=0; s<3+i%4; ++s) {
+      Key k;
+      k.mat.tex = &textures[(i*7+s)%200];
+      k.bones   = 20+(i%3)*10;
+      k.type    = Animated;
+      npcMeshes[i].push_back(k);
+      }
+  struct Spawn {
+    size_t mesh;
+    bool   despawn;
+    size_t victim;
+    };
+  std::vector<Spawn> spawns(4000);
+  for(size_t i=0; i<spawns.size(); ++i) {
+    spawns[i].mesh    = size_t(u(rng)*float(npcMeshes.size()))%npcMeshes.size();
+    spawns[i].despawn = (i>=500 && u(rng)<0.8f);
+    spawns[i].victim  = size_t(u(rng)*float(i));
+    }
+
+  // same population is replayed for both; bucket of every instance is recorded
+  struct Alive {
+    std::vector<Bucket*> sub;
+    bool                 alive = true;
+    };
+  auto replay = [&](auto& obj, std::vector<Bucket*>& world, std::vector<Alive>& npc, double& tLoad, double& tSpawn) {
+    auto t0 = Clock::now();
+    for(auto v:vobs)
+      for(auto& k:meshes[v]) {
+        auto& b = obj.getBucket(k);
+        b.size++;
+        world.push_back(&b);
+        }
+    auto t1 = Clock::now();
+    for(auto& s:spawns) {
+      if(s.despawn && npc[s.victim].alive) {
+        for(auto b:npc[s.victim].sub)
+          b->size--;
+        npc[s.victim].alive = false;
+        }
+      Alive a;
+      for(auto& k:npcMeshes[s.mesh]) {
+        auto& b = obj.getBucket(k);
+        b.size++;
+        a.sub.push_back(&b);
+        }
+      npc.push_back(std::move(a));
+      }
+    auto t2 = Clock::now();
+    tLoad  = std::chrono::duration<double,std::milli>(t1-t0).count();
+    tSpawn = std::chrono::duration<double,std::milli>(t2-t1).count();
+    };
+
+  Legacy::Objects      legacy;
+  Objects              hashed;
+  std::vector<Bucket*> worldL, worldH;
+  std::vector<Alive>   npcL, npcH;
+  double tLoadL = 0, tSpawnL = 0, tLoadH = 0, tSpawnH = 0;
+  replay(legacy,worldL,npcL,tLoadL,tSpawnL);
+  replay(hashed,worldH,npcH,tLoadH,tSpawnH);
+
+  std::printf("instances: world %zu, npc %zu; buckets: legacy %zu, hashed %zu (%zu keys)\n",
+              worldH.size(),npcH.size(),legacy.buckets.size(),hashed.buckets.size(),hashed.bucketsByKey.size());
+  std::printf("world load: legacy %.3f ms, hashed %.3f ms; npc spawns: legacy %.3f ms, hashed %.3f ms\n",
+              tLoadL,tLoadH,tSpawnL,tSpawnH);
+
+  // world load: one non-full bucket per key, so both create buckets in same order and fill them alike
+  std::unordered_map<const Bucket*,size_t> idL, idH;
+  for(auto& b:legacy.buckets) {
+    const size_t id = idL.size();
+    idL[&b] = id;
+    }
+  for(size_t i=0; i<hashed.buckets.size(); ++i)
+    idH[hashed.buckets[i].get()] = i;
+  size_t wrong = 0;
+  for(size_t i=0; i<worldH.size(); ++i)
+    if(idL[worldL[i]]!=idH[worldH[i]])
+      ++wrong;
+  // npc's land in bucket of own key
+  for(size_t i=0; i<npcH.size(); ++i)
+    for(size_t s=0; s<npcH[i].sub.size(); ++s) {
+      auto& k = npcMeshes[spawns[i].mesh][s];
+      auto& b = npcH[i].sub[s]->key;
+      if(!(b.mat==k.mat) || b.bones!=k.bones || b.type!=k.type)
+        ++wrong;
+      }
+  // no overfilled buckets
+  size_t over = 0, live = 0;
+  for(auto& b:hashed.buckets) {
+    over += (b->size>CAPACITY) ? 1 : 0;
+    live += b->size;
+    }
+  size_t liveL = 0;
+  for(auto& b:legacy.buckets)
+    liveL += b.size;
+
+  CHECK(wrong==0);
+  CHECK(over==0);
+  CHECK(live==liveL);
+  // new bucket only when every bucket of its key is full: holes of despawned npc's are reused, not only newest bucket
+  CHECK(hashed.buckets.size()==legacy.buckets.size());
+
+  return TEST_RESULT();
+  }
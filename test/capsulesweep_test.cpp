@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "physics/capsulesweep.h"
+
+#include "testing.h"
+
+// Segment vs npc capsule, as used for projectiles: exact cases, dense sampling reference and a
+// benchmark of one frame of projectiles against a crowd, with x-sorted sweep against brute force.
+namespace {
+
+struct Capsule {
+  btVector3 pa, pb;
+  float     r = 0;
+  };
+
+float distToAxis(const Capsule& c, const btVector3& p) {
+  const btVector3 ba = c.pb-c.pa;
+  const float     t  = std::max(0.f,std::min(1.f,(p-c.pa).dot(ba)/ba.dot(ba)));
+  return (p-(c.pa+ba*t)).length();
+  }
+
+// first sample inside of capsule, or -1; closest approach to the axis in `dist`
+float sampled(const Capsule& c, const btVector3& s, const btVector3& e, int steps, float& dist) {
+  dist = std::numeric_limits<float>::max();
+  for(int i=0; i<=steps; ++i) {
+    const float f = float(i)/float(steps);
+    const float d = distToAxis(c,s+(e-s)*f);
+    dist = std::min(dist,d);
+    if(d<=c.r)
+      return f;
+    }
+  return -1.f;
+  }
+
+}
+
+int main() {
+  const Capsule npc = {btVector3(0,50,0),btVector3(0,150,0),40.f};
+  float frac = -1;
+
+  // through the body
+  CHECK(capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(-200,100,0),btVector3(200,100,0),frac));
+  CHECK(std::fabs(frac-160.f/400.f)<1e-4f);
+  // onto top cap
+  CHECK(capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(0,400,0),btVector3(0,0,0),frac));
+  CHECK(std::fabs(frac-(400.f-190.f)/400.f)<1e-4f);
+  // past and short of it
+  CHECK(!capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(-200,100,50),btVector3(200,100,50),frac));
+  CHECK(!capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(-200,100,0),btVector3(-50,100,0),frac));
+  // starting inside: hit at 0, for zero-length segment as well
+  frac = -1;
+  CHECK(capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(10,100,0),btVector3(200,100,0),frac));
+  CHECK(frac==0.f);
+  CHECK(capsuleSweep(npc.pa,npc.pb,npc.r,btVector3(0,30,0),btVector3(0,30,0),frac));
+  CHECK(frac==0.f);
+
+  // random segments against dense sampling
+  std::mt19937                          rng(11);
+  std::uniform_real_distribution<float> coord(-300.f,300.f);
+  size_t mismatch = 0, hits = 0;
+  for(int i=0; i<4000; ++i) {
+    const btVector3 s(coord(rng),coord(rng)+100.f,coord(rng));
+    const btVector3 e(coord(rng),coord(rng)+100.f,coord(rng));
+    float           dist = 0;
+    const float     ref  = sampled(npc,s,e,4096,dist);
+    float           f    = -1;
+    const bool      hit  = capsuleSweep(npc.pa,npc.pb,npc.r,s,e,f);
+    // grazing segments may fall in between of samples
+    if(hit!=(ref>=0.f) && std::fabs(dist-npc.r)>0.5f)
+      ++mismatch;
+    if(hit && ref>=0.f) {
+      ++hits;
+      if(std::fabs(f-ref)>1.f/4096.f+1e-4f)
+        ++mismatch;
+      }
+    }
+  CHECK(hits>0);
+  CHECK(mismatch==0);
+
+  // benchmark: frame of projectiles against a crowd
+  struct Body {
+    Capsule c;
+    float   x = 0;
+    };
+  std::vector<Body> crowd(2000);
+  std::uniform_real_distribution<float> field(0.f,20000.f);
+  for(auto& i:crowd) {
+    const float x = field(rng), z = field(rng);
+    i.c = {btVector3(x,50,z),btVector3(x,150,z),40.f};
+    i.x = x;
+    }
+  std::sort(crowd.begin(),crowd.end(),[](const Body& a, const Body& b){ return a.x<b.x; });
+  std::vector<std::pair<btVector3,btVector3>> shots(500);
+  for(auto& i:shots) {
+    const btVector3 s(field(rng),100.f,field(rng));
+    const btVector3 d(coord(rng),0,coord(rng));
+    i = std::make_pair(s,s+d);
+    }
+
+  auto closest = [](const Body* b, const Body* e, const btVector3& s, const btVector3& d) {
+    const Body* ret = nullptr;
+    float       fr  = 1.f;
+    for(; b!=e; ++b) {
+      float f = 0;
+      if(capsuleSweep(b->c.pa,b->c.pb,b->c.r,s,d,f) && f<=fr) {
+        fr  = f;
+        ret = b;
+        }
+      }
+    return ret;
+    };
+
+  using Clock = std::chrono::steady_clock;
+  std::vector<const Body*> brute(shots.size()), sweep(shots.size());
+  auto t0 = Clock::now();
+  for(size_t i=0; i<shots.size(); ++i)
+    brute[i] = closest(crowd.data(),crowd.data()+crowd.size(),shots[i].first,shots[i].second);
+  auto t1 = Clock::now();
+  for(size_t i=0; i<shots.size(); ++i) {
+    auto& s  = shots[i].first;
+    auto& e  = shots[i].second;
+    auto  x0 = std::min(s.x(),e.x())-40.f, x1 = std::max(s.x(),e.x())+40.f;
+    auto  l  = std::lower_bound(crowd.begin(),crowd.end(),x0,[](const Body& b, float x){ return b.x<x; });
+    auto  r  = std::upper_bound(l,crowd.end(),x1,[](float x, const Body& b){ return x<b.x; });
+    sweep[i] = closest(crowd.data()+(l-crowd.begin()),crowd.data()+(r-crowd.begin()),s,e);
+    }
+  auto t2 = Clock::now();
+
+  size_t hit = 0;
+  for(size_t i=0; i<shots.size(); ++i) {
+    CHECK(brute[i]==sweep[i]);
+    if(sweep[i]!=nullptr)
+      ++hit;
+    }
+  std::printf("shots: %zu, npc's: %zu, hits: %zu; brute force %.3f ms, x-sorted sweep %.3f ms\n",
+              shots.size(),crowd.size(),hit,
+              std::chrono::duration<double,std::milli>(t1-t0).count(),
+              std::chrono::duration<double,std::milli>(t2-t1).count());
+  return TEST_RESULT();
+  }
@@ -0,0 +1,127 @@
+#include <random>
+#include <vector>
+
+#include "graphics/dirtyranges.h"
+
+#include "testing.h"
+
+using Range = DirtyRanges::Range;
+
+static bool equal(const std::vector<Range>& r, std::initializer_list<Range> expect) {
+  if(r.size()!=expect.size())
+    return false;
+  size_t i = 0;
+  for(auto& e:expect) {
+    if(r[i].begin!=e.begin || r[i].end!=e.end)
+      return false;
+    ++i;
+    }
+  return true;
+  }
+
+static void testResize() {
+  DirtyRanges        d;
+  std::vector<Range> r;
+
+  // new elements are dirty in every frame
+  d.resize(10);
+  d.take(0,r,0,64);
+  CHECK(equal(r,{{0,10}}));
+  d.take(0,r,0,64);
+  CHECK(r.empty());
+
+  // growth keeps pending bits and marks only the tail
+  d.resize(200);
+  d.take(0,r,0,64);
+  CHECK(equal(r,{{10,200}}));
+  d.take(1,r,0,64);
+  CHECK(equal(r,{{0,200}}));
+  CHECK(!d.isDirty(0));
+  CHECK(!d.isDirty(1));
+  }
+
+static void testCoalesce() {
+  DirtyRanges        d;
+  std::vector<Range> r;
+  d.resize(256);
+  d.clear(0);
+  d.clear(1);
+
+  d.mark(3,4);
+  d.mark(5,6);
+  d.mark(63,66); // crosses word boundary
+  d.mark(200,201);
+  d.take(0,r,0,64);
+  CHECK(equal(r,{{3,4},{5,6},{63,66},{200,201}}));
+
+  // same marks, seen by other frame, with gap of one element merged
+  d.take(1,r,1,64);
+  CHECK(equal(r,{{3,6},{63,66},{200,201}}));
+
+  // too many ranges collapse into one
+  d.mark(1,2);
+  d.mark(100,101);
+  d.mark(250,251);
+  d.take(0,r,0,2);
+  CHECK(equal(r,{{1,251}}));
+
+  // out of range marks are clipped
+  d.mark(250,1000);
+  d.take(1,r,0,64);
+  CHECK(equal(r,{{1,2},{100,101},{250,256}}));
+  }
+
+static void testMarkAll() {
+  DirtyRanges        d;
+  std::vector<Range> r;
+  d.resize(70);
+  d.clear(0);
+  d.markAll();
+  d.take(0,r,0,64);
+  CHECK(equal(r,{{0,70}}));
+  }
+
+// reference: plain per-element flags, coalesced by the same rule
+static void testRandom() {
+  std::mt19937       rng(1);
+  DirtyRanges        d;
+  std::vector<Range> r;
+  const size_t       size = 300;
+  d.resize(size);
+  d.clear(0);
+
+  for(int iter=0; iter<1000; ++iter) {
+    std::vector<bool> ref(size,false);
+    const size_t      cnt = rng()%20;
+    for(size_t k=0; k<cnt; ++k) {
+      const size_t b = rng()%size;
+      const size_t e = b+rng()%70;
+      d.mark(b,e);
+      for(size_t i=b; i<e && i<size; ++i)
+        ref[i] = true;
+      }
+
+    const size_t gap = rng()%4;
+    d.take(0,r,gap,size);
+
+    std::vector<bool> got(size,false);
+    for(size_t i=0; i<r.size(); ++i) {
+      CHECK(r[i].begin<r[i].end && r[i].end<=size);
+      CHECK(ref[r[i].begin] && ref[r[i].end-1]);
+      if(i>0)
+        CHECK(r[i].begin>r[i-1].end+gap);
+      for(size_t j=r[i].begin; j<r[i].end; ++j)
+        got[j] = true;
+      }
+    for(size_t i=0; i<size; ++i)
+      CHECK(!ref[i] || got[i]);
+    }
+  }
+
+int main() {
+  testResize();
+  testCoalesce();
+  testMarkAll();
+  testRandom();
+  return TEST_RESULT();
+  }
@@ -0,0 +1,77 @@
+#include <random>
+#include <vector>
+
+#include "graphics/drawlist.h"
+
+#include "testing.h"
+
+enum {
+  CAPACITY = 128,
+  CAMERAS  = 3,
+  };
+
+struct Slot {
+  bool empty  = false;
+  bool morph  = false;
+  bool visible[CAMERAS] = {};
+  };
+
+// reference: per-slot loop of ObjectsBucket::drawCommon, before compaction
+static std::vector<uint8_t> reference(const std::vector<Slot>& slots, size_t c) {
+  std::vector<uint8_t> ret;
+  for(size_t i=0; i<slots.size(); ++i) {
+    auto& v = slots[i];
+    if(v.empty)
+      continue;
+    if(!v.morph && !v.visible[c])
+      continue;
+    ret.push_back(uint8_t(i));
+    }
+  return ret;
+  }
+
+static void compare(const std::vector<Slot>& slots) {
+  uint8_t mask[CAPACITY] = {};
+  for(size_t i=0; i<slots.size(); ++i)
+    mask[i] = DrawList::slotMask(slots[i].empty,slots[i].morph,slots[i].visible,CAMERAS);
+
+  uint8_t ids  [CAMERAS][CAPACITY] = {};
+  size_t  sizes[CAMERAS] = {};
+  DrawList::compact(mask,slots.size(),CAMERAS,ids[0],CAPACITY,sizes);
+
+  for(size_t c=0; c<CAMERAS; ++c) {
+    auto ref = reference(slots,c);
+    CHECK(sizes[c]==ref.size());
+    if(sizes[c]!=ref.size())
+      continue;
+    for(size_t i=0; i<ref.size(); ++i)
+      CHECK(ids[c][i]==ref[i]);
+    }
+  }
+
+int main() {
+  // degenerate buckets
+  compare({});
+  compare(std::vector<Slot>(CAPACITY));
+
+  std::vector<Slot> all(CAPACITY);
+  for(auto& i:all)
+    i.morph = true;
+  compare(all);
+
+  // random occupancy and visibility
+  std::mt19937 rng(1);
+  for(int iter=0; iter<2000; ++iter) {
+    std::vector<Slot> slots(rng()%(CAPACITY+1));
+    const auto        density = rng()%5;
+    for(auto& s:slots) {
+      s.empty = (rng()%4==0);
+      s.morph = (rng()%16==0);
+      for(auto& v:s.visible)
+        v = (rng()%4)<density;
+      }
+    compare(slots);
+    }
+
+  return TEST_RESULT();
+  }
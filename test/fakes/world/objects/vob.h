@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Tempest/Vec>
+
+// Stand-in for Vob in headless tests: spatial indexes only need position of an object
+class Vob {
+  public:
+    virtual ~Vob() = default;
+
+    Tempest::Vec3 position() const { return pos; }
+    void          setPosition(const Tempest::Vec3& p) { pos = p; }
+
+  private:
+    Tempest::Vec3 pos;
+  };
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "graphics/mesh/packedanim.h"
+#include "graphics/mesh/animmath.h"
+
+#include "testing.h"
+
+// Compressed animation samples: error, memory and decode cost against uncompressed SoA samples.
+// Sequences mimic humanoid .MAN: most finger and toe tracks are constant, slots and some bones move linearly,
+// limbs swing, root carries mocap noise.
+namespace {
+
+const size_t tracks       = PackedAnim::TRACKS;
+const float  rotTolerance = PackedAnim::ROT_TOLERANCE;
+const float  posTolerance = PackedAnim::POS_TOLERANCE;
+
+struct Sequence {
+  size_t             frames = 0;
+  std::vector<float> soa;
+  };
+
+void quat(float ax, float ay, float az, float angle, float* q) {
+  const float l = std::sqrt(ax*ax+ay*ay+az*az);
+  const float s = std::sin(angle*0.5f)/l;
+  q[0] = ax*s;
+  q[1] = ay*s;
+  q[2] = az*s;
+  q[3] = std::cos(angle*0.5f);
+  }
+
+Sequence mkSequence(size_t count, size_t stride, size_t frames, std::mt19937& rng) {
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+  std::normal_distribution<float>       noise(0.f,0.002f);
+
+  Sequence s;
+  s.frames = frames;
+  s.soa.assign(frames*stride*tracks,0.f);
+  for(size_t i=0; i<count; ++i) {
+    const float ax = u(rng)+1.5f, ay = u(rng), az = u(rng);
+    const float amp = std::fabs(u(rng))+0.1f, freq = std::fabs(u(rng))*0.3f+0.05f, ph = u(rng)*3.f;
+    const float px = u(rng)*20.f, py = u(rng)*20.f, pz = u(rng)*20.f;
+    const size_t kind = (i==0) ? 3 : (i%5<2 ? 0 : i%5);
+    for(size_t f=0; f<frames; ++f) {
+      float* dst = &s.soa[f*stride*tracks];
+      float  q[4], p[3] = {px,py,pz};
+      switch(kind) {
+        case 0: // constant
+          quat(ax,ay,az,amp,q);
+          break;
+        case 2: // linear turn
+          quat(ax,ay,az,amp*float(f)/float(frames),q);
+          p[1] += float(f)*0.5f;
+          break;
+        case 3: // root: walk cycle with mocap noise
+          quat(ax,ay,az,amp*std::sin(float(f)*freq+ph)+noise(rng),q);
+          p[0] += float(f)*2.f+noise(rng)*50.f;
+          p[1] += std::sin(float(f)*0.4f)*3.f;
+          break;
+        default: // swing
+          quat(ax,ay,az,amp*std::sin(float(f)*freq+ph),q);
+          break;
+        }
+      for(size_t c=0; c<4; ++c)
+        dst[c*stride+i] = q[c];
+      for(size_t c=0; c<3; ++c)
+        dst[(4+c)*stride+i] = p[c];
+      }
+    }
+  for(size_t f=0; f<frames; ++f)
+    for(size_t i=count; i<stride; ++i)
+      s.soa[f*stride*tracks+3*stride+i] = 1.f;
+  return s;
+  }
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(3);
+
+  const size_t count  = 59;
+  const size_t stride = (count+3)/4*4;
+
+  std::vector<Sequence>   seq;
+  std::vector<PackedAnim> packed;
+  size_t rawMem = 0, packedMem = 0;
+  for(size_t i=0; i<64; ++i) {
+    seq.push_back(mkSequence(count,stride,20+(i*37)%180,rng));
+    auto& s = seq.back();
+    packed.emplace_back(s.soa.data(),s.frames,count,stride,rotTolerance,posTolerance);
+    rawMem    += s.soa.size()*sizeof(float);
+    packedMem += packed.back().memoryUsage();
+    }
+
+  // error of every decoded frame
+  std::vector<float> out(stride*tracks);
+  float  rotErr = 0, posErr = 0, posBound = 0;
+  size_t pad    = 0;
+  for(size_t i=0; i<seq.size(); ++i) {
+    auto& s = seq[i];
+    CHECK(packed[i].frameCount()==s.frames);
+    for(size_t f=0; f<s.frames; ++f) {
+      const float* ref = &s.soa[f*stride*tracks];
+      packed[i].frame(f,out.data());
+      for(size_t n=0; n<count; ++n) {
+        float d = 0;
+        for(size_t c=0; c<4; ++c)
+          d += out[c*stride+n]*ref[c*stride+n];
+        rotErr = std::max(rotErr,2.f*std::acos(std::min(1.f,std::fabs(d))));
+        for(size_t c=4; c<7; ++c)
+          posErr = std::max(posErr,std::fabs(out[c*stride+n]-ref[c*stride+n]));
+        }
+      for(size_t n=count; n<stride; ++n)
+        for(size_t c=0; c<tracks; ++c)
+          if(out[c*stride+n]!=ref[c*stride+n])
+            ++pad;
+      }
+    // quantization step of positions: per track range over 16 bits
+    for(size_t n=0; n<count; ++n)
+      for(size_t c=4; c<7; ++c) {
+        float mn = s.soa[c*stride+n], mx = mn;
+        for(size_t f=0; f<s.frames; ++f) {
+          mn = std::min(mn,s.soa[f*stride*tracks+c*stride+n]);
+          mx = std::max(mx,s.soa[f*stride*tracks+c*stride+n]);
+          }
+        posBound = std::max(posBound,(mx-mn)/65535.f);
+        }
+    }
+  posBound += posTolerance;
+
+  // decode cost: blend of two frames for 1000 poses, as Pose::updateFrame does
+  const size_t poses = 1000;
+  std::vector<float> tmpA, tmpB, smp(stride*tracks);
+  double tRaw = 0, tPacked = 0;
+  float  sum  = 0;
+  for(int pass=0; pass<2; ++pass) {
+    auto t0 = Clock::now();
+    for(size_t p=0; p<poses; ++p) {
+      auto&        s  = seq[p%seq.size()];
+      const size_t fa = (p*7)%s.frames, fb = (fa+1)%s.frames;
+      const float* a  = &s.soa[fa*stride*tracks];
+      const float* b  = &s.soa[fb*stride*tracks];
+      if(pass==1) {
+        tmpA.resize(stride*tracks);
+        tmpB.resize(stride*tracks);
+        packed[p%seq.size()].frame(fa,tmpA.data());
+        packed[p%seq.size()].frame(fb,tmpB.data());
+        a = tmpA.data();
+        b = tmpB.data();
+        }
+      mix(a,b,0.3f,count,stride,smp.data());
+      sum += smp[4*stride];
+      }
+    auto t1 = Clock::now();
+    (pass==0 ? tRaw : tPacked) += std::chrono::duration<double,std::milli>(t1-t0).count();
+    }
+
+  std::printf("sequences: %zu, memory: raw %zu kb, packed %zu kb (%.1fx)\n",
+              seq.size(),rawMem/1024,packedMem/1024,double(rawMem)/double(packedMem));
+  std::printf("max error: rotation %g rad (tolerance %g), position %g (bound %g)\n",
+              double(rotErr),double(rotTolerance),double(posErr),double(posBound));
+  std::printf("%zu poses: raw %.3f ms, packed %.3f ms (%.2f us per decoded frame) [%g]\n",
+              poses,tRaw,tPacked,tPacked*1000.0/double(2*poses),double(sum));
+
+  // quantization of smallest-three in 15 bits adds about 1e-4 rad
+  CHECK(rotErr<rotTolerance+0.0005f);
+  CHECK(posErr<=posBound);
+  CHECK(pad==0);
+  CHECK(packedMem*3<rawMem);
+
+  // one frame and constant sequences
+  {
+    auto s = mkSequence(count,stride,1,rng);
+    PackedAnim p(s.soa.data(),1,count,stride,rotTolerance,posTolerance);
+    p.frame(0,out.data());
+    float e = 0;
+    for(size_t i=0; i<out.size(); ++i)
+      e = std::max(e,std::fabs(out[i]-s.soa[i]));
+    CHECK(e<0.01f);
+    CHECK(p.memoryUsage()<s.soa.size()*sizeof(float)+sizeof(PackedAnim)+count*64);
+  }
+  CHECK(!PackedAnim::canPack(0));
+  CHECK(!PackedAnim::canPack(0x10000));
+
+  return TEST_RESULT();
+  }
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "world/pointgrid.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Npc index: crowd walks slowly over a world, with occasional teleports; every tick perception-like queries
+// are answered by the grid and checked against linear search over all npc's, as WorldObjects did before.
+static void linear(const std::vector<Vec3>& pos, const Vec3& p, float R, std::vector<uint32_t>& out) {
+  out.clear();
+  for(size_t i=0; i<pos.size(); ++i) {
+    float dx = pos[i].x-p.x;
+    float dz = pos[i].z-p.z;
+    if(dx*dx+dz*dz<=R*R)
+      out.push_back(uint32_t(i));
+    }
+  }
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+
+  const float worldSize = 60000.f;
+  const float R         = 3000.f; // typical senses range
+  const size_t ticks    = 200;
+
+  std::mt19937 rng(13);
+  std::uniform_real_distribution<float> coord(-worldSize*0.5f,worldSize*0.5f);
+  std::uniform_real_distribution<float> step (-4.f,4.f);
+
+  for(size_t count:{250u,1000u,4000u}) {
+    std::vector<Vec3> pos(count), vel(count);
+    for(size_t i=0; i<count; ++i) {
+      pos[i] = Vec3(coord(rng),0,coord(rng));
+      // slow walkers: never move far enough in one tick, to be noticed by a drift threshold
+      vel[i] = Vec3(step(rng),0,step(rng));
+      }
+
+    PointGrid grid;
+    grid.build(pos);
+
+    std::vector<uint32_t> a, b;
+    double   tGrid = 0, tLinear = 0;
+    size_t   found = 0, queries = 0, wrong = 0;
+    for(size_t t=0; t<ticks; ++t) {
+      for(size_t i=0; i<count; ++i) {
+        pos[i] = pos[i]+vel[i]*8.f;
+        if(i%97==t%97)
+          pos[i] = Vec3(coord(rng),0,coord(rng)); // teleport
+        grid.move(uint32_t(i),pos[i]);
+        }
+
+      for(size_t q=0; q<count; q+=count/50) {
+        const Vec3 p = pos[q];
+        auto t0 = Clock::now();
+        grid.find(p,R,a);
+        auto t1 = Clock::now();
+        linear(pos,p,R,b);
+        auto t2 = Clock::now();
+        tGrid   += std::chrono::duration<double,std::milli>(t1-t0).count();
+        tLinear += std::chrono::duration<double,std::milli>(t2-t1).count();
+        found   += a.size();
+        wrong   += (a==b) ? 0 : 1;
+        ++queries;
+        }
+      }
+
+    std::printf("npc: %5zu, queries: %zu, found avg: %.1f, grid: %.3f ms, linear: %.3f ms\n",
+                count,queries,double(found)/double(queries),tGrid,tLinear);
+    CHECK(wrong==0);
+    CHECK(grid.size()==count);
+    }
+
+  // re-bucketing keeps grid consistent for moves in both directions and over many cells
+  std::vector<Vec3> pos = {Vec3(0,0,0),Vec3(500,0,500),Vec3(-1500,0,200),Vec3(5000,0,-5000)};
+  PointGrid grid;
+  grid.build(pos);
+  std::vector<uint32_t> out;
+
+  pos[0] = Vec3(9999,0,9999);   grid.move(0,pos[0]);
+  pos[3] = Vec3(-9999,0,-9999); grid.move(3,pos[3]);
+  pos[1] = Vec3(999,0,501);     grid.move(1,pos[1]);
+  pos[1] = Vec3(1001,0,501);    grid.move(1,pos[1]);
+
+  grid.find(Vec3(9999,0,9999),1,out);
+  CHECK(out==std::vector<uint32_t>{0});
+  grid.find(Vec3(-9999,0,-9999),1,out);
+  CHECK(out==std::vector<uint32_t>{3});
+  grid.find(Vec3(1000,0,500),2,out);
+  CHECK(out==std::vector<uint32_t>{1});
+  grid.find(Vec3(0,0,0),20000,out);
+  CHECK(out.size()==4);
+
+  return TEST_RESULT();
+  }
@@ -0,0 +1,282 @@
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "physics/collisionworld.h"
+#include "physics/dynamicworld.h"
+#include "utils/prefetched.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+// Determinism of two-phase npc tick: agents probe ground of a landscape mesh with objects on it, like MoveAlgo::rayMain.
+// Parallel phase prefetches the probe of each agent with CollisionWorld::rayEpoch; serial phase moves, adds and removes
+// objects right in front of other agents. Final state must match plain serial tick exactly.
+namespace {
+
+struct Land {
+  std::vector<btScalar> vbo;
+  std::vector<int>      ibo;
+  std::unique_ptr<btTriangleIndexVertexArray> mesh;
+  std::unique_ptr<btBvhTriangleMeshShape>     shape;
+  btCollisionObject                           obj;
+
+  static float height(int x, int z) { return float((x*7+z*13)%5)*4.f; }
+
+  Land(int n, float cell) {
+    for(int z=0; z<=n; ++z)
+      for(int x=0; x<=n; ++x) {
+        vbo.push_back(float(x)*cell);
+        vbo.push_back(height(x,z));
+        vbo.push_back(float(z)*cell);
+        }
+    for(int z=0; z<n; ++z)
+      for(int x=0; x<n; ++x) {
+        const int i = z*(n+1)+x;
+        int quad[] = {i, i+n+1, i+1, i+1, i+n+1, i+n+2};
+        ibo.insert(ibo.end(),std::begin(quad),std::end(quad));
+        }
+    mesh.reset(new btTriangleIndexVertexArray(int(ibo.size()/3),ibo.data(),3*int(sizeof(int)),
+                                              int(vbo.size()/3),vbo.data(),3*int(sizeof(btScalar))));
+    shape.reset(new btBvhTriangleMeshShape(mesh.get(),true,true));
+    obj.setCollisionShape(shape.get());
+    obj.setUserIndex(DynamicWorld::C_Landscape);
+    obj.setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT);
+    }
+  };
+
+// crate, that agents push around: static object, as seen by land rays
+struct Crate {
+  btCollisionObject obj;
+  bool              inWorld = false;
+  };
+
+struct RayKey {
+  float x = 0, z = 0;
+  bool operator == (const RayKey& r) const { return x==r.x && z==r.z; }
+  };
+
+struct Agent {
+  float x = 0, z = 0, vx = 0, vz = 0, y = 0;
+  Prefetched<RayKey,float> pref;
+
+  RayKey next() const { return RayKey{x+vx,z+vz}; }
+  };
+
+enum Mode {
+  Serial,
+  TwoPhase,
+  IgnoreEpoch, // broken consumer: takes prefetched value of any epoch
+  };
+
+const int   n    = 32;
+const float cell = 100.f;
+const float half = 40.f;
+
+struct Sim {
+  CollisionWorld     world;
+  Land               land{n,cell};
+  btBoxShape         crateShape{btVector3(half,half,half)};
+  std::vector<Crate> crates = std::vector<Crate>(24);
+  std::vector<Agent> agents = std::vector<Agent>(400);
+  size_t             hits   = 0;
+  size_t             probes = 0;
+
+  Sim() {
+    world.addCollisionObject(&land.obj);
+    for(size_t i=0; i<crates.size(); ++i) {
+      auto& c = crates[i].obj;
+      c.setCollisionShape(&crateShape);
+      c.setUserIndex(DynamicWorld::C_Object);
+      c.setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT);
+      place(crates[i],200.f+float(i*113%2800),200.f+float(i*197%2800));
+      }
+    for(size_t i=0; i<agents.size(); ++i) {
+      auto& a = agents[i];
+      a.x  = 100.f+float(i*37%3000);
+      a.z  = 100.f+float(i*91%3000);
+      a.vx = float(int(i%7)-3)*3.f;
+      a.vz = float(int(i%5)-2)*4.f;
+      }
+    }
+
+  ~Sim() {
+    for(auto& c:crates)
+      if(c.inWorld)
+        world.removeCollisionObject(&c.obj);
+    world.removeCollisionObject(&land.obj);
+    }
+
+  void place(Crate& c, float x, float z) {
+    btTransform tr;
+    tr.setIdentity();
+    tr.setOrigin(btVector3(x,half,z));
+    if(!c.inWorld) {
+      c.obj.setWorldTransform(tr);
+      world.addCollisionObject(&c.obj);
+      c.inWorld = true;
+      } else {
+      world.setObjTransform(c.obj,tr);
+      }
+    }
+
+  // read only - same as DynamicWorld::landRay, as far as landscape and objects are concerned
+  float probe(const RayKey& k) const {
+    btTransform s, e;
+    s.setIdentity();
+    e.setIdentity();
+    s.setOrigin(btVector3(k.x,1000.f,k.z));
+    e.setOrigin(btVector3(k.x,-100.f,k.z));
+
+    btCollisionWorld::ClosestRayResultCallback cb(s.getOrigin(),e.getOrigin());
+    auto& objs = world.getCollisionObjectArray();
+    for(int i=0; i<objs.size(); ++i) {
+      auto* obj = objs[i];
+      btCollisionWorld::rayTestSingle(s,e,obj,obj->getCollisionShape(),obj->getWorldTransform(),cb);
+      }
+    return cb.hasHit() ? cb.m_hitPointWorld.y() : -100.f;
+    }
+
+  uint64_t epoch(Mode mode) const {
+    return mode==IgnoreEpoch ? 0 : world.rayEpoch();
+    }
+
+  void prefetch(Mode mode) {
+    const uint64_t ep = epoch(mode);
+    Workers::parallelFor(agents,[this,ep](Agent& a){
+      const RayKey k = a.next();
+      a.pref.set(k,ep,probe(k));
+      });
+    }
+
+  void tick(uint64_t t, Mode mode) {
+    if(mode!=Serial)
+      prefetch(mode);
+
+    for(size_t i=0; i<agents.size(); ++i) {
+      auto& a = agents[i];
+      // reaction to agent before in serial order: changes query after the prefetch
+      if(i>0 && (t+i)%11==0)
+        a.vx = -a.vx;
+
+      const RayKey k = a.next();
+      float        y = 0;
+      ++probes;
+      if(mode!=Serial && a.pref.take(k,epoch(mode),y))
+        ++hits; else
+        y = probe(k);
+      a.pref.reset();
+
+      a.x = k.x;
+      a.z = k.z;
+      a.y = y;
+      if(a.x<0 || a.x>float(n)*cell) a.vx = -a.vx;
+      if(a.z<0 || a.z>float(n)*cell) a.vz = -a.vz;
+
+      // now and then one agent drops a crate right in front of next one, or picks it up
+      if(t%4==3 && i==(t*37)%(agents.size()-1)) {
+        auto& c = crates[t%crates.size()];
+        auto  f = agents[i+1].next();
+        if(c.inWorld && (t/4)%3==2) {
+          world.removeCollisionObject(&c.obj);
+          c.inWorld = false;
+          } else {
+          place(c,f.x,f.z);
+          }
+        }
+      }
+    }
+
+  void run(uint64_t ticks, Mode mode) {
+    for(uint64_t t=0; t<ticks; ++t)
+      tick(t,mode);
+    }
+  };
+
+size_t mismatch(const Sim& a, const Sim& b) {
+  size_t cnt = 0;
+  for(size_t i=0; i<a.agents.size(); ++i) {
+    auto& l = a.agents[i];
+    auto& r = b.agents[i];
+    if(l.x!=r.x || l.z!=r.z || l.y!=r.y)
+      ++cnt;
+    }
+  return cnt;
+  }
+
+}
+
+int main() {
+  const uint64_t ticks = 40;
+
+  std::unique_ptr<Sim> serial(new Sim());
+  serial->run(ticks,Serial);
+
+  std::unique_ptr<Sim> twoPhase(new Sim());
+  twoPhase->run(ticks,TwoPhase);
+  std::printf("two-phase: %zu of %zu probes prefetched\n",twoPhase->hits,twoPhase->probes);
+  CHECK(mismatch(*serial,*twoPhase)==0);
+  // both paths are exercised: most probes come from parallel phase, some are refused
+  CHECK(twoPhase->hits>twoPhase->probes/2);
+  CHECK(twoPhase->hits<twoPhase->probes);
+
+  // epoch is what makes it work: consumer, that ignores it, walks over crates, that are no longer there
+  std::unique_ptr<Sim> broken(new Sim());
+  broken->run(ticks,IgnoreEpoch);
+  CHECK(mismatch(*serial,*broken)>0);
+
+  // every kind of change refuses prefetched value
+  Sim      sim;
+  auto&    c  = sim.crates[0];
+  RayKey   k  = {c.obj.getWorldTransform().getOrigin().x(),c.obj.getWorldTransform().getOrigin().z()};
+  float    y  = 0;
+  uint64_t ep = sim.world.rayEpoch();
+  Prefetched<RayKey,float> p;
+
+  p.set(k,ep,sim.probe(k));
+  CHECK(p.take(k,sim.world.rayEpoch(),y));
+  CHECK(std::fabs(y-2.f*half)<0.01f);
+
+  p.set(k,ep,y);
+  sim.place(c,k.x+500.f,k.z);
+  CHECK(sim.world.rayEpoch()!=ep);
+  CHECK(!p.take(k,sim.world.rayEpoch(),y));
+
+  ep = sim.world.rayEpoch();
+  p.set(k,ep,y);
+  sim.world.removeCollisionObject(&c.obj);
+  c.inWorld = false;
+  CHECK(!p.take(k,sim.world.rayEpoch(),y));
+
+  ep = sim.world.rayEpoch();
+  p.set(k,ep,y);
+  sim.place(c,k.x,k.z);
+  CHECK(!p.take(k,sim.world.rayEpoch(),y));
+
+  // npc's and items don't change land rays
+  ep = sim.world.rayEpoch();
+  btCollisionObject item;
+  item.setCollisionShape(&sim.crateShape);
+  item.setUserIndex(DynamicWorld::C_item);
+  sim.world.addCollisionObject(&item);
+  sim.world.removeCollisionObject(&item);
+  CHECK(sim.world.rayEpoch()==ep);
+
+  return TEST_RESULT();
+  }
@@ -0,0 +1,221 @@
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wfloat-conversion"
+#endif
+
+#include <BulletCollision/CollisionShapes/btBoxShape.h>
+#include <BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h>
+#include <BulletCollision/CollisionShapes/btTriangleIndexVertexArray.h>
+#include <BulletCollision/NarrowPhaseCollision/btRaycastCallback.h>
+
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "physics/collisionworld.h"
+#include "physics/dynamicworld.h"
+#include "physics/raybatch.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Ray traffic of one game tick: ground probes of every npc (MoveAlgo::rayMain), line of sight of perception
+// and focus, sound occlusion - over hilly landscape mesh with objects and items on it.
+// Same rays are answered one by one in submission order, as single DynamicWorld::ray calls did, and by RayBatch.
+namespace {
+
+const int   n    = 64;
+const float cell = 200.f;
+
+struct Land {
+  std::vector<btScalar> vbo;
+  std::vector<int>      ibo;
+  std::unique_ptr<btTriangleIndexVertexArray> mesh;
+  std::unique_ptr<btBvhTriangleMeshShape>     shape;
+  btCollisionObject                           obj;
+
+  static float height(int x, int z) {
+    return std::sin(float(x)*0.3f)*300.f + std::cos(float(z)*0.2f)*200.f + float((x*7+z*13)%5)*10.f;
+    }
+
+  Land() {
+    for(int z=0; z<=n; ++z)
+      for(int x=0; x<=n; ++x) {
+        vbo.push_back(float(x)*cell);
+        vbo.push_back(height(x,z));
+        vbo.push_back(float(z)*cell);
+        }
+    for(int z=0; z<n; ++z)
+      for(int x=0; x<n; ++x) {
+        const int i = z*(n+1)+x;
+        int quad[] = {i, i+n+1, i+1, i+1, i+n+1, i+n+2};
+        ibo.insert(ibo.end(),std::begin(quad),std::end(quad));
+        }
+    mesh.reset(new btTriangleIndexVertexArray(int(ibo.size()/3),ibo.data(),3*int(sizeof(int)),
+                                              int(vbo.size()/3),vbo.data(),3*int(sizeof(btScalar))));
+    shape.reset(new btBvhTriangleMeshShape(mesh.get(),true,true));
+    obj.setCollisionShape(shape.get());
+    obj.setUserIndex(DynamicWorld::C_Landscape);
+    obj.setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT);
+    }
+  };
+
+// same filter and flags as DynamicWorld::ray
+struct CallBack : btCollisionWorld::ClosestRayResultCallback {
+  using ClosestRayResultCallback::ClosestRayResultCallback;
+
+  bool needsCollision(btBroadphaseProxy* proxy0) const override {
+    auto obj=reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+    if(obj->getUserIndex()==DynamicWorld::C_Landscape || obj->getUserIndex()==DynamicWorld::C_Object)
+      return ClosestRayResultCallback::needsCollision(proxy0);
+    return false;
+    }
+  };
+
+struct Result {
+  bool  hit = false;
+  float x = 0, y = 0, z = 0;
+  bool operator == (const Result& r) const { return hit==r.hit && x==r.x && y==r.y && z==r.z; }
+  };
+
+struct Query {
+  Vec3 from, to;
+  };
+
+Result ray(const CollisionWorld& world, const Query& q) {
+  btVector3 s(q.from.x,q.from.y,q.from.z), e(q.to.x,q.to.y,q.to.z);
+  CallBack  cb{s,e};
+  cb.m_flags = btTriangleRaycastCallback::kF_KeepUnflippedNormal | btTriangleRaycastCallback::kF_FilterBackfaces;
+  world.rayTest(s,e,cb);
+
+  Result r;
+  r.hit = cb.hasHit();
+  if(r.hit) {
+    r.x = cb.m_hitPointWorld.x();
+    r.y = cb.m_hitPointWorld.y();
+    r.z = cb.m_hitPointWorld.z();
+    }
+  return r;
+  }
+
+const float half        = 60.f;
+const float padding     = 27.5f;   // DynamicWorld::ghostPadding
+const float worldHeight = 20000.f; // DynamicWorld::worldHeight
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(9);
+  std::uniform_real_distribution<float> coord(100.f,float(n)*cell-100.f);
+  std::uniform_real_distribution<float> u(-1.f,1.f);
+
+  CollisionWorld world;
+  Land           land;
+  btBoxShape     box{btVector3(half,half,half)};
+  std::vector<std::unique_ptr<btCollisionObject>> objs;
+  world.addCollisionObject(&land.obj);
+  // objects are seen by land rays, items are filtered out
+  for(size_t i=0; i<600; ++i) {
+    std::unique_ptr<btCollisionObject> o(new btCollisionObject());
+    const float x = coord(rng), z = coord(rng);
+    btTransform tr;
+    tr.setIdentity();
+    tr.setOrigin(btVector3(x,Land::height(int(x/cell),int(z/cell))+half,z));
+    o->setCollisionShape(&box);
+    o->setWorldTransform(tr);
+    o->setUserIndex(i%3==0 ? DynamicWorld::C_item : DynamicWorld::C_Object);
+    o->setCollisionFlags(btCollisionObject::CF_STATIC_OBJECT);
+    world.addCollisionObject(o.get());
+    objs.emplace_back(std::move(o));
+    }
+
+  // one tick of a crowd, in order rays are issued by npc's
+  const size_t npcCount = 500;
+  std::vector<Vec3> npc(npcCount);
+  for(auto& p:npc) {
+    p.x = coord(rng);
+    p.z = coord(rng);
+    p.y = Land::height(int(p.x/cell),int(p.z/cell))+20.f;
+    }
+  const Vec3 player = npc[0];
+
+  std::vector<Query> q;
+  for(size_t i=0; i<npcCount; ++i) {
+    auto& p = npc[i];
+    // ground probe
+    q.push_back({Vec3(p.x,p.y+padding,p.z),Vec3(p.x,p.y-worldHeight,p.z)});
+    // slope probe ahead
+    q.push_back({Vec3(p.x+u(rng)*40.f,p.y+50.f,p.z+u(rng)*40.f),Vec3(p.x+u(rng)*40.f,p.y-200.f,p.z+u(rng)*40.f)});
+    // perception: line of sight to a few others
+    for(size_t k=0; k<3; ++k) {
+      auto& o = npc[(i*31+k*17+1)%npcCount];
+      q.push_back({Vec3(p.x,p.y+180.f,p.z),Vec3(o.x,o.y+180.f,o.z)});
+      }
+    }
+  // sound occlusion: sources around the player
+  for(size_t i=0; i<64; ++i) {
+    auto& s = npc[(i*7)%npcCount];
+    q.push_back({Vec3(s.x,s.y+100.f,s.z),Vec3(player.x,player.y+180.f,player.z)});
+    }
+  // focus of player
+  for(size_t i=0; i<32; ++i) {
+    auto& o = npc[(i*13+5)%npcCount];
+    q.push_back({Vec3(player.x,player.y+180.f,player.z),Vec3(o.x,o.y+100.f,o.z)});
+    }
+
+  std::vector<Result> legacy(q.size()), batch(q.size());
+  double tLegacy = 0, tBatch = 0;
+  const int runs = 5;
+  for(int r=0; r<runs; ++r) {
+    auto t0 = Clock::now();
+    for(size_t i=0; i<q.size(); ++i) {
+      world.updateAabbs();
+      legacy[i] = ray(world,q[i]);
+      }
+    auto t1 = Clock::now();
+    world.updateAabbs();
+    RayBatch::run(q,[&](size_t i){
+      batch[i] = ray(world,q[i]);
+      });
+    auto t2 = Clock::now();
+    const double l = std::chrono::duration<double,std::milli>(t1-t0).count();
+    const double b = std::chrono::duration<double,std::milli>(t2-t1).count();
+    tLegacy = (r==0 ? l : std::min(tLegacy,l));
+    tBatch  = (r==0 ? b : std::min(tBatch, b));
+    }
+
+  size_t hits = 0, wrong = 0;
+  for(size_t i=0; i<q.size(); ++i) {
+    hits  += legacy[i].hit ? 1 : 0;
+    wrong += (legacy[i]==batch[i]) ? 0 : 1;
+    }
+  std::printf("rays: %zu (hit %zu), hw threads %u, single: %.3f ms, batch: %.3f ms\n",
+              q.size(),hits,std::thread::hardware_concurrency(),tLegacy,tBatch);
+  CHECK(wrong==0);
+  CHECK(hits>npcCount);
+  CHECK(hits<q.size());
+
+  // neighbour rays get neighbour keys; key is order-independent of ray direction
+  CHECK(RayBatch::key(Vec3(0,0,0),Vec3(0,-100,0))==RayBatch::key(Vec3(0,100,0),Vec3(0,0,0)));
+  CHECK(RayBatch::key(Vec3(0,0,0),Vec3(200,0,200))==RayBatch::key(Vec3(200,0,200),Vec3(0,0,0)));
+  CHECK(RayBatch::key(Vec3(50,0,50),Vec3(50,0,50))<RayBatch::key(Vec3(10000,0,10000),Vec3(10000,0,10000)));
+
+  for(auto& o:objs)
+    world.removeCollisionObject(o.get());
+  world.removeCollisionObject(&land.obj);
+  return TEST_RESULT();
+  }
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "utils/residency.h"
+
+#include "testing.h"
+
+// Soak test of resource residency over many world changes, same order as Resources::trimResidency:
+// meshes are trimmed first, then textures, that are not referenced by surviving meshes.
+enum {
+  WORLDS         = 8,
+  MESHES         = 3000,
+  TEXTURES       = 2000,
+  PINNED         = 40,
+  SWITCHES       = 400,
+  MESHES_A_WORLD = 500,
+  };
+
+struct Mesh {
+  size_t bytes = 0;
+  size_t tex[2] = {};
+  };
+
+struct Cache {
+  std::vector<Mesh>       mesh;
+  std::vector<size_t>     texBytes;
+  std::unordered_set<int> meshLive, texLive;
+  };
+
+static const void* meshPtr(size_t i) { return reinterpret_cast<const void*>(0x10000+i*16); }
+static const void* texPtr (size_t i) { return reinterpret_cast<const void*>(0x80000+i*16); }
+
+static size_t total(const Cache& c, const std::unordered_set<int>& live, bool tex) {
+  size_t ret = 0;
+  for(auto i:live)
+    ret += tex ? c.texBytes[size_t(i)] : c.mesh[size_t(i)].bytes;
+  return ret;
+  }
+
+int main() {
+  const size_t meshBudget = 24*1024*1024;
+  const size_t texBudget  = 48*1024*1024;
+
+  std::mt19937 rng(7);
+  Cache        c;
+  for(size_t i=0; i<TEXTURES; ++i)
+    c.texBytes.push_back(size_t(16*1024) << (rng()%6));
+  for(size_t i=0; i<MESHES; ++i) {
+    Mesh m;
+    m.bytes  = 4*1024+rng()%(96*1024);
+    m.tex[0] = rng()%TEXTURES;
+    m.tex[1] = rng()%TEXTURES;
+    c.mesh.push_back(m);
+    }
+  // every world has own mesh set with overlap; ui and effects use pinned textures
+  std::vector<std::vector<size_t>> worlds(WORLDS);
+  for(auto& w:worlds)
+    for(size_t i=0; i<MESHES_A_WORLD; ++i)
+      w.push_back(rng()%MESHES);
+
+  Residency res;
+  for(size_t i=0; i<PINNED; ++i) {
+    res.touch(texPtr(i));
+    res.pin(texPtr(i));
+    c.texLive.insert(int(i));
+    }
+
+  size_t evictedMesh = 0, evictedTex = 0, peakMesh = 0, peakTex = 0;
+  for(size_t sw=0; sw<SWITCHES; ++sw) {
+    res.beginEpoch();
+    std::unordered_set<int> usedMesh, usedTex;
+    for(auto m:worlds[rng()%WORLDS]) {
+      auto& mesh = c.mesh[m];
+      res.touch(meshPtr(m));
+      c.meshLive.insert(int(m));
+      usedMesh.insert(int(m));
+      for(auto t:mesh.tex) {
+        res.touch(texPtr(t));
+        c.texLive.insert(int(t));
+        usedTex.insert(int(t));
+        }
+      }
+    peakMesh = std::max(peakMesh,total(c,c.meshLive,false));
+    peakTex  = std::max(peakTex, total(c,c.texLive, true));
+
+    // meshes
+    std::vector<Residency::Entry> all;
+    for(auto i:c.meshLive)
+      all.push_back({meshPtr(size_t(i)),c.mesh[size_t(i)].bytes});
+    for(auto p:res.evict(all,meshBudget)) {
+      const int id = int((reinterpret_cast<size_t>(p)-0x10000)/16);
+      CHECK(usedMesh.count(id)==0);
+      c.meshLive.erase(id);
+      ++evictedMesh;
+      }
+    // textures, that are not referenced by surviving meshes
+    std::unordered_set<const void*> keep;
+    for(auto i:c.meshLive)
+      for(auto t:c.mesh[size_t(i)].tex)
+        keep.insert(texPtr(t));
+    all.clear();
+    for(auto i:c.texLive)
+      all.push_back({texPtr(size_t(i)),c.texBytes[size_t(i)]});
+    for(auto p:res.evict(all,texBudget,keep)) {
+      const int id = int((reinterpret_cast<size_t>(p)-0x80000)/16);
+      CHECK(usedTex.count(id)==0);
+      CHECK(id>=PINNED);
+      CHECK(keep.count(p)==0);
+      c.texLive.erase(id);
+      ++evictedTex;
+      }
+
+    // current world and pinned resources are resident; rest fits into budget
+    for(auto i:usedMesh)
+      CHECK(c.meshLive.count(i));
+    for(auto i:usedTex)
+      CHECK(c.texLive.count(i));
+    for(int i=0; i<PINNED; ++i)
+      CHECK(c.texLive.count(i));
+    size_t meshCur = 0, texFixed = 0;
+    for(auto i:usedMesh)
+      meshCur += c.mesh[size_t(i)].bytes;
+    for(auto i:c.texLive)
+      if(usedTex.count(i) || i<PINNED || keep.count(texPtr(size_t(i))))
+        texFixed += c.texBytes[size_t(i)];
+    CHECK(total(c,c.meshLive,false)<=std::max(meshBudget,meshCur));
+    CHECK(total(c,c.texLive, true) <=std::max(texBudget, texFixed));
+    }
+
+  std::printf("switches: %d, evicted: %zu meshes, %zu textures; peak: %zu kb meshes, %zu kb textures\n",
+              int(SWITCHES),evictedMesh,evictedTex,peakMesh/1024,peakTex/1024);
+  // budgets are below working set of all worlds: eviction must actually happen
+  CHECK(evictedMesh>0);
+  CHECK(evictedTex>0);
+  return TEST_RESULT();
+  }
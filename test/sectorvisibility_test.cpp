@@ -0,0 +1,137 @@
+#include <Tempest/Matrix4x4>
+
+#include "graphics/dynamic/sectorvisibility.h"
+#include "graphics/mesh/submesh/packedmesh.h"
+#include "graphics/bounds.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Synthetic level along x axis, y and z are in [-1,1]:
+//   outdoor [-1,0] | HALL [0,1] | CELLAR [1,2] | VAULT [2,3]
+// portals: outdoor-HALL at x=0, HALL-CELLAR at x=1; VAULT portal material is broken and never resolves
+static ZenLoad::zCBspNode node(float x0, float x1) {
+  ZenLoad::zCBspNode n = {};
+  n.front     = uint32_t(-1);
+  n.back      = uint32_t(-1);
+  n.bbox3dMin = {x0,-1,-1};
+  n.bbox3dMax = {x1, 1, 1};
+  return n;
+  }
+
+static ZenLoad::zCBspNode split(float x, uint32_t front, uint32_t back, float x0, float x1) {
+  auto n = node(x0,x1);
+  n.plane.v[0] = 1;
+  n.plane.v[1] = 0;
+  n.plane.v[2] = 0;
+  n.plane.v[3] = x;
+  n.front      = front;
+  n.back       = back;
+  return n;
+  }
+
+static ZenLoad::zCBspTreeData mkBsp() {
+  ZenLoad::zCBspTreeData bsp;
+  bsp.nodes.push_back(split(0,1,2,-1,3)); // 0
+  bsp.nodes.push_back(split(1,3,4, 0,3)); // 1
+  bsp.nodes.push_back(node(-1,0));        // 2: outdoor leaf
+  bsp.nodes.push_back(split(2,5,6, 1,3)); // 3
+  bsp.nodes.push_back(node( 0,1));        // 4: HALL
+  bsp.nodes.push_back(node( 2,3));        // 5: VAULT
+  bsp.nodes.push_back(node( 1,2));        // 6: CELLAR
+  bsp.leafIndices = {2,4,5,6};
+
+  const char*    names[] = {"HALL","CELLAR","VAULT"};
+  const uint32_t leaf[]  = {1,3,2};
+  for(size_t i=0; i<3; ++i) {
+    ZenLoad::zCSector s;
+    s.name = names[i];
+    s.bspNodeIndices.push_back(leaf[i]);
+    bsp.sectors.push_back(s);
+    }
+  return bsp;
+  }
+
+static void addQuad(PackedMesh& m, const char* mat, float x) {
+  const uint32_t base = uint32_t(m.vertices.size());
+  const float    yz[][2] = {{-0.1f,-0.1f},{0.1f,-0.1f},{0.f,0.1f}};
+  for(auto& i:yz) {
+    ZenLoad::WorldVertex v = {};
+    v.Position = {x,i[0],i[1]};
+    m.vertices.push_back(v);
+    }
+  PackedMesh::SubMesh sm;
+  sm.material.matName = mat;
+  sm.indices          = {base,base+1,base+2};
+  m.subMeshes.push_back(sm);
+  }
+
+static Bounds box(float x0, float x1) {
+  Bounds a, b;
+  a.assign(Vec3(x0,0,0),0.1f);
+  b.assign(Vec3(x1,0,0),0.1f);
+  Bounds r;
+  r.assign(a,b);
+  return r;
+  }
+
+// view-projection, that shows world x in [-1-dx,1-dx]
+static Matrix4x4 view(float dx) {
+  Matrix4x4 m;
+  m.identity();
+  m.translate(dx,0,0);
+  return m;
+  }
+
+int main() {
+  auto       bsp = mkBsp();
+  PackedMesh land;
+  addQuad(land,"P:HALL",       0);
+  addQuad(land,"P:HALL_CELLAR",1);
+  addQuad(land,"P:CRYPT",      2.5f);
+  addQuad(land,"WALL",         1.5f);
+
+  SectorVisibility sv(bsp,land);
+  CHECK(sv.sectorsCount()==3);
+
+  const int32_t hall   = sv.classify(box(0.4f,0.6f));
+  const int32_t cellar = sv.classify(box(1.4f,1.6f));
+  const int32_t vault  = sv.classify(box(2.4f,2.6f));
+  CHECK(hall  ==0);
+  CHECK(cellar==1);
+  // no resolved portals: objects must never be culled
+  CHECK(vault ==SectorVisibility::S_Outdoor);
+  CHECK(sv.classify(box(-0.6f,-0.4f))==SectorVisibility::S_Outdoor);
+  // crosses HALL-CELLAR boundary
+  CHECK(sv.classify(box( 0.6f, 1.4f))==SectorVisibility::S_Outdoor);
+
+  // recorded camera path: position, frustum shift, expected HALL and CELLAR visibility
+  struct Frame {
+    Vec3 cam;
+    float dx;
+    bool hall;
+    bool cellar;
+    };
+  const Frame path[] = {
+    {Vec3(-0.5f,0,0), 0.0f, true,  true },  // both portals in frustum
+    {Vec3(-0.5f,0,0), 0.5f, true,  false},  // HALL-CELLAR portal is off-screen
+    {Vec3(-0.5f,0,0), 3.0f, false, false},  // looking away
+    {Vec3( 0.5f,0,0), 3.0f, true,  false},  // inside HALL: own sector is always visible
+    {Vec3( 1.5f,0,0), 3.0f, false, true },  // inside CELLAR
+    {Vec3( 1.5f,0,0),-0.5f, true,  true },  // CELLAR -> HALL through portal
+    {Vec3( 2.5f,0,0), 3.0f, false, false},  // inside VAULT: walk starts from outdoor
+    {Vec3( 2.5f,0,0), 0.0f, true,  true },
+    };
+
+  for(auto& f:path) {
+    sv.update(f.cam,view(f.dx));
+    CHECK(sv.isVisible(hall)  ==f.hall);
+    CHECK(sv.isVisible(cellar)==f.cellar);
+    CHECK(sv.isVisible(vault));
+    CHECK(sv.isVisible(SectorVisibility::S_Outdoor));
+    CHECK(sv.visibleCount()==size_t(f.hall)+size_t(f.cellar));
+    }
+
+  return TEST_RESULT();
+  }
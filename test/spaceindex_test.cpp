@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "world/spaceindex.h"
+#include "world/objects/vob.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// World items and interactive objects: focus-like radius queries every frame, while loot is picked up,
+// dropped and rolls around. SpaceIndex is compared against rebuild-on-change k-d index it replaced.
+namespace {
+
+struct Obj : Vob {
+  bool item    = false;
+  bool dynamic = false; // item with physics: moves, until it comes to rest
+  };
+
+// k-d index, that SpaceIndex had before: thrown away on every add/del, dynamic objects are returned unconditionally
+namespace Legacy {
+class Index {
+  public:
+    void add(Obj* v) { arr.push_back(v); index.clear(); }
+    void del(Obj* v) {
+      for(size_t i=0; i<arr.size(); ++i)
+        if(arr[i]==v) {
+          arr[i] = arr.back();
+          arr.pop_back();
+          index.clear();
+          return;
+          }
+      }
+
+    template<class F>
+    void find(const Vec3& p, float R, const F& f) {
+      if(index.empty())
+        build();
+      for(auto i:dynamic)
+        f(*i);
+      implFind(index.data(),index.size(),0,p,R,f);
+      }
+
+  private:
+    std::vector<Obj*> arr, index, dynamic;
+
+    void build() {
+      index.clear();
+      dynamic.clear();
+      for(auto i:arr)
+        (i->dynamic ? dynamic : index).push_back(i);
+      build(index.data(),index.size(),0);
+      }
+
+    static float at(const Obj* v, int c) {
+      auto p = v->position();
+      return c==0 ? p.x : (c==1 ? p.y : p.z);
+      }
+
+    void build(Obj** v, size_t cnt, int depth) {
+      depth %= 3;
+      std::sort(v,v+cnt,[depth](const Obj* a, const Obj* b){ return at(a,depth)<at(b,depth); });
+      size_t mid = cnt/2;
+      if(mid>0)
+        build(v,mid,depth+1);
+      if(mid+1<cnt)
+        build(v+mid+1,cnt-mid-1,depth+1);
+      }
+
+    template<class F>
+    void implFind(Obj** v, size_t cnt, int depth, const Vec3& p, float R, const F& f) {
+      if(cnt==0)
+        return;
+      auto mid = cnt/2;
+      auto pos = v[mid]->position();
+      if((pos-p).quadLength()<=R*R)
+        f(*v[mid]);
+      depth %= 3;
+      const float c  = depth==0 ? p.x : (depth==1 ? p.y : p.z);
+      const float cm = at(v[mid],depth);
+      if(c-R<=cm)
+        implFind(v,mid,depth+1,p,R,f);
+      if(c+R>=cm)
+        implFind(v+mid+1,cnt-mid-1,depth+1,p,R,f);
+      }
+  };
+}
+
+struct Population {
+  std::vector<std::unique_ptr<Obj>> obj;
+  std::vector<Obj*>                 inWorld, picked;
+  };
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+
+  const float  worldSize = 80000.f;  // size of G2 main world, roughly
+  const size_t items     = 4000;
+  const size_t mobs      = 2000;
+  const size_t frames    = 300;
+  const float  focusR    = 2000.f;
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> coord(-worldSize*0.5f,worldSize*0.5f);
+  std::uniform_real_distribution<float> near (-300.f,300.f);
+
+  Population pop;
+  for(size_t i=0; i<items+mobs; ++i) {
+    pop.obj.emplace_back(new Obj());
+    pop.obj.back()->setPosition(Vec3(coord(rng),coord(rng)*0.01f,coord(rng)));
+    pop.obj.back()->item    = (i<items);
+    pop.obj.back()->dynamic = (i<items && i%10==0);
+    pop.inWorld.push_back(pop.obj.back().get());
+    }
+
+  SpaceIndex<Obj> index;
+  Legacy::Index   legacy;
+  for(auto i:pop.inWorld) {
+    index.add(i);
+    legacy.add(i);
+    }
+
+  Vec3   player(0,0,0);
+  double tIndex = 0, tLegacy = 0;
+  size_t found = 0, wrong = 0, queries = 0;
+  std::vector<Obj*> a, b;
+  for(size_t f=0; f<frames; ++f) {
+    player = player + Vec3(40.f,0,25.f);
+
+    // loot churn around the player: a few items picked up and dropped every frame
+    auto t0 = Clock::now();
+    for(int k=0; k<4; ++k) {
+      auto& w = pop.inWorld;
+      auto  i = size_t(rng()%w.size());
+      if(!w[i]->item)
+        continue;
+      pop.picked.push_back(w[i]);
+      index.del(w[i]);
+      legacy.del(w[i]);
+      w[i] = w.back();
+      w.pop_back();
+      }
+    while(pop.picked.size()>8) {
+      auto it = pop.picked.front();
+      pop.picked.erase(pop.picked.begin());
+      it->setPosition(player+Vec3(near(rng),0,near(rng)));
+      it->dynamic = true;
+      pop.inWorld.push_back(it);
+      index.add(it);
+      legacy.add(it);
+      }
+    // dropped items roll
+    for(auto i:pop.inWorld)
+      if(i->dynamic) {
+        i->setPosition(i->position()+Vec3(1.f,0,0.5f));
+        index.invalidate(i);
+        }
+    auto t1 = Clock::now();
+    tIndex += std::chrono::duration<double,std::milli>(t1-t0).count();
+
+    for(int q=0; q<8; ++q) {
+      const Vec3 p = q==0 ? player : pop.inWorld[size_t(rng()%pop.inWorld.size())]->position();
+
+      a.clear();
+      auto q0 = Clock::now();
+      index.find(p,focusR,[&a](Obj& o){ a.push_back(&o); });
+      auto q1 = Clock::now();
+      b.clear();
+      legacy.find(p,focusR,[&b,&p,focusR](Obj& o){
+        // caller had to filter dynamic objects by itself
+        if((o.position()-p).quadLength()<=focusR*focusR)
+          b.push_back(&o);
+        });
+      auto q2 = Clock::now();
+      tIndex  += std::chrono::duration<double,std::milli>(q1-q0).count();
+      tLegacy += std::chrono::duration<double,std::milli>(q2-q1).count();
+
+      std::sort(a.begin(),a.end());
+      std::sort(b.begin(),b.end());
+      found += a.size();
+      wrong += (a==b) ? 0 : 1;
+      ++queries;
+      }
+    }
+
+  std::printf("objects: %zu, frames: %zu, queries: %zu, found avg: %.1f, space index: %.2f ms, legacy k-d: %.2f ms\n",
+              pop.inWorld.size(),frames,queries,double(found)/double(queries),tIndex,tLegacy);
+  CHECK(wrong==0);
+  CHECK(index.size()==pop.inWorld.size());
+
+  // membership is by handle, removed object is gone at once
+  for(auto i:pop.picked)
+    CHECK(!index.hasObject(i));
+  for(size_t i=0; i<pop.inWorld.size(); i+=97)
+    CHECK(index.hasObject(pop.inWorld[i]));
+
+  return TEST_RESULT();
+  }
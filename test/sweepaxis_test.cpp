@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <Tempest/Vec>
+
+#include "physics/sweepaxis.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Stress of npc-vs-npc collision: 500 npc's walk in a small arena, most of them move every tick, some stand,
+// some are disabled, some despawn and spawn again. Every step is a tryMove: position is changed first,
+// then collision is asked, and step is taken back on collision - same as NpcItem::tryMove.
+// SweepAxis is checked against brute force and timed against moving/frozen lists, that NpcBodyList had before.
+namespace {
+
+struct Body {
+  Vec3     pos;
+  float    r      = 25.f;
+  float    h      = 180.f;
+  bool     enable = true;
+  size_t   slot   = 0;
+  // legacy
+  uint64_t lastMove = 0;
+  size_t   frozen   = size_t(-1);
+  };
+
+bool hasCollision(const Body& a, const Body& b, Vec3& normal) {
+  if(&a==&b)
+    return false;
+  auto dx = a.pos.x-b.pos.x, dy = a.pos.y-b.pos.y, dz = a.pos.z-b.pos.z;
+  auto r  = a.r+b.r;
+
+  if(dx*dx+dz*dz>r*r)
+    return false;
+  if(dy>b.h || dy<-a.h)
+    return false;
+
+  normal.x += dx;
+  normal.y += dy;
+  normal.z += dz;
+  return true;
+  }
+
+}
+
+namespace Legacy {
+
+// previous NpcBodyList: unsorted movers, frozen bodies re-sorted every tick
+struct NpcBodyList {
+  struct Record {
+    Body* body = nullptr;
+    float x    = 0.f;
+    };
+
+  std::vector<Record> body, frozen;
+  bool                srt  = false;
+  uint64_t            tick = 0;
+  float               maxR = 0;
+
+  void add(Body* b) {
+    Record r;
+    r.body = b;
+    r.x    = b->pos.x;
+    body.push_back(r);
+    maxR = std::max(maxR,b->r);
+    }
+
+  bool del(Body* b) {
+    if(del(b,body))
+      return true;
+    if(del(b,frozen)) {
+      srt = false;
+      return true;
+      }
+    return false;
+    }
+
+  bool del(Body* b, std::vector<Record>& arr) {
+    for(size_t i=0; i<arr.size(); ++i) {
+      if(arr[i].body!=b)
+        continue;
+      arr[i] = arr.back();
+      arr.pop_back();
+      return true;
+      }
+    return false;
+    }
+
+  bool delMisordered(Body* b, std::vector<Record>& arr) {
+    auto&       fr = arr[b->frozen];
+    const float x  = fr.x;
+    if((b->frozen==0 || arr[b->frozen-1].x<x) &&
+       (b->frozen+1==arr.size() || x<arr[b->frozen+1].x)) {
+      fr.x = fr.body->pos.x;
+      return false;
+      }
+    fr.body = nullptr;
+    return true;
+    }
+
+  void onMove(Body& n) {
+    if(n.frozen!=size_t(-1)) {
+      if(delMisordered(&n,frozen)) {
+        n.lastMove = tick;
+        n.frozen   = size_t(-1);
+
+        Record r;
+        r.body = &n;
+        body.push_back(r);
+        }
+      } else {
+      n.lastMove = tick;
+      }
+    }
+
+  bool hasCollision(const Body& n, Vec3& normal) {
+    if(srt) {
+      if(hasCollision(n,frozen,normal,true))
+        return true;
+      return hasCollision(n,body,normal,false);
+      }
+    if(hasCollision(n,body,normal,false))
+      return true;
+    return hasCollision(n,frozen,normal,false);
+    }
+
+  bool hasCollision(const Body& n, const std::vector<Record>& arr, Vec3& normal, bool sorted) {
+    auto l = arr.begin();
+    auto r = arr.end();
+    if(sorted) {
+      const float dX = maxR+n.r;
+      l = std::lower_bound(arr.begin(),arr.end(),n.pos.x-dX,[](const Record& b,float x){ return b.x<x; });
+      r = std::upper_bound(arr.begin(),arr.end(),n.pos.x+dX,[](float x,const Record& b){ return x<b.x; });
+      }
+    if(std::distance(l,r)<=1)
+      return false;
+
+    bool ret = false;
+    for(; l!=r; ++l) {
+      auto& v = *l;
+      if(v.body!=nullptr && v.body->enable && ::hasCollision(n,*v.body,normal))
+        ret = true;
+      }
+    return ret;
+    }
+
+  void tickAabbs() {
+    for(size_t i=0; i<body.size();) {
+      if(body[i].body->lastMove!=tick) {
+        auto b = body[i];
+        body[i] = body.back();
+        body.pop_back();
+        b.x = b.body->pos.x;
+        frozen.push_back(b);
+        } else {
+        ++i;
+        }
+      }
+    for(size_t i=0; i<frozen.size();) {
+      if(frozen[i].body==nullptr) {
+        frozen[i] = frozen.back();
+        frozen.pop_back();
+        }
+      else if(frozen[i].body->lastMove==tick) {
+        frozen[i].body->frozen = size_t(-1);
+        body.push_back(frozen[i]);
+        frozen[i] = frozen.back();
+        frozen.pop_back();
+        }
+      else {
+        ++i;
+        }
+      }
+    srt = true;
+    std::sort(frozen.begin(),frozen.end(),[](const Record& a, const Record& b){ return a.x<b.x; });
+    for(size_t i=0; i<frozen.size(); ++i)
+      frozen[i].body->frozen = i;
+    tick++;
+    }
+  };
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+
+  const size_t npcCount = 500;
+  const float  arena    = 4000.f; // 40 meters
+  const size_t ticks    = 200;
+
+  std::mt19937 rng(14);
+  std::uniform_real_distribution<float> coord(0.f,arena);
+  std::uniform_real_distribution<float> u(0.f,1.f);
+
+  std::vector<Body> npc(npcCount);
+  std::vector<float> dir(npcCount);
+  for(size_t i=0; i<npcCount; ++i) {
+    npc[i].pos = Vec3(coord(rng),(i%7==0) ? 300.f : 0.f,coord(rng)); // few on a balcony
+    npc[i].r   = 20.f+float(i%4)*5.f;
+    dir[i]     = u(rng)*6.2831853f;
+    }
+
+  SweepAxis<Body>     sweep;
+  Legacy::NpcBodyList legacy;
+  float maxR = 0;
+  for(auto& n:npc) {
+    sweep.add(&n);
+    legacy.add(&n);
+    maxR = std::max(maxR,n.r);
+    }
+
+  double tSweep = 0, tLegacy = 0;
+  size_t queries = 0, collisions = 0, wrong = 0, legacyMissed = 0, misordered = 0, churn = 0;
+  std::vector<Vec3>    start(npcCount), next(npcCount), normal(npcCount);
+  std::vector<uint8_t> walk(npcCount), hit(npcCount);
+  for(size_t tick=0; tick<ticks; ++tick) {
+    // plan of the tick: walk, wander a bit and turn back at the walls of arena
+    for(size_t i=0; i<npcCount; ++i) {
+      auto& n = npc[i];
+      start[i] = n.pos;
+      walk[i]  = 0;
+      // standing npc's: guards, traders, chatting ones
+      if(i%10<3)
+        continue;
+      // dead body: disabled, still in the list
+      if(i%97==0 && tick==ticks/2)
+        n.enable = false;
+      if(!n.enable)
+        continue;
+      dir[i] += (u(rng)-0.5f)*0.3f;
+      next[i] = Vec3(n.pos.x+std::cos(dir[i])*4.f,n.pos.y,n.pos.z+std::sin(dir[i])*4.f);
+      if(next[i].x<0 || next[i].z<0 || next[i].x>arena || next[i].z>arena) {
+        dir[i] += 3.1415926f;
+        continue;
+        }
+      walk[i] = 1;
+      }
+
+    // same tick is replayed for every implementation: step is taken back, if sweep found collision
+    auto replay = [&](auto query) {
+      for(size_t i=0; i<npcCount; ++i) {
+        if(!walk[i])
+          continue;
+        auto& n = npc[i];
+        n.pos = next[i];
+        query(n,i);
+        if(hit[i])
+          n.pos = start[i];
+        }
+      };
+
+    auto t0 = Clock::now();
+    replay([&](Body& n, size_t i){
+      const float dX = maxR+n.r;
+      auto        rg = sweep.range(n.pos.x-dX,n.pos.x+dX);
+      Vec3        nr;
+      bool        c  = false;
+      for(auto r=rg.first; r!=rg.second; ++r)
+        if(r->body->enable && hasCollision(n,*r->body,nr))
+          c = true;
+      if(!c)
+        sweep.onMove(n);
+      hit[i]    = c ? 1 : 0;
+      normal[i] = nr;
+      });
+    auto t1 = Clock::now();
+    for(size_t i=0; i<npcCount; ++i)
+      npc[i].pos = start[i];
+    replay([&](Body& n, size_t i){
+      Vec3 nr;
+      if(legacy.hasCollision(n,nr)!=(hit[i]!=0))
+        ++legacyMissed;
+      if(hit[i])
+        return;
+      legacy.onMove(n);
+      });
+    legacy.tickAabbs();
+    auto t2 = Clock::now();
+    tSweep  += std::chrono::duration<double,std::milli>(t1-t0).count();
+    tLegacy += std::chrono::duration<double,std::milli>(t2-t1).count();
+
+    // reference: brute force over all bodies
+    for(size_t i=0; i<npcCount; ++i)
+      npc[i].pos = start[i];
+    replay([&](Body& n, size_t i){
+      Vec3 nr;
+      bool c = false;
+      for(auto& v:npc)
+        if(v.enable && hasCollision(n,v,nr))
+          c = true;
+      if(c!=(hit[i]!=0) || (nr-normal[i]).quadLength()>1e-3f)
+        ++wrong;
+      ++queries;
+      collisions += c ? 1 : 0;
+      });
+
+    // despawn and spawn of few npc's
+    for(size_t k=0; k<3; ++k) {
+      auto& n = npc[(tick*31+k*167)%npcCount];
+      CHECK(sweep.del(&n));
+      CHECK(legacy.del(&n));
+      n.frozen = size_t(-1);
+      n.pos    = Vec3(coord(rng),n.pos.y,coord(rng));
+      sweep.add(&n);
+      legacy.add(&n);
+      ++churn;
+      }
+
+    // order and back references are intact
+    auto all = sweep.range(-std::numeric_limits<float>::max(),std::numeric_limits<float>::max());
+    size_t id = 0;
+    for(auto r=all.first; r!=all.second; ++r, ++id) {
+      if(r->body->slot!=id || r->x!=r->body->pos.x)
+        ++misordered;
+      if(r!=all.first && r->x<(r-1)->x)
+        ++misordered;
+      }
+    CHECK(id==npcCount);
+    }
+
+  std::printf("npc: %zu, queries: %zu (collisions %zu), respawns: %zu, sweep: %.3f ms, legacy: %.3f ms\n",
+              npcCount,queries,collisions,churn,tSweep,tLegacy);
+  std::printf("legacy missed/extra collisions: %zu\n",legacyMissed);
+
+  CHECK(wrong==0);
+  CHECK(misordered==0);
+  CHECK(collisions>0);
+  CHECK(sweep.size()==npcCount);
+
+  // body, that is not in the list, is not removed
+  Body stray;
+  stray.slot = 0;
+  CHECK(!sweep.del(&stray));
+  CHECK(sweep.size()==npcCount);
+
+  return TEST_RESULT();
+  }
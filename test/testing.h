@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+
+// minimal check macros: test executable returns number of failed checks, ctest reports nonzero as failure
+namespace Testing {
+  inline int& failed() {
+    static int cnt = 0;
+    return cnt;
+    }
+  }
+
+#define CHECK(expr)                                                                 \
+  do {                                                                              \
+    if(!(expr)) {                                                                   \
+      std::fprintf(stderr,"%s:%d: check failed: %s\n",__FILE__,__LINE__,#expr);     \
+      ++Testing::failed();                                                          \
+      }                                                                             \
+    } while(false)
+
+#define TEST_RESULT() (Testing::failed()==0 ? 0 : 1)
@@ -0,0 +1,252 @@
+#include <Tempest/Matrix4x4>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "graphics/dynamic/frustrum.h"
+#include "graphics/dynamic/visibilitygroup.h"
+#include "graphics/bounds.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Visibility pass over token set of a world of G2 size: towns and camps of dense static vobs, forest spread over
+// the whole map, npc's and items moving around camps. Camera flies a recorded path from camp to camp with two shadow
+// cascades around it. Each frame tree culling of VisibilityGroup is checked against per-token tests of all frusta,
+// that VisibilityGroup::pass did before, and timed against them.
+namespace {
+
+const float worldSize = 80000.f;
+
+struct Sphere {
+  Vec3  at;
+  float r = 0;
+  };
+
+// clip = M*(x,y,z,1), stored in layout read by Frustrum::make
+Matrix4x4 mkMatrix(const float (&m)[4][4]) {
+  float v[16] = {};
+  for(int r=0; r<4; ++r)
+    for(int c=0; c<4; ++c)
+      v[4*c+r] = m[r][c];
+  return Matrix4x4(v);
+  }
+
+Matrix4x4 mkView(const Vec3& eye, float yaw) {
+  const float n = 10.f, far = 20000.f, fx = 1.f/std::tan(0.6f), fy = fx*16.f/9.f;
+  const float a = far/(far-n), b = -far*n/(far-n);
+  const Vec3  fw(std::sin(yaw),0,std::cos(yaw)), rt(std::cos(yaw),0,-std::sin(yaw));
+  const float dr = rt.x*eye.x+rt.z*eye.z, df = fw.x*eye.x+fw.z*eye.z;
+  const float m[4][4] = {
+    {fx*rt.x, 0,  fx*rt.z, -fx*dr     },
+    {0,       fy, 0,       -fy*eye.y  },
+    {a*fw.x,  0,  a*fw.z,  -a*df+b    },
+    {fw.x,    0,  fw.z,    -df        },
+    };
+  return mkMatrix(m);
+  }
+
+// orthographic box of half-size h around camera, looking along sun direction
+Matrix4x4 mkShadow(const Vec3& at, float h) {
+  const Vec3 s(0.3f,-0.9f,0.3f), u(0.7071f,0,-0.7071f);
+  const float ls = std::sqrt(s.x*s.x+s.y*s.y+s.z*s.z);
+  const Vec3  sn(s.x/ls,s.y/ls,s.z/ls);
+  const Vec3  v(sn.y*u.z-sn.z*u.y, sn.z*u.x-sn.x*u.z, sn.x*u.y-sn.y*u.x);
+  const float depth = 20000.f;
+  auto dot = [&at](const Vec3& a){ return a.x*at.x+a.y*at.y+a.z*at.z; };
+  const float m[4][4] = {
+    {u.x/h,      u.y/h,      u.z/h,      -dot(u)/h     },
+    {v.x/h,      v.y/h,      v.z/h,      -dot(v)/h     },
+    {sn.x/depth, sn.y/depth, sn.z/depth, -dot(sn)/depth},
+    {0,          0,          0,          1             },
+    };
+  return mkMatrix(m);
+  }
+
+Matrix4x4 mkPos(const Vec3& p) {
+  Matrix4x4 m;
+  m.identity();
+  m.translate(p.x,p.y,p.z);
+  return m;
+  }
+
+}
+
+namespace Legacy {
+
+// previous VisibilityGroup::pass: every token against every frustum
+void pass(const std::vector<Sphere>& tok, std::vector<uint8_t>& vis,
+          const Matrix4x4& main, const Matrix4x4* sh) {
+  Frustrum f[SceneGlobals::V_Count];
+  f[SceneGlobals::V_Shadow0].make(sh[0]);
+  f[SceneGlobals::V_Shadow1].make(sh[1]);
+  f[SceneGlobals::V_Main   ].make(main);
+
+  vis.resize(tok.size());
+  std::vector<size_t> id(tok.size());
+  for(size_t i=0; i<id.size(); ++i)
+    id[i] = i;
+  Workers::parallelFor(id,[&](size_t& i){
+    auto&   b = tok[i];
+    uint8_t v = 0;
+    for(uint8_t c=0; c<SceneGlobals::V_Count; ++c)
+      if(f[c].testPoint(b.at,b.r))
+        v |= uint8_t(1u<<c);
+    vis[i] = v;
+    });
+  }
+
+}
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937 rng(21);
+  std::uniform_real_distribution<float> coord(-worldSize*0.5f,worldSize*0.5f);
+  std::uniform_real_distribution<float> around(-1500.f,1500.f);
+  std::uniform_real_distribution<float> u(0.f,1.f);
+
+  VisibilityGroup                     vg;
+  std::vector<VisibilityGroup::Token> tok;
+  std::vector<Vec3>                   pos;
+  std::vector<uint8_t>                alive;
+
+  auto add = [&](bool isStatic, const Vec3& at, float size) {
+    Bounds b;
+    b.assign(Vec3(),size);
+    tok.push_back(vg.get(isStatic));
+    tok.back().setBounds(b);
+    tok.back().setObjMatrix(mkPos(at));
+    pos.push_back(at);
+    alive.push_back(1);
+    };
+
+  // towns and camps: dense clutter of small vobs and houses
+  std::vector<Vec3> camps(120);
+  for(auto& c:camps)
+    c = Vec3(coord(rng),u(rng)*2000.f,coord(rng));
+  for(size_t i=0; i<30000; ++i) {
+    auto& c = camps[i%camps.size()];
+    add(true,Vec3(c.x+around(rng),c.y+u(rng)*300.f,c.z+around(rng)),(i%10==0) ? 600.f : 20.f+u(rng)*100.f);
+    }
+  // forest and rocks everywhere
+  for(size_t i=0; i<12000; ++i)
+    add(true,Vec3(coord(rng),u(rng)*2000.f,coord(rng)),150.f+u(rng)*400.f);
+  const size_t staticCount = tok.size();
+  // npc's and items: movers
+  for(size_t i=0; i<1500; ++i) {
+    auto& c = camps[(i*7)%camps.size()];
+    add(false,Vec3(c.x+around(rng),c.y,c.z+around(rng)),(i%3==0) ? 100.f : 15.f);
+    }
+  vg.rebuildStaticTree();
+
+  // recorded path: camera goes from camp to camp, looking ahead and sometimes around
+  struct Key {
+    Vec3  at;
+    float yaw;
+    };
+  std::vector<Key> keys;
+  for(size_t i=0; i<8; ++i) {
+    auto& c = camps[(i*13)%camps.size()];
+    keys.push_back({Vec3(c.x,c.y+250.f,c.z-2000.f),float(i)*0.8f});
+    }
+  const size_t frames = 400;
+
+  double tTree = 0, tLegacy = 0, tBuild = 0;
+  size_t wrong = 0, visible[SceneGlobals::V_Count] = {}, total = 0;
+  std::vector<Sphere>  sph;
+  std::vector<uint8_t> vis;
+  std::vector<size_t>  runtime;
+  for(size_t fr=0; fr<frames; ++fr) {
+    const float  t  = float(fr)*float(keys.size()-1)/float(frames);
+    const size_t k  = std::min(size_t(t),keys.size()-2);
+    const float  a  = t-float(k);
+    const Vec3&  p0 = keys[k].at;
+    const Vec3&  p1 = keys[k+1].at;
+    const Vec3   at = Vec3(p0.x+(p1.x-p0.x)*a,p0.y+(p1.y-p0.y)*a,p0.z+(p1.z-p0.z)*a);
+    const float  yw = keys[k].yaw*(1.f-a)+keys[k+1].yaw*a;
+
+    const Matrix4x4 main  = mkView(at,yw);
+    const Matrix4x4 sh[2] = {mkShadow(at,1500.f),mkShadow(at,8000.f)};
+
+    // npc's walk
+    for(size_t i=staticCount; i<staticCount+1500; ++i) {
+      pos[i].x += std::sin(float(fr+i)*0.05f)*5.f;
+      pos[i].z += std::cos(float(fr+i)*0.05f)*5.f;
+      tok[i].setObjMatrix(mkPos(pos[i]));
+      }
+    // door opens: static turns out to be not so static
+    if(fr==50)
+      for(size_t i=0; i<30000; i+=997)
+        tok[i].setObjMatrix(mkPos(pos[i]+Vec3(0,10,0)));
+    // arrows and dropped items: runtime statics; folded into tree on next rebuild point
+    if(fr==100)
+      for(size_t i=0; i<300; ++i) {
+        runtime.push_back(tok.size());
+        add(true,at+Vec3(around(rng),0,around(rng)+2500.f),10.f);
+        }
+    if(fr==200)
+      vg.rebuildStaticTree();
+    if(fr==300) {
+      for(auto i:runtime) {
+        tok[i]   = VisibilityGroup::Token();
+        alive[i] = 0;
+        }
+      runtime.clear();
+      }
+
+    // tree is built on first pass after rebuild point
+    const bool build = (fr==0 || fr==200);
+    auto t0 = Clock::now();
+    vg.pass(main,sh,2);
+    auto t1 = Clock::now();
+
+    sph.clear();
+    std::vector<size_t> live;
+    for(size_t i=0; i<tok.size(); ++i) {
+      if(!alive[i])
+        continue;
+      auto& b = tok[i].bounds();
+      sph.push_back({b.midTr,b.r});
+      live.push_back(i);
+      }
+    auto t2 = Clock::now();
+    Legacy::pass(sph,vis,main,sh);
+    auto t3 = Clock::now();
+
+    if(build)
+      tBuild += std::chrono::duration<double,std::milli>(t1-t0).count(); else
+      tTree  += std::chrono::duration<double,std::milli>(t1-t0).count();
+    if(!build)
+      tLegacy += std::chrono::duration<double,std::milli>(t3-t2).count();
+
+    for(size_t i=0; i<live.size(); ++i) {
+      for(uint8_t c=0; c<SceneGlobals::V_Count; ++c) {
+        const bool v = tok[live[i]].isVisible(SceneGlobals::VisCamera(c));
+        if(v!=(((vis[i]>>c)&1)!=0))
+          ++wrong;
+        visible[c] += v ? 1 : 0;
+        }
+      }
+    total += live.size();
+    }
+
+  std::printf("tokens: %zu (static %zu), frames: %zu, hw threads %u\n",tok.size(),staticCount,frames,std::thread::hardware_concurrency());
+  std::printf("visible per frame: main %zu, shadow0 %zu, shadow1 %zu of %zu\n",
+              visible[SceneGlobals::V_Main]/frames,visible[SceneGlobals::V_Shadow0]/frames,
+              visible[SceneGlobals::V_Shadow1]/frames,total/frames);
+  std::printf("pass: tree %.3f ms, legacy %.3f ms (per frame %.3f / %.3f ms), tree build %.3f ms\n",
+              tTree,tLegacy,tTree/double(frames-2),tLegacy/double(frames-2),tBuild);
+
+  CHECK(wrong==0);
+  CHECK(visible[SceneGlobals::V_Main]>0);
+  CHECK(visible[SceneGlobals::V_Main]<total/4);
+  CHECK(visible[SceneGlobals::V_Shadow0]<visible[SceneGlobals::V_Shadow1]);
+
+  return TEST_RESULT();
+  }
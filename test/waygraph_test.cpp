@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "world/waygraph.h"
+#include "world/waypoint.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Routine paths: town of streets with a few roads to a camp and a separate island. At every hour change
+// each npc goes from its current routine point to the next one, like all TA_ routines of a world do.
+// Routes from WayGraph are checked against unguided relaxation, that WayMatrix::wayTo did before.
+namespace Legacy {
+
+// previous WayMatrix::wayTo, with pathGen/pathLen moved out of WayPoint
+struct Search {
+  const std::vector<WayPoint>& wp;
+  std::vector<int32_t>         pathLen;
+  std::vector<uint32_t>        pathGen;
+  uint32_t                     gen = 0;
+  std::vector<uint32_t>        stk[2];
+
+  explicit Search(const std::vector<WayPoint>& wp):wp(wp),pathLen(wp.size()),pathGen(wp.size()) {}
+
+  uint32_t id(const WayPoint* p) const { return uint32_t(std::distance(wp.data(),p)); }
+
+  bool route(uint32_t begin, uint32_t end, std::vector<uint32_t>& out) {
+    out.clear();
+    gen++;
+    pathLen[begin] = 0;
+    pathGen[begin] = gen;
+
+    std::vector<uint32_t> *front=&stk[0], *back=&stk[1];
+    stk[0].clear();
+    stk[1].clear();
+    front->push_back(begin);
+
+    while(pathGen[end]!=gen && front->size()>0) {
+      for(auto wp0:*front) {
+        int32_t l0 = pathLen[wp0];
+        for(auto& i:wp[wp0].connections()) {
+          auto    w  = id(i.point);
+          int32_t l1 = l0+i.len;
+          if(pathGen[w]!=gen || pathLen[w]>l1) {
+            pathLen[w] = l1;
+            pathGen[w] = gen;
+            back->push_back(w);
+            }
+          }
+        }
+      std::swap(front,back);
+      back->clear();
+      }
+
+    if(pathGen[end]!=gen)
+      return false;
+    out.push_back(end);
+    uint32_t current = end;
+    while(current!=begin) {
+      int32_t  l0 = pathLen[current], l1 = l0;
+      uint32_t next = uint32_t(-1);
+      for(auto& i:wp[current].connections()) {
+        auto w = id(i.point);
+        if(pathGen[w]==gen && pathLen[w]+i.len<=l0 && pathLen[w]<l1) {
+          next = w;
+          l1   = pathLen[w];
+          }
+        }
+      if(next==uint32_t(-1))
+        return false;
+      out.push_back(next);
+      current = next;
+      }
+    return true;
+    }
+  };
+
+}
+
+// reference: exact shortest distance
+static int32_t dijkstra(const std::vector<WayPoint>& wp, uint32_t begin, uint32_t end) {
+  std::vector<int32_t> dist(wp.size(),std::numeric_limits<int32_t>::max());
+  std::vector<bool>    done(wp.size(),false);
+  dist[begin] = 0;
+  for(;;) {
+    uint32_t n = uint32_t(-1);
+    for(size_t i=0; i<wp.size(); ++i)
+      if(!done[i] && dist[i]!=std::numeric_limits<int32_t>::max() && (n==uint32_t(-1) || dist[i]<dist[n]))
+        n = uint32_t(i);
+    if(n==uint32_t(-1) || n==end)
+      break;
+    done[n] = true;
+    for(auto& c:wp[n].connections()) {
+      auto id = uint32_t(std::distance(wp.data(),static_cast<const WayPoint*>(c.point)));
+      dist[id] = std::min(dist[id],dist[n]+c.len);
+      }
+    }
+  return dist[end];
+  }
+
+// length of route, stored end-to-begin; -1 if route is broken
+static int32_t length(const std::vector<WayPoint>& wp, const std::vector<uint32_t>& path) {
+  int32_t len = 0;
+  for(size_t i=1; i<path.size(); ++i) {
+    auto& a = wp[path[i]];
+    auto  l = -1;
+    for(auto& c:a.connections())
+      if(c.point==&wp[path[i-1]])
+        l = c.len;
+    if(l<0)
+      return -1;
+    len += l;
+    }
+  return len;
+  }
+
+static void link(std::vector<WayPoint>& wp, size_t a, size_t b) {
+  wp[a].connect(wp[b]);
+  wp[b].connect(wp[a]);
+  }
+
+static std::vector<WayPoint> mkWaynet(size_t n, size_t& island) {
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> jitter(-150.f,150.f);
+
+  std::vector<WayPoint> wp;
+  // town: n*n crossings of streets, 1000 apart
+  for(size_t z=0; z<n; ++z)
+    for(size_t x=0; x<n; ++x) {
+      Vec3 p(float(x)*1000.f+jitter(rng),float((x*7+z*3)%11)*20.f,float(z)*1000.f+jitter(rng));
+      wp.emplace_back(p,("TOWN_"+std::to_string(x)+"_"+std::to_string(z)).c_str());
+      }
+  // winding road to camp: many short segments
+  const size_t road = wp.size();
+  for(size_t i=0; i<200; ++i) {
+    Vec3 p(float(n)*1000.f+float(i)*300.f,0,float(n)*500.f+std::sin(float(i)*0.3f)*2000.f);
+    wp.emplace_back(p,("ROAD_"+std::to_string(i)).c_str());
+    }
+  // island, not connected to anything else
+  island = wp.size();
+  for(size_t i=0; i<50; ++i) {
+    Vec3 p(-20000.f-float(i%10)*800.f,0,float(i/10)*800.f);
+    wp.emplace_back(p,("ISLAND_"+std::to_string(i)).c_str());
+    }
+
+  // connect only after all points are in place: connections point into the vector
+  for(size_t z=0; z<n; ++z)
+    for(size_t x=0; x<n; ++x) {
+      const size_t i = z*n+x;
+      // some streets are blocked by houses
+      if(x+1<n && (x*13+z*7)%9!=0)
+        link(wp,i,i+1);
+      if(z+1<n && (x*5+z*11)%8!=0)
+        link(wp,i,i+n);
+      // and some alleys cut corners
+      if(x+1<n && z+1<n && (x+z)%6==0)
+        link(wp,i,i+n+1);
+      }
+  link(wp,(n/2)*n+n-1,road);
+  for(size_t i=road; i+1<island; ++i)
+    link(wp,i,i+1);
+  for(size_t i=island; i+1<wp.size(); ++i)
+    if(i%10!=9)
+      link(wp,i,i+1);
+  for(size_t i=island; i+10<wp.size(); ++i)
+    link(wp,i,i+10);
+  return wp;
+  }
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+
+  size_t island = 0;
+  auto   wp     = mkWaynet(40,island);
+
+  WayGraph graph;
+  graph.build(wp);
+
+  // npc's with 4 routine points each; island has own inhabitants
+  const size_t npcCount = 400;
+  const size_t hours    = 4; // one cycle of routine: every route is asked once
+  std::mt19937 rng(21);
+  std::uniform_int_distribution<uint32_t> town(0,uint32_t(island-1));
+  std::uniform_int_distribution<uint32_t> isl (uint32_t(island),uint32_t(wp.size()-1));
+  std::vector<std::vector<uint32_t>> routine(npcCount);
+  for(size_t i=0; i<npcCount; ++i)
+    for(size_t r=0; r<4; ++r)
+      routine[i].push_back(i%40==0 ? isl(rng) : town(rng));
+
+  struct Query {
+    uint32_t begin, end;
+    };
+  std::vector<Query> queries;
+  for(size_t h=0; h<hours; ++h)
+    for(size_t i=0; i<npcCount; ++i)
+      queries.push_back({routine[i][h%4],routine[i][(h+1)%4]});
+
+  // day one: cold cache
+  Legacy::Search legacy(wp);
+  std::vector<uint32_t> a, b;
+  std::vector<std::vector<uint32_t>> dayOne;
+  double tGraph = 0, tLegacy = 0;
+  size_t longer = 0, broken = 0, wrong = 0;
+  for(auto& q:queries) {
+    auto t0 = Clock::now();
+    bool ra = graph.route(q.begin,q.end,a);
+    auto t1 = Clock::now();
+    bool rb = legacy.route(q.begin,q.end,b);
+    auto t2 = Clock::now();
+    tGraph  += std::chrono::duration<double,std::milli>(t1-t0).count();
+    tLegacy += std::chrono::duration<double,std::milli>(t2-t1).count();
+
+    dayOne.push_back(a);
+    if(ra!=rb || !ra) {
+      ++wrong;
+      continue;
+      }
+    const int32_t la = length(wp,a), lb = length(wp,b);
+    if(la<0 || a.front()!=q.end || a.back()!=q.begin)
+      ++broken;
+    // legacy stops at first arrival, so it may be longer, but never shorter
+    if(la>lb)
+      ++longer;
+    }
+  std::printf("waypoints: %zu, routes: %zu, a*: %.3f ms, legacy: %.3f ms\n",
+              wp.size(),queries.size(),tGraph,tLegacy);
+  CHECK(wrong==0);
+  CHECK(broken==0);
+  CHECK(longer==0);
+
+  // exact optimality on a sample
+  size_t notOptimal = 0;
+  for(size_t i=0; i<queries.size(); i+=37) {
+    auto& q = queries[i];
+    graph.route(q.begin,q.end,a);
+    if(length(wp,a)!=dijkstra(wp,q.begin,q.end))
+      ++notOptimal;
+    }
+  CHECK(notOptimal==0);
+
+  // day two: same routines, answered from cache
+  size_t differ = 0;
+  auto t0 = Clock::now();
+  for(size_t i=0; i<queries.size(); ++i) {
+    graph.route(queries[i].begin,queries[i].end,a);
+    if(a!=dayOne[i])
+      ++differ;
+    }
+  auto t1 = Clock::now();
+  const double tCached = std::chrono::duration<double,std::milli>(t1-t0).count();
+  std::printf("cached replay: %.3f ms\n",tCached);
+  CHECK(differ==0);
+
+  // and in parallel, as npc's of one tick would ask
+  std::vector<std::vector<uint32_t>> par(npcCount);
+  std::vector<uint8_t> ok(npcCount);
+  for(size_t h=0; h<hours; ++h) {
+    Workers::parallelFor(par,[&](std::vector<uint32_t>& out){
+      const size_t i = size_t(std::distance(par.data(),&out));
+      ok[i] = graph.route(routine[i][h%4],routine[i][(h+1)%4],out) ? 1 : 0;
+      });
+    for(size_t i=0; i<npcCount; ++i)
+      if(!ok[i] || par[i]!=dayOne[h*npcCount+i])
+        ++wrong;
+    }
+  CHECK(wrong==0);
+
+  // no route between town and island
+  CHECK(!graph.isConnected(0,uint32_t(island)));
+  CHECK(graph.isConnected(0,uint32_t(island-1)));
+  CHECK(!graph.route(0,uint32_t(island),a));
+
+  // rebuild starts over with empty cache
+  graph.build(wp);
+  CHECK(graph.route(queries[0].begin,queries[0].end,a));
+  CHECK(length(wp,a)==dijkstra(wp,queries[0].begin,queries[0].end));
+
+  return TEST_RESULT();
+  }
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "world/waypointgrid.h"
+#include "world/waypoint.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Free point queries of one world, as scripts ask them every tick: Wld_IsFPAvailable and AI_GotoFP of npc's,
+// that look for unlocked FP_ of some kind nearby; start of routes, that look for visible waypoint; and
+// findNextPoint of npc's, that got lost. Grid answers are checked against scans, that WayMatrix did before.
+namespace Legacy {
+
+// free points with name, sorted by x
+struct FpIndex {
+  std::vector<const WayPoint*> index;
+
+  FpIndex(const std::vector<WayPoint>& fp, const char* name) {
+    for(auto& w:fp)
+      if(w.checkName(name))
+        index.push_back(&w);
+    std::sort(index.begin(),index.end(),[](const WayPoint* a,const WayPoint* b){
+      return a->x<b->x;
+      });
+    }
+
+  const WayPoint* findFreePoint(float x, float y, float z, const std::function<bool(const WayPoint&)>& filter) const {
+    float R = 5.f*100.f;
+    auto b = std::lower_bound(index.begin(),index.end(), x-R ,[](const WayPoint *a, float b){
+      return a->x<b;
+      });
+    auto e = std::upper_bound(index.begin(),index.end(), x+R ,[](float a,const WayPoint *b){
+      return a<b->x;
+      });
+
+    const WayPoint *ret=nullptr;
+    float dist  = R*R;
+    for(auto i=b;i!=e;++i){
+      auto& w  = **i;
+      if(!filter(w))
+        continue;
+      float dx = w.x-x;
+      float dy = w.y-y;
+      float dz = w.z-z;
+      float l=dx*dx+dy*dy+dz*dz;
+      if(l<dist && dz*dz<300*300){
+        ret  = &w;
+        dist = l;
+        }
+      }
+    return ret;
+    }
+  };
+
+const WayPoint* findWayPoint(const std::vector<WayPoint>& wp, const Vec3& at, const std::function<bool(const WayPoint&)>& filter) {
+  const WayPoint* ret =nullptr;
+  float           dist=std::numeric_limits<float>::max();
+  for(auto& w:wp) {
+    if(!filter(w))
+      continue;
+    auto  dp = w.position()-at;
+    float l  = dp.quadLength();
+    if(l<dist){
+      ret  = &w;
+      dist = l;
+      }
+    }
+  return ret;
+  }
+
+const WayPoint* findNextPoint(const std::vector<const WayPoint*>& all, const Vec3& at, const std::function<bool(const WayPoint&)>& locked) {
+  const WayPoint* ret   = nullptr;
+  float           dist  = 20.f*100.f;
+
+  dist*=dist;
+  for(auto pw:all){
+    auto& w  = *pw;
+    auto  dp = w.position()-at;
+    float l  = dp.quadLength();
+
+    if(l<dist && dp.z*dp.z<300*300 && !locked(w)){
+      ret  = &w;
+      dist = l;
+      }
+    }
+  return ret;
+  }
+
+}
+
+// stand-in for Npc::canSeeNpc: deterministic, and not too cheap
+static bool canSee(const Vec3& from, const WayPoint& w) {
+  uint32_t h = uint32_t(int32_t(from.x))*73856093u ^ uint32_t(int32_t(w.x))*19349663u ^ uint32_t(int32_t(w.z))*83492791u;
+  for(int i=0; i<16; ++i)
+    h = h*1664525u+1013904223u;
+  return (h>>28)!=0;
+  }
+
+int main() {
+  using Clock = std::chrono::steady_clock;
+
+  const float worldSize = 80000.f;
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<float> coord (-worldSize*0.5f,worldSize*0.5f);
+  std::uniform_real_distribution<float> near  (-400.f,400.f);
+  std::uniform_real_distribution<float> height(0.f,600.f);
+
+  // waynet and free points, clustered around camps, like in a real world
+  const char* kinds[] = {"ROAM","SIT","CAMPFIRE","STAND","SMALLTALK","PICK","GUARD","SWEEP"};
+  std::vector<Vec3> camps(300);
+  for(auto& c:camps)
+    c = Vec3(coord(rng),height(rng),coord(rng));
+
+  std::vector<WayPoint> wayPoints, freePoints;
+  for(size_t i=0; i<8000; ++i) {
+    auto& c = camps[i%camps.size()];
+    wayPoints.emplace_back(Vec3(c.x+near(rng)*4.f,c.y,c.z+near(rng)*4.f),("WP_"+std::to_string(i)).c_str());
+    }
+  for(size_t i=0; i<6000; ++i) {
+    auto& c = camps[i%camps.size()];
+    std::string name = std::string("FP_")+kinds[i%8]+"_CAMP_"+std::to_string(i%camps.size())+"_"+std::to_string(i/camps.size());
+    freePoints.emplace_back(Vec3(c.x+near(rng)*2.f,c.y+near(rng)*0.1f,c.z+near(rng)*2.f),name.c_str());
+    }
+
+  std::vector<const WayPoint*> way, all;
+  for(auto& w:wayPoints)
+    way.push_back(&w);
+  all = way;
+  for(auto& w:freePoints)
+    all.push_back(&w);
+
+  // locks of AI_GotoFP, by index in 'all'
+  std::vector<uint8_t> lock(all.size(),0);
+  auto idOf = [&](const WayPoint* w) -> size_t {
+    if(w>=wayPoints.data() && w<wayPoints.data()+wayPoints.size())
+      return size_t(w-wayPoints.data());
+    return wayPoints.size()+size_t(w-freePoints.data());
+    };
+  auto locked = [&](const WayPoint& w){ return lock[idOf(&w)]!=0; };
+
+  auto t0 = Clock::now();
+  WayPointGrid wayGrid, allGrid;
+  wayGrid.build(way);
+  allGrid.build(all);
+  std::vector<WayPointGrid>   fpGrid(8);
+  std::vector<Legacy::FpIndex> fpLegacy;
+  for(size_t k=0; k<8; ++k) {
+    std::vector<const WayPoint*> pt;
+    for(auto& w:freePoints)
+      if(w.checkName(kinds[k]))
+        pt.push_back(&w);
+    fpGrid[k].build(pt);
+    }
+  auto t1 = Clock::now();
+  for(size_t k=0; k<8; ++k)
+    fpLegacy.emplace_back(freePoints,kinds[k]);
+  auto t2 = Clock::now();
+  std::printf("build: grid %.3f ms, legacy %.3f ms\n",
+              std::chrono::duration<double,std::milli>(t1-t0).count(),
+              std::chrono::duration<double,std::milli>(t2-t1).count());
+
+  // npc's stand around camps
+  std::vector<Vec3> npc(1200);
+  for(size_t i=0; i<npc.size(); ++i) {
+    auto& c = camps[(i*7)%camps.size()];
+    npc[i] = Vec3(c.x+near(rng),c.y+near(rng)*0.1f,c.z+near(rng));
+    }
+
+  double tGrid[3] = {}, tLegacy[3] = {};
+  size_t calls[2][2] = {}, found[3] = {}, wrong[3] = {};
+  // filter calls are counted by implementation: in game it's a raycast, that costs more than the rest of query
+  size_t* cnt = nullptr;
+  auto run = [&](double& t, size_t* c, const std::function<const WayPoint*()>& f) {
+    cnt = c;
+    auto b = Clock::now();
+    auto r = f();
+    t += std::chrono::duration<double,std::milli>(Clock::now()-b).count();
+    return r;
+    };
+
+  for(size_t tick=0; tick<20; ++tick) {
+    for(size_t i=0; i<npc.size(); ++i) {
+      const Vec3 at = npc[i];
+      // Wld_IsFPAvailable / AI_GotoFP: World::findFreePoint(npc,name)
+      const size_t k = (i+tick)%8;
+      auto fpFilter = [&](const WayPoint& w){
+        ++cnt[0];
+        return !locked(w) && canSee(at,w);
+        };
+      auto a = run(tGrid[0],  calls[0],[&](){ return fpGrid[k].nearest(at,500.f,[&](const WayPoint& w){
+                                                return (w.z-at.z)*(w.z-at.z)<300*300 && fpFilter(w);
+                                                }); });
+      auto b = run(tLegacy[0],calls[1],[&](){ return fpLegacy[k].findFreePoint(at.x,at.y,at.z,fpFilter); });
+      wrong[0] += (a!=b) ? 1 : 0;
+      found[0] += a ? 1 : 0;
+      // AI_GotoFP holds point for some ticks
+      if(a!=nullptr && i%3==0)
+        lock[idOf(a)] = uint8_t(4);
+
+      // start of route: World::wayTo, visible waypoint
+      if(i%4==tick%4) {
+        auto wpFilter = [&](const WayPoint& w){
+          ++cnt[1];
+          return canSee(at,w);
+          };
+        a = run(tGrid[1],  calls[0],[&](){ return wayGrid.nearest(at,std::numeric_limits<float>::max(),wpFilter); });
+        b = run(tLegacy[1],calls[1],[&](){ return Legacy::findWayPoint(wayPoints,at,wpFilter); });
+        wrong[1] += (a!=b) ? 1 : 0;
+        found[1] += a ? 1 : 0;
+        }
+
+      // findNextPoint: npc got lost
+      if(i%16==tick%16) {
+        a = run(tGrid[2],  calls[0],[&](){ return allGrid.nearest(at,2000.f,[&](const WayPoint& w){
+                                             auto dp = w.position()-at;
+                                             return dp.z*dp.z<300*300 && !locked(w);
+                                             }); });
+        b = run(tLegacy[2],calls[1],[&](){ return Legacy::findNextPoint(all,at,locked); });
+        wrong[2] += (a!=b) ? 1 : 0;
+        found[2] += a ? 1 : 0;
+        }
+      }
+    // locks expire
+    for(auto& l:lock)
+      if(l>0)
+        --l;
+    }
+
+  const char* names[] = {"findFreePoint","findWayPoint ","findNextPoint"};
+  for(size_t i=0; i<3; ++i)
+    std::printf("%s: found %5zu, grid: %8.3f ms, legacy: %8.3f ms\n",names[i],found[i],tGrid[i],tLegacy[i]);
+  std::printf("filter calls, grid: fp %zu, waypoint %zu; legacy: fp %zu, waypoint %zu\n",
+              calls[0][0],calls[0][1],calls[1][0],calls[1][1]);
+
+  for(size_t i=0; i<3; ++i) {
+    CHECK(wrong[i]==0);
+    CHECK(found[i]>0);
+    }
+  // linear scans are where time went: grid must ask filter much less; timings are reported only
+  CHECK(calls[0][0]<calls[1][0]);
+  CHECK(calls[0][1]*100<calls[1][1]);
+
+  // edge cases: empty grid, nothing passes filter, nothing in range
+  WayPointGrid empty;
+  empty.build({});
+  CHECK(empty.nearest(Vec3(),1000.f,[](const WayPoint&){ return true; })==nullptr);
+  CHECK(wayGrid.nearest(Vec3(),std::numeric_limits<float>::max(),[](const WayPoint&){ return false; })==nullptr);
+  CHECK(allGrid.nearest(Vec3(worldSize*2.f,0,worldSize*2.f),2000.f,[](const WayPoint&){ return true; })==nullptr);
+  // far away from all points: still finds nearest one
+  auto far = wayGrid.nearest(Vec3(worldSize*2.f,0,worldSize*2.f),std::numeric_limits<float>::max(),[](const WayPoint&){ return true; });
+  CHECK(far==Legacy::findWayPoint(wayPoints,Vec3(worldSize*2.f,0,worldSize*2.f),[](const WayPoint&){ return true; }));
+
+  return TEST_RESULT();
+  }
@@ -0,0 +1,248 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "utils/workers.h"
+
+#include "testing.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point t) {
+  return std::chrono::duration<double,std::milli>(Clock::now()-t).count();
+  }
+
+// uneven per-item cost, similar to npc tick: a crowd of heavy items at the start of the array,
+// many light ones after it - static batches put the whole crowd on one thread
+static uint64_t work(uint32_t v, size_t sz) {
+  uint64_t h    = v;
+  uint32_t iter = (size_t(v)*8<sz) ? 2000 : 100;
+  for(uint32_t i=0; i<iter; ++i)
+    h = h*6364136223846793005ull+1442695040888963407ull;
+  return h;
+  }
+
+// Workers as it was before work-stealing: at most 16 static batches, caller yield-spins
+// until every batch is done. Kept as baseline of the benchmark.
+namespace Legacy {
+
+class Workers final {
+  public:
+    Workers() {
+      for(size_t id=0; id<MAX_THREADS; ++id)
+        th[id] = std::thread([this,id]() noexcept { threadFunc(id); });
+      }
+    ~Workers() {
+      running   = false;
+      workTasks = MAX_THREADS;
+      execWork();
+      for(auto& i:th)
+        i.join();
+      }
+
+    template<class T,class F>
+    static void parallelFor(std::vector<T>& data, const F& func) {
+      inst().runParallelFor(data.data(),data.size(),std::thread::hardware_concurrency(),func);
+      }
+
+  private:
+    enum { MAX_THREADS=16 };
+
+    static Workers& inst() {
+      static Workers w;
+      return w;
+      }
+
+    void threadFunc(size_t id) {
+      while(true) {
+        {
+        std::unique_lock<std::mutex> lck(sync);
+        while(!workInc[id])
+          workWait.wait(lck);
+        workInc[id]=false;
+        }
+        if(!running) {
+          workDone.fetch_add(1);
+          return;
+          }
+        size_t b = std::min((id  )*batchSize, workSize);
+        size_t e = std::min((id+1)*batchSize, workSize);
+        if(b!=e)
+          workFunc(&workSet[b*workEltSize],e-b);
+        workDone.fetch_add(1);
+        }
+      }
+
+    void execWork() {
+      {
+        std::unique_lock<std::mutex> lck(sync);
+        for(size_t i=0; i<workTasks; ++i)
+          workInc[i]=true;
+        workWait.notify_all();
+      }
+      std::this_thread::yield();
+      while(true) {
+        int expect = int(workTasks);
+        if(workDone.compare_exchange_strong(expect,0,std::memory_order_acq_rel))
+          break;
+        std::this_thread::yield();
+        }
+      }
+
+    template<class T,class F>
+    void runParallelFor(T* data, size_t sz, size_t maxTh, const F& func) {
+      workSet     = reinterpret_cast<uint8_t*>(data);
+      workSize    = sz;
+      workEltSize = sizeof(T);
+      workFunc = [&func](void* data,size_t sz) {
+        T* tdata = reinterpret_cast<T*>(data);
+        for(size_t i=0;i<sz;++i)
+          func(tdata[i]);
+        };
+      workTasks = std::max<size_t>(1,std::min<size_t>(maxTh,MAX_THREADS));
+      batchSize = std::max<size_t>(16,(sz+workTasks-1)/workTasks);
+      execWork();
+      }
+
+    std::thread                       th     [MAX_THREADS];
+    bool                              workInc[MAX_THREADS] = {};
+    std::atomic<bool>                 running{true};
+
+    uint8_t*                          workSet=nullptr;
+    size_t                            workSize=0, batchSize=0, workEltSize=0;
+    size_t                            workTasks=0;
+    std::function<void(void*,size_t)> workFunc;
+
+    std::mutex                        sync;
+    std::condition_variable           workWait;
+    std::atomic_int                   workDone{0};
+  };
+
+}
+
+// best of few runs, to filter out scheduling noise
+template<class F>
+static double bestOf(int runs, const F& fn) {
+  double ret = 0;
+  for(int i=0; i<runs; ++i) {
+    auto         t0 = Clock::now();
+    fn();
+    const double t  = msSince(t0);
+    ret = (i==0 ? t : std::min(ret,t));
+    }
+  return ret;
+  }
+
+static void benchParallelFor() {
+  const unsigned hw = std::thread::hardware_concurrency();
+  std::printf("parallelFor, uneven workload, hw threads %u\n",hw);
+  std::printf("%10s %12s %12s %12s\n","items","serial ms","legacy ms","stealing ms");
+
+  for(size_t sz:{1000u,5000u,20000u,100000u}) {
+    std::vector<uint32_t> data(sz);
+    std::iota(data.begin(),data.end(),0u);
+
+    std::vector<uint64_t> ref(sz), legacy(sz), res(sz);
+    const double tSerial = bestOf(5,[&]() {
+      for(size_t i=0; i<sz; ++i)
+        ref[i] = work(data[i],sz);
+      });
+    const double tLegacy = bestOf(5,[&]() {
+      Legacy::Workers::parallelFor(data,[&legacy,sz](uint32_t& v){ legacy[v] = work(v,sz); });
+      });
+    const double tSteal = bestOf(5,[&]() {
+      Workers::parallelFor(data,[&res,sz](uint32_t& v){ res[v] = work(v,sz); });
+      });
+    CHECK(legacy==ref);
+    CHECK(res==ref);
+    // timings are reported only: they depend on load of the machine and on build type
+    std::printf("%10zu %12.2f %12.2f %12.2f\n",sz,tSerial,tLegacy,tSteal);
+    }
+  }
+
+static void testNested() {
+  // nested parallelFor inside TaskGroup tasks: every item must run exactly once
+  std::vector<uint32_t>  outer(8), inner(1000);
+  std::atomic<size_t>    cnt{0};
+  Workers::TaskGroup     grp;
+  for(size_t i=0; i<outer.size(); ++i)
+    grp.run([&]() {
+      std::vector<uint32_t> local(inner);
+      Workers::parallelFor(local,[&cnt](uint32_t&){ cnt.fetch_add(1); });
+      });
+  grp.wait();
+  CHECK(cnt.load()==outer.size()*inner.size());
+  }
+
+static void testAsyncNotStolen() {
+  // detached job must not be executed by a waiter of unrelated parallelFor
+  if(std::thread::hardware_concurrency()<=1)
+    return; // no pool: async runs inline
+  std::atomic<bool>            release{false}, done{false};
+  std::atomic<std::thread::id> runner{};
+  Workers::async([&]() {
+    runner.store(std::this_thread::get_id());
+    const auto t0 = Clock::now();
+    while(!release.load() && msSince(t0)<2000)
+      std::this_thread::yield();
+    done.store(true);
+    });
+
+  std::vector<uint32_t> data(256);
+  for(int i=0; i<16; ++i)
+    Workers::parallelFor(data,[](uint32_t& v){ v = uint32_t(work(v,1)); });
+  const bool stolen = (runner.load()==std::this_thread::get_id());
+  release.store(true);
+  Workers::waitFor(done);
+  CHECK(!stolen);
+  }
+
+static void testExceptions() {
+  std::vector<uint32_t> data(5000);
+  std::iota(data.begin(),data.end(),0u);
+
+  bool thrown = false;
+  try {
+    Workers::parallelFor(data,[](uint32_t& v){ if(v==4321) throw std::runtime_error("item"); });
+    }
+  catch(const std::runtime_error&) {
+    thrown = true;
+    }
+  CHECK(thrown);
+
+  thrown = false;
+  std::atomic<int> ok{0};
+  try {
+    Workers::TaskGroup grp;
+    grp.run([]() { throw std::runtime_error("task"); });
+    grp.run([&ok]() { ok.fetch_add(1); });
+    grp.wait();
+    }
+  catch(const std::runtime_error&) {
+    thrown = true;
+    }
+  CHECK(thrown);
+  CHECK(ok.load()==1);
+
+  // async failure is reported, but must not take down the pool
+  std::atomic<bool> after{false};
+  Workers::async([]() { throw std::runtime_error("async"); });
+  Workers::async([&after]() { after.store(true); });
+  Workers::waitFor(after);
+  CHECK(after.load());
+  }
+
+int main() {
+  benchParallelFor();
+  testNested();
+  testAsyncNotStolen();
+  testExceptions();
+  return TEST_RESULT();
+  }
@@ -0,0 +1,135 @@
+#include <Tempest/File>
+
+#include <cstdio>
+#include <vector>
+
+#include "world/worldcacheio.h"
+
+#include "testing.h"
+
+using namespace Tempest;
+
+// Round trip of world data through WorldCache format: loaded world must be equal to parsed one
+// in every field, that engine reads; truncated file must be rejected, not half-loaded.
+static ZenLoad::zCVobData mkVob(int id) {
+  ZenLoad::zCVobData v;
+  v.vobName    = "VOB_" + std::to_string(id);
+  v.visual     = "MESH_" + std::to_string(id) + ".3DS";
+  v.position.x = float(id);
+  v.position.y = float(id*2);
+  v.position.z = float(id*3);
+  v.bbox[0].x  = -float(id);
+  v.bbox[1].x  =  float(id);
+  v.zBias      = id;
+  v.cdStatic   = (id%2)==0;
+
+  v.zCVobLight.range = float(id)*100.f;
+  v.zCVobLight.dynamic.rangeAniScale = {1.f,2.f,float(id)};
+
+  v.zCMover.sfxMoving = "MOVE_" + std::to_string(id);
+  v.zCMover.keyframes.resize(size_t(id%3));
+
+  v.zCTrigger.triggerTarget = "TARGET_" + std::to_string(id);
+  v.zCTriggerList.list.resize(2);
+  v.zCTriggerList.list[1].triggerTarget = "LIST_" + std::to_string(id);
+  v.zCTriggerList.list[1].fireDelay     = 0.5f;
+  v.zCCodeMaster.slaveVobName = {"A","B",std::to_string(id)};
+  v.oCMobInter.onStateFunc    = "ON_STATE_" + std::to_string(id);
+  return v;
+  }
+
+static bool equal(const ZenLoad::zCVobData& a, const ZenLoad::zCVobData& b) {
+  if(a.childVobs.size()!=b.childVobs.size())
+    return false;
+  for(size_t i=0; i<a.childVobs.size(); ++i)
+    if(!equal(a.childVobs[i],b.childVobs[i]))
+      return false;
+  return a.vobName==b.vobName &&
+         a.visual==b.visual &&
+         a.position.x==b.position.x && a.position.y==b.position.y && a.position.z==b.position.z &&
+         a.bbox[0].x==b.bbox[0].x && a.bbox[1].x==b.bbox[1].x &&
+         a.zBias==b.zBias &&
+         a.cdStatic==b.cdStatic &&
+         a.zCVobLight.range==b.zCVobLight.range &&
+         a.zCVobLight.dynamic.rangeAniScale==b.zCVobLight.dynamic.rangeAniScale &&
+         a.zCMover.sfxMoving==b.zCMover.sfxMoving &&
+         a.zCMover.keyframes.size()==b.zCMover.keyframes.size() &&
+         a.zCTrigger.triggerTarget==b.zCTrigger.triggerTarget &&
+         a.zCTriggerList.list.size()==b.zCTriggerList.list.size() &&
+         a.zCTriggerList.list[1].triggerTarget==b.zCTriggerList.list[1].triggerTarget &&
+         a.zCTriggerList.list[1].fireDelay==b.zCTriggerList.list[1].fireDelay &&
+         a.zCCodeMaster.slaveVobName==b.zCCodeMaster.slaveVobName &&
+         a.oCMobInter.onStateFunc==b.oCMobInter.onStateFunc;
+  }
+
+int main() {
+  const char* path = "worldcache_test.bin";
+
+  ZenLoad::oCWorldData src;
+  for(int i=0; i<50; ++i) {
+    src.rootVobs.push_back(mkVob(i));
+    for(int r=0; r<i%4; ++r)
+      src.rootVobs.back().childVobs.push_back(mkVob(1000+i*10+r));
+    }
+  for(int i=0; i<20; ++i) {
+    ZenLoad::zCWaypointData wp;
+    wp.wpName     = "WP_" + std::to_string(i);
+    wp.position.x = float(i);
+    src.waynet.waypoints.push_back(wp);
+    if(i>0)
+      src.waynet.edges.push_back({size_t(i-1),size_t(i)});
+    }
+  src.bspTree.nodes.resize(7);
+  src.bspTree.nodes[3].front = 5;
+  src.bspTree.leafIndices = {2,4,5,6};
+  ZenLoad::zCSector sec;
+  sec.name           = "HALL";
+  sec.bspNodeIndices = {1,3};
+  src.bspTree.sectors.push_back(sec);
+
+  size_t total = 0;
+  {
+  WFile f(path);
+  WorldCacheIo::write(f,src);
+  }
+  {
+  RFile f(path);
+  total = f.size();
+  ZenLoad::oCWorldData dst;
+  CHECK(WorldCacheIo::read(f,dst));
+  CHECK(dst.rootVobs.size()==src.rootVobs.size());
+  for(size_t i=0; i<src.rootVobs.size() && i<dst.rootVobs.size(); ++i)
+    CHECK(equal(src.rootVobs[i],dst.rootVobs[i]));
+
+  CHECK(dst.waynet.waypoints.size()==src.waynet.waypoints.size());
+  CHECK(dst.waynet.waypoints.back().wpName=="WP_19");
+  CHECK(dst.waynet.waypoints.back().position.x==19.f);
+  CHECK(dst.waynet.edges==src.waynet.edges);
+
+  CHECK(dst.bspTree.nodes.size()==7);
+  CHECK(dst.bspTree.nodes[3].front==5);
+  CHECK(dst.bspTree.leafIndices==src.bspTree.leafIndices);
+  CHECK(dst.bspTree.sectors.size()==1);
+  CHECK(dst.bspTree.sectors[0].name=="HALL");
+  CHECK(dst.bspTree.sectors[0].bspNodeIndices==sec.bspNodeIndices);
+  }
+
+  // truncated cache
+  {
+  std::vector<char> data(total);
+  {
+  RFile f(path);
+  f.read(data.data(),data.size());
+  }
+  {
+  WFile f(path);
+  f.write(data.data(),data.size()/2);
+  }
+  RFile f(path);
+  ZenLoad::oCWorldData dst;
+  CHECK(!WorldCacheIo::read(f,dst));
+  }
+
+  std::remove(path);
+  return TEST_RESULT();
+  }
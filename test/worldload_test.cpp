@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/async.h"
+#include "utils/workers.h"
+
+#include "testing.h"
+
+// Stages of World::implLoad over a synthetic world: landscape mesh is packed for rendering and, again, for physics;
+// vob tree needs meshes and textures; waypoints are snapped to ground by rays down.
+// Former loader ran stages one after another and loaded assets on demand, vob by vob; pipeline runs physics
+// packing aside of visual packing and asset prefetch, and probes waypoints in parallel.
+// Scheduling only: both must produce same world, and progress of pipeline must grow monotonically up to 100.
+// Stages are stand-ins, so there is no timing here; load time of real worlds is logged by World::implLoad.
+namespace {
+
+const uint32_t gridN    = 256;
+const float    gridCell = 100.f;
+const uint32_t physCell = 8; // landscape quads per physics cell
+
+struct Land {
+  std::vector<float>    vert;  // xyz
+  std::vector<uint32_t> index;
+  std::vector<uint8_t>  mat;   // per triangle
+  };
+
+float height(uint32_t x, uint32_t z) {
+  return std::sin(float(x)*0.11f)*400.f+std::cos(float(z)*0.07f)*300.f+float((x*31+z*17)%13);
+  }
+
+// ZenParser output: triangle soup, every triangle has own vertices
+Land readWorld() {
+  Land l;
+  for(uint32_t z=0; z<gridN; ++z)
+    for(uint32_t x=0; x<gridN; ++x) {
+      const uint32_t q[6][2] = {{x,z},{x,z+1},{x+1,z},{x+1,z},{x,z+1},{x+1,z+1}};
+      for(auto& p:q) {
+        l.index.push_back(uint32_t(l.vert.size()/3));
+        l.vert.push_back(float(p[0])*gridCell);
+        l.vert.push_back(height(p[0],p[1]));
+        l.vert.push_back(float(p[1])*gridCell);
+        }
+      const uint8_t m = uint8_t(((x/16)*7+(z/16)*3)%24);
+      l.mat.push_back(m);
+      l.mat.push_back(m);
+      }
+  return l;
+  }
+
+uint64_t mixHash(uint64_t h, uint64_t v) {
+  return (h^v)*1099511628211ull;
+  }
+
+// PackedMesh: shared vertices, indices grouped by material
+struct Packed {
+  std::vector<float>                 vert;
+  std::vector<std::vector<uint32_t>> sub;
+  uint64_t                           hash = 1469598103934665603ull;
+  };
+
+Packed packVisual(const Land& l) {
+  Packed p;
+  std::unordered_map<uint64_t,uint32_t> uniq;
+  p.sub.resize(24);
+  for(size_t t=0; t<l.index.size()/3; ++t)
+    for(size_t k=0; k<3; ++k) {
+      const float* v   = &l.vert[l.index[t*3+k]*3];
+      const auto   key = uint64_t(uint32_t(v[0]/gridCell))<<32 | uint64_t(uint32_t(v[2]/gridCell));
+      auto it = uniq.find(key);
+      if(it==uniq.end()) {
+        it = uniq.emplace(key,uint32_t(p.vert.size()/3)).first;
+        p.vert.insert(p.vert.end(),v,v+3);
+        }
+      p.sub[l.mat[t]].push_back(it->second);
+      }
+  for(auto& s:p.sub)
+    for(auto i:s)
+      p.hash = mixHash(p.hash,i);
+  return p;
+  }
+
+// PhysicCache: triangles bucketed by cell, for ray queries
+struct Physic {
+  std::vector<uint32_t> cellStart;
+  std::vector<uint32_t> tri;
+  const Land*           land = nullptr;
+  uint64_t              hash = 1469598103934665603ull;
+
+  static uint32_t cellOf(float x, float z) {
+    const uint32_t n  = gridN/physCell;
+    const uint32_t cx = std::min(n-1,uint32_t(std::max(0.f,x/(gridCell*physCell))));
+    const uint32_t cz = std::min(n-1,uint32_t(std::max(0.f,z/(gridCell*physCell))));
+    return cz*n+cx;
+    }
+
+  // ray down at (x,z): height of landscape, or -inf
+  float rayDown(float x, float z) const {
+    const uint32_t c = cellOf(x,z);
+    float ret = -std::numeric_limits<float>::infinity();
+    for(uint32_t i=cellStart[c]; i<cellStart[c+1]; ++i) {
+      const uint32_t* id = &land->index[tri[i]*3];
+      const float*    a  = &land->vert[id[0]*3];
+      const float*    b  = &land->vert[id[1]*3];
+      const float*    d  = &land->vert[id[2]*3];
+      const float det = (b[2]-d[2])*(a[0]-d[0])+(d[0]-b[0])*(a[2]-d[2]);
+      const float u   = ((b[2]-d[2])*(x-d[0])+(d[0]-b[0])*(z-d[2]))/det;
+      const float v   = ((d[2]-a[2])*(x-d[0])+(a[0]-d[0])*(z-d[2]))/det;
+      if(u<0 || v<0 || u+v>1)
+        continue;
+      ret = std::max(ret,a[1]*u+b[1]*v+d[1]*(1-u-v));
+      }
+    return ret;
+    }
+  };
+
+Physic packPhysic(const Land& l) {
+  Physic p;
+  p.land = &l;
+  const uint32_t n = gridN/physCell;
+  std::vector<std::pair<uint32_t,uint32_t>> key;
+  for(uint32_t t=0; t<uint32_t(l.index.size()/3); ++t) {
+    const uint32_t* id = &l.index[t*3];
+    const float cx = (l.vert[id[0]*3+0]+l.vert[id[1]*3+0]+l.vert[id[2]*3+0])/3.f;
+    const float cz = (l.vert[id[0]*3+2]+l.vert[id[1]*3+2]+l.vert[id[2]*3+2])/3.f;
+    key.emplace_back(Physic::cellOf(cx,cz),t);
+    }
+  std::sort(key.begin(),key.end());
+  p.cellStart.assign(n*n+1,0);
+  for(auto& k:key) {
+    p.cellStart[k.first+1]++;
+    p.tri.push_back(k.second);
+    p.hash = mixHash(p.hash,k.second);
+    }
+  for(size_t i=1; i<p.cellStart.size(); ++i)
+    p.cellStart[i] += p.cellStart[i-1];
+  return p;
+  }
+
+// asset store and decode: mip chain of generated image
+struct Texture {
+  uint64_t hash = 0;
+  };
+
+struct Mesh {
+  std::vector<const Texture*> tex;
+  };
+
+Texture decodeTexture(uint32_t id) {
+  const uint32_t w = 64u<<(id%3);
+  std::vector<uint8_t> px(size_t(w)*w*4);
+  uint32_t s = id*2654435761u+1u;
+  for(auto& i:px) {
+    s = s*1664525u+1013904223u;
+    i = uint8_t(s>>24);
+    }
+  Texture t;
+  t.hash = 1469598103934665603ull;
+  for(uint32_t sz=w; sz>1; sz/=2) {
+    const uint32_t nw = sz/2;
+    for(uint32_t y=0; y<nw; ++y)
+      for(uint32_t x=0; x<nw*4; ++x) {
+        const uint32_t v = px[(2*y*sz)*4+2*x] + px[((2*y+1)*sz)*4+2*x];
+        px[(y*nw)*4+x] = uint8_t(v/2);
+        }
+    for(size_t i=0; i<size_t(nw)*nw*4; ++i)
+      t.hash = mixHash(t.hash,px[i]);
+    }
+  return t;
+  }
+
+struct Resources {
+  std::recursive_mutex sync;
+  std::atomic<size_t>  asyncLeft{0};
+  std::unordered_map<uint32_t,std::unique_ptr<Texture>> tex;
+  std::unordered_map<uint32_t,std::unique_ptr<Mesh>>    mesh;
+
+  ~Resources() { Workers::waitFor(asyncLeft); }
+
+  // decode out of lock, first insert wins
+  const Texture* loadTexture(uint32_t id) {
+    {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = tex.find(id);
+    if(it!=tex.end())
+      return it->second.get();
+    }
+    std::unique_ptr<Texture> t(new Texture(decodeTexture(id)));
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto& dst = tex[id];
+    if(dst==nullptr)
+      dst = std::move(t);
+    return dst.get();
+    }
+
+  const Mesh* loadMesh(uint32_t id) {
+    {
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto it = mesh.find(id);
+    if(it!=mesh.end())
+      return it->second.get();
+    }
+    std::unique_ptr<Mesh> m(new Mesh());
+    for(uint32_t k=0; k<=id%3; ++k)
+      m->tex.push_back(loadTexture((id*7+k*13)%500));
+    std::lock_guard<std::recursive_mutex> g(sync);
+    auto& dst = mesh[id];
+    if(dst==nullptr)
+      dst = std::move(m);
+    return dst.get();
+    }
+  };
+
+struct Vob {
+  uint32_t    visual = 0;
+  const Mesh* mesh   = nullptr;
+  };
+
+struct WayPoint {
+  float x = 0, y = 0, z = 0;
+  };
+
+struct World {
+  Land                  land;
+  Packed                visual;
+  Physic                physic;
+  std::vector<Vob>      vobs;
+  std::vector<WayPoint> wp;
+  };
+
+World mkScene() {
+  World w;
+  for(uint32_t i=0; i<6000; ++i) {
+    Vob v;
+    v.visual = ((i*2654435761u)>>8)%700;
+    w.vobs.push_back(v);
+    }
+  for(uint32_t i=0; i<20000; ++i) {
+    WayPoint p;
+    p.x = float((i*7919)%(gridN*100))*float(gridN)*gridCell/float(gridN*100);
+    p.z = float((i*104729)%(gridN*100))*float(gridN)*gridCell/float(gridN*100);
+    p.y = 1000.f;
+    w.wp.push_back(p);
+    }
+  return w;
+  }
+
+}
+
+namespace Legacy {
+
+// previous World::World: stage by stage, assets on demand
+void load(World& w, Resources& res, const std::function<void(int)>& loadProgress) {
+  w.land   = readWorld();
+  loadProgress(10);
+  w.visual = packVisual(w.land);
+  loadProgress(20);
+  w.physic = packPhysic(w.land);
+  loadProgress(40);
+  for(auto& v:w.vobs)
+    v.mesh = res.loadMesh(v.visual);
+  loadProgress(90);
+  for(auto& p:w.wp)
+    p.y = w.physic.rayDown(p.x,p.z);
+  loadProgress(100);
+  }
+
+}
+
+// same stage graph as World::implLoad
+void load(World& w, Resources& res, const std::function<void(int)>& loadProgress) {
+  w.land = readWorld();
+  loadProgress(10);
+
+  Workers::TaskGroup physicTask;
+  physicTask.run([&w]() {
+    w.physic = packPhysic(w.land);
+    });
+
+  std::unordered_map<uint32_t,Async<Mesh>> prefetch;
+  for(auto& v:w.vobs)
+    if(prefetch.find(v.visual)==prefetch.end())
+      prefetch[v.visual] = Async<Mesh>::run([&res,id=v.visual](){ return res.loadMesh(id); },res.asyncLeft);
+  w.visual = packVisual(w.land);
+
+  // progress in range [10,80], as handles are completed
+  size_t done = 0;
+  int    prev = -1;
+  for(auto& i:prefetch) {
+    i.second.get();
+    ++done;
+    const int p = 10 + int(size_t(80-10)*done/prefetch.size());
+    if(p!=prev)
+      loadProgress(p);
+    prev = p;
+    }
+  physicTask.wait();
+  loadProgress(85);
+
+  for(auto& v:w.vobs)
+    v.mesh = res.loadMesh(v.visual);
+  loadProgress(95);
+  Workers::parallelFor(w.wp,[&w](WayPoint& p){
+    p.y = w.physic.rayDown(p.x,p.z);
+    });
+  loadProgress(100);
+  }
+
+int main() {
+  std::vector<int> progressA, progressB;
+  World     a = mkScene(), b = mkScene();
+  Resources resA, resB;
+
+  Legacy::load(a,resA,[&](int p){ progressA.push_back(p); });
+  load(b,resB,[&](int p){ progressB.push_back(p); });
+
+  std::printf("triangles: %zu, vobs: %zu, meshes: %zu, textures: %zu, waypoints: %zu, hw threads %u\n",
+              b.land.mat.size(),b.vobs.size(),resB.mesh.size(),resB.tex.size(),b.wp.size(),std::thread::hardware_concurrency());
+  std::printf("progress steps: sequential %zu, pipeline %zu\n",progressA.size(),progressB.size());
+
+  // same world
+  CHECK(a.visual.hash==b.visual.hash);
+  CHECK(a.physic.hash==b.physic.hash);
+  size_t wrongVob = 0, wrongWp = 0, onGround = 0;
+  for(size_t i=0; i<a.vobs.size(); ++i) {
+    auto ma = a.vobs[i].mesh, mb = b.vobs[i].mesh;
+    if(ma==nullptr || mb==nullptr || ma->tex.size()!=mb->tex.size()) {
+      ++wrongVob;
+      continue;
+      }
+    for(size_t k=0; k<ma->tex.size(); ++k)
+      if(ma->tex[k]->hash!=mb->tex[k]->hash)
+        ++wrongVob;
+    }
+  for(size_t i=0; i<a.wp.size(); ++i) {
+    if(a.wp[i].y!=b.wp[i].y)
+      ++wrongWp;
+    if(std::fabs(b.wp[i].y)<1000.f)
+      ++onGround;
+    }
+  CHECK(wrongVob==0);
+  CHECK(wrongWp==0);
+  CHECK(onGround==b.wp.size());
+  CHECK(resA.tex.size()==resB.tex.size());
+  CHECK(resA.mesh.size()==resB.mesh.size());
+
+  // progress is monotonic and complete
+  CHECK(!progressB.empty() && progressB.back()==100);
+  CHECK(std::is_sorted(progressB.begin(),progressB.end()));
+  CHECK(progressB.size()>progressA.size());
+
+  return TEST_RESULT();
+  }